@@ -0,0 +1,370 @@
+
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/PassTimingInfo.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/Pass.h"
+#include "llvm/PassRegistry.h"
+#include "llvm/PassInfo.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/PluginLoader.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "BinaryGraph.h"
+#include "DotReader.h"
+#include "ChannelGraph.h"
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace llvm;
+using namespace DFGraphComp;
+
+
+/* Compile-time benchmark of the pass pipeline. Each kernel is run through GetElemPtrPass,
+    LiveVarsPass and DFGraphPass, loaded with -load as in opt, timing each pass on its own,
+    and the sizes of the graph are taken from the binary file written by DFGraphPass.
+    The results are written as JSON, and compared with the ones of a previous run if
+    a baseline is given, failing if some pass got slower than the tolerance. A kernel
+    also fails when its graph keeps a combinational cycle, as the buffers have to break
+    all of them, also the ones that go through the called functions.
+
+    Usage: dfgraph-bench -load <pass.so>... [-repetitions N] [-output-dir dir]
+        [-o results.json] [-baseline baseline.json] [-tolerance 0.1] kernel.ll... */
+
+
+static cl::list <string> kernelFiles(cl::Positional, cl::desc("<kernel.ll>..."),
+    cl::OneOrMore);
+
+static cl::opt <unsigned int> repetitions("repetitions",
+    cl::desc("Times each kernel is compiled, the median time is reported"), cl::init(5));
+
+static cl::opt <string> outputDir("output-dir",
+    cl::desc("Directory where the graphs of the kernels are written"), cl::init("."));
+
+static cl::opt <string> resultsFile("o", cl::desc("File with the results in JSON"),
+    cl::value_desc("filename"), cl::init("benchmark.json"));
+
+static cl::opt <string> baselineFile("baseline",
+    cl::desc("Results of a previous run to compare with"), cl::value_desc("filename"));
+
+static cl::opt <double> tolerance("tolerance",
+    cl::desc("Slowdown over the baseline allowed for each pass, as a fraction"),
+    cl::init(0.1));
+
+static cl::opt <double> minDelta("min-delta",
+    cl::desc("Slowdowns below this many milliseconds are taken as noise"), cl::init(0.5));
+
+
+// Passes in the order they run, as registered with RegisterPass
+static const char* passArgs[] = {"gepPass", "liveVarsPass", "dfGraphPass"};
+static const char* passNames[] = {"GetElemPtrPass", "LiveVarsPass", "DFGraphPass"};
+static const unsigned int numPasses = 3;
+
+
+struct KernelResult
+{
+    string name;
+    unsigned int numFunctions;
+    unsigned int numBBs;
+    unsigned int numInstructions;
+    // Milliseconds of each pass in every repetition
+    vector <double> times[numPasses];
+    unsigned int numBlocks;
+    unsigned int numChannels;
+    unsigned int numForks;
+    unsigned int numForkOutputs;
+    map <string, unsigned int> blocksByType;
+};
+
+
+static double getMedian(vector <double> values) {
+    std::sort(values.begin(), values.end());
+    unsigned int size = values.size();
+    if (size % 2 == 1) return values[size/2];
+    return (values[size/2 - 1] + values[size/2]) / 2;
+}
+
+static double getMinimum(const vector <double>& values) {
+    return *std::min_element(values.begin(), values.end());
+}
+
+static string getBlockTypeName(BlockType type) {
+    ostringstream name;
+    name << type;
+    return name.str();
+}
+
+/* Strongly connected components of the whole module, with the functions linked by their
+    calls, that have no register in their cycles. -1 if the DOT file cannot be read */
+static int countCombinationalCycles(const string& dotName) {
+    DotReader reader;
+    if (!reader.readFile(dotName)) {
+        errs() << dotName << ": " << reader.getError() << '\n';
+        return -1;
+    }
+    vector <FunctionGraph*> graphs;
+    for (unsigned int i = 0; i < reader.getNumGraphs(); ++i) {
+        graphs.push_back(&reader.getGraph(i));
+    }
+    ChannelGraph channelGraph(graphs);
+    const vector <ChannelGraph::Channel>& channels = channelGraph.getChannels();
+    const vector <bool>& sequential = channelGraph.getSequential();
+    auto combinational = [&](unsigned int channel) {
+        return !sequential[channels[channel].from];
+    };
+    vector <unsigned int> components;
+    vector <unsigned int> sizes;
+    channelGraph.findComponents(combinational, components, sizes);
+    vector <bool> cyclic(sizes.size(), false);
+    for (unsigned int i = 0; i < sizes.size(); ++i) cyclic[i] = sizes[i] > 1;
+    for (unsigned int i = 0; i < channels.size(); ++i) {
+        if (channels[i].from == channels[i].to and combinational(i)) {
+            cyclic[components[channels[i].from]] = true;
+        }
+    }
+    return count(cyclic.begin(), cyclic.end(), true);
+}
+
+static bool runKernel(const string& fileName, KernelResult& result) {
+    result.name = sys::path::stem(fileName).str();
+    // The pass writes the graph next to the name of the module
+    SmallString <128> moduleName(outputDir);
+    sys::path::append(moduleName, result.name + ".ll");
+    for (unsigned int i = 0; i < repetitions; ++i) {
+        // GetElemPtrPass changes the IR, so the kernel is parsed again every time
+        LLVMContext context;
+        SMDiagnostic diagnostic;
+        unique_ptr <Module> M = parseIRFile(fileName, diagnostic, context);
+        if (!M) {
+            diagnostic.print("dfgraph-bench", errs());
+            return false;
+        }
+        M->setModuleIdentifier(moduleName);
+        if (i == 0) {
+            result.numFunctions = 0;
+            result.numBBs = 0;
+            result.numInstructions = 0;
+            for (Module::const_iterator it = M->begin(); it != M->end(); ++it) {
+                if (it->isDeclaration()) continue;
+                result.numFunctions += 1;
+                result.numBBs += it->size();
+                result.numInstructions += it->getInstructionCount();
+            }
+        }
+        legacy::PassManager PM;
+        Pass* passes[numPasses];
+        for (unsigned int j = 0; j < numPasses; ++j) {
+            const PassInfo* info = PassRegistry::getPassRegistry()->getPassInfo(
+                StringRef(passArgs[j]));
+            if (info == nullptr) {
+                errs() << "Pass " << passArgs[j] << " not loaded, use -load\n";
+                return false;
+            }
+            passes[j] = info->createPass();
+            PM.add(passes[j]);
+        }
+        PM.run(*M);
+        for (unsigned int j = 0; j < numPasses; ++j) {
+            Timer* timer = getPassTimer(passes[j]);
+            result.times[j].push_back(timer->getTotalTime().getWallTime() * 1000);
+        }
+        // Otherwise the timers keep adding and they are reported when exiting
+        reportAndResetTimings(&nulls());
+    }
+    BinaryGraphReader reader;
+    SmallString <128> graphName(moduleName);
+    sys::path::replace_extension(graphName, "dfg");
+    if (!reader.open(graphName.str().str())) {
+        errs() << "Cannot read the graph " << graphName << '\n';
+        return false;
+    }
+    result.numBlocks = reader.getNumNodes();
+    result.numChannels = reader.getNumEdges();
+    result.numForks = 0;
+    result.numForkOutputs = 0;
+    for (unsigned int i = 0; i < reader.getNumNodes(); ++i) {
+        const BinaryNodeRecord& node = reader.getNode(i);
+        result.blocksByType[getBlockTypeName((BlockType)node.blockType)] += 1;
+        if (node.blockType == BlockType::Fork_Block) {
+            result.numForks += 1;
+            result.numForkOutputs += node.numOutPorts;
+        }
+    }
+    SmallString <128> dotName(moduleName);
+    sys::path::replace_extension(dotName, "dot");
+    int numCycles = countCombinationalCycles(dotName.str().str());
+    if (numCycles < 0) return false;
+    if (numCycles > 0) {
+        errs() << result.name << ": " << numCycles << " combinational cycles left\n";
+        return false;
+    }
+    return true;
+}
+
+static json::Value getResultJSON(const KernelResult& result) {
+    json::Object times;
+    for (unsigned int i = 0; i < numPasses; ++i) {
+        times[passNames[i]] = json::Object{
+            {"median", getMedian(result.times[i])},
+            {"min", getMinimum(result.times[i])}
+        };
+    }
+    json::Object blockTypes;
+    for (map <string, unsigned int>::const_iterator it = result.blocksByType.begin();
+        it != result.blocksByType.end(); ++it)
+    {
+        blockTypes[it->first] = it->second;
+    }
+    return json::Object{
+        {"name", result.name},
+        {"functions", result.numFunctions},
+        {"BBs", result.numBBs},
+        {"instructions", result.numInstructions},
+        {"timeMs", std::move(times)},
+        {"graph", json::Object{
+            {"blocks", result.numBlocks},
+            {"channels", result.numChannels},
+            {"forks", result.numForks},
+            {"forkOutputs", result.numForkOutputs},
+            {"blockTypes", std::move(blockTypes)}
+        }}
+    };
+}
+
+static void printResult(const KernelResult& result) {
+    outs() << format("%-12s %4u BB %5u inst", result.name.c_str(), result.numBBs,
+        result.numInstructions);
+    for (unsigned int i = 0; i < numPasses; ++i) {
+        outs() << format("  %s %8.3f ms", passNames[i], getMedian(result.times[i]));
+    }
+    outs() << format("  %5u blocks %5u channels %4u forks\n", result.numBlocks,
+        result.numChannels, result.numForks);
+}
+
+// Returns the number of regressions
+static unsigned int compareWithBaseline(const json::Array& baseline,
+    const vector <KernelResult>& results)
+{
+    unsigned int numRegressions = 0;
+    outs() << "\nComparison with " << baselineFile << '\n';
+    for (unsigned int i = 0; i < results.size(); ++i) {
+        const KernelResult& result = results[i];
+        const json::Object* base = nullptr;
+        for (const json::Value& value : baseline) {
+            const json::Object* kernel = value.getAsObject();
+            if (kernel != nullptr and kernel->getString("name") == StringRef(result.name)) {
+                base = kernel;
+            }
+        }
+        if (base == nullptr) {
+            outs() << format("%-12s not in the baseline\n", result.name.c_str());
+            continue;
+        }
+        const json::Object* baseTimes = base->getObject("timeMs");
+        for (unsigned int j = 0; j < numPasses and baseTimes != nullptr; ++j) {
+            const json::Object* passTime = baseTimes->getObject(passNames[j]);
+            Optional <double> baseMedian;
+            if (passTime != nullptr) baseMedian = passTime->getNumber("median");
+            if (!baseMedian) continue;
+            double median = getMedian(result.times[j]);
+            bool regression = median > *baseMedian * (1 + tolerance) and
+                median - *baseMedian > minDelta;
+            if (regression) numRegressions += 1;
+            outs() << format("%-12s %-16s %8.3f -> %8.3f ms  %+6.1f%%%s\n",
+                result.name.c_str(), passNames[j], *baseMedian, median,
+                (*baseMedian > 0 ? (median / *baseMedian - 1) * 100 : 0.0),
+                regression ? "  REGRESSION" : "");
+        }
+        // Different sizes are not an error, but the times are not comparable then
+        const json::Object* baseGraph = base->getObject("graph");
+        if (baseGraph != nullptr) {
+            Optional <int64_t> blocks = baseGraph->getInteger("blocks");
+            Optional <int64_t> channels = baseGraph->getInteger("channels");
+            if ((blocks and *blocks != result.numBlocks) or
+                (channels and *channels != result.numChannels))
+            {
+                outs() << format("%-12s graph changed from %lld blocks %lld channels\n",
+                    result.name.c_str(), (long long)blocks.getValueOr(0),
+                    (long long)channels.getValueOr(0));
+            }
+        }
+    }
+    return numRegressions;
+}
+
+int main(int argc, char* argv[]) {
+    cl::ParseCommandLineOptions(argc, argv, "Compile-time benchmark of DFGraphPass\n");
+    if (repetitions == 0) repetitions = 1;
+    // The sizes of the graph are read from the binary file
+    StringMap <cl::Option*>& options = cl::getRegisteredOptions();
+    if (options.count("dfgraph-format") and
+        options["dfgraph-format"]->getNumOccurrences() == 0)
+    {
+        options["dfgraph-format"]->addOccurrence(0, "dfgraph-format", "all");
+    }
+    TimePassesIsEnabled = true;
+    // Analyses DFGraphPass requires, registered by opt when it is used instead
+    PassRegistry& registry = *PassRegistry::getPassRegistry();
+    initializeCore(registry);
+    initializeAnalysis(registry);
+    sys::fs::create_directories(outputDir);
+
+    vector <KernelResult> results(kernelFiles.size());
+    for (unsigned int i = 0; i < kernelFiles.size(); ++i) {
+        if (!runKernel(kernelFiles[i], results[i])) return 1;
+        printResult(results[i]);
+    }
+
+    json::Array kernels;
+    for (unsigned int i = 0; i < results.size(); ++i) {
+        kernels.push_back(getResultJSON(results[i]));
+    }
+    error_code error;
+    raw_fd_ostream file(resultsFile, error);
+    if (error) {
+        errs() << "Cannot write " << resultsFile << ": " << error.message() << '\n';
+        return 1;
+    }
+    json::Value allResults = json::Object{
+        {"repetitions", (int64_t)repetitions},
+        {"kernels", std::move(kernels)}
+    };
+    file << formatv("{0:2}", allResults) << '\n';
+    file.close();
+
+    if (baselineFile.empty()) return 0;
+    ErrorOr <unique_ptr <MemoryBuffer> > baselineText = MemoryBuffer::getFile(baselineFile);
+    if (!baselineText) {
+        errs() << "Cannot read " << baselineFile << '\n';
+        return 1;
+    }
+    Expected <json::Value> baseline = json::parse((*baselineText)->getBuffer());
+    if (!baseline) {
+        errs() << baselineFile << ": " << toString(baseline.takeError()) << '\n';
+        return 1;
+    }
+    const json::Object* baselineObject = baseline->getAsObject();
+    const json::Array* baselineKernels = (baselineObject != nullptr ?
+        baselineObject->getArray("kernels") : nullptr);
+    if (baselineKernels == nullptr) {
+        errs() << baselineFile << ": no kernels\n";
+        return 1;
+    }
+    unsigned int numRegressions = compareWithBaseline(*baselineKernels, results);
+    if (numRegressions > 0) {
+        outs() << numRegressions << " passes slower than the baseline\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,502 @@
+
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Program.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cmath>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace llvm;
+
+
+/* Scaling tests of the pass pipeline. Synthetic modules are generated with a shape that
+    stresses one part of the graph construction, for a growing size, and each one is
+    compiled by dfgraph-bench in its own process, so its peak memory can be measured too.
+    The results are written as CSV together with a gnuplot script that plots them, and the
+    growth of the time with the size is printed, to find the corners that are not linear.
+
+    Shapes:
+        blocks   chain of if-then-else diamonds, size BBs
+        loops    loop nest size levels deep, with an accumulator
+        phis     a BB with size predecessors and two phis that wide
+        live     size values live through a few diamonds and used at the end
+        fanout   an argument used by size operators
+        calls    chain of size functions, each calling the previous one
+        callers  one function called from size places
+
+    Usage: dfgraph-stress -load <pass.so>... [-shapes blocks,phis] [-sizes 100,200]
+        [-bench dfgraph-bench] [-output-dir dir] [-o stress.csv] [-generate-only] */
+
+
+static cl::list <string> shapes("shapes", cl::desc("Shapes of the modules generated"),
+    cl::CommaSeparated);
+
+static cl::list <unsigned int> sizes("sizes", cl::desc("Sizes of each shape"),
+    cl::CommaSeparated);
+
+static cl::list <string> plugins("load", cl::desc("Passes given to dfgraph-bench"),
+    cl::value_desc("pluginfilename"));
+
+static cl::opt <string> benchProgram("bench",
+    cl::desc("dfgraph-bench program, by default the one next to this program"));
+
+static cl::opt <unsigned int> repetitions("repetitions",
+    cl::desc("Times each module is compiled, the median time is reported"), cl::init(3));
+
+static cl::opt <string> outputDir("output-dir",
+    cl::desc("Directory where the modules and their graphs are written"), cl::init("stress"));
+
+static cl::opt <string> resultsFile("o", cl::desc("File with the results in CSV"),
+    cl::value_desc("filename"), cl::init("stress.csv"));
+
+static cl::opt <bool> generateOnly("generate-only",
+    cl::desc("Only write the modules, without compiling them"), cl::init(false));
+
+
+static const char* allShapes[] = {"blocks", "loops", "phis", "live", "fanout", "calls",
+    "callers"};
+static const unsigned int defaultSizes[] = {50, 100, 200, 400};
+static const char* passNames[] = {"GetElemPtrPass", "LiveVarsPass", "DFGraphPass"};
+static const unsigned int numPasses = 3;
+
+
+/* ===== Generation of the modules ===== */
+
+
+// All the shapes build int stress(int n, int x), as the entry of the module
+static Function* createStressFunction(Module& M, const string& name = "stress") {
+    Type* intType = Type::getInt32Ty(M.getContext());
+    FunctionType* type = FunctionType::get(intType, {intType, intType}, false);
+    Function* F = Function::Create(type, Function::ExternalLinkage, name, M);
+    F->getArg(0)->setName("n");
+    F->getArg(1)->setName("x");
+    return F;
+}
+
+// Chain of diamonds, each choosing between an add and a sub of the previous value
+static void generateBlocks(Module& M, unsigned int size) {
+    Function* F = createStressFunction(M);
+    LLVMContext& context = M.getContext();
+    IRBuilder <> builder(BasicBlock::Create(context, "entry", F));
+    Value* value = F->getArg(1);
+    unsigned int numDiamonds = max(1u, (size - 1) / 3);
+    for (unsigned int i = 0; i < numDiamonds; ++i) {
+        BasicBlock* thenBB = BasicBlock::Create(context, "then" + to_string(i), F);
+        BasicBlock* elseBB = BasicBlock::Create(context, "else" + to_string(i), F);
+        BasicBlock* joinBB = BasicBlock::Create(context, "join" + to_string(i), F);
+        Value* condition = builder.CreateICmpSLT(value, builder.getInt32(i));
+        builder.CreateCondBr(condition, thenBB, elseBB);
+        builder.SetInsertPoint(thenBB);
+        Value* thenValue = builder.CreateAdd(value, builder.getInt32(i + 1));
+        builder.CreateBr(joinBB);
+        builder.SetInsertPoint(elseBB);
+        Value* elseValue = builder.CreateSub(value, F->getArg(0));
+        builder.CreateBr(joinBB);
+        builder.SetInsertPoint(joinBB);
+        PHINode* phi = builder.CreatePHI(builder.getInt32Ty(), 2);
+        phi->addIncoming(thenValue, thenBB);
+        phi->addIncoming(elseValue, elseBB);
+        value = phi;
+    }
+    builder.CreateRet(value);
+}
+
+/* Loop nest in rotated form, as the loops reach the pass after -O1: every level enters the
+    next one unconditionally and its latch decides whether to iterate again or to go to the
+    latch of the outer level, carrying the accumulator */
+static void generateLoops(Module& M, unsigned int size) {
+    Function* F = createStressFunction(M);
+    LLVMContext& context = M.getContext();
+    unsigned int depth = max(1u, size);
+    BasicBlock* entryBB = BasicBlock::Create(context, "entry", F);
+    vector <BasicBlock*> headers(depth);
+    vector <BasicBlock*> latches(depth);
+    for (unsigned int i = 0; i < depth; ++i) {
+        headers[i] = BasicBlock::Create(context, "header" + to_string(i), F);
+    }
+    BasicBlock* bodyBB = BasicBlock::Create(context, "body", F);
+    for (unsigned int i = depth; i > 0; --i) {
+        latches[i - 1] = BasicBlock::Create(context, "latch" + to_string(i - 1), F);
+    }
+    BasicBlock* exitBB = BasicBlock::Create(context, "exit", F);
+    IRBuilder <> builder(entryBB);
+    builder.CreateBr(headers[0]);
+
+    vector <PHINode*> inductions(depth);
+    vector <PHINode*> accumulators(depth);
+    BasicBlock* predBB = entryBB;
+    Value* accumulator = F->getArg(1);
+    for (unsigned int i = 0; i < depth; ++i) {
+        builder.SetInsertPoint(headers[i]);
+        inductions[i] = builder.CreatePHI(builder.getInt32Ty(), 2);
+        inductions[i]->addIncoming(builder.getInt32(0), predBB);
+        accumulators[i] = builder.CreatePHI(builder.getInt32Ty(), 2);
+        accumulators[i]->addIncoming(accumulator, predBB);
+        builder.CreateBr(i + 1 < depth ? headers[i + 1] : bodyBB);
+        predBB = headers[i];
+        accumulator = accumulators[i];
+    }
+    builder.SetInsertPoint(bodyBB);
+    Value* bodyValue = builder.CreateAdd(accumulators[depth - 1], inductions[depth - 1]);
+    builder.CreateBr(latches[depth - 1]);
+    for (unsigned int i = depth; i > 0; --i) {
+        builder.SetInsertPoint(latches[i - 1]);
+        Value* next = builder.CreateAdd(inductions[i - 1], builder.getInt32(1));
+        Value* condition = builder.CreateICmpSLT(next, F->getArg(0));
+        builder.CreateCondBr(condition, headers[i - 1], (i > 1 ? latches[i - 2] : exitBB));
+        inductions[i - 1]->addIncoming(next, latches[i - 1]);
+        // Every level leaves with the last value of the innermost one
+        accumulators[i - 1]->addIncoming(bodyValue, latches[i - 1]);
+    }
+    builder.SetInsertPoint(exitBB);
+    builder.CreateRet(bodyValue);
+}
+
+// Chain of tests leaving to the same BB, which merges a computed value and a constant
+static void generatePhis(Module& M, unsigned int size) {
+    Function* F = createStressFunction(M);
+    LLVMContext& context = M.getContext();
+    unsigned int width = max(2u, size);
+    BasicBlock* entryBB = BasicBlock::Create(context, "entry", F);
+    BasicBlock* mergeBB = BasicBlock::Create(context, "merge", F);
+    IRBuilder <> builder(entryBB);
+    vector <pair <Value*, BasicBlock*> > incomings;
+    for (unsigned int i = 0; i < width; ++i) {
+        BasicBlock* caseBB = BasicBlock::Create(context, "case" + to_string(i), F, mergeBB);
+        builder.CreateBr(caseBB);
+        builder.SetInsertPoint(caseBB);
+        incomings.push_back(make_pair(builder.CreateMul(F->getArg(1),
+            builder.getInt32(i + 1)), caseBB));
+        if (i + 1 == width) break;
+        // The last case falls into the merge unconditionally
+        BasicBlock* testBB = BasicBlock::Create(context, "test" + to_string(i), F, mergeBB);
+        Value* condition = builder.CreateICmpEQ(F->getArg(0), builder.getInt32(i));
+        builder.CreateCondBr(condition, mergeBB, testBB);
+        builder.SetInsertPoint(testBB);
+    }
+    builder.CreateBr(mergeBB);
+    builder.SetInsertPoint(mergeBB);
+    PHINode* values = builder.CreatePHI(builder.getInt32Ty(), width);
+    PHINode* constants = builder.CreatePHI(builder.getInt32Ty(), width);
+    for (unsigned int i = 0; i < width; ++i) {
+        values->addIncoming(incomings[i].first, incomings[i].second);
+        constants->addIncoming(builder.getInt32(i), incomings[i].second);
+    }
+    builder.CreateRet(builder.CreateAdd(values, constants));
+}
+
+/* Values defined at the entry and only used after a few diamonds, so all of them are live
+    in and out of every BB in between */
+static void generateLive(Module& M, unsigned int size) {
+    Function* F = createStressFunction(M);
+    LLVMContext& context = M.getContext();
+    const unsigned int numDiamonds = 4;
+    IRBuilder <> builder(BasicBlock::Create(context, "entry", F));
+    vector <Value*> values;
+    for (unsigned int i = 0; i < max(1u, size); ++i) {
+        values.push_back(builder.CreateAdd(F->getArg(1), builder.getInt32(i)));
+    }
+    Value* value = F->getArg(0);
+    for (unsigned int i = 0; i < numDiamonds; ++i) {
+        BasicBlock* thenBB = BasicBlock::Create(context, "then" + to_string(i), F);
+        BasicBlock* joinBB = BasicBlock::Create(context, "join" + to_string(i), F);
+        BasicBlock* fromBB = builder.GetInsertBlock();
+        Value* condition = builder.CreateICmpSGT(value, builder.getInt32(i));
+        builder.CreateCondBr(condition, thenBB, joinBB);
+        builder.SetInsertPoint(thenBB);
+        Value* thenValue = builder.CreateSub(value, builder.getInt32(1));
+        builder.CreateBr(joinBB);
+        builder.SetInsertPoint(joinBB);
+        PHINode* phi = builder.CreatePHI(builder.getInt32Ty(), 2);
+        phi->addIncoming(thenValue, thenBB);
+        phi->addIncoming(value, fromBB);
+        value = phi;
+    }
+    for (unsigned int i = 0; i < values.size(); ++i) {
+        value = builder.CreateXor(value, values[i]);
+    }
+    builder.CreateRet(value);
+}
+
+// One value used by many operators, so it needs a wide fork
+static void generateFanout(Module& M, unsigned int size) {
+    Function* F = createStressFunction(M);
+    IRBuilder <> builder(BasicBlock::Create(M.getContext(), "entry", F));
+    Value* value = F->getArg(0);
+    for (unsigned int i = 0; i < max(1u, size); ++i) {
+        value = builder.CreateAdd(value, builder.CreateMul(F->getArg(1),
+            builder.getInt32(i + 1)));
+    }
+    builder.CreateRet(value);
+}
+
+// Each function calls the previous one once, so there are no call wrappers
+static void generateCalls(Module& M, unsigned int size) {
+    Type* intType = Type::getInt32Ty(M.getContext());
+    FunctionType* type = FunctionType::get(intType, {intType}, false);
+    Function* previous = nullptr;
+    for (unsigned int i = 0; i < max(1u, size); ++i) {
+        Function* F = Function::Create(type, Function::ExternalLinkage,
+            "chain" + to_string(i), M);
+        F->getArg(0)->setName("a");
+        IRBuilder <> builder(BasicBlock::Create(M.getContext(), "entry", F));
+        Value* value = F->getArg(0);
+        if (previous != nullptr) value = builder.CreateCall(previous, {value});
+        builder.CreateRet(builder.CreateAdd(value, builder.getInt32(i + 1)));
+        previous = F;
+    }
+    Function* F = createStressFunction(M);
+    IRBuilder <> builder(BasicBlock::Create(M.getContext(), "entry", F));
+    Value* value = builder.CreateCall(previous, {F->getArg(1)});
+    builder.CreateRet(builder.CreateAdd(value, F->getArg(0)));
+}
+
+// A function with a branch called from many places, going through a call wrapper
+static void generateCallers(Module& M, unsigned int size) {
+    LLVMContext& context = M.getContext();
+    Function* callee = createStressFunction(M, "mac");
+    IRBuilder <> builder(BasicBlock::Create(context, "entry", callee));
+    BasicBlock* clampBB = BasicBlock::Create(context, "clamp", callee);
+    BasicBlock* exitBB = BasicBlock::Create(context, "exit", callee);
+    Value* product = builder.CreateMul(callee->getArg(0), callee->getArg(1));
+    Value* value = builder.CreateAdd(product, builder.getInt32(1));
+    builder.CreateCondBr(builder.CreateICmpSGT(value, builder.getInt32(1000)), clampBB,
+        exitBB);
+    builder.SetInsertPoint(clampBB);
+    builder.CreateBr(exitBB);
+    builder.SetInsertPoint(exitBB);
+    PHINode* result = builder.CreatePHI(builder.getInt32Ty(), 2);
+    result->addIncoming(builder.getInt32(1000), clampBB);
+    result->addIncoming(value, &callee->getEntryBlock());
+    builder.CreateRet(result);
+
+    Function* F = createStressFunction(M);
+    builder.SetInsertPoint(BasicBlock::Create(context, "entry", F));
+    value = F->getArg(1);
+    for (unsigned int i = 0; i < max(1u, size); ++i) {
+        value = builder.CreateCall(callee, {value, builder.CreateAdd(F->getArg(0),
+            builder.getInt32(i))});
+    }
+    builder.CreateRet(value);
+}
+
+static bool generateModule(const string& shape, unsigned int size, Module& M) {
+    if (shape == "blocks") generateBlocks(M, size);
+    else if (shape == "loops") generateLoops(M, size);
+    else if (shape == "phis") generatePhis(M, size);
+    else if (shape == "live") generateLive(M, size);
+    else if (shape == "fanout") generateFanout(M, size);
+    else if (shape == "calls") generateCalls(M, size);
+    else if (shape == "callers") generateCallers(M, size);
+    else return false;
+    assert(!verifyModule(M, &errs()) && "Wrong module generated");
+    return true;
+}
+
+
+/* ===== Measurements ===== */
+
+
+struct StressResult
+{
+    string shape;
+    unsigned int size;
+    int64_t numBBs;
+    int64_t numInstructions;
+    int64_t numBlocks;
+    int64_t numChannels;
+    double times[numPasses];
+    // In KiB, of the whole process
+    uint64_t peakMemory;
+};
+
+
+static bool runBench(const string& moduleFile, StressResult& result) {
+    SmallString <128> jsonFile(moduleFile);
+    sys::path::replace_extension(jsonFile, "json");
+    string repetitionsText = to_string(repetitions);
+    vector <StringRef> args;
+    args.push_back(benchProgram);
+    for (unsigned int i = 0; i < plugins.size(); ++i) {
+        args.push_back("-load");
+        args.push_back(plugins[i]);
+    }
+    args.push_back("-repetitions");
+    args.push_back(repetitionsText);
+    args.push_back("-output-dir");
+    args.push_back(outputDir);
+    args.push_back("-o");
+    args.push_back(jsonFile);
+    args.push_back(moduleFile);
+    // The table of dfgraph-bench is not needed, its errors are
+    Optional <StringRef> redirects[] = {None, StringRef(""), None};
+    string error;
+    Optional <sys::ProcessStatistics> statistics;
+    int status = sys::ExecuteAndWait(benchProgram, args, None, redirects, 0, 0, &error,
+        nullptr, &statistics);
+    if (status != 0) {
+        errs() << moduleFile << ": dfgraph-bench failed " << error << '\n';
+        return false;
+    }
+    result.peakMemory = statistics ? statistics->PeakMemory : 0;
+
+    ErrorOr <unique_ptr <MemoryBuffer> > text = MemoryBuffer::getFile(jsonFile);
+    if (!text) return false;
+    Expected <json::Value> results = json::parse((*text)->getBuffer());
+    if (!results) {
+        errs() << jsonFile << ": " << toString(results.takeError()) << '\n';
+        return false;
+    }
+    const json::Array* kernels = results->getAsObject()->getArray("kernels");
+    const json::Object* kernel = (*kernels)[0].getAsObject();
+    result.numBBs = kernel->getInteger("BBs").getValueOr(0);
+    result.numInstructions = kernel->getInteger("instructions").getValueOr(0);
+    const json::Object* graph = kernel->getObject("graph");
+    result.numBlocks = graph->getInteger("blocks").getValueOr(0);
+    result.numChannels = graph->getInteger("channels").getValueOr(0);
+    const json::Object* times = kernel->getObject("timeMs");
+    for (unsigned int i = 0; i < numPasses; ++i) {
+        result.times[i] = times->getObject(passNames[i])->getNumber("median").getValueOr(0);
+    }
+    return true;
+}
+
+// Exponent k of time ~ size^k between two consecutive sizes, 2 is quadratic
+static double getGrowth(double value, double previousValue, int64_t size,
+    int64_t previousSize)
+{
+    if (value <= 0 or previousValue <= 0 or size == previousSize) return 0;
+    return log(value / previousValue) / log((double)size / previousSize);
+}
+
+static void writePlotScript(const string& csvFile, const vector <string>& shapeNames) {
+    SmallString <128> scriptFile(csvFile);
+    sys::path::replace_extension(scriptFile, "gp");
+    error_code error;
+    raw_fd_ostream file(scriptFile, error);
+    if (error) {
+        errs() << "Cannot write " << scriptFile << ": " << error.message() << '\n';
+        return;
+    }
+    // One line per shape, log-log so the slope is the growth
+    file << "# gnuplot " << sys::path::filename(scriptFile) << "\n";
+    file << "set datafile separator ','\n";
+    file << "set terminal pngcairo size 1200,500\n";
+    file << "set logscale xy\n";
+    file << "set key left top\n";
+    file << "set xlabel 'size'\n";
+    file << "shapes = '";
+    for (unsigned int i = 0; i < shapeNames.size(); ++i) {
+        file << (i > 0 ? " " : "") << shapeNames[i];
+    }
+    file << "'\n";
+    file << "set output '" << sys::path::stem(csvFile) << ".png'\n";
+    file << "set multiplot layout 1,2\n";
+    file << "set ylabel 'DFGraphPass ms'\n";
+    file << "plot for [s in shapes] '" << sys::path::filename(csvFile) <<
+        "' using (strcol(1) eq s ? $2 : NaN):9 with linespoints title s\n";
+    file << "set ylabel 'peak memory KiB'\n";
+    file << "plot for [s in shapes] '" << sys::path::filename(csvFile) <<
+        "' using (strcol(1) eq s ? $2 : NaN):12 with linespoints title s\n";
+    file << "unset multiplot\n";
+}
+
+int main(int argc, char* argv[]) {
+    cl::ParseCommandLineOptions(argc, argv, "Scaling tests of DFGraphPass\n");
+    vector <string> shapeNames(shapes.begin(), shapes.end());
+    if (shapeNames.empty()) shapeNames.assign(begin(allShapes), end(allShapes));
+    vector <unsigned int> shapeSizes(sizes.begin(), sizes.end());
+    if (shapeSizes.empty()) shapeSizes.assign(begin(defaultSizes), end(defaultSizes));
+    if (repetitions == 0) repetitions = 1;
+    if (benchProgram.empty()) {
+        SmallString <128> program(sys::path::parent_path(
+            sys::fs::getMainExecutable(argv[0], (void*)&main)));
+        sys::path::append(program, "dfgraph-bench");
+        benchProgram = program.str().str();
+    }
+    sys::fs::create_directories(outputDir);
+
+    vector <StressResult> results;
+    for (unsigned int i = 0; i < shapeNames.size(); ++i) {
+        for (unsigned int j = 0; j < shapeSizes.size(); ++j) {
+            LLVMContext context;
+            string name = shapeNames[i] + "_" + to_string(shapeSizes[j]);
+            Module M(name, context);
+            if (!generateModule(shapeNames[i], shapeSizes[j], M)) {
+                errs() << "Unknown shape " << shapeNames[i] << '\n';
+                return 1;
+            }
+            SmallString <128> moduleFile(outputDir);
+            sys::path::append(moduleFile, name + ".ll");
+            error_code error;
+            raw_fd_ostream file(moduleFile, error);
+            if (error) {
+                errs() << "Cannot write " << moduleFile << ": " << error.message() << '\n';
+                return 1;
+            }
+            M.print(file, nullptr);
+            file.close();
+            if (generateOnly) continue;
+
+            StressResult result;
+            result.shape = shapeNames[i];
+            result.size = shapeSizes[j];
+            if (!runBench(moduleFile.str().str(), result)) return 1;
+            outs() << format("%-8s %6u %6lld BB %7lld blocks %7lld channels %10.2f ms %8llu KiB",
+                result.shape.c_str(), result.size, (long long)result.numBBs,
+                (long long)result.numBlocks, (long long)result.numChannels,
+                result.times[numPasses - 1], (unsigned long long)result.peakMemory);
+            if (j > 0) {
+                const StressResult& previous = results.back();
+                // Against the graph too, as some shapes have graphs that are not linear
+                outs() << format("  growth %4.2f, %4.2f in blocks",
+                    getGrowth(result.times[numPasses - 1], previous.times[numPasses - 1],
+                        result.size, previous.size),
+                    getGrowth(result.times[numPasses - 1], previous.times[numPasses - 1],
+                        result.numBlocks, previous.numBlocks));
+            }
+            outs() << '\n';
+            results.push_back(result);
+        }
+    }
+    if (generateOnly) return 0;
+
+    error_code error;
+    raw_fd_ostream file(resultsFile, error);
+    if (error) {
+        errs() << "Cannot write " << resultsFile << ": " << error.message() << '\n';
+        return 1;
+    }
+    file << "shape,size,BBs,instructions,blocks,channels";
+    for (unsigned int i = 0; i < numPasses; ++i) file << ',' << passNames[i] << "Ms";
+    file << ",totalMs,DFGraphPassMsPerBlock,peakMemoryKiB\n";
+    for (unsigned int i = 0; i < results.size(); ++i) {
+        const StressResult& result = results[i];
+        double total = 0;
+        file << result.shape << ',' << result.size << ',' << result.numBBs << ',' <<
+            result.numInstructions << ',' << result.numBlocks << ',' << result.numChannels;
+        for (unsigned int j = 0; j < numPasses; ++j) {
+            file << ',' << format("%.4f", result.times[j]);
+            total += result.times[j];
+        }
+        file << ',' << format("%.4f", total) << ',' <<
+            format("%.6f", result.times[numPasses - 1] / max<int64_t>(1, result.numBlocks)) <<
+            ',' << result.peakMemory << '\n';
+    }
+    file.close();
+    writePlotScript(resultsFile, shapeNames);
+    return 0;
+}
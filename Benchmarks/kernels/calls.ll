@@ -0,0 +1,77 @@
+; Call-heavy code: mac and clamp are called from several places, so both get a
+; call wrapper, and scale calls both from inside another function. n > 1
+;
+;   int mac(int acc, int a, int b) { return acc + a * b; }
+;
+;   int clamp(int v, int lo, int hi) {
+;       if (v < lo) return lo;
+;       return v > hi ? hi : v;
+;   }
+;
+;   int scale(int v) { return clamp(mac(0, v, 3), -100, 100); }
+;
+;   int calls(int* x, int n) {
+;       int acc = 0;
+;       for (int i = 0; i < n - 1; ++i) {
+;           acc = mac(acc, x[i], x[i + 1]);
+;           acc = clamp(acc, -1000, 1000);
+;       }
+;       return scale(acc) + scale(n) + mac(acc, n, n);
+;   }
+
+define i32 @mac(i32 %acc, i32 %a, i32 %b) {
+entry:
+  %prod = mul nsw i32 %a, %b
+  %res = add nsw i32 %acc, %prod
+  ret i32 %res
+}
+
+define i32 @clamp(i32 %v, i32 %lo, i32 %hi) {
+entry:
+  %below = icmp slt i32 %v, %lo
+  br i1 %below, label %exit, label %upper
+
+upper:
+  %above = icmp sgt i32 %v, %hi
+  %top = select i1 %above, i32 %hi, i32 %v
+  br label %exit
+
+exit:
+  %res = phi i32 [ %lo, %entry ], [ %top, %upper ]
+  ret i32 %res
+}
+
+define i32 @scale(i32 %v) {
+entry:
+  %m = call i32 @mac(i32 0, i32 %v, i32 3)
+  %c = call i32 @clamp(i32 %m, i32 -100, i32 100)
+  ret i32 %c
+}
+
+define i32 @calls(i32* %x, i32 %n) {
+entry:
+  %last = add nsw i32 %n, -1
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %acc = phi i32 [ 0, %entry ], [ %acc.next, %loop ]
+  %i64 = sext i32 %i to i64
+  %p0 = getelementptr inbounds i32, i32* %x, i64 %i64
+  %x0 = load i32, i32* %p0, align 4
+  %p1 = getelementptr inbounds i32, i32* %p0, i64 1
+  %x1 = load i32, i32* %p1, align 4
+  %m = call i32 @mac(i32 %acc, i32 %x0, i32 %x1)
+  %acc.next = call i32 @clamp(i32 %m, i32 -1000, i32 1000)
+  %i.next = add nuw nsw i32 %i, 1
+  %cond = icmp slt i32 %i.next, %last
+  br i1 %cond, label %loop, label %exit
+
+exit:
+  %s0 = call i32 @scale(i32 %acc.next)
+  %s1 = call i32 @scale(i32 %n)
+  %s2 = call i32 @mac(i32 %acc.next, i32 %n, i32 %n)
+  %t = add nsw i32 %s0, %s1
+  %r = add nsw i32 %t, %s2
+  ret i32 %r
+}
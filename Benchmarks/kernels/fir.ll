@@ -0,0 +1,62 @@
+; FIR filter of 8 taps with constant coefficients, with the taps unrolled.
+; x has n + 7 samples and n > 0
+;
+;   int fir(int* x, int* y, int n) {
+;       const int h[8] = {3, -5, 12, 31, 31, 12, -5, 3};
+;       for (int i = 0; i < n; ++i) {
+;           int acc = 0;
+;           for (int t = 0; t < 8; ++t)
+;               acc += h[t] * x[i + t];
+;           y[i] = acc >> 6;
+;       }
+;       return y[n - 1];
+;   }
+
+define i32 @fir(i32* %x, i32* %y, i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %p0 = getelementptr inbounds i32, i32* %x, i64 %i
+  %x0 = load i32, i32* %p0, align 4
+  %p1 = getelementptr inbounds i32, i32* %p0, i64 1
+  %x1 = load i32, i32* %p1, align 4
+  %p2 = getelementptr inbounds i32, i32* %p0, i64 2
+  %x2 = load i32, i32* %p2, align 4
+  %p3 = getelementptr inbounds i32, i32* %p0, i64 3
+  %x3 = load i32, i32* %p3, align 4
+  %p4 = getelementptr inbounds i32, i32* %p0, i64 4
+  %x4 = load i32, i32* %p4, align 4
+  %p5 = getelementptr inbounds i32, i32* %p0, i64 5
+  %x5 = load i32, i32* %p5, align 4
+  %p6 = getelementptr inbounds i32, i32* %p0, i64 6
+  %x6 = load i32, i32* %p6, align 4
+  %p7 = getelementptr inbounds i32, i32* %p0, i64 7
+  %x7 = load i32, i32* %p7, align 4
+  %m0 = mul nsw i32 %x0, 3
+  %m1 = mul nsw i32 %x1, -5
+  %m2 = mul nsw i32 %x2, 12
+  %m3 = mul nsw i32 %x3, 31
+  %m4 = mul nsw i32 %x4, 31
+  %m5 = mul nsw i32 %x5, 12
+  %m6 = mul nsw i32 %x6, -5
+  %m7 = mul nsw i32 %x7, 3
+  %s0 = add nsw i32 %m0, %m1
+  %s1 = add nsw i32 %m2, %m3
+  %s2 = add nsw i32 %m4, %m5
+  %s3 = add nsw i32 %m6, %m7
+  %s4 = add nsw i32 %s0, %s1
+  %s5 = add nsw i32 %s2, %s3
+  %acc = add nsw i32 %s4, %s5
+  %out = ashr i32 %acc, 6
+  %y.ptr = getelementptr inbounds i32, i32* %y, i64 %i
+  store i32 %out, i32* %y.ptr, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %n64 = sext i32 %n to i64
+  %cond = icmp slt i64 %i.next, %n64
+  br i1 %cond, label %loop, label %exit
+
+exit:
+  ret i32 %out
+}
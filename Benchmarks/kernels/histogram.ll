@@ -0,0 +1,47 @@
+; Weighted histogram of 256 bins, where the high values count twice. n > 0
+;
+;   int histogram(int* data, int* hist, int n) {
+;       for (int i = 0; i < n; ++i) {
+;           int v = data[i] & 255;
+;           int w;
+;           if (v > 127) w = 2;
+;           else w = 1;
+;           hist[v] = hist[v] + w;
+;       }
+;       return hist[0];
+;   }
+
+define i32 @histogram(i32* %data, i32* %hist, i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %update ]
+  %i64 = sext i32 %i to i64
+  %d.ptr = getelementptr inbounds i32, i32* %data, i64 %i64
+  %d = load i32, i32* %d.ptr, align 4
+  %v = and i32 %d, 255
+  %high = icmp sgt i32 %v, 127
+  br i1 %high, label %heavy, label %light
+
+heavy:
+  br label %update
+
+light:
+  br label %update
+
+update:
+  %w = phi i32 [ 2, %heavy ], [ 1, %light ]
+  %v64 = zext i32 %v to i64
+  %h.ptr = getelementptr inbounds i32, i32* %hist, i64 %v64
+  %h = load i32, i32* %h.ptr, align 4
+  %h.next = add nsw i32 %h, %w
+  store i32 %h.next, i32* %h.ptr, align 4
+  %i.next = add nuw nsw i32 %i, 1
+  %cond = icmp slt i32 %i.next, %n
+  br i1 %cond, label %loop, label %exit
+
+exit:
+  %r = load i32, i32* %hist, align 4
+  ret i32 %r
+}
@@ -0,0 +1,62 @@
+; Matrix multiply of n x n matrices stored by rows, with n > 0
+;
+;   int matmul(int* A, int* B, int* C, int n) {
+;       for (int i = 0; i < n; ++i)
+;           for (int j = 0; j < n; ++j) {
+;               int acc = 0;
+;               for (int k = 0; k < n; ++k)
+;                   acc += A[i*n + k] * B[k*n + j];
+;               C[i*n + j] = acc;
+;           }
+;       return C[0];
+;   }
+
+define i32 @matmul(i32* %A, i32* %B, i32* %C, i32 %n) {
+entry:
+  br label %for.i
+
+for.i:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %for.i.latch ]
+  %row.i = mul nsw i32 %i, %n
+  br label %for.j
+
+for.j:
+  %j = phi i32 [ 0, %for.i ], [ %j.next, %for.j.latch ]
+  br label %for.k
+
+for.k:
+  %k = phi i32 [ 0, %for.j ], [ %k.next, %for.k ]
+  %acc = phi i32 [ 0, %for.j ], [ %acc.next, %for.k ]
+  %a.idx = add nsw i32 %row.i, %k
+  %a.idx64 = sext i32 %a.idx to i64
+  %a.ptr = getelementptr inbounds i32, i32* %A, i64 %a.idx64
+  %a = load i32, i32* %a.ptr, align 4
+  %row.k = mul nsw i32 %k, %n
+  %b.idx = add nsw i32 %row.k, %j
+  %b.idx64 = sext i32 %b.idx to i64
+  %b.ptr = getelementptr inbounds i32, i32* %B, i64 %b.idx64
+  %b = load i32, i32* %b.ptr, align 4
+  %prod = mul nsw i32 %a, %b
+  %acc.next = add nsw i32 %acc, %prod
+  %k.next = add nuw nsw i32 %k, 1
+  %k.cond = icmp slt i32 %k.next, %n
+  br i1 %k.cond, label %for.k, label %for.j.latch
+
+for.j.latch:
+  %c.idx = add nsw i32 %row.i, %j
+  %c.idx64 = sext i32 %c.idx to i64
+  %c.ptr = getelementptr inbounds i32, i32* %C, i64 %c.idx64
+  store i32 %acc.next, i32* %c.ptr, align 4
+  %j.next = add nuw nsw i32 %j, 1
+  %j.cond = icmp slt i32 %j.next, %n
+  br i1 %j.cond, label %for.j, label %for.i.latch
+
+for.i.latch:
+  %i.next = add nuw nsw i32 %i, 1
+  %i.cond = icmp slt i32 %i.next, %n
+  br i1 %i.cond, label %for.i, label %exit
+
+exit:
+  %r = load i32, i32* %C, align 4
+  ret i32 %r
+}
@@ -0,0 +1,103 @@
+; Batcher odd-even merge sorting network of 8 elements, sorted in place.
+; Each compare-exchange is a comparison and two selects, as after if-conversion
+;
+;   #define CE(a, b) { int lo = a < b ? a : b; int hi = a < b ? b : a; a = lo; b = hi; }
+;
+;   int sortnet(int* v) {
+;       int v0 = v[0], v1 = v[1], v2 = v[2], v3 = v[3];
+;       int v4 = v[4], v5 = v[5], v6 = v[6], v7 = v[7];
+;       CE(v0, v1) CE(v2, v3) CE(v4, v5) CE(v6, v7)
+;       CE(v0, v2) CE(v1, v3) CE(v4, v6) CE(v5, v7)
+;       CE(v1, v2) CE(v5, v6)
+;       CE(v0, v4) CE(v1, v5) CE(v2, v6) CE(v3, v7)
+;       CE(v2, v4) CE(v3, v5)
+;       CE(v1, v2) CE(v3, v4) CE(v5, v6)
+;       v[0] = v0; ...; v[7] = v7;
+;       return v0 + v7;
+;   }
+
+define i32 @sortnet(i32* %v) {
+entry:
+  %v0.0 = load i32, i32* %v, align 4
+  %p1 = getelementptr inbounds i32, i32* %v, i64 1
+  %v1.0 = load i32, i32* %p1, align 4
+  %p2 = getelementptr inbounds i32, i32* %v, i64 2
+  %v2.0 = load i32, i32* %p2, align 4
+  %p3 = getelementptr inbounds i32, i32* %v, i64 3
+  %v3.0 = load i32, i32* %p3, align 4
+  %p4 = getelementptr inbounds i32, i32* %v, i64 4
+  %v4.0 = load i32, i32* %p4, align 4
+  %p5 = getelementptr inbounds i32, i32* %v, i64 5
+  %v5.0 = load i32, i32* %p5, align 4
+  %p6 = getelementptr inbounds i32, i32* %v, i64 6
+  %v6.0 = load i32, i32* %p6, align 4
+  %p7 = getelementptr inbounds i32, i32* %v, i64 7
+  %v7.0 = load i32, i32* %p7, align 4
+  %lt0 = icmp slt i32 %v0.0, %v1.0
+  %v0.1 = select i1 %lt0, i32 %v0.0, i32 %v1.0
+  %v1.1 = select i1 %lt0, i32 %v1.0, i32 %v0.0
+  %lt1 = icmp slt i32 %v2.0, %v3.0
+  %v2.1 = select i1 %lt1, i32 %v2.0, i32 %v3.0
+  %v3.1 = select i1 %lt1, i32 %v3.0, i32 %v2.0
+  %lt2 = icmp slt i32 %v4.0, %v5.0
+  %v4.1 = select i1 %lt2, i32 %v4.0, i32 %v5.0
+  %v5.1 = select i1 %lt2, i32 %v5.0, i32 %v4.0
+  %lt3 = icmp slt i32 %v6.0, %v7.0
+  %v6.1 = select i1 %lt3, i32 %v6.0, i32 %v7.0
+  %v7.1 = select i1 %lt3, i32 %v7.0, i32 %v6.0
+  %lt4 = icmp slt i32 %v0.1, %v2.1
+  %v0.2 = select i1 %lt4, i32 %v0.1, i32 %v2.1
+  %v2.2 = select i1 %lt4, i32 %v2.1, i32 %v0.1
+  %lt5 = icmp slt i32 %v1.1, %v3.1
+  %v1.2 = select i1 %lt5, i32 %v1.1, i32 %v3.1
+  %v3.2 = select i1 %lt5, i32 %v3.1, i32 %v1.1
+  %lt6 = icmp slt i32 %v4.1, %v6.1
+  %v4.2 = select i1 %lt6, i32 %v4.1, i32 %v6.1
+  %v6.2 = select i1 %lt6, i32 %v6.1, i32 %v4.1
+  %lt7 = icmp slt i32 %v5.1, %v7.1
+  %v5.2 = select i1 %lt7, i32 %v5.1, i32 %v7.1
+  %v7.2 = select i1 %lt7, i32 %v7.1, i32 %v5.1
+  %lt8 = icmp slt i32 %v1.2, %v2.2
+  %v1.3 = select i1 %lt8, i32 %v1.2, i32 %v2.2
+  %v2.3 = select i1 %lt8, i32 %v2.2, i32 %v1.2
+  %lt9 = icmp slt i32 %v5.2, %v6.2
+  %v5.3 = select i1 %lt9, i32 %v5.2, i32 %v6.2
+  %v6.3 = select i1 %lt9, i32 %v6.2, i32 %v5.2
+  %lt10 = icmp slt i32 %v0.2, %v4.2
+  %v0.3 = select i1 %lt10, i32 %v0.2, i32 %v4.2
+  %v4.3 = select i1 %lt10, i32 %v4.2, i32 %v0.2
+  %lt11 = icmp slt i32 %v1.3, %v5.3
+  %v1.4 = select i1 %lt11, i32 %v1.3, i32 %v5.3
+  %v5.4 = select i1 %lt11, i32 %v5.3, i32 %v1.3
+  %lt12 = icmp slt i32 %v2.3, %v6.3
+  %v2.4 = select i1 %lt12, i32 %v2.3, i32 %v6.3
+  %v6.4 = select i1 %lt12, i32 %v6.3, i32 %v2.3
+  %lt13 = icmp slt i32 %v3.2, %v7.2
+  %v3.3 = select i1 %lt13, i32 %v3.2, i32 %v7.2
+  %v7.3 = select i1 %lt13, i32 %v7.2, i32 %v3.2
+  %lt14 = icmp slt i32 %v2.4, %v4.3
+  %v2.5 = select i1 %lt14, i32 %v2.4, i32 %v4.3
+  %v4.4 = select i1 %lt14, i32 %v4.3, i32 %v2.4
+  %lt15 = icmp slt i32 %v3.3, %v5.4
+  %v3.4 = select i1 %lt15, i32 %v3.3, i32 %v5.4
+  %v5.5 = select i1 %lt15, i32 %v5.4, i32 %v3.3
+  %lt16 = icmp slt i32 %v1.4, %v2.5
+  %v1.5 = select i1 %lt16, i32 %v1.4, i32 %v2.5
+  %v2.6 = select i1 %lt16, i32 %v2.5, i32 %v1.4
+  %lt17 = icmp slt i32 %v3.4, %v4.4
+  %v3.5 = select i1 %lt17, i32 %v3.4, i32 %v4.4
+  %v4.5 = select i1 %lt17, i32 %v4.4, i32 %v3.4
+  %lt18 = icmp slt i32 %v5.5, %v6.4
+  %v5.6 = select i1 %lt18, i32 %v5.5, i32 %v6.4
+  %v6.5 = select i1 %lt18, i32 %v6.4, i32 %v5.5
+  store i32 %v0.3, i32* %v, align 4
+  store i32 %v1.5, i32* %p1, align 4
+  store i32 %v2.6, i32* %p2, align 4
+  store i32 %v3.5, i32* %p3, align 4
+  store i32 %v4.5, i32* %p4, align 4
+  store i32 %v5.6, i32* %p5, align 4
+  store i32 %v6.5, i32* %p6, align 4
+  store i32 %v7.3, i32* %p7, align 4
+  %r = add nsw i32 %v0.3, %v7.3
+  ret i32 %r
+}
@@ -0,0 +1,61 @@
+; Jacobi 5-point stencil over the inner points of a n x m grid, with n, m > 2
+;
+;   int stencil(int* in, int* out, int n, int m) {
+;       for (int i = 1; i < n - 1; ++i)
+;           for (int j = 1; j < m - 1; ++j) {
+;               int c = i*m + j;
+;               out[c] = (4*in[c] + in[c-1] + in[c+1] + in[c-m] + in[c+m]) >> 3;
+;           }
+;       return out[m + 1];
+;   }
+
+define i32 @stencil(i32* %in, i32* %out, i32 %n, i32 %m) {
+entry:
+  %n.last = add nsw i32 %n, -1
+  %m.last = add nsw i32 %m, -1
+  %m64 = sext i32 %m to i64
+  br label %for.i
+
+for.i:
+  %i = phi i32 [ 1, %entry ], [ %i.next, %for.i.latch ]
+  %row = mul nsw i32 %i, %m
+  br label %for.j
+
+for.j:
+  %j = phi i32 [ 1, %for.i ], [ %j.next, %for.j ]
+  %c = add nsw i32 %row, %j
+  %c64 = sext i32 %c to i64
+  %center.ptr = getelementptr inbounds i32, i32* %in, i64 %c64
+  %center = load i32, i32* %center.ptr, align 4
+  %west.ptr = getelementptr inbounds i32, i32* %center.ptr, i64 -1
+  %west = load i32, i32* %west.ptr, align 4
+  %east.ptr = getelementptr inbounds i32, i32* %center.ptr, i64 1
+  %east = load i32, i32* %east.ptr, align 4
+  %m.neg = sub nsw i64 0, %m64
+  %north.ptr = getelementptr inbounds i32, i32* %center.ptr, i64 %m.neg
+  %north = load i32, i32* %north.ptr, align 4
+  %south.ptr = getelementptr inbounds i32, i32* %center.ptr, i64 %m64
+  %south = load i32, i32* %south.ptr, align 4
+  %center4 = shl nsw i32 %center, 2
+  %s0 = add nsw i32 %center4, %west
+  %s1 = add nsw i32 %east, %north
+  %s2 = add nsw i32 %s0, %s1
+  %s3 = add nsw i32 %s2, %south
+  %res = ashr i32 %s3, 3
+  %out.ptr = getelementptr inbounds i32, i32* %out, i64 %c64
+  store i32 %res, i32* %out.ptr, align 4
+  %j.next = add nuw nsw i32 %j, 1
+  %j.cond = icmp slt i32 %j.next, %m.last
+  br i1 %j.cond, label %for.j, label %for.i.latch
+
+for.i.latch:
+  %i.next = add nuw nsw i32 %i, 1
+  %i.cond = icmp slt i32 %i.next, %n.last
+  br i1 %i.cond, label %for.i, label %exit
+
+exit:
+  %r.idx = add nsw i64 %m64, 1
+  %r.ptr = getelementptr inbounds i32, i32* %out, i64 %r.idx
+  %r = load i32, i32* %r.ptr, align 4
+  ret i32 %r
+}
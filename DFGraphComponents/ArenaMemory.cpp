@@ -0,0 +1,73 @@
+#include "ArenaMemory.h"
+#include <cstddef>
+
+
+namespace DFGraphComp
+{
+
+
+/*
+ * =================================
+ *  Class ArenaMemory
+ * =================================
+*/
+
+
+thread_local ArenaMemory* ArenaMemory::current = nullptr;
+
+ArenaMemory::ArenaMemory() {
+    next = nullptr;
+    left = 0;
+    slabBytes = 0;
+    allocatedBytes = 0;
+}
+
+ArenaMemory::~ArenaMemory() {}
+
+void* ArenaMemory::allocate(size_t size, size_t align) {
+    assert(align <= alignof(max_align_t) && "Alignment not supported");
+    size_t padding = (align - (size_t)next % align) % align;
+    if (padding + size > left) {
+        if (slabBytes == 0) slabBytes = minSlabBytes;
+        else if (slabBytes < maxSlabBytes) slabBytes *= 2;
+        // The slabs come aligned from new, so a piece bigger than a slab gets its own
+        size_t bytes = size > slabBytes ? size : slabBytes;
+        slabs.push_back(unique_ptr <char[]>(new char[bytes]));
+        next = slabs.back().get();
+        left = bytes;
+        padding = 0;
+        allocatedBytes += bytes;
+    }
+    void* memory = next + padding;
+    next += padding + size;
+    left -= padding + size;
+    return memory;
+}
+
+void ArenaMemory::release() {
+    slabs.clear();
+    next = nullptr;
+    left = 0;
+    slabBytes = 0;
+    allocatedBytes = 0;
+}
+
+size_t ArenaMemory::getAllocatedBytes() {
+    return allocatedBytes;
+}
+
+ArenaMemory* ArenaMemory::getCurrent() {
+    return current;
+}
+
+ArenaMemory::Scope::Scope(ArenaMemory* memory) {
+    previous = current;
+    current = memory;
+}
+
+ArenaMemory::Scope::~Scope() {
+    current = previous;
+}
+
+
+} // Close namespace
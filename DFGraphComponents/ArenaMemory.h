@@ -0,0 +1,138 @@
+#ifndef ARENAMEMORY_H
+#define ARENAMEMORY_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <assert.h>
+
+using namespace std;
+
+namespace DFGraphComp
+{
+
+
+/* Memory of the ports, names and connections of the blocks of a graph. It is taken from
+    big slabs one piece after the other and no piece is given back on its own: all the
+    slabs go at once when the memory is released, without running any destructor */
+class ArenaMemory {
+
+public:
+
+    ArenaMemory();
+    ~ArenaMemory();
+
+    ArenaMemory(const ArenaMemory&) = delete;
+    ArenaMemory& operator = (const ArenaMemory&) = delete;
+
+    void* allocate(size_t size, size_t align);
+    void release();
+
+    size_t getAllocatedBytes();
+
+    /* Memory of the containers made while a block is created, so a block keeps all it
+        owns in the arena of its graph. It is nullptr out of the creation of a block, and
+        those containers use the heap */
+    static ArenaMemory* getCurrent();
+
+    // Makes a memory the current one of the thread while it lives
+    class Scope {
+
+    public:
+
+        Scope(ArenaMemory* memory);
+        ~Scope();
+
+    private:
+
+        ArenaMemory* previous;
+
+    };
+
+private:
+
+    // Bytes of the first slab, the next ones double until the one of the end
+    static const size_t minSlabBytes = 4096;
+    static const size_t maxSlabBytes = 1 << 20;
+
+    vector <unique_ptr <char[]> > slabs;
+    char* next;
+    size_t left;
+    size_t slabBytes;
+    size_t allocatedBytes;
+
+    static thread_local ArenaMemory* current;
+
+};
+
+
+/* Allocator of the containers of the blocks. Without a memory it uses the heap, and with
+    one it never gives anything back, the memory is released with the arena. The elements
+    that take an allocator get the one of their container, so the names of the ports of a
+    block end in the same arena as the block */
+template <typename T>
+class ArenaAllocator {
+
+public:
+
+    typedef T value_type;
+
+    ArenaAllocator() : memory(ArenaMemory::getCurrent()) {}
+    ArenaAllocator(ArenaMemory* memory) : memory(memory) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator <U>& allocator) : memory(allocator.getMemory()) {}
+
+    T* allocate(size_t n) {
+        if (memory == nullptr) return (T*)::operator new(n*sizeof(T));
+        return (T*)memory->allocate(n*sizeof(T), alignof(T));
+    }
+
+    void deallocate(T* pointer, size_t n) {
+        if (memory == nullptr) ::operator delete(pointer);
+    }
+
+    template <typename U, typename... Args>
+    void construct(U* pointer, Args&&... args) {
+        if constexpr (uses_allocator <U, ArenaAllocator>::value) {
+            ::new((void*)pointer) U(std::forward<Args>(args)..., *this);
+        }
+        else ::new((void*)pointer) U(std::forward<Args>(args)...);
+    }
+
+    /* A copy of a container goes where the containers are made at that moment, e.g. the
+        name of a port copied out of a block goes to the heap */
+    ArenaAllocator select_on_container_copy_construction() const {
+        return ArenaAllocator();
+    }
+
+    ArenaMemory* getMemory() const {
+        return memory;
+    }
+
+private:
+
+    ArenaMemory* memory;
+
+};
+
+template <typename T, typename U>
+bool operator == (const ArenaAllocator <T>& first, const ArenaAllocator <U>& second) {
+    return first.getMemory() == second.getMemory();
+}
+
+template <typename T, typename U>
+bool operator != (const ArenaAllocator <T>& first, const ArenaAllocator <U>& second) {
+    return first.getMemory() != second.getMemory();
+}
+
+typedef basic_string <char, char_traits <char>, ArenaAllocator <char> > ArenaString;
+
+template <typename T>
+using ArenaVector = vector <T, ArenaAllocator <T> >;
+
+
+} // Close namespace
+
+#endif // ARENAMEMORY_H
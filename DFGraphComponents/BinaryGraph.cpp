@@ -0,0 +1,336 @@
+
+#include "BinaryGraph.h"
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+namespace DFGraphComp
+{
+
+
+/*
+ * =================================
+ *  Class BinaryGraphWriter
+ * =================================
+*/
+
+
+BinaryGraphWriter::BinaryGraphWriter() {}
+
+BinaryGraphWriter::~BinaryGraphWriter() {}
+
+void BinaryGraphWriter::addFunction(FunctionGraph& graph) {
+    BinaryFunctionRecord function;
+    uint32_t functionId = functions.size();
+    function.name = addString(graph.getFunctionName());
+    function.defaultPortWidth = graph.getDefaultPortWidth();
+    string callLinking = graph.getCallLinking();
+    function.callLinking = callLinking.empty() ? binaryGraphNone : addString(callLinking);
+    string copyOf = graph.getCopyOf();
+    function.copyOf = copyOf.empty() ? binaryGraphNone : addString(copyOf);
+    function.firstBB = BBs.size();
+    function.numBBs = graph.getNumBBs();
+    function.firstNode = nodes.size();
+    for (unsigned int i = 0; i < graph.getNumBBs(); ++i) {
+        BBGraph& BB = graph.getBB(i);
+        BinaryBBRecord BBRecord;
+        BBRecord.name = addString(BB.getBBName());
+        BBRecord.function = functionId;
+        uint32_t BBId = BBs.size();
+        BBs.push_back(BBRecord);
+        const vector <Block*>& BBBlocks = BB.getBlocks();
+        for (unsigned int j = 0; j < BBBlocks.size(); ++j) {
+            addNode(BBBlocks[j], BBId, false);
+        }
+        const vector <Block*>& BBControlBlocks = BB.getControlBlocks();
+        for (unsigned int j = 0; j < BBControlBlocks.size(); ++j) {
+            addNode(BBControlBlocks[j], BBId, true);
+        }
+    }
+    vector <Block*> outerBlocks;
+    graph.getOuterBlocks(outerBlocks);
+    for (unsigned int i = 0; i < outerBlocks.size(); ++i) {
+        addNode(outerBlocks[i], binaryGraphNone, false);
+    }
+    function.numNodes = nodes.size() - function.firstNode;
+    function.firstEdge = 0;
+    function.numEdges = 0;
+    functions.push_back(function);
+}
+
+void BinaryGraphWriter::write(ostream& file) {
+    addEdges();
+    BinaryGraphHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, binaryGraphMagic, sizeof(header.magic));
+    header.version = binaryGraphVersion;
+    header.numFunctions = functions.size();
+    header.numBBs = BBs.size();
+    header.numNodes = nodes.size();
+    header.numPorts = ports.size();
+    header.numEdges = edges.size();
+    header.stringsSize = strings.size();
+    // The sections are written in order, so the offsets can be known beforehand
+    uint64_t offset = sizeof(header);
+    uint64_t* sectionOffsets[6] = {&header.functionsOffset, &header.BBsOffset,
+        &header.nodesOffset, &header.portsOffset, &header.edgesOffset, &header.stringsOffset};
+    uint64_t sectionSizes[6] = {functions.size()*sizeof(BinaryFunctionRecord),
+        BBs.size()*sizeof(BinaryBBRecord), nodes.size()*sizeof(BinaryNodeRecord),
+        ports.size()*sizeof(BinaryPortRecord), edges.size()*sizeof(BinaryEdgeRecord),
+        strings.size()};
+    for (unsigned int i = 0; i < 6; ++i) {
+        // Each section starts aligned to 8 bytes
+        offset = (offset + 7) / 8 * 8;
+        *sectionOffsets[i] = offset;
+        offset += sectionSizes[i];
+    }
+    file.write((const char*)&header, sizeof(header));
+    offset = sizeof(header);
+    writeSection(file, functions.data(), sectionSizes[0], offset);
+    writeSection(file, BBs.data(), sectionSizes[1], offset);
+    writeSection(file, nodes.data(), sectionSizes[2], offset);
+    writeSection(file, ports.data(), sectionSizes[3], offset);
+    writeSection(file, edges.data(), sectionSizes[4], offset);
+    writeSection(file, strings.data(), sectionSizes[5], offset);
+}
+
+uint32_t BinaryGraphWriter::addString(const string& text) {
+    unordered_map <string, uint32_t>::const_iterator it = stringOffsets.find(text);
+    if (it != stringOffsets.end()) return it->second;
+    uint32_t offset = strings.size();
+    strings.append(text);
+    strings.push_back('\0');
+    stringOffsets[text] = offset;
+    return offset;
+}
+
+void BinaryGraphWriter::addPort(const Port& port) {
+    BinaryPortRecord record;
+    memset(&record, 0, sizeof(record));
+    record.name = addString(port.getName());
+    record.type = port.getType();
+    record.width = port.getWidth();
+    record.delay = port.getDelay();
+    ports.push_back(record);
+}
+
+void BinaryGraphWriter::addNode(Block* block, uint32_t BB, bool control) {
+    BinaryNodeRecord node;
+    memset(&node, 0, sizeof(node));
+    node.name = addString(block->getBlockName());
+    node.BB = BB;
+    node.blockType = block->getBlockType();
+    node.opType = 0;
+    node.flags = (control ? BinaryNodeFlags::ControlNode : 0);
+    node.delay = block->getBlockDelay();
+    node.value = binaryGraphNone;
+    if (block->getBlockType() == BlockType::Operator_Block) {
+        Operator* op = (Operator*)block;
+        node.opType = op->getOpType();
+        node.latency = op->getLatency();
+        node.II = op->getII();
+    }
+    else if (block->getBlockType() == BlockType::Buffer_Block) {
+        Buffer* buffer = (Buffer*)block;
+        node.slots = buffer->getNumSlots();
+        if (buffer->isTransparent()) node.flags |= BinaryNodeFlags::TransparentBuffer;
+    }
+    else if (block->getBlockType() == BlockType::Constant_Block) {
+        node.value = addString(((ConstantInterf*)block)->getValueText());
+    }
+    else if (block->getBlockType() == BlockType::LSQ_Block) {
+        LSQ* queue = (LSQ*)block;
+        node.slots = queue->getDepth();
+        node.value = addString(queue->getGroupsText());
+    }
+    else if (block->getBlockType() == BlockType::Tagger_Block) {
+        node.slots = ((Tagger*)block)->getNumTags();
+    }
+    else if (block->getBlockType() == BlockType::Untagger_Block) {
+        node.slots = ((Untagger*)block)->getNumTags();
+    }
+    node.firstInPort = ports.size();
+    node.numInPorts = block->getNumInputPorts();
+    for (unsigned int i = 0; i < node.numInPorts; ++i) {
+        addPort(block->getInputPort(i));
+    }
+    node.firstOutPort = ports.size();
+    node.numOutPorts = block->getNumOutputPorts();
+    for (unsigned int i = 0; i < node.numOutPorts; ++i) {
+        addPort(block->getOutputPort(i));
+    }
+    node.firstEdge = 0;
+    node.numEdges = 0;
+    nodeIds[block] = nodes.size();
+    nodes.push_back(node);
+    blocks.push_back(block);
+}
+
+void BinaryGraphWriter::addEdges() {
+    edges.clear();
+    for (unsigned int i = 0; i < functions.size(); ++i) {
+        BinaryFunctionRecord& function = functions[i];
+        function.firstEdge = edges.size();
+        for (uint32_t j = function.firstNode; j < function.firstNode + function.numNodes; ++j) {
+            BinaryNodeRecord& node = nodes[j];
+            Block* block = blocks[j];
+            node.firstEdge = edges.size();
+            for (unsigned int k = 0; k < node.numOutPorts; ++k) {
+                pair <Block*, int> connection = block->getOutputConnection(k);
+                if (connection.first == nullptr or connection.second == -1) continue;
+                unordered_map <Block*, uint32_t>::const_iterator it =
+                    nodeIds.find(connection.first);
+                assert(it != nodeIds.end() && "Channel to a block not in the graph");
+                BinaryEdgeRecord edge;
+                edge.fromNode = j;
+                edge.fromPort = k;
+                edge.toNode = it->second;
+                edge.toPort = connection.second;
+                edge.width = block->getOutputPort(k).getWidth();
+                edges.push_back(edge);
+            }
+            node.numEdges = edges.size() - node.firstEdge;
+        }
+        function.numEdges = edges.size() - function.firstEdge;
+    }
+}
+
+void BinaryGraphWriter::writeSection(ostream& file, const void* data, uint64_t size,
+    uint64_t& offset)
+{
+    static const char padding[8] = {0};
+    uint64_t alignedOffset = (offset + 7) / 8 * 8;
+    file.write(padding, alignedOffset - offset);
+    file.write((const char*)data, size);
+    offset = alignedOffset + size;
+}
+
+
+/*
+ * =================================
+ *  Class BinaryGraphReader
+ * =================================
+*/
+
+
+BinaryGraphReader::BinaryGraphReader() {
+    data = nullptr;
+    size = 0;
+    header = nullptr;
+}
+
+BinaryGraphReader::~BinaryGraphReader() {
+    close();
+}
+
+bool BinaryGraphReader::open(const string& fileName) {
+    close();
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) < 0 or (size_t)fileStat.st_size < sizeof(BinaryGraphHeader)) {
+        ::close(fd);
+        return false;
+    }
+    size = fileStat.st_size;
+    void* memory = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping is kept after closing the file
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        size = 0;
+        return false;
+    }
+    data = (const char*)memory;
+    header = (const BinaryGraphHeader*)data;
+    if (memcmp(header->magic, binaryGraphMagic, sizeof(header->magic)) != 0 or
+        header->version != binaryGraphVersion or
+        !sectionFits(header->functionsOffset, header->numFunctions,
+            sizeof(BinaryFunctionRecord)) or
+        !sectionFits(header->BBsOffset, header->numBBs, sizeof(BinaryBBRecord)) or
+        !sectionFits(header->nodesOffset, header->numNodes, sizeof(BinaryNodeRecord)) or
+        !sectionFits(header->portsOffset, header->numPorts, sizeof(BinaryPortRecord)) or
+        !sectionFits(header->edgesOffset, header->numEdges, sizeof(BinaryEdgeRecord)) or
+        !sectionFits(header->stringsOffset, header->stringsSize, 1))
+    {
+        close();
+        return false;
+    }
+    functions = (const BinaryFunctionRecord*)(data + header->functionsOffset);
+    BBs = (const BinaryBBRecord*)(data + header->BBsOffset);
+    nodes = (const BinaryNodeRecord*)(data + header->nodesOffset);
+    ports = (const BinaryPortRecord*)(data + header->portsOffset);
+    edges = (const BinaryEdgeRecord*)(data + header->edgesOffset);
+    strings = data + header->stringsOffset;
+    return true;
+}
+
+void BinaryGraphReader::close() {
+    if (data != nullptr) {
+        munmap((void*)data, size);
+    }
+    data = nullptr;
+    size = 0;
+    header = nullptr;
+}
+
+uint32_t BinaryGraphReader::getNumFunctions() {
+    return header->numFunctions;
+}
+
+uint32_t BinaryGraphReader::getNumBBs() {
+    return header->numBBs;
+}
+
+uint32_t BinaryGraphReader::getNumNodes() {
+    return header->numNodes;
+}
+
+uint32_t BinaryGraphReader::getNumPorts() {
+    return header->numPorts;
+}
+
+uint32_t BinaryGraphReader::getNumEdges() {
+    return header->numEdges;
+}
+
+const BinaryFunctionRecord& BinaryGraphReader::getFunction(uint32_t index) {
+    assert(index < header->numFunctions && "Wrong function");
+    return functions[index];
+}
+
+const BinaryBBRecord& BinaryGraphReader::getBB(uint32_t index) {
+    assert(index < header->numBBs && "Wrong BB");
+    return BBs[index];
+}
+
+const BinaryNodeRecord& BinaryGraphReader::getNode(uint32_t index) {
+    assert(index < header->numNodes && "Wrong node");
+    return nodes[index];
+}
+
+const BinaryPortRecord& BinaryGraphReader::getPort(uint32_t index) {
+    assert(index < header->numPorts && "Wrong port");
+    return ports[index];
+}
+
+const BinaryEdgeRecord& BinaryGraphReader::getEdge(uint32_t index) {
+    assert(index < header->numEdges && "Wrong edge");
+    return edges[index];
+}
+
+const char* BinaryGraphReader::getString(uint32_t offset) {
+    assert(offset < header->stringsSize && "Wrong string");
+    return strings + offset;
+}
+
+bool BinaryGraphReader::sectionFits(uint64_t offset, uint64_t numRecords,
+    uint64_t recordSize)
+{
+    return offset % 8 == 0 and offset <= size and numRecords <= (size - offset) / recordSize;
+}
+
+
+} // Close namespace
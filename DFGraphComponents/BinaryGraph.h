@@ -0,0 +1,216 @@
+#ifndef BINARYGRAPH_H
+#define BINARYGRAPH_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <ostream>
+#include <assert.h>
+#include "Graph.h"
+
+using namespace std;
+
+namespace DFGraphComp
+{
+
+
+/* Binary version of the graphs printed in the DOT file, made to be mapped in memory
+    and walked without parsing. The file is a header followed by arrays of fixed-width
+    records (functions, BB, nodes, ports and channels) and a table with all the names.
+    Records refer to each other by their index in the array, and to names by their
+    offset in the string table. All the values are stored in the byte order of the
+    machine that writes the file */
+
+const char binaryGraphMagic[8] = {'D', 'F', 'G', 'R', 'A', 'P', 'H', '\0'};
+/* Version 2 stores the delays as floats, they were whole units before. Version 3 adds
+    the load-store queues, version 4 the taggers and untaggers, and version 5 how the
+    functions are linked with their calls */
+const uint32_t binaryGraphVersion = 5;
+// Used in the nodes that do not belong to any BB and in fields that do not apply
+const uint32_t binaryGraphNone = UINT32_MAX;
+
+struct BinaryGraphHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t numFunctions;
+    uint32_t numBBs;
+    uint32_t numNodes;
+    uint32_t numPorts;
+    uint32_t numEdges;
+    // Offsets in bytes from the beginning of the file
+    uint64_t functionsOffset;
+    uint64_t BBsOffset;
+    uint64_t nodesOffset;
+    uint64_t portsOffset;
+    uint64_t edgesOffset;
+    uint64_t stringsOffset;
+    uint64_t stringsSize;
+};
+
+struct BinaryFunctionRecord
+{
+    uint32_t name;
+    int32_t defaultPortWidth;
+    // Names of the calls attribute and of the function it is a copy of, or none
+    uint32_t callLinking;
+    uint32_t copyOf;
+    uint32_t firstBB;
+    uint32_t numBBs;
+    uint32_t firstNode;
+    uint32_t numNodes;
+    // Channels leaving the nodes of the function
+    uint32_t firstEdge;
+    uint32_t numEdges;
+};
+
+struct BinaryBBRecord
+{
+    uint32_t name;
+    uint32_t function;
+};
+
+enum BinaryNodeFlags {
+    ControlNode = 1, // Printed in the control subgraph of its BB
+    TransparentBuffer = 2
+};
+
+struct BinaryNodeRecord
+{
+    uint32_t name;
+    uint32_t BB;
+    uint8_t blockType;
+    uint8_t opType;
+    uint8_t flags;
+    uint8_t reserved;
+    float delay;
+    // Only for operators
+    uint32_t latency;
+    uint32_t II;
+    // Only for buffers, the depth of load-store queues and the tags of taggers and untaggers
+    uint32_t slots;
+    // String with the value of constants, and with the groups of load-store queues
+    uint32_t value;
+    uint32_t firstInPort;
+    uint32_t numInPorts;
+    uint32_t firstOutPort;
+    uint32_t numOutPorts;
+    // Channels leaving each output port, in the order of the ports
+    uint32_t firstEdge;
+    uint32_t numEdges;
+};
+
+struct BinaryPortRecord
+{
+    uint32_t name;
+    uint8_t type;
+    uint8_t reserved[3];
+    int32_t width;
+    float delay;
+};
+
+struct BinaryEdgeRecord
+{
+    uint32_t fromNode;
+    uint32_t fromPort;
+    uint32_t toNode;
+    uint32_t toPort;
+    int32_t width;
+};
+
+static_assert(sizeof(BinaryGraphHeader) == 88, "Header layout changed");
+static_assert(sizeof(BinaryFunctionRecord) == 40, "Function record layout changed");
+static_assert(sizeof(BinaryBBRecord) == 8, "BB record layout changed");
+static_assert(sizeof(BinaryNodeRecord) == 56, "Node record layout changed");
+static_assert(sizeof(BinaryPortRecord) == 16, "Port record layout changed");
+static_assert(sizeof(BinaryEdgeRecord) == 20, "Edge record layout changed");
+
+
+/* Builds the records of the graphs of a module. The functions have to be added in the
+    same order they are printed, and the channels are collected when writing, as they
+    can go to blocks of functions added later */
+class BinaryGraphWriter {
+
+public:
+
+    BinaryGraphWriter();
+    ~BinaryGraphWriter();
+
+    void addFunction(FunctionGraph& graph);
+
+    void write(ostream& file);
+
+private:
+
+    vector <BinaryFunctionRecord> functions;
+    vector <BinaryBBRecord> BBs;
+    vector <BinaryNodeRecord> nodes;
+    vector <BinaryPortRecord> ports;
+    vector <BinaryEdgeRecord> edges;
+    // Block of each node record
+    vector <Block*> blocks;
+    unordered_map <Block*, uint32_t> nodeIds;
+
+    string strings;
+    unordered_map <string, uint32_t> stringOffsets;
+
+    uint32_t addString(const string& text);
+    void addPort(const Port& port);
+    void addNode(Block* block, uint32_t BB, bool control);
+    void addEdges();
+
+    void writeSection(ostream& file, const void* data, uint64_t size, uint64_t& offset);
+
+};
+
+
+/* Read-only view of a binary graph file mapped in memory */
+class BinaryGraphReader {
+
+public:
+
+    BinaryGraphReader();
+    ~BinaryGraphReader();
+
+    BinaryGraphReader(const BinaryGraphReader&) = delete;
+    BinaryGraphReader& operator = (const BinaryGraphReader&) = delete;
+
+    // Returns false if the file cannot be mapped or it is not a valid graph file
+    bool open(const string& fileName);
+    void close();
+
+    uint32_t getNumFunctions();
+    uint32_t getNumBBs();
+    uint32_t getNumNodes();
+    uint32_t getNumPorts();
+    uint32_t getNumEdges();
+
+    const BinaryFunctionRecord& getFunction(uint32_t index);
+    const BinaryBBRecord& getBB(uint32_t index);
+    const BinaryNodeRecord& getNode(uint32_t index);
+    const BinaryPortRecord& getPort(uint32_t index);
+    const BinaryEdgeRecord& getEdge(uint32_t index);
+
+    const char* getString(uint32_t offset);
+
+private:
+
+    const char* data;
+    size_t size;
+    const BinaryGraphHeader* header;
+    const BinaryFunctionRecord* functions;
+    const BinaryBBRecord* BBs;
+    const BinaryNodeRecord* nodes;
+    const BinaryPortRecord* ports;
+    const BinaryEdgeRecord* edges;
+    const char* strings;
+
+    bool sectionFits(uint64_t offset, uint64_t numRecords, uint64_t recordSize);
+
+};
+
+
+} // Close namespace
+
+#endif // BINARYGRAPH_H
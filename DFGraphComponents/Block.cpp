@@ -16,10 +16,11 @@ namespace DFGraphComp
 
 Block::Block() {}
 
-Block::Block(const string &blockName, const BasicBlock* parentBB,
-    BlockType blockType, unsigned int blockDelay) 
+Block::Block(const string &namePrefix, const BasicBlock* parentBB,
+    BlockType blockType, double blockDelay) 
 {
-    this->blockName = blockName;
+    this->namePrefix = namePrefix;
+    this->blockName = namePrefix;
     this->parentBB = parentBB;
     this->blockType = blockType;
     this->blockDelay = blockDelay;
@@ -32,17 +33,77 @@ const BasicBlock* Block::getParentBB() {
 }
 
 string Block::getBlockName() {
-    return blockName;
+    return string(blockName.data(), blockName.size());
+}
+
+string Block::getNamePrefix() {
+    return string(namePrefix.data(), namePrefix.size());
+}
+
+void Block::setInstanceNumber(unsigned int number) {
+    blockName = namePrefix;
+    blockName += to_string(number);
+}
+
+void Block::setBlockName(const string& blockName) {
+    this->blockName = blockName;
 }
 
 BlockType Block::getBlockType() {
     return blockType;
 }
 
-void Block::setBlockDelay(unsigned int blockDelay) {
+double Block::getBlockDelay() {
+    return blockDelay;
+}
+
+void Block::setBlockDelay(double blockDelay) {
     this->blockDelay = blockDelay;
 }
 
+void Block::setInputPort(unsigned int index, const Port& port) {
+    // Every block returns its own ports, so they can be modified through the references
+    const_cast <Port&>(getInputPort(index)) = port;
+}
+
+void Block::setOutputPort(unsigned int index, const Port& port) {
+    const_cast <Port&>(getOutputPort(index)) = port;
+}
+
+void Block::setOutputConnection(unsigned int index, pair <Block*, int> connection) {
+    switch (blockType)
+    {
+        case BlockType::Fork_Block:
+            ((Fork*)this)->setOutPort(index, connection);
+            break;
+        case BlockType::Branch_Block:
+            // The false output is the first one
+            ((Branch*)this)->setCurrentPort(index == 1);
+            setConnectedPort(connection);
+            break;
+        case BlockType::Demux_Block:
+            ((Demux*)this)->setCurrentConnectedPort(index);
+            setConnectedPort(connection);
+            break;
+        case BlockType::Operator_Block:
+            ((Operator*)this)->setOutPort(index, connection);
+            break;
+        case BlockType::LSQ_Block:
+            ((LSQ*)this)->setOutPort(index, connection);
+            break;
+        case BlockType::Tagger_Block:
+            ((Tagger*)this)->setOutPort(index, connection);
+            break;
+        case BlockType::Untagger_Block:
+            ((Untagger*)this)->setOutPort(index, connection);
+            break;
+        default:
+            assert(index == 0 && "Block with a single output port");
+            setConnectedPort(connection);
+            break;
+    }
+}
+
 
 /*
  * =================================
@@ -51,19 +112,16 @@ void Block::setBlockDelay(unsigned int blockDelay) {
 */
 
 
-vector <unsigned int> Operator::instanceCounter(numberOperators, 1);
-
 Operator::Operator(OpType opType, const BasicBlock* parentBB, 
-    int portWidth, unsigned int blockDelay, unsigned int latency, 
+    int portWidth, double blockDelay, unsigned int latency, 
     unsigned int II) : 
-    Block(getOpName(opType) + to_string(instanceCounter[opType]), 
+    Block(getOpName(opType), 
     parentBB, BlockType::Operator_Block, blockDelay), 
-    dataOut("out", portWidth), connectedPort(nullptr, -1)
+    dataOut("out", portWidth), connectedPort(nullptr, -1), numOrderIn(0)
 {
     this->latency = latency;
     this->II = II;
     this->opType = opType;
-    ++instanceCounter[opType];
     if (isUnary(opType)) {
         dataIn.push_back(Port("in", portWidth));
     }
@@ -79,7 +137,15 @@ OpType Operator::getOpType() {
     return opType;
 }
 
-unsigned int Operator::addInputPort(int portWidth, unsigned int portDelay) {
+unsigned int Operator::getLatency() {
+    return latency;
+}
+
+unsigned int Operator::getII() {
+    return II;
+}
+
+unsigned int Operator::addInputPort(int portWidth, double portDelay) {
     assert(!isUnary(opType) and !isBinary(opType));
     if (portWidth == -1 and dataIn.size() > 0) {
         portWidth = dataIn[0].getWidth();
@@ -113,15 +179,71 @@ void Operator::setDataPortWidth(int width) {
     }
 }
 
-void Operator::setDataInPortDelay(unsigned int index, unsigned int delay) {
+void Operator::setDataInPortDelay(unsigned int index, double delay) {
     assert(index < dataIn.size() && "Wrong input port");
     dataIn[index].setDelay(delay);
 }
 
-void Operator::setDataOutPortDelay(unsigned int delay) {
+void Operator::setDataOutPortDelay(double delay) {
     dataOut.setDelay(delay);
 }
 
+unsigned int Operator::addMemoryInputPort(const string& name, int width) {
+    assert(isMemory(opType) && "Only loads and stores have memory ports");
+    dataIn.push_back(Port(name, width));
+    return dataIn.size()-1;
+}
+
+unsigned int Operator::addMemoryOutputPort(const string& name, int width) {
+    assert(isMemory(opType) && "Only loads and stores have memory ports");
+    memoryOut.push_back(Port(name, width));
+    memoryConnections.push_back(make_pair(nullptr, -1));
+    return getNumOutputPorts()-1;
+}
+
+unsigned int Operator::addOrderInputPort() {
+    return addMemoryInputPort("order" + to_string(numOrderIn++), 0);
+}
+
+void Operator::addOrderOutputPort() {
+    addMemoryOutputPort("done", 0);
+}
+
+bool Operator::hasOrderOutputPort() {
+    return findOutputPort("done") >= 0;
+}
+
+void Operator::setOrderConnection(Block* block, int idxPort) {
+    int index = findOutputPort("done");
+    assert(index >= 0 && "Operator without done port");
+    setOutPort(index, make_pair(block, idxPort));
+}
+
+int Operator::findInputPort(const string& name) {
+    for (unsigned int i = 0; i < dataIn.size(); ++i) {
+        if (dataIn[i].getName() == name) return i;
+    }
+    return -1;
+}
+
+int Operator::findOutputPort(const string& name) {
+    for (unsigned int i = 0; i < getNumOutputPorts(); ++i) {
+        if (getOutputPort(i).getName() == name) return i;
+    }
+    return -1;
+}
+
+void Operator::setOutPort(unsigned int index, pair <Block*, int> connection) {
+    assert(index < getNumOutputPorts() && "Wrong output port");
+    if (index < getNumDataOutputs()) connectedPort = connection;
+    else memoryConnections[index - getNumDataOutputs()] = connection;
+}
+
+unsigned int Operator::getNumDataOutputs() {
+    if (opType == OpType::Store) return 0;
+    return 1;
+}
+
 pair <Block*, int> Operator::getConnectedPort() {
     return connectedPort;
 }
@@ -148,7 +270,27 @@ const Port& Operator::getInputPort(unsigned int index) {
     return dataIn[index];
 }
 
-void Operator::printBlock(ostream& file) {
+unsigned int Operator::getNumInputPorts() {
+    return dataIn.size();
+}
+
+unsigned int Operator::getNumOutputPorts() {
+    return getNumDataOutputs() + memoryOut.size();
+}
+
+const Port& Operator::getOutputPort(unsigned int index) {
+    assert(index < getNumOutputPorts() && "Wrong output port");
+    if (index < getNumDataOutputs()) return dataOut;
+    return memoryOut[index - getNumDataOutputs()];
+}
+
+pair <Block*, int> Operator::getOutputConnection(unsigned int index) {
+    assert(index < getNumOutputPorts() && "Wrong output port");
+    if (index < getNumDataOutputs()) return connectedPort;
+    return memoryConnections[index - getNumDataOutputs()];
+}
+
+void Operator::printBlock(DotBuffer& file) {
     file << blockName << "[type = Operator";
     file << ", in = \"";
     for (unsigned int i = 0; i < dataIn.size(); ++i) {
@@ -156,7 +298,14 @@ void Operator::printBlock(ostream& file) {
         file << dataIn[i];
     }
     file << "\"";
-    if (opType != OpType::Store) file << ", out = \"" << dataOut << "\"";
+    if (getNumOutputPorts() > 0) {
+        file << ", out = \"";
+        for (unsigned int i = 0; i < getNumOutputPorts(); ++i) {
+            if (i > 0) file << " ";
+            file << getOutputPort(i);
+        }
+        file << "\"";
+    }
     bool first = true;
     for (unsigned int i = 0; i < dataIn.size(); ++i) {
         if (dataIn[i].getDelay() > 0) {
@@ -168,14 +317,14 @@ void Operator::printBlock(ostream& file) {
             file << dataIn[i].getName() << ":" << dataIn[i].getDelay();
         }
     }
-    if (opType != OpType::Store and dataOut.getDelay() > 0) {
+    if (getNumDataOutputs() > 0 and dataOut.getDelay() > 0) {
         if (first) {
             first = false;
             file << ", delay = \"";
         }
         else file << " ";
         if (blockDelay > 0) file << blockDelay << " ";
-        file << dataOut.getName() << ":" << dataOut.getDelay() << "\"";
+        file << dataOut.getName() << ":" << dataOut.getDelay();
     }
     else if (blockDelay > 0) {
         if (first) file << ", delay = ";
@@ -186,11 +335,11 @@ void Operator::printBlock(ostream& file) {
     file << ", op = " << opType;
     file << ", latency = " << latency;
     file << ", II = " << II;
-    file << "];" << endl;
+    file << "];\n";
 }
 
-void Operator::printChannels(ostream& file) {
-    if (opType != OpType::Store) {
+void Operator::printChannels(DotBuffer& file) {
+    if (getNumDataOutputs() > 0) {
         assert(connectedPort.first != nullptr and connectedPort.second != -1 &&
             "Operator output port disconnected");
         file << '\t' << blockName << " -> " << connectedPort.first->getBlockName() << 
@@ -201,7 +350,21 @@ void Operator::printChannels(ostream& file) {
         if (width == 0) file << "red";
         else if (width == 1) file << "magenta";
         else file << "blue";
-        file << "];" << endl;
+        file << "];\n";
+    }
+    for (unsigned int i = 0; i < memoryOut.size(); ++i) {
+        pair <Block*, int> connection = memoryConnections[i];
+        assert(connection.first != nullptr and connection.second != -1 &&
+            "Operator memory port disconnected");
+        file << '\t' << blockName << " -> " << connection.first->getBlockName() <<
+            " [from = " << memoryOut[i].getName() << ", to = " <<
+            connection.first->getInputPort(connection.second).getName();
+        unsigned int width = memoryOut[i].getWidth();
+        file << ", color = ";
+        if (width == 0) file << "red";
+        else if (width == 1) file << "magenta";
+        else file << "blue";
+        file << "];\n";
     }
 }
 
@@ -213,26 +376,31 @@ void Operator::printChannels(ostream& file) {
 */
 
 
-unsigned int Buffer::instanceCounter = 1;
-
-Buffer::Buffer(const BasicBlock* parentBB, int portWidth, unsigned int blockDelay,
+Buffer::Buffer(const BasicBlock* parentBB, int portWidth, double blockDelay,
     unsigned int slots, bool transparent) : 
-    Block("Buffer" + to_string(instanceCounter), 
+    Block("Buffer", 
     parentBB, BlockType::Buffer_Block, blockDelay), 
     dataIn("in", portWidth), dataOut("out", portWidth), 
     connectedPort(nullptr, -1)
 {
-    ++instanceCounter;
     this->slots = slots;
     this->transparent = transparent;
 }
 
 Buffer::~Buffer() {}
 
+unsigned int Buffer::getNumSlots() {
+    return slots;
+}
+
 void Buffer::setNumSlots(unsigned int slots) {
     this->slots = slots;
 }
 
+bool Buffer::isTransparent() {
+    return transparent;
+}
+
 void Buffer::setTransparent(bool transparent) {
     this->transparent = transparent;
 }
@@ -242,11 +410,11 @@ void Buffer::setDataPortWidth(int width) {
     dataOut.setWidth(width);
 }
 
-void Buffer::setDataInPortDelay(unsigned int delay) {
+void Buffer::setDataInPortDelay(double delay) {
     dataIn.setDelay(delay);
 }
 
-void Buffer::setDataOutPortDelay(unsigned int delay) {
+void Buffer::setDataOutPortDelay(double delay) {
     dataOut.setDelay(delay);
 }
 
@@ -276,7 +444,25 @@ const Port& Buffer::getInputPort(unsigned int index) {
     return dataIn;
 }
 
-void Buffer::printBlock(ostream &file) {
+unsigned int Buffer::getNumInputPorts() {
+    return 1;
+}
+
+unsigned int Buffer::getNumOutputPorts() {
+    return 1;
+}
+
+const Port& Buffer::getOutputPort(unsigned int index) {
+    assert(index == 0 && "Wrong output port");
+    return dataOut;
+}
+
+pair <Block*, int> Buffer::getOutputConnection(unsigned int index) {
+    assert(index == 0 && "Wrong output port");
+    return connectedPort;
+}
+
+void Buffer::printBlock(DotBuffer& file) {
     file << blockName << "[type = Buffer";
     file << ", in = \"" << dataIn << "\"";
     file << ", out = \"" << dataOut << "\"";
@@ -305,10 +491,10 @@ void Buffer::printBlock(ostream &file) {
     file << ", transparent = ";
     if (transparent) file << "true";
     else file << "false";
-    file << "];" << endl;
+    file << "];\n";
 }
 
-void Buffer::printChannels(ostream& file) {
+void Buffer::printChannels(DotBuffer& file) {
     assert(connectedPort.first != nullptr and connectedPort.second != -1 &&
         "Buffer output port disconnected");
     file << '\t' << blockName << " -> " << connectedPort.first->getBlockName() << 
@@ -319,7 +505,7 @@ void Buffer::printChannels(ostream& file) {
     if (width == 0) file << "red";
     else if (width == 1) file << "magenta";
     else file << "blue";
-    file << "];" << endl;
+    file << "];\n";
 }
 
 
@@ -329,18 +515,13 @@ void Buffer::printChannels(ostream& file) {
  * =================================
 */
 
-unsigned int ConstantInterf::instanceCounter = 1;
-
-ConstantInterf::ConstantInterf() {}
+ConstantInterf::ConstantInterf() : source(false) {}
 
 ConstantInterf::ConstantInterf(const BasicBlock* parentBB, int portWidth, 
-    unsigned int blockDelay) : 
-    Block("Constant" + to_string(instanceCounter), parentBB,
+    double blockDelay) : 
+    Block("Constant", parentBB,
     BlockType::Constant_Block, blockDelay), controlIn("in", 0), 
-    dataOut("out", portWidth), connectedPort(nullptr, -1) 
-{
-    ++instanceCounter;
-}
+    dataOut("out", portWidth), connectedPort(nullptr, -1), source(false) {}
 
 ConstantInterf::~ConstantInterf() {}
 
@@ -348,14 +529,22 @@ void ConstantInterf::setDataPortWidth(int width) {
     dataOut.setWidth(width);
 }
 
-void ConstantInterf::setControlPortDelay(unsigned int delay) {
+void ConstantInterf::setControlPortDelay(double delay) {
     controlIn.setDelay(delay);
 }
 
-void ConstantInterf::setDataPortDelay(unsigned int delay) {
+void ConstantInterf::setDataPortDelay(double delay) {
     dataOut.setDelay(delay);
 }
 
+void ConstantInterf::setSource(bool source) {
+    this->source = source;
+}
+
+bool ConstantInterf::isSource() {
+    return source;
+}
+
 pair <Block*, int> ConstantInterf::getConnectedPort() {
     return connectedPort;
 }
@@ -378,11 +567,29 @@ unsigned int ConstantInterf::getOutputPortIndex() {
 }
 
 const Port& ConstantInterf::getInputPort(unsigned int index) {
-    assert(index == 0 && "Wrong input port");
+    assert(index == 0 and !source && "Wrong input port");
     return controlIn;
 }
 
-void ConstantInterf::printChannels(ostream& file) {
+unsigned int ConstantInterf::getNumInputPorts() {
+    return (source ? 0 : 1);
+}
+
+unsigned int ConstantInterf::getNumOutputPorts() {
+    return 1;
+}
+
+const Port& ConstantInterf::getOutputPort(unsigned int index) {
+    assert(index == 0 && "Wrong output port");
+    return dataOut;
+}
+
+pair <Block*, int> ConstantInterf::getOutputConnection(unsigned int index) {
+    assert(index == 0 && "Wrong output port");
+    return connectedPort;
+}
+
+void ConstantInterf::printChannels(DotBuffer& file) {
     assert(connectedPort.first != nullptr and connectedPort.second != -1 &&
         "Constant output port disconnected");
     file << '\t' << blockName << " -> " << connectedPort.first->getBlockName() << 
@@ -393,7 +600,7 @@ void ConstantInterf::printChannels(ostream& file) {
     if (width == 0) file << "red";
     else if (width == 1) file << "magenta";
     else file << "blue";
-    file << "];" << endl;
+    file << "];\n";
 }
 
 
@@ -404,15 +611,10 @@ void ConstantInterf::printChannels(ostream& file) {
 */
 
 
-unsigned int Fork::instanceCounter = 1;
-
 Fork::Fork(const BasicBlock* parentBB, int portWidth, 
-    unsigned int blockDelay) : 
-    Block("Fork" + to_string(instanceCounter), parentBB,
-    BlockType::Fork_Block, blockDelay), dataIn("in", portWidth)
-{
-    ++instanceCounter;
-}
+    double blockDelay) : 
+    Block("Fork", parentBB,
+    BlockType::Fork_Block, blockDelay), dataIn("in", portWidth) {}
 
 Fork::~Fork() {}
 
@@ -423,11 +625,11 @@ void Fork::setDataPortWidth(int width) {
     }
 }
 
-void Fork::setDataInPortDelay(unsigned int delay) {
+void Fork::setDataInPortDelay(double delay) {
     dataIn.setDelay(delay);
 }
 
-void Fork::setDataOutPortDelay(unsigned int index, unsigned int delay) {
+void Fork::setDataOutPortDelay(unsigned int index, double delay) {
     assert(index < dataOut.size() && "Wrong output port");
     dataOut[index].setDelay(delay);
 }
@@ -439,7 +641,7 @@ pair <Block*, int> Fork::getConnectedPort() {
 
 void Fork::setConnectedPort(Block* block, int idxPort) {
     int width = dataIn.getWidth();
-    int delay = dataIn.getDelay();
+    double delay = dataIn.getDelay();
     dataOut.push_back(Port("out" + to_string(dataOut.size()),
         width, Port::Base, delay));
     connectedPorts.push_back(make_pair(block, idxPort));
@@ -447,7 +649,7 @@ void Fork::setConnectedPort(Block* block, int idxPort) {
 
 void Fork::setConnectedPort(pair <Block*, int> connection) {
     int width = dataIn.getWidth();
-    int delay = dataIn.getDelay();
+    double delay = dataIn.getDelay();
     dataOut.push_back(Port("out" + to_string(dataOut.size()),
         width, Port::Base, delay));
     connectedPorts.push_back(connection);
@@ -466,12 +668,43 @@ void Fork::setOutPort(unsigned int index, pair <Block*, int> connection) {
     connectedPorts[index] = connection;
 }
 
+void Fork::removeDisconnectedPorts() {
+    unsigned int numPorts = 0;
+    for (unsigned int i = 0; i < connectedPorts.size(); ++i) {
+        if (connectedPorts[i].first == nullptr) continue;
+        dataOut[numPorts] = dataOut[i];
+        dataOut[numPorts].setName("out" + to_string(numPorts));
+        connectedPorts[numPorts] = connectedPorts[i];
+        ++numPorts;
+    }
+    dataOut.resize(numPorts);
+    connectedPorts.resize(numPorts);
+}
+
 const Port& Fork::getInputPort(unsigned int index) {
     assert(index == 0 && "Wrong input port");
     return dataIn;
 }
 
-void Fork::printBlock(ostream& file ) {
+unsigned int Fork::getNumInputPorts() {
+    return 1;
+}
+
+unsigned int Fork::getNumOutputPorts() {
+    return dataOut.size();
+}
+
+const Port& Fork::getOutputPort(unsigned int index) {
+    assert(index < dataOut.size() && "Wrong output port");
+    return dataOut[index];
+}
+
+pair <Block*, int> Fork::getOutputConnection(unsigned int index) {
+    assert(index < connectedPorts.size() && "Wrong output port");
+    return connectedPorts[index];
+}
+
+void Fork::printBlock(DotBuffer& file) {
     file << blockName << "[type = Fork";
     file << ", in = \"" << dataIn << "\"";
     file << ", out = \"";
@@ -507,10 +740,10 @@ void Fork::printBlock(ostream& file ) {
         file << blockDelay;
     }
     if (!first) file << "\"";
-    file << "];" << endl;
+    file << "];\n";
 }
 
-void Fork::printChannels(ostream& file) {
+void Fork::printChannels(DotBuffer& file) {
     unsigned int width = dataIn.getWidth();
     for (unsigned int i = 0; i < dataOut.size(); ++i) {
         assert(connectedPorts[i].first != nullptr and connectedPorts[i].second != -1 &&
@@ -522,7 +755,7 @@ void Fork::printChannels(ostream& file) {
         if (width == 0) file << "red";
         else if (width == 1) file << "magenta";
         else file << "blue";
-        file << "];" << endl;
+        file << "];\n";
     }
 }
 
@@ -534,20 +767,15 @@ void Fork::printChannels(ostream& file) {
 */
 
 
-unsigned int Merge::instanceCounter = 1;
-
 Merge::Merge(const BasicBlock* parentBB, int portWidth,
-    unsigned int blockDelay) : 
-    Block("Merge" + to_string(instanceCounter), parentBB,
+    double blockDelay) : 
+    Block("Merge", parentBB,
     BlockType::Merge_Block, blockDelay), dataOut("out", portWidth),
-    connectedPort(nullptr, -1)
-{
-    ++instanceCounter;
-}
+    connectedPort(nullptr, -1) {}
 
 Merge::~Merge() {}
 
-unsigned int Merge::addDataInPort(unsigned int delay) {
+unsigned int Merge::addDataInPort(double delay) {
     int width = dataOut.getWidth();
     dataIn.push_back(Port("in" + to_string(dataIn.size()), width,
         Port::Base, delay));
@@ -561,12 +789,12 @@ void Merge::setDataPortWidth(int width) {
     dataOut.setWidth(width);
 }
 
-void Merge::setDataInPortDelay(unsigned int index, unsigned int delay) {
+void Merge::setDataInPortDelay(unsigned int index, double delay) {
     assert(index < dataIn.size() && "Wrong input port");
     dataIn[index].setDelay(delay);
 }
 
-void Merge::setDataOutPortDelay(unsigned int delay) {
+void Merge::setDataOutPortDelay(double delay) {
     dataOut.setDelay(delay);
 }
 
@@ -596,7 +824,25 @@ const Port& Merge::getInputPort(unsigned int index) {
     return dataIn[index];
 }
 
-void Merge::printBlock(ostream& file) {
+unsigned int Merge::getNumInputPorts() {
+    return dataIn.size();
+}
+
+unsigned int Merge::getNumOutputPorts() {
+    return 1;
+}
+
+const Port& Merge::getOutputPort(unsigned int index) {
+    assert(index == 0 && "Wrong output port");
+    return dataOut;
+}
+
+pair <Block*, int> Merge::getOutputConnection(unsigned int index) {
+    assert(index == 0 && "Wrong output port");
+    return connectedPort;
+}
+
+void Merge::printBlock(DotBuffer& file) {
     file << blockName << "[type = Merge";
     file << ", in = \"";
     for (unsigned int i = 0; i < dataIn.size(); ++i) {
@@ -630,10 +876,10 @@ void Merge::printBlock(ostream& file) {
         file << blockDelay;
     }
     if (!first) file << "\"";
-    file << "];" << endl;
+    file << "];\n";
 }
 
-void Merge::printChannels(ostream& file) {
+void Merge::printChannels(DotBuffer& file) {
     assert(connectedPort.first != nullptr and connectedPort.second != -1 &&
         "Merge output port disconnected");
     file << '\t' << blockName << " -> " << connectedPort.first->getBlockName() << 
@@ -644,7 +890,7 @@ void Merge::printChannels(ostream& file) {
     if (width == 0) file << "red";
     else if (width == 1) file << "magenta";
     else file << "blue";
-    file << "];" << endl;
+    file << "];\n";
 }
 
 
@@ -655,17 +901,12 @@ void Merge::printChannels(ostream& file) {
 */
 
 
-unsigned int Select::instanceCounter = 1;
-
 Select::Select(const BasicBlock* parentBB, int portWidth, 
-    unsigned int blockDelay) : 
-    Block("Select" + to_string(instanceCounter), parentBB,
+    double blockDelay) : 
+    Block("Select", parentBB,
     BlockType::Select_Block, blockDelay), dataTrue("inTrue", portWidth, Port::True),
     dataFalse("inFalse", portWidth, Port::False), condition("inCondition", 1, Port::Condition),
-    dataOut("out", portWidth), connectedPort(nullptr, -1)
-{
-    ++instanceCounter;
-}
+    dataOut("out", portWidth), connectedPort(nullptr, -1) {}
 
 Select::~Select() {}
 
@@ -675,19 +916,19 @@ void Select::setDataPortWidth(int width) {
     dataOut.setWidth(width);
 }
 
-void Select::setDataTruePortDelay(unsigned int delay) {
+void Select::setDataTruePortDelay(double delay) {
     dataTrue.setDelay(delay);
 }
 
-void Select::setDataFalsePortDelay(unsigned int delay) {
+void Select::setDataFalsePortDelay(double delay) {
     dataFalse.setDelay(delay);
 }
 
-void Select::setConditionPortDelay(unsigned int delay) {
+void Select::setConditionPortDelay(double delay) {
     condition.setDelay(delay);
 }
 
-void Select::setDataOutPortDelay(unsigned int delay) {
+void Select::setDataOutPortDelay(double delay) {
     dataOut.setDelay(delay);
 }
 
@@ -719,7 +960,25 @@ const Port& Select::getInputPort(unsigned int index) {
     else return condition;
 }
 
-void Select::printBlock(ostream& file) {
+unsigned int Select::getNumInputPorts() {
+    return 3;
+}
+
+unsigned int Select::getNumOutputPorts() {
+    return 1;
+}
+
+const Port& Select::getOutputPort(unsigned int index) {
+    assert(index == 0 && "Wrong output port");
+    return dataOut;
+}
+
+pair <Block*, int> Select::getOutputConnection(unsigned int index) {
+    assert(index == 0 && "Wrong output port");
+    return connectedPort;
+}
+
+void Select::printBlock(DotBuffer& file) {
     file << blockName << "[type = Select";
     file << ", in = \"" << dataTrue << " " << dataFalse
         << " " << condition << "\"";
@@ -761,10 +1020,10 @@ void Select::printBlock(ostream& file) {
         file << blockDelay;
     }
     if (!first) file << "\"";
-    file << "];" << endl;
+    file << "];\n";
 }
 
-void Select::printChannels(ostream& file) {
+void Select::printChannels(DotBuffer& file) {
     assert(connectedPort.first != nullptr and connectedPort.second != -1 &&
         "Select output port disconnected");
     file << '\t' << blockName << " -> " << connectedPort.first->getBlockName() << 
@@ -775,7 +1034,7 @@ void Select::printChannels(ostream& file) {
     if (width == 0) file << "red";
     else if (width == 1) file << "magenta";
     else file << "blue";
-    file << "];" << endl;
+    file << "];\n";
 }
 
 
@@ -786,17 +1045,14 @@ void Select::printChannels(ostream& file) {
 */
 
 
-unsigned int Branch::instanceCounter = 1;
-
 Branch::Branch(const BasicBlock* parentBB, int portWidth, 
-    unsigned int blockDelay) : 
-    Block("Branch" + to_string(instanceCounter), parentBB,
+    double blockDelay) : 
+    Block("Branch", parentBB,
     BlockType::Branch_Block, blockDelay), dataIn("in", portWidth), 
     condition("inCondition", 1, Port::Condition), dataTrue("outTrue", portWidth, 
     Port::True), dataFalse("outFalse", portWidth, Port::False), 
     connectedPortTrue(nullptr, -1), connectedPortFalse(nullptr, -1)
 {
-    ++instanceCounter;
     currentPort = false;
 }
 
@@ -808,19 +1064,19 @@ void Branch::setDataPortWidth(int width) {
     dataFalse.setWidth(width);
 }
 
-void Branch::setDataInPortDelay(unsigned int delay) {
+void Branch::setDataInPortDelay(double delay) {
     dataIn.setDelay(delay);
 }
 
-void Branch::setConditionPortDelay(unsigned int delay) {
+void Branch::setConditionPortDelay(double delay) {
     condition.setDelay(delay);
 }
 
-void Branch::setDataTruePortDelay(unsigned int delay) {
+void Branch::setDataTruePortDelay(double delay) {
     dataTrue.setDelay(delay);
 }
 
-void Branch::setDataFalsePortDelay(unsigned int delay) {
+void Branch::setDataFalsePortDelay(double delay) {
     dataFalse.setDelay(delay);
 }
 
@@ -859,11 +1115,32 @@ const Port& Branch::getInputPort(unsigned int index) {
     else return condition;
 }
 
+unsigned int Branch::getNumInputPorts() {
+    return 2;
+}
+
+unsigned int Branch::getNumOutputPorts() {
+    return 2;
+}
+
+// Same indices than getOutputPortIndex, 0 the false port and 1 the true port
+const Port& Branch::getOutputPort(unsigned int index) {
+    assert(index < 2 && "Wrong output port");
+    if (index == 0) return dataFalse;
+    else return dataTrue;
+}
+
+pair <Block*, int> Branch::getOutputConnection(unsigned int index) {
+    assert(index < 2 && "Wrong output port");
+    if (index == 0) return connectedPortFalse;
+    else return connectedPortTrue;
+}
+
 void Branch::setCurrentPort(bool currentPort) {
     this->currentPort = currentPort;
 }
 
-void Branch::printBlock(ostream& file) {
+void Branch::printBlock(DotBuffer& file) {
     file << blockName << "[type = Branch";
     file << ", in = \"" << dataIn << " " << condition << "\"";
     file << ", out = \"" << dataTrue << " " << dataFalse << "\"";
@@ -905,10 +1182,10 @@ void Branch::printBlock(ostream& file) {
         file << blockDelay;
     }
     if (!first) file << "\"";
-    file << "];" << endl;
+    file << "];\n";
 }
 
-void Branch::printChannels(ostream& file) {
+void Branch::printChannels(DotBuffer& file) {
     assert(((connectedPortTrue.first != nullptr and connectedPortTrue.second != -1) or
         (connectedPortFalse.first != nullptr and connectedPortFalse.second != -1)) &&
         "Branch has some output port disconnected");
@@ -921,7 +1198,7 @@ void Branch::printChannels(ostream& file) {
         if (width == 0) file << "red";
         else if (width == 1) file << "magenta";
         else file << "blue";
-        file << "];" << endl;
+        file << "];\n";
     }
     if (connectedPortFalse.first != nullptr) {
         file << '\t' << blockName << " -> " << connectedPortFalse.first->getBlockName() << 
@@ -931,7 +1208,7 @@ void Branch::printChannels(ostream& file) {
         if (width == 0) file << "red";
         else if (width == 1) file << "magenta";
         else file << "blue";
-        file << "];" << endl;
+        file << "];\n";
     }
 }
 
@@ -943,26 +1220,23 @@ void Branch::printChannels(ostream& file) {
 */
 
 
-unsigned int Demux::instanceCounter = 1;
-
 Demux::Demux(const BasicBlock* parentBB, int portWidth, 
-    unsigned int blockDelay) : 
-    Block("Demux" + to_string(instanceCounter), parentBB,
+    double blockDelay) : 
+    Block("Demux", parentBB,
     BlockType::Demux_Block, blockDelay), dataIn("in", portWidth)
 {
-    ++instanceCounter;
     currentConnected = 0;
 }
 
 Demux::~Demux() {}
 
-unsigned int Demux::addControlInPort(unsigned int delay) {
+unsigned int Demux::addControlInPort(double delay) {
     control.push_back(Port("inControl" + to_string(control.size()),
         0, Port::Base, delay));
     return control.size();
 }
 
-void Demux::addDataOutPort(unsigned int delay) {
+void Demux::addDataOutPort(double delay) {
     dataOut.push_back(Port("out" + to_string(dataOut.size()), dataIn.getWidth(), 
         Port::Base, delay));
     currentConnected = connectedPorts.size();
@@ -976,16 +1250,16 @@ void Demux::setDataPortWidth(int width) {
     }
 }
 
-void Demux::setControlPortDelay(unsigned int index, unsigned int delay) {
+void Demux::setControlPortDelay(unsigned int index, double delay) {
     assert(index < control.size() && "Wrong input port");
     control[index].setDelay(delay);
 }
 
-void Demux::setDataInPortDelay(unsigned int delay) {
+void Demux::setDataInPortDelay(double delay) {
     dataIn.setDelay(delay);
 }
 
-void Demux::setDataOutPortDelay(unsigned int index, unsigned int delay) {
+void Demux::setDataOutPortDelay(unsigned int index, double delay) {
     assert(index < dataOut.size() && "Wrong output port");
     dataOut[index].setDelay(delay);
 }
@@ -1022,7 +1296,27 @@ const Port& Demux::getInputPort(unsigned int index) {
     else return control[index-1];
 }
 
-void Demux::printBlock(ostream& file) {
+unsigned int Demux::getNumInputPorts() {
+    return control.size() + 1;
+}
+
+unsigned int Demux::getNumOutputPorts() {
+    return dataOut.size();
+}
+
+const Port& Demux::getOutputPort(unsigned int index) {
+    assert(index < dataOut.size() && "Wrong output port");
+    return dataOut[index];
+}
+
+pair <Block*, int> Demux::getOutputConnection(unsigned int index) {
+    assert(index < dataOut.size() && "Wrong output port");
+    // Output ports are added before connecting them
+    if (index >= connectedPorts.size()) return make_pair(nullptr, -1);
+    return connectedPorts[index];
+}
+
+void Demux::printBlock(DotBuffer& file) {
     assert(control.size() == dataOut.size());
     file << blockName << "[type = Demux";
     file << ", in = \"";
@@ -1030,6 +1324,7 @@ void Demux::printBlock(ostream& file) {
         if (i > 0) file << " ";
         file << control[i];
     }
+    if (control.size() > 0) file << " ";
     file << dataIn << "\", out = \"";
     for (unsigned int i = 0; i < dataOut.size(); ++i) {
         if (i > 0) file << " ";
@@ -1076,10 +1371,10 @@ void Demux::printBlock(ostream& file) {
         file << blockDelay;
     }
     if (!first) file << "\"";
-    file << "];" << endl;
+    file << "];\n";
 }
 
-void Demux::printChannels(ostream& file) {
+void Demux::printChannels(DotBuffer& file) {
     unsigned int width = dataIn.getWidth();
     for (unsigned int i = 0; i < dataOut.size(); ++i) {
         assert(connectedPorts[i].first != nullptr and connectedPorts[i].second != -1 &&
@@ -1091,7 +1386,7 @@ void Demux::printChannels(ostream& file) {
         if (width == 0) file << "red";
         else if (width == 1) file << "magenta";
         else file << "blue";
-        file << "];" << endl;
+        file << "];\n";
     }
 }
 
@@ -1106,18 +1401,18 @@ void Demux::printChannels(ostream& file) {
 EntryInterf::EntryInterf() : Block() {}
 
 EntryInterf::EntryInterf(const string& blockName, const BasicBlock* parentBB,
-    int portWidth, unsigned int blockDelay) : 
+    int portWidth, double blockDelay) : 
     Block(blockName, parentBB, BlockType::Entry_Block, blockDelay),
     inPort("in", portWidth), outPort("out", portWidth), 
     connectedPort(nullptr, -1) {}
 
 EntryInterf::~EntryInterf() {}
 
-void EntryInterf::setInPortDelay(unsigned int delay) {
+void EntryInterf::setInPortDelay(double delay) {
     inPort.setDelay(delay);
 }
 
-void EntryInterf::setOutPortDelay(unsigned int delay) {
+void EntryInterf::setOutPortDelay(double delay) {
     outPort.setDelay(delay);
 }
 
@@ -1147,7 +1442,25 @@ const Port& EntryInterf::getInputPort(unsigned int index) {
     return inPort;
 }
 
-void EntryInterf::printBlock(ostream &file) {
+unsigned int EntryInterf::getNumInputPorts() {
+    return 1;
+}
+
+unsigned int EntryInterf::getNumOutputPorts() {
+    return 1;
+}
+
+const Port& EntryInterf::getOutputPort(unsigned int index) {
+    assert(index == 0 && "Wrong output port");
+    return outPort;
+}
+
+pair <Block*, int> EntryInterf::getOutputConnection(unsigned int index) {
+    assert(index == 0 && "Wrong output port");
+    return connectedPort;
+}
+
+void EntryInterf::printBlock(DotBuffer& file) {
     file << blockName << "[type = Entry";
     file << ", in = \"" << inPort << "\"";
     file << ", out = \"" << outPort << "\"";
@@ -1172,10 +1485,10 @@ void EntryInterf::printBlock(ostream &file) {
         file << blockDelay;
     }
     if (!first) file << "\"";
-    file << "];" << endl;
+    file << "];\n";
 }
 
-void EntryInterf::printChannels(ostream& file) {
+void EntryInterf::printChannels(DotBuffer& file) {
     assert(connectedPort.first != nullptr and connectedPort.second != -1 &&
         "Entry output port disconnected");
     file << '\t' << blockName << " -> " << connectedPort.first->getBlockName() << 
@@ -1186,7 +1499,7 @@ void EntryInterf::printChannels(ostream& file) {
     if (width == 0) file << "red";
     else if (width == 1) file << "magenta";
     else file << "blue";
-    file << "];" << endl;
+    file << "];\n";
 }
 
 
@@ -1197,14 +1510,9 @@ void EntryInterf::printChannels(ostream& file) {
 */
 
 
-unsigned int Entry::instanceCounter = 1;
-
-Entry::Entry(const BasicBlock* parentBB, unsigned int blockDelay) : 
-    EntryInterf("Entry" + to_string(instanceCounter), parentBB,
-    0, blockDelay)
-{
-    ++instanceCounter;
-}
+Entry::Entry(const BasicBlock* parentBB, double blockDelay) : 
+    EntryInterf("Entry", parentBB,
+    0, blockDelay) {}
 
 Entry::~Entry() {}
 
@@ -1216,15 +1524,10 @@ Entry::~Entry() {}
 */
 
 
-unsigned int Argument::instanceCounter = 1;
-
 Argument::Argument(const BasicBlock* parentBB, int portWidth, 
-    unsigned int blockDelay) : 
-    EntryInterf("Argument" + to_string(instanceCounter), parentBB,
-    portWidth, blockDelay)
-{
-    ++instanceCounter;
-}
+    double blockDelay) : 
+    EntryInterf("Argument", parentBB,
+    portWidth, blockDelay) {}
 
 Argument::~Argument() {}
 
@@ -1244,18 +1547,18 @@ void Argument::setDataPortWidth(int width) {
 ExitInterf::ExitInterf() : Block() {}
 
 ExitInterf::ExitInterf(const string& blockName, const BasicBlock* parentBB,
-    int portWidth, unsigned int blockDelay) :
+    int portWidth, double blockDelay) :
     Block(blockName, parentBB, BlockType::Exit_Block, blockDelay),
     inPort("in", portWidth), outPort("out", portWidth),
     connectedPort(nullptr, -1) {}
 
 ExitInterf::~ExitInterf() {}
 
-void ExitInterf::setInPortDelay(unsigned int delay) {
+void ExitInterf::setInPortDelay(double delay) {
     inPort.setDelay(delay);
 }
 
-void ExitInterf::setOutPortDelay(unsigned int delay) {
+void ExitInterf::setOutPortDelay(double delay) {
     outPort.setDelay(delay);
 }
 
@@ -1285,7 +1588,25 @@ const Port& ExitInterf::getInputPort(unsigned int index) {
     return inPort;
 }
 
-void ExitInterf::printBlock(ostream &file) {
+unsigned int ExitInterf::getNumInputPorts() {
+    return 1;
+}
+
+unsigned int ExitInterf::getNumOutputPorts() {
+    return 1;
+}
+
+const Port& ExitInterf::getOutputPort(unsigned int index) {
+    assert(index == 0 && "Wrong output port");
+    return outPort;
+}
+
+pair <Block*, int> ExitInterf::getOutputConnection(unsigned int index) {
+    assert(index == 0 && "Wrong output port");
+    return connectedPort;
+}
+
+void ExitInterf::printBlock(DotBuffer& file) {
     file << blockName << "[type = Exit";
     file << ", in = \"" << inPort << "\"";
     file << ", out = \"" << outPort << "\"";
@@ -1310,10 +1631,10 @@ void ExitInterf::printBlock(ostream &file) {
         file << blockDelay;
     }
     if (!first) file << "\"";
-    file << "];" << endl;
+    file << "];\n";
 }
 
-void ExitInterf::printChannels(ostream& file) {
+void ExitInterf::printChannels(DotBuffer& file) {
     if (connectedPort.first != nullptr and connectedPort.second != -1) {
         file << '\t' << blockName << " -> " << connectedPort.first->getBlockName() << 
         " [from = " << outPort.getName() << ", to = " << 
@@ -1323,7 +1644,7 @@ void ExitInterf::printChannels(ostream& file) {
         if (width == 0) file << "red";
         else if (width == 1) file << "magenta";
         else file << "blue";
-        file << "];" << endl;
+        file << "];\n";
     }
 }
 
@@ -1335,14 +1656,9 @@ void ExitInterf::printChannels(ostream& file) {
 */
 
 
-unsigned int Exit::instanceCounter = 1;
-
-Exit::Exit(const BasicBlock* parentBB, unsigned int blockDelay) : 
-    ExitInterf("Exit" + to_string(instanceCounter), 
-    parentBB, 0, blockDelay)
-{
-    ++instanceCounter;
-}
+Exit::Exit(const BasicBlock* parentBB, double blockDelay) : 
+    ExitInterf("Exit", 
+    parentBB, 0, blockDelay) {}
 
 Exit::~Exit() {}
 
@@ -1354,15 +1670,10 @@ Exit::~Exit() {}
 */
 
 
-unsigned int Return::instanceCounter = 1;
-
 Return::Return(const BasicBlock* parentBB, int portWidth, 
-    unsigned int blockDelay) : 
-    ExitInterf("Return" + to_string(instanceCounter), parentBB,
-    portWidth, blockDelay)
-{
-    ++instanceCounter;
-}
+    double blockDelay) : 
+    ExitInterf("Return", parentBB,
+    portWidth, blockDelay) {}
 
 Return::~Return() {}
 
@@ -1374,46 +1685,685 @@ void Return::setDataPortWidth(int width) {
 
 /*
  * =================================
- *  Class FunctionCall (Dummy block)
+ *  Class Sink
  * =================================
 */
 
 
-FunctionCall::FunctionCall(const BasicBlock* parentBB) : 
-    Block("", parentBB, BlockType::FunctionCall_Block, 0),
-    inputControlPort(nullptr, -1), connectedResultPort(nullptr, -1),
-    connectedControlPort(nullptr, -1) {}
+Sink::Sink(const BasicBlock* parentBB, int portWidth, double blockDelay) :
+    Block("Sink", parentBB, BlockType::Sink_Block, blockDelay),
+    dataIn("in", portWidth) {}
 
-FunctionCall::~FunctionCall() {}
+Sink::~Sink() {}
 
+void Sink::setDataPortWidth(int width) {
+    dataIn.setWidth(width);
+}
 
-void FunctionCall::setConnectedControlPort(Block* block, int idxPort) {
-    connectedControlPort = make_pair(block, idxPort);
+void Sink::setDataInPortDelay(double delay) {
+    dataIn.setDelay(delay);
 }
 
-pair <Block*, int> FunctionCall::getConnectedPort() {
-    return connectedResultPort;
+pair <Block*, int> Sink::getConnectedPort() {
+    return make_pair(nullptr, -1);
 }
 
-void FunctionCall::setConnectedPort(Block* block, int idxPort) {
-    connectedResultPort = make_pair(block, idxPort);
+void Sink::setConnectedPort(Block* block, int idxPort) {
+    assert(0 && "Sink without output ports");
 }
 
-void FunctionCall::setConnectedPort(pair <Block*, int> connection) {
-    connectedResultPort = connection;
+void Sink::setConnectedPort(pair <Block*, int> connection) {
+    assert(0 && "Sink without output ports");
 }
 
-bool FunctionCall::connectionAvailable() {
-    return (connectedResultPort.first == nullptr and
-        connectedResultPort.second == -1);
+bool Sink::connectionAvailable() {
+    return false;
 }
 
-unsigned int FunctionCall::getOutputPortIndex() {
-    assert(0 && "Not should be called");
+unsigned int Sink::getOutputPortIndex() {
+    return 0;
 }
 
-const Port& FunctionCall::getInputPort(unsigned int index) {
+const Port& Sink::getInputPort(unsigned int index) {
+    assert(index == 0 && "Wrong input port");
+    return dataIn;
+}
+
+unsigned int Sink::getNumInputPorts() {
+    return 1;
+}
+
+unsigned int Sink::getNumOutputPorts() {
+    return 0;
+}
+
+const Port& Sink::getOutputPort(unsigned int index) {
+    assert(0 && "Sink without output ports");
+    return dataIn;
+}
+
+pair <Block*, int> Sink::getOutputConnection(unsigned int index) {
+    assert(0 && "Sink without output ports");
+    return make_pair(nullptr, -1);
+}
+
+void Sink::printBlock(DotBuffer& file) {
+    file << blockName << "[type = Sink";
+    file << ", in = \"" << dataIn << "\"";
+    bool first = true;
+    if (dataIn.getDelay() > 0) {
+        first = false;
+        file << ", delay = \"";
+        if (blockDelay > 0) file << blockDelay << " ";
+        file << dataIn.getName() << ":" << dataIn.getDelay();
+    }
+    else if (blockDelay > 0) {
+        file << ", delay = " << blockDelay;
+    }
+    if (!first) file << "\"";
+    file << "];\n";
+}
+
+void Sink::printChannels(DotBuffer& file) {}
+
+
+/*
+ * =================================
+ *  Class LSQ
+ * =================================
+*/
+
+
+LSQ::LSQ(const BasicBlock* parentBB, unsigned int depth, double blockDelay) :
+    Block("LSQ", parentBB, BlockType::LSQ_Block, blockDelay)
+{
+    this->depth = depth;
+}
+
+LSQ::~LSQ() {}
+
+unsigned int LSQ::getDepth() {
+    return depth;
+}
+
+void LSQ::setDepth(unsigned int depth) {
+    this->depth = depth;
+}
+
+unsigned int LSQ::addGroup(unsigned int BBId) {
+    dataIn.push_back(Port("ctrl" + to_string(groupBBs.size()), 0));
+    groupBBs.push_back(BBId);
+    groupAccesses.push_back(ArenaVector <ArenaString>());
+    return dataIn.size()-1;
+}
+
+unsigned int LSQ::getNumGroups() {
+    return groupBBs.size();
+}
+
+unsigned int LSQ::getGroupBB(unsigned int group) {
+    assert(group < groupBBs.size() && "Wrong group");
+    return groupBBs[group];
+}
+
+unsigned int LSQ::addLoad(int addressWidth, int dataWidth) {
+    assert(!groupAccesses.empty() && "Access added before any group");
+    unsigned int load = loadAddressPorts.size();
+    string name = "ld" + to_string(load);
+    groupAccesses.back().push_back(ArenaString(name.data(), name.size()));
+    loadAddressPorts.push_back(dataIn.size());
+    dataIn.push_back(Port(name + "_addr", addressWidth));
+    dataOut.push_back(Port(name + "_data", dataWidth));
+    connectedPorts.push_back(make_pair(nullptr, -1));
+    return load;
+}
+
+unsigned int LSQ::addStore(int addressWidth, int dataWidth) {
+    assert(!groupAccesses.empty() && "Access added before any group");
+    unsigned int store = storeAddressPorts.size();
+    string name = "st" + to_string(store);
+    groupAccesses.back().push_back(ArenaString(name.data(), name.size()));
+    storeAddressPorts.push_back(dataIn.size());
+    dataIn.push_back(Port(name + "_addr", addressWidth));
+    dataIn.push_back(Port(name + "_data", dataWidth));
+    return store;
+}
+
+unsigned int LSQ::getNumLoads() {
+    return loadAddressPorts.size();
+}
+
+unsigned int LSQ::getNumStores() {
+    return storeAddressPorts.size();
+}
+
+unsigned int LSQ::getLoadAddressPort(unsigned int load) {
+    assert(load < loadAddressPorts.size() && "Wrong load");
+    return loadAddressPorts[load];
+}
+
+unsigned int LSQ::getLoadDataPort(unsigned int load) {
+    assert(load < dataOut.size() && "Wrong load");
+    return load;
+}
+
+unsigned int LSQ::getStoreAddressPort(unsigned int store) {
+    assert(store < storeAddressPorts.size() && "Wrong store");
+    return storeAddressPorts[store];
+}
+
+unsigned int LSQ::getStoreDataPort(unsigned int store) {
+    // The data follows the address
+    return getStoreAddressPort(store) + 1;
+}
+
+void LSQ::setOutPort(unsigned int index, pair <Block*, int> connection) {
+    assert(index < connectedPorts.size() && "Wrong output port");
+    connectedPorts[index] = connection;
+}
+
+string LSQ::getGroupsText() {
+    string text;
+    for (unsigned int i = 0; i < groupBBs.size(); ++i) {
+        if (i > 0) text += "; ";
+        text += to_string(groupBBs[i]) + ":";
+        for (unsigned int j = 0; j < groupAccesses[i].size(); ++j) {
+            text += " ";
+            text += groupAccesses[i][j];
+        }
+    }
+    return text;
+}
+
+pair <Block*, int> LSQ::getConnectedPort() {
+    assert(!connectedPorts.empty() && "LSQ without loads");
+    return connectedPorts.back();
+}
+
+void LSQ::setConnectedPort(Block* block, int idxPort) {
+    assert(!connectedPorts.empty() && "LSQ without loads");
+    connectedPorts.back() = make_pair(block, idxPort);
+}
+
+void LSQ::setConnectedPort(pair <Block*, int> connection) {
+    assert(!connectedPorts.empty() && "LSQ without loads");
+    connectedPorts.back() = connection;
+}
+
+bool LSQ::connectionAvailable() {
+    return (!connectedPorts.empty() and connectedPorts.back().first == nullptr and
+        connectedPorts.back().second == -1);
+}
+
+unsigned int LSQ::getOutputPortIndex() {
+    assert(!connectedPorts.empty() && "LSQ without loads");
+    return connectedPorts.size()-1;
+}
+
+const Port& LSQ::getInputPort(unsigned int index) {
+    assert(index < dataIn.size() && "Wrong input port");
+    return dataIn[index];
+}
+
+unsigned int LSQ::getNumInputPorts() {
+    return dataIn.size();
+}
+
+unsigned int LSQ::getNumOutputPorts() {
+    return dataOut.size();
+}
+
+const Port& LSQ::getOutputPort(unsigned int index) {
+    assert(index < dataOut.size() && "Wrong output port");
+    return dataOut[index];
+}
+
+pair <Block*, int> LSQ::getOutputConnection(unsigned int index) {
+    assert(index < connectedPorts.size() && "Wrong output port");
+    return connectedPorts[index];
+}
+
+void LSQ::printBlock(DotBuffer& file) {
+    file << blockName << "[type = LSQ";
+    file << ", in = \"";
+    for (unsigned int i = 0; i < dataIn.size(); ++i) {
+        if (i > 0) file << " ";
+        file << dataIn[i];
+    }
+    file << "\", out = \"";
+    for (unsigned int i = 0; i < dataOut.size(); ++i) {
+        if (i > 0) file << " ";
+        file << dataOut[i];
+    }
+    file << "\"";
+    bool first = true;
+    for (unsigned int i = 0; i < dataIn.size(); ++i) {
+        if (dataIn[i].getDelay() > 0) {
+            if (first) {
+                first = false;
+                file << ", delay = \"";
+            }
+            else file << " ";
+            file << dataIn[i].getName() << ":" << dataIn[i].getDelay();
+        }
+    }
+    if (blockDelay > 0) {
+        if (first) {
+            first = false;
+            file << ", delay = \"";
+        }
+        else file << " ";
+        file << blockDelay;
+    }
+    for (unsigned int i = 0; i < dataOut.size(); ++i) {
+        if (dataOut[i].getDelay() > 0) {
+            if (first) {
+                first = false;
+                file << ", delay = \"";
+            }
+            else file << " ";
+            file << dataOut[i].getName() << ":" << dataOut[i].getDelay();
+        }
+    }
+    if (!first) file << "\"";
+    file << ", depth = " << depth;
+    file << ", groups = \"" << getGroupsText() << "\"";
+    file << "];\n";
+}
+
+void LSQ::printChannels(DotBuffer& file) {
+    for (unsigned int i = 0; i < dataOut.size(); ++i) {
+        assert(connectedPorts[i].first != nullptr and connectedPorts[i].second != -1 &&
+            "LSQ has some output port disconnected");
+        file << '\t' << blockName << " -> " << connectedPorts[i].first->getBlockName() <<
+            " [from = " << dataOut[i].getName() << ", to = " <<
+            connectedPorts[i].first->getInputPort(connectedPorts[i].second).getName();
+        unsigned int width = dataOut[i].getWidth();
+        file << ", color = ";
+        if (width == 0) file << "red";
+        else if (width == 1) file << "magenta";
+        else file << "blue";
+        file << "];\n";
+    }
+}
+
+
+/*
+ * =================================
+ *  Class Tagger
+ * =================================
+*/
+
+
+Tagger::Tagger(const BasicBlock* parentBB, unsigned int numTags, double blockDelay) :
+    Block("Tagger", parentBB, BlockType::Tagger_Block, blockDelay), freeIn("free", 0)
+{
+    this->numTags = numTags;
+}
+
+Tagger::~Tagger() {}
+
+unsigned int Tagger::getNumTags() {
+    return numTags;
+}
+
+void Tagger::setNumTags(unsigned int numTags) {
+    this->numTags = numTags;
+}
+
+unsigned int Tagger::addValue(int width) {
+    dataIn.push_back(Port("in" + to_string(dataIn.size()), width));
+    dataOut.push_back(Port("out" + to_string(dataOut.size()), width));
+    connectedPorts.push_back(make_pair(nullptr, -1));
+    return dataOut.size()-1;
+}
+
+unsigned int Tagger::getNumValues() {
+    return dataOut.size();
+}
+
+unsigned int Tagger::getFreePort() {
+    return dataIn.size();
+}
+
+void Tagger::setOutPort(unsigned int index, pair <Block*, int> connection) {
+    assert(index < connectedPorts.size() && "Wrong output port");
+    connectedPorts[index] = connection;
+}
+
+pair <Block*, int> Tagger::getConnectedPort() {
+    assert(!connectedPorts.empty() && "Tagger without values");
+    return connectedPorts.back();
+}
+
+void Tagger::setConnectedPort(Block* block, int idxPort) {
+    assert(!connectedPorts.empty() && "Tagger without values");
+    connectedPorts.back() = make_pair(block, idxPort);
+}
+
+void Tagger::setConnectedPort(pair <Block*, int> connection) {
+    assert(!connectedPorts.empty() && "Tagger without values");
+    connectedPorts.back() = connection;
+}
+
+bool Tagger::connectionAvailable() {
+    return (!connectedPorts.empty() and connectedPorts.back().first == nullptr and
+        connectedPorts.back().second == -1);
+}
+
+unsigned int Tagger::getOutputPortIndex() {
+    assert(!connectedPorts.empty() && "Tagger without values");
+    return connectedPorts.size()-1;
+}
+
+const Port& Tagger::getInputPort(unsigned int index) {
+    assert(index <= dataIn.size() && "Wrong input port");
+    if (index == dataIn.size()) return freeIn;
+    return dataIn[index];
+}
+
+unsigned int Tagger::getNumInputPorts() {
+    return dataIn.size() + 1;
+}
+
+unsigned int Tagger::getNumOutputPorts() {
+    return dataOut.size();
+}
+
+const Port& Tagger::getOutputPort(unsigned int index) {
+    assert(index < dataOut.size() && "Wrong output port");
+    return dataOut[index];
+}
+
+pair <Block*, int> Tagger::getOutputConnection(unsigned int index) {
+    assert(index < connectedPorts.size() && "Wrong output port");
+    return connectedPorts[index];
+}
+
+void Tagger::printBlock(DotBuffer& file) {
+    file << blockName << "[type = Tagger";
+    file << ", in = \"";
+    for (unsigned int i = 0; i < dataIn.size(); ++i) file << dataIn[i] << " ";
+    file << freeIn << "\", out = \"";
+    for (unsigned int i = 0; i < dataOut.size(); ++i) {
+        if (i > 0) file << " ";
+        file << dataOut[i];
+    }
+    file << "\"";
+    bool first = true;
+    for (unsigned int i = 0; i <= dataIn.size(); ++i) {
+        const Port& port = getInputPort(i);
+        if (port.getDelay() > 0) {
+            if (first) {
+                first = false;
+                file << ", delay = \"";
+            }
+            else file << " ";
+            file << port.getName() << ":" << port.getDelay();
+        }
+    }
+    if (blockDelay > 0) {
+        if (first) {
+            first = false;
+            file << ", delay = \"";
+        }
+        else file << " ";
+        file << blockDelay;
+    }
+    for (unsigned int i = 0; i < dataOut.size(); ++i) {
+        if (dataOut[i].getDelay() > 0) {
+            if (first) {
+                first = false;
+                file << ", delay = \"";
+            }
+            else file << " ";
+            file << dataOut[i].getName() << ":" << dataOut[i].getDelay();
+        }
+    }
+    if (!first) file << "\"";
+    file << ", tags = " << numTags;
+    file << "];\n";
+}
+
+void Tagger::printChannels(DotBuffer& file) {
+    for (unsigned int i = 0; i < dataOut.size(); ++i) {
+        assert(connectedPorts[i].first != nullptr and connectedPorts[i].second != -1 &&
+            "Tagger has some output port disconnected");
+        file << '\t' << blockName << " -> " << connectedPorts[i].first->getBlockName() <<
+            " [from = " << dataOut[i].getName() << ", to = " <<
+            connectedPorts[i].first->getInputPort(connectedPorts[i].second).getName();
+        unsigned int width = dataOut[i].getWidth();
+        file << ", color = ";
+        if (width == 0) file << "red";
+        else if (width == 1) file << "magenta";
+        else file << "blue";
+        file << "];\n";
+    }
+}
+
+
+/*
+ * =================================
+ *  Class Untagger
+ * =================================
+*/
+
+
+Untagger::Untagger(const BasicBlock* parentBB, unsigned int numTags, double blockDelay) :
+    Block("Untagger", parentBB, BlockType::Untagger_Block, blockDelay), freeOut("free", 0)
+{
+    this->numTags = numTags;
+    connectedPorts.push_back(make_pair(nullptr, -1));
+}
+
+Untagger::~Untagger() {}
+
+unsigned int Untagger::getNumTags() {
+    return numTags;
+}
+
+void Untagger::setNumTags(unsigned int numTags) {
+    this->numTags = numTags;
+}
+
+unsigned int Untagger::addValue(int width) {
+    dataIn.push_back(Port("in" + to_string(dataIn.size()), width));
+    dataOut.push_back(Port("out" + to_string(dataOut.size()), width));
+    // The connection of the free port stays the last one
+    connectedPorts.insert(connectedPorts.end() - 1, make_pair(nullptr, -1));
+    return dataOut.size()-1;
+}
+
+unsigned int Untagger::getNumValues() {
+    return dataOut.size();
+}
+
+unsigned int Untagger::getFreePort() {
+    return dataOut.size();
+}
+
+void Untagger::setOutPort(unsigned int index, pair <Block*, int> connection) {
+    assert(index < connectedPorts.size() && "Wrong output port");
+    connectedPorts[index] = connection;
+}
+
+pair <Block*, int> Untagger::getConnectedPort() {
+    assert(!dataOut.empty() && "Untagger without values");
+    return connectedPorts[dataOut.size()-1];
+}
+
+void Untagger::setConnectedPort(Block* block, int idxPort) {
+    assert(!dataOut.empty() && "Untagger without values");
+    connectedPorts[dataOut.size()-1] = make_pair(block, idxPort);
+}
+
+void Untagger::setConnectedPort(pair <Block*, int> connection) {
+    assert(!dataOut.empty() && "Untagger without values");
+    connectedPorts[dataOut.size()-1] = connection;
+}
+
+bool Untagger::connectionAvailable() {
+    return (!dataOut.empty() and connectedPorts[dataOut.size()-1].first == nullptr and
+        connectedPorts[dataOut.size()-1].second == -1);
+}
+
+unsigned int Untagger::getOutputPortIndex() {
+    assert(!dataOut.empty() && "Untagger without values");
+    return dataOut.size()-1;
+}
+
+const Port& Untagger::getInputPort(unsigned int index) {
+    assert(index < dataIn.size() && "Wrong input port");
+    return dataIn[index];
+}
+
+unsigned int Untagger::getNumInputPorts() {
+    return dataIn.size();
+}
+
+unsigned int Untagger::getNumOutputPorts() {
+    return dataOut.size() + 1;
+}
+
+const Port& Untagger::getOutputPort(unsigned int index) {
+    assert(index <= dataOut.size() && "Wrong output port");
+    if (index == dataOut.size()) return freeOut;
+    return dataOut[index];
+}
+
+pair <Block*, int> Untagger::getOutputConnection(unsigned int index) {
+    assert(index < connectedPorts.size() && "Wrong output port");
+    return connectedPorts[index];
+}
+
+void Untagger::printBlock(DotBuffer& file) {
+    file << blockName << "[type = Untagger";
+    file << ", in = \"";
+    for (unsigned int i = 0; i < dataIn.size(); ++i) {
+        if (i > 0) file << " ";
+        file << dataIn[i];
+    }
+    file << "\", out = \"";
+    for (unsigned int i = 0; i < dataOut.size(); ++i) file << dataOut[i] << " ";
+    file << freeOut << "\"";
+    bool first = true;
+    for (unsigned int i = 0; i < dataIn.size(); ++i) {
+        if (dataIn[i].getDelay() > 0) {
+            if (first) {
+                first = false;
+                file << ", delay = \"";
+            }
+            else file << " ";
+            file << dataIn[i].getName() << ":" << dataIn[i].getDelay();
+        }
+    }
+    if (blockDelay > 0) {
+        if (first) {
+            first = false;
+            file << ", delay = \"";
+        }
+        else file << " ";
+        file << blockDelay;
+    }
+    for (unsigned int i = 0; i <= dataOut.size(); ++i) {
+        const Port& port = getOutputPort(i);
+        if (port.getDelay() > 0) {
+            if (first) {
+                first = false;
+                file << ", delay = \"";
+            }
+            else file << " ";
+            file << port.getName() << ":" << port.getDelay();
+        }
+    }
+    if (!first) file << "\"";
+    file << ", tags = " << numTags;
+    file << "];\n";
+}
+
+void Untagger::printChannels(DotBuffer& file) {
+    for (unsigned int i = 0; i < connectedPorts.size(); ++i) {
+        assert(connectedPorts[i].first != nullptr and connectedPorts[i].second != -1 &&
+            "Untagger has some output port disconnected");
+        const Port& port = getOutputPort(i);
+        file << '\t' << blockName << " -> " << connectedPorts[i].first->getBlockName() <<
+            " [from = " << port.getName() << ", to = " <<
+            connectedPorts[i].first->getInputPort(connectedPorts[i].second).getName();
+        unsigned int width = port.getWidth();
+        file << ", color = ";
+        if (width == 0) file << "red";
+        else if (width == 1) file << "magenta";
+        else file << "blue";
+        file << "];\n";
+    }
+}
+
+
+/*
+ * =================================
+ *  Class FunctionCall (Dummy block)
+ * =================================
+*/
+
+
+FunctionCall::FunctionCall(const BasicBlock* parentBB) : 
+    Block("", parentBB, BlockType::FunctionCall_Block, 0),
+    inputControlPort(nullptr, -1), connectedResultPort(nullptr, -1),
+    connectedControlPort(nullptr, -1) {}
+
+FunctionCall::~FunctionCall() {}
+
+
+void FunctionCall::setConnectedControlPort(Block* block, int idxPort) {
+    connectedControlPort = make_pair(block, idxPort);
+}
+
+pair <Block*, int> FunctionCall::getConnectedPort() {
+    return connectedResultPort;
+}
+
+void FunctionCall::setConnectedPort(Block* block, int idxPort) {
+    connectedResultPort = make_pair(block, idxPort);
+}
+
+void FunctionCall::setConnectedPort(pair <Block*, int> connection) {
+    connectedResultPort = connection;
+}
+
+bool FunctionCall::connectionAvailable() {
+    return (connectedResultPort.first == nullptr and
+        connectedResultPort.second == -1);
+}
+
+unsigned int FunctionCall::getOutputPortIndex() {
+    // The result of the call, when it is the argument of another call
+    return 0;
+}
+
+const Port& FunctionCall::getInputPort(unsigned int index) {
+    assert(0 && "Not should be called");
+    static const Port noPort;
+    return noPort;
+}
+
+// The dummy block is never part of the final graph
+unsigned int FunctionCall::getNumInputPorts() {
+    return 0;
+}
+
+unsigned int FunctionCall::getNumOutputPorts() {
+    return 0;
+}
+
+const Port& FunctionCall::getOutputPort(unsigned int index) {
+    assert(0 && "Not should be called");
+    static const Port noPort;
+    return noPort;
+}
+
+pair <Block*, int> FunctionCall::getOutputConnection(unsigned int index) {
     assert(0 && "Not should be called");
+    return make_pair(nullptr, -1);
 }
 
 void FunctionCall::addInputArgPort(Block* block, int idxPort) {
@@ -1442,11 +2392,11 @@ pair <Block*, int> FunctionCall::getConnecControlPort() {
     return connectedControlPort;
 }
 
-void FunctionCall::printBlock(ostream &file) {
+void FunctionCall::printBlock(DotBuffer& file) {
     assert(0 && "Not should be called");
 }
 
-void FunctionCall::printChannels(ostream& file) {
+void FunctionCall::printChannels(DotBuffer& file) {
     assert(0 && "Not should be called");
 }
 
@@ -6,7 +6,12 @@
 #include <fstream>
 #include <assert.h>
 #include "SupportTypes.h"
-#include "llvm/IR/BasicBlock.h"
+
+/* The blocks only keep a reference to the BB of the LLVM IR they come from, so the
+    components can be used without LLVM, e.g. on graphs read from a DOT file */
+namespace llvm {
+    class BasicBlock;
+}
 
 using namespace std;
 using namespace llvm;
@@ -24,10 +29,18 @@ public:
     const BasicBlock* getParentBB();
 
     string getBlockName();
+    /* The name is the prefix shared by the blocks of the same kind followed by a number,
+        given once the whole graph is built so it does not depend on the order in which
+        the functions are processed */
+    string getNamePrefix();
+    void setInstanceNumber(unsigned int number);
+    // Used when the name is given from outside, like in a graph read from a DOT file
+    void setBlockName(const string& blockName);
     
     BlockType getBlockType();
     
-    void setBlockDelay(unsigned int blockDelay);
+    double getBlockDelay();
+    void setBlockDelay(double blockDelay);
 
     // We store in each block the connections of its output ports, storing for each output port
     //  which block and the index of which input port is connected with
@@ -40,17 +53,32 @@ public:
     // Used to get an input port that an output port is connected with
     virtual const Port& getInputPort(unsigned int index) = 0; 
 
-    virtual void printBlock(ostream& file) = 0;
-    virtual void printChannels(ostream& file) = 0;
+    /* Used to walk the ports and channels without knowing the type of the block. The
+        connection of an output port not connected yet is (nullptr, -1) */
+    virtual unsigned int getNumInputPorts() = 0;
+    virtual unsigned int getNumOutputPorts() = 0;
+    virtual const Port& getOutputPort(unsigned int index) = 0;
+    virtual pair <Block*, int> getOutputConnection(unsigned int index) = 0;
+
+    // Replace the name, type, width and delay of a port that already exists
+    void setInputPort(unsigned int index, const Port& port);
+    void setOutputPort(unsigned int index, const Port& port);
+
+    // Connect an output port given by its index, whatever the type of the block
+    void setOutputConnection(unsigned int index, pair <Block*, int> connection);
+
+    virtual void printBlock(DotBuffer& file) = 0;
+    virtual void printChannels(DotBuffer& file) = 0;
 
 protected:
 
     Block();
-    Block(const string &blockName, const BasicBlock* parentBB,
-        BlockType type, unsigned int blockDelay);
-    string blockName;
+    Block(const string &namePrefix, const BasicBlock* parentBB,
+        BlockType type, double blockDelay);
+    ArenaString namePrefix;
+    ArenaString blockName;
     BlockType blockType;
-    unsigned int blockDelay;
+    double blockDelay;
     // Used to know where to place certain modules like forks
     const BasicBlock* parentBB;
 
@@ -62,13 +90,15 @@ class Operator : public Block {
 public:
 
     Operator(OpType opType, const BasicBlock* parentBB = nullptr, 
-        int portWidth = -1, unsigned int blockDelay = 0, 
+        int portWidth = -1, double blockDelay = 0, 
         unsigned int latency = 0, unsigned int II = 0);
     ~Operator();
 
     OpType getOpType();
+    unsigned int getLatency();
+    unsigned int getII();
 
-    unsigned int addInputPort(int portWidth = -1, unsigned int portDelay = 0);
+    unsigned int addInputPort(int portWidth = -1, double portDelay = 0);
 
     void setLatency(unsigned int latency);
     void setII(unsigned int II);
@@ -77,8 +107,25 @@ public:
     void setDataOutPortWidth(int width);
     void setDataPortWidth(int width);
 
-    void setDataInPortDelay(unsigned int index, unsigned int delay);
-    void setDataOutPortDelay(unsigned int delay);
+    void setDataInPortDelay(unsigned int index, double delay);
+    void setDataOutPortDelay(double delay);
+
+    /* Loads and stores can have more ports after their operands and result. The ones that
+        may access the same address are ordered with 0-width channels: an order input
+        waits for an operation before it, and the done output tells the ones after it that
+        the access is finished. The ones that go through a load-store queue send it the
+        addr (and the data of stores) and loads get the data back in an input */
+    unsigned int addMemoryInputPort(const string& name, int width);
+    unsigned int addMemoryOutputPort(const string& name, int width);
+    unsigned int addOrderInputPort();
+    void addOrderOutputPort();
+    bool hasOrderOutputPort();
+    void setOrderConnection(Block* block, int idxPort);
+    // Index of a port by its name, -1 if the operator does not have it
+    int findInputPort(const string& name);
+    int findOutputPort(const string& name);
+    // Output connection by index, the memory ports are after the result
+    void setOutPort(unsigned int index, pair <Block*, int> connection);
 
     pair <Block*, int> getConnectedPort() override;
     void setConnectedPort(Block* block, int idxPort) override;
@@ -86,20 +133,28 @@ public:
     bool connectionAvailable() override;
     unsigned int getOutputPortIndex() override;
     const Port& getInputPort(unsigned int index) override;
+    unsigned int getNumInputPorts() override;
+    unsigned int getNumOutputPorts() override;
+    const Port& getOutputPort(unsigned int index) override;
+    pair <Block*, int> getOutputConnection(unsigned int index) override;
 
-    void printBlock(ostream& file) override;
-    void printChannels(ostream& file) override;
+    void printBlock(DotBuffer& file) override;
+    void printChannels(DotBuffer& file) override;
 
 private:
 
     OpType opType;
-    vector <Port> dataIn;
+    ArenaVector <Port> dataIn;
     Port dataOut;
     unsigned int latency;
     unsigned int II;
     pair <Block*, int> connectedPort;
-    // Used to assign a number to each block of the same type we create
-    static vector<unsigned int> instanceCounter;
+    unsigned int numOrderIn;
+    ArenaVector <Port> memoryOut;
+    ArenaVector <pair <Block*, int> > memoryConnections;
+
+    // Stores do not have a result
+    unsigned int getNumDataOutputs();
 
 };
 
@@ -109,17 +164,19 @@ class Buffer : public Block {
 public:
 
     Buffer(const BasicBlock* parentBB = nullptr, int portWidth = -1,
-        unsigned int blockDelay = 0, unsigned int slots = 2, 
+        double blockDelay = 0, unsigned int slots = 2, 
         bool transparent = false);
     ~Buffer();
 
+    unsigned int getNumSlots();
     void setNumSlots(unsigned int slots);
+    bool isTransparent();
     void setTransparent(bool transparent);
 
     void setDataPortWidth(int width);
 
-    void setDataInPortDelay(unsigned int delay);
-    void setDataOutPortDelay(unsigned int delay);
+    void setDataInPortDelay(double delay);
+    void setDataOutPortDelay(double delay);
 
     pair <Block*, int> getConnectedPort() override;
     void setConnectedPort(Block* block, int idxPort) override;
@@ -127,9 +184,13 @@ public:
     bool connectionAvailable() override;
     unsigned int getOutputPortIndex() override;
     const Port& getInputPort(unsigned int index) override;
+    unsigned int getNumInputPorts() override;
+    unsigned int getNumOutputPorts() override;
+    const Port& getOutputPort(unsigned int index) override;
+    pair <Block*, int> getOutputConnection(unsigned int index) override;
 
-    void printBlock(ostream &file) override;
-    void printChannels(ostream& file) override;
+    void printBlock(DotBuffer& file) override;
+    void printChannels(DotBuffer& file) override;
 
 private:
 
@@ -138,7 +199,6 @@ private:
     unsigned int slots;
     bool transparent;
     pair <Block*, int> connectedPort;
-    static unsigned int instanceCounter;
 
 };
 
@@ -149,8 +209,16 @@ public:
 
     void setDataPortWidth(int width);
 
-    void setControlPortDelay(unsigned int delay);
-    void setDataPortDelay(unsigned int delay);
+    void setControlPortDelay(double delay);
+    void setDataPortDelay(double delay);
+
+    /* A source has no control port and offers its value all the time. It can only feed
+        blocks that also wait for other inputs, that do not take it on their own */
+    void setSource(bool source);
+    bool isSource();
+
+    // Value as printed in the DOT file
+    virtual string getValueText() = 0;
  
     pair <Block*, int> getConnectedPort() override;
     void setConnectedPort(Block* block, int idxPort) override;
@@ -158,19 +226,23 @@ public:
     bool connectionAvailable() override;
     unsigned int getOutputPortIndex() override;
     const Port& getInputPort(unsigned int index) override;
+    unsigned int getNumInputPorts() override;
+    unsigned int getNumOutputPorts() override;
+    const Port& getOutputPort(unsigned int index) override;
+    pair <Block*, int> getOutputConnection(unsigned int index) override;
 
-    void printChannels(ostream& file) override;
+    void printChannels(DotBuffer& file) override;
 
 protected:
 
     ConstantInterf();
     ConstantInterf(const BasicBlock* parentBB, int portWidth, 
-        unsigned int blockDelay);
+        double blockDelay);
     virtual ~ConstantInterf();
     Port controlIn;
     Port dataOut;
     pair <Block*, int> connectedPort;
-    static unsigned int instanceCounter;
+    bool source;
 
 };
 
@@ -180,12 +252,14 @@ class Constant : public ConstantInterf {
 public:
 
     Constant(T value, const BasicBlock* parentBB = nullptr, 
-        int portWidth = -1, unsigned int blockDelay = 0);
+        int portWidth = -1, double blockDelay = 0);
     ~Constant();
 
     void setValue(T value);
 
-    void printBlock(ostream &file) override;
+    string getValueText() override;
+
+    void printBlock(DotBuffer& file) override;
 
 private:
 
@@ -194,7 +268,7 @@ private:
 
 template <typename T>
 Constant<T>::Constant(T value, const BasicBlock* parentBB, 
-    int portWidth, unsigned int blockDelay)
+    int portWidth, double blockDelay)
     : ConstantInterf(parentBB, portWidth, blockDelay)
 {
     this->value = value;
@@ -211,12 +285,21 @@ void Constant<T>::setValue(T value) {
 }
 
 template <typename T>
-void Constant<T>::printBlock(ostream &file) {
+string Constant<T>::getValueText() {
+    DotBuffer text;
+    text << value;
+    return text.getText();
+}
+
+template <typename T>
+void Constant<T>::printBlock(DotBuffer& file) {
     file << blockName << "[type = Constant";
-    file << ", in = \"" << controlIn << "\"";
+    file << ", in = \"";
+    if (!source) file << controlIn;
+    file << "\"";
     file << ", out = \"" << dataOut << "\"";
     bool first = true;
-    if (controlIn.getDelay() > 0) {
+    if (!source and controlIn.getDelay() > 0) {
         first = false;
         file << ", delay = \"";
         file << controlIn.getName() << ":" << controlIn.getDelay();
@@ -228,7 +311,7 @@ void Constant<T>::printBlock(ostream &file) {
         }
         else file << " ";
         if (blockDelay > 0) file << blockDelay << " "; 
-        file << " " << dataOut.getName() << ":" << dataOut.getDelay() << "\""; 
+        file << dataOut.getName() << ":" << dataOut.getDelay(); 
     }
     else if (blockDelay > 0) {
         if (first) file << ", delay = ";
@@ -237,7 +320,7 @@ void Constant<T>::printBlock(ostream &file) {
     }
     if (!first) file << "\"";
     file << ", value = " << value;
-    file << "];" << endl;
+    file << "];\n";
 }
 
 
@@ -246,13 +329,13 @@ class Fork : public Block {
 public:
 
     Fork(const BasicBlock* parentBB = nullptr, int portWidth = -1,
-        unsigned int blockDelay = 0);
+        double blockDelay = 0);
     ~Fork();
 
     void setDataPortWidth(int width);
 
-    void setDataInPortDelay(unsigned int delay);
-    void setDataOutPortDelay(unsigned int index, unsigned int delay);
+    void setDataInPortDelay(double delay);
+    void setDataOutPortDelay(unsigned int index, double delay);
 
     pair <Block*, int> getConnectedPort() override;
     void setConnectedPort(Block* block, int idxPort) override;
@@ -260,17 +343,22 @@ public:
     bool connectionAvailable() override;
     unsigned int getOutputPortIndex() override;
     const Port& getInputPort(unsigned int index) override;
+    unsigned int getNumInputPorts() override;
+    unsigned int getNumOutputPorts() override;
+    const Port& getOutputPort(unsigned int index) override;
+    pair <Block*, int> getOutputConnection(unsigned int index) override;
     void setOutPort(unsigned int index, pair <Block*, int> connection);
+    // Drops the output ports that are not connected and numbers the others again
+    void removeDisconnectedPorts();
 
-    void printBlock(ostream &file) override;
-    void printChannels(ostream& file) override;
+    void printBlock(DotBuffer& file) override;
+    void printChannels(DotBuffer& file) override;
 
 private:
 
     Port dataIn;
-    vector <Port> dataOut;
-    static unsigned int instanceCounter;
-    vector <pair <Block*, int> > connectedPorts;
+    ArenaVector <Port> dataOut;
+    ArenaVector <pair <Block*, int> > connectedPorts;
 
 };
 
@@ -280,15 +368,15 @@ class Merge : public Block {
 public:
 
     Merge(const BasicBlock* parentBB = nullptr, int portWidth = -1,
-        unsigned int blockDelay = 0);
+        double blockDelay = 0);
     ~Merge();
 
-    unsigned int addDataInPort(unsigned int delay = 0);
+    unsigned int addDataInPort(double delay = 0);
 
     void setDataPortWidth(int width);
 
-    void setDataInPortDelay(unsigned int index, unsigned int delay);
-    void setDataOutPortDelay(unsigned int delay);
+    void setDataInPortDelay(unsigned int index, double delay);
+    void setDataOutPortDelay(double delay);
 
     pair <Block*, int> getConnectedPort() override;
     void setConnectedPort(Block* block, int idxPort) override;
@@ -296,15 +384,18 @@ public:
     bool connectionAvailable() override;
     unsigned int getOutputPortIndex() override;
     const Port& getInputPort(unsigned int index) override;
+    unsigned int getNumInputPorts() override;
+    unsigned int getNumOutputPorts() override;
+    const Port& getOutputPort(unsigned int index) override;
+    pair <Block*, int> getOutputConnection(unsigned int index) override;
 
-    void printBlock(ostream &file) override;
-    void printChannels(ostream& file) override;
+    void printBlock(DotBuffer& file) override;
+    void printChannels(DotBuffer& file) override;
 
 private:
 
-    vector <Port> dataIn;
+    ArenaVector <Port> dataIn;
     Port dataOut;
-    static unsigned int instanceCounter;
     pair <Block*, int> connectedPort;
 };
 
@@ -314,15 +405,15 @@ class Select : public Block {
 public:
 
     Select(const BasicBlock* parentBB = nullptr, int portWidth = -1, 
-        unsigned int blockDelay = 0);
+        double blockDelay = 0);
     ~Select();
 
     void setDataPortWidth(int width);
 
-    void setDataTruePortDelay(unsigned int delay);
-    void setDataFalsePortDelay(unsigned int delay);
-    void setConditionPortDelay(unsigned int delay);
-    void setDataOutPortDelay(unsigned int delay);
+    void setDataTruePortDelay(double delay);
+    void setDataFalsePortDelay(double delay);
+    void setConditionPortDelay(double delay);
+    void setDataOutPortDelay(double delay);
 
     pair <Block*, int> getConnectedPort() override;
     void setConnectedPort(Block* block, int idxPort) override;
@@ -330,9 +421,13 @@ public:
     bool connectionAvailable() override;
     unsigned int getOutputPortIndex() override;
     const Port& getInputPort(unsigned int index) override;
+    unsigned int getNumInputPorts() override;
+    unsigned int getNumOutputPorts() override;
+    const Port& getOutputPort(unsigned int index) override;
+    pair <Block*, int> getOutputConnection(unsigned int index) override;
 
-    void printBlock(ostream &file) override;
-    void printChannels(ostream& file) override;
+    void printBlock(DotBuffer& file) override;
+    void printChannels(DotBuffer& file) override;
 
 private:
 
@@ -340,7 +435,6 @@ private:
     Port dataFalse;
     Port condition;
     Port dataOut;
-    static unsigned int instanceCounter;
     pair <Block*, int> connectedPort;
 
 };
@@ -350,15 +444,15 @@ class Branch : public Block {
 public:
 
     Branch(const BasicBlock* parentBB = nullptr, int portWidth = -1,
-        unsigned int blockDelay = 0);
+        double blockDelay = 0);
     ~Branch();
 
     void setDataPortWidth(int width);
 
-    void setDataInPortDelay(unsigned int delay);
-    void setConditionPortDelay(unsigned int delay);
-    void setDataTruePortDelay(unsigned int delay);
-    void setDataFalsePortDelay(unsigned int delay);
+    void setDataInPortDelay(double delay);
+    void setConditionPortDelay(double delay);
+    void setDataTruePortDelay(double delay);
+    void setDataFalsePortDelay(double delay);
 
     pair <Block*, int> getConnectedPort() override;
     void setConnectedPort(Block* block, int idxPort) override;
@@ -366,11 +460,15 @@ public:
     bool connectionAvailable() override;
     unsigned int getOutputPortIndex() override;
     const Port& getInputPort(unsigned int index) override;
+    unsigned int getNumInputPorts() override;
+    unsigned int getNumOutputPorts() override;
+    const Port& getOutputPort(unsigned int index) override;
+    pair <Block*, int> getOutputConnection(unsigned int index) override;
 
     void setCurrentPort(bool currentPort);
 
-    void printBlock(ostream &file) override;
-    void printChannels(ostream& file) override;
+    void printBlock(DotBuffer& file) override;
+    void printChannels(DotBuffer& file) override;
 
 private:
 
@@ -378,7 +476,6 @@ private:
     Port condition;
     Port dataTrue;
     Port dataFalse;
-    static unsigned int instanceCounter;
     pair <Block*, int> connectedPortTrue;
     pair <Block*, int> connectedPortFalse;
     // Used to modify true port or false port, permitting the use of the overrided methods
@@ -392,17 +489,17 @@ class Demux : public Block {
 public:
 
     Demux(const BasicBlock* parentBB = nullptr, int portWidth = -1, 
-        unsigned int blockDelay = 0);
+        double blockDelay = 0);
     ~Demux();
 
-    unsigned int addControlInPort(unsigned int delay = 0);
-    void addDataOutPort(unsigned int delay = 0);
+    unsigned int addControlInPort(double delay = 0);
+    void addDataOutPort(double delay = 0);
     
     void setDataPortWidth(int width);
 
-    void setControlPortDelay(unsigned int index, unsigned int delay);
-    void setDataInPortDelay(unsigned int delay);
-    void setDataOutPortDelay(unsigned int index, unsigned int delay);
+    void setControlPortDelay(unsigned int index, double delay);
+    void setDataInPortDelay(double delay);
+    void setDataOutPortDelay(unsigned int index, double delay);
 
     void setCurrentConnectedPort(unsigned int current);
 
@@ -412,17 +509,20 @@ public:
     bool connectionAvailable() override;
     unsigned int getOutputPortIndex() override;
     const Port& getInputPort(unsigned int index) override;
+    unsigned int getNumInputPorts() override;
+    unsigned int getNumOutputPorts() override;
+    const Port& getOutputPort(unsigned int index) override;
+    pair <Block*, int> getOutputConnection(unsigned int index) override;
 
-    void printBlock(ostream &file) override;
-    void printChannels(ostream& file) override;
+    void printBlock(DotBuffer& file) override;
+    void printChannels(DotBuffer& file) override;
 
 private:
 
-    vector <Port> control;
+    ArenaVector <Port> control;
     Port dataIn;
-    vector <Port> dataOut;
-    static unsigned int instanceCounter;
-    vector <pair <Block*, int> > connectedPorts;
+    ArenaVector <Port> dataOut;
+    ArenaVector <pair <Block*, int> > connectedPorts;
     // We use it to set the port we want to connect using the override methods
     // just like with the branch 
     unsigned int currentConnected;
@@ -433,8 +533,8 @@ private:
 class EntryInterf : public Block { 
 public:
     
-    void setInPortDelay(unsigned int delay);
-    void setOutPortDelay(unsigned int delay);
+    void setInPortDelay(double delay);
+    void setOutPortDelay(double delay);
 
     pair <Block*, int> getConnectedPort() override;
     void setConnectedPort(Block* block, int idxPort) override;
@@ -442,15 +542,19 @@ public:
     bool connectionAvailable() override;
     unsigned int getOutputPortIndex() override;
     const Port& getInputPort(unsigned int index) override;
+    unsigned int getNumInputPorts() override;
+    unsigned int getNumOutputPorts() override;
+    const Port& getOutputPort(unsigned int index) override;
+    pair <Block*, int> getOutputConnection(unsigned int index) override;
 
-    virtual void printBlock(ostream &file) override;
-    void printChannels(ostream& file) override;
+    virtual void printBlock(DotBuffer& file) override;
+    void printChannels(DotBuffer& file) override;
 
 
 protected:
     EntryInterf();
     EntryInterf(const string& blockName, const BasicBlock* parentBB, 
-        int portWidth = -1, unsigned int blockDelay = 0);
+        int portWidth = -1, double blockDelay = 0);
     virtual ~EntryInterf();
     Port inPort;
     Port outPort;
@@ -463,12 +567,11 @@ class Entry : public EntryInterf {
 
 public:
 
-    Entry(const BasicBlock* parentBB = nullptr, unsigned int blockDelay = 0);
+    Entry(const BasicBlock* parentBB = nullptr, double blockDelay = 0);
     ~Entry();
   
 private:
 
-    static unsigned int instanceCounter;
 
 };
 
@@ -478,14 +581,13 @@ class Argument : public EntryInterf {
 public:
 
     Argument(const BasicBlock* parentBB = nullptr, int portWidth = -1, 
-        unsigned int blockDelay = 0);
+        double blockDelay = 0);
     ~Argument();
 
     void setDataPortWidth(int width);
 
 private:
 
-    static unsigned int instanceCounter;
 
 };
 
@@ -494,8 +596,8 @@ private:
 class ExitInterf : public Block {
 public:
 
-    void setInPortDelay(unsigned int delay);
-    void setOutPortDelay(unsigned int delay);
+    void setInPortDelay(double delay);
+    void setOutPortDelay(double delay);
 
     pair <Block*, int> getConnectedPort() override;
     void setConnectedPort(Block* block, int idxPort) override;
@@ -503,15 +605,19 @@ public:
     bool connectionAvailable() override;
     unsigned int getOutputPortIndex() override;
     const Port& getInputPort(unsigned int index) override;
+    unsigned int getNumInputPorts() override;
+    unsigned int getNumOutputPorts() override;
+    const Port& getOutputPort(unsigned int index) override;
+    pair <Block*, int> getOutputConnection(unsigned int index) override;
 
-    virtual void printBlock(ostream &file) override;
-    void printChannels(ostream& file) override;
+    virtual void printBlock(DotBuffer& file) override;
+    void printChannels(DotBuffer& file) override;
 
 
 protected:
     ExitInterf();
     ExitInterf(const string& blockName, const BasicBlock* parentBB, 
-        int portWidth = -1, unsigned  int blockDelay = 0);
+        int portWidth = -1, double blockDelay = 0);
     virtual ~ExitInterf();
     Port inPort;
     Port outPort;
@@ -524,12 +630,11 @@ class Exit : public ExitInterf {
 
 public:
 
-    Exit(const BasicBlock* parentBB = nullptr, unsigned int blockDelay = 0);
+    Exit(const BasicBlock* parentBB = nullptr, double blockDelay = 0);
     ~Exit();
 
 private:
 
-    static unsigned int instanceCounter;
 
 };
 
@@ -539,14 +644,212 @@ class Return : public ExitInterf {
 public:
 
     Return(const BasicBlock* parentBB = nullptr, int portWidth = -1, 
-        unsigned int blockDelay = 0);
+        double blockDelay = 0);
     ~Return();
     
     void setDataPortWidth(int width);
 
 private:
 
-    static unsigned int instanceCounter;
+
+};
+
+
+/* Consumes and discards every value that arrives to it, for the outputs of the blocks that
+    have to be connected but whose values are not used, like the side of a branch that
+    no block takes */
+class Sink : public Block {
+
+public:
+
+    Sink(const BasicBlock* parentBB = nullptr, int portWidth = -1, double blockDelay = 0);
+    ~Sink();
+
+    void setDataPortWidth(int width);
+    void setDataInPortDelay(double delay);
+
+    // It has no output ports
+    pair <Block*, int> getConnectedPort() override;
+    void setConnectedPort(Block* block, int idxPort) override;
+    void setConnectedPort(pair <Block*, int> connection) override;
+    bool connectionAvailable() override;
+    unsigned int getOutputPortIndex() override;
+    const Port& getInputPort(unsigned int index) override;
+    unsigned int getNumInputPorts() override;
+    unsigned int getNumOutputPorts() override;
+    const Port& getOutputPort(unsigned int index) override;
+    pair <Block*, int> getOutputConnection(unsigned int index) override;
+
+    void printBlock(DotBuffer& file) override;
+    void printChannels(DotBuffer& file) override;
+
+private:
+
+    Port dataIn;
+
+};
+
+/* Load-store queue, for the loads and stores whose dependences cannot be resolved when
+    the graph is built. The accesses are grouped by the BB they belong to, in program
+    order: each time the control of a BB arrives to the control port of its group, the
+    queue allocates the accesses of the group, and it does each one once the addresses of
+    the accesses allocated before are known and do not conflict with it. Loads send the
+    address and get the data back, stores send the address and the data. At most depth
+    accesses can be in the queue at the same time */
+class LSQ : public Block {
+
+public:
+
+    LSQ(const BasicBlock* parentBB = nullptr, unsigned int depth = 16,
+        double blockDelay = 0);
+    ~LSQ();
+
+    unsigned int getDepth();
+    void setDepth(unsigned int depth);
+
+    // Starts the group of a BB, by the id the FunctionGraph gives it. Returns its control port
+    unsigned int addGroup(unsigned int BBId);
+    unsigned int getNumGroups();
+    unsigned int getGroupBB(unsigned int group);
+
+    // Adds an access at the end of the last group, returns its number among loads or stores
+    unsigned int addLoad(int addressWidth = -1, int dataWidth = -1);
+    unsigned int addStore(int addressWidth = -1, int dataWidth = -1);
+    unsigned int getNumLoads();
+    unsigned int getNumStores();
+
+    // Input ports of the addresses and the data of the stores, output ports of the loads
+    unsigned int getLoadAddressPort(unsigned int load);
+    unsigned int getLoadDataPort(unsigned int load);
+    unsigned int getStoreAddressPort(unsigned int store);
+    unsigned int getStoreDataPort(unsigned int store);
+    void setOutPort(unsigned int index, pair <Block*, int> connection);
+
+    // The accesses of each group as in the DOT file, e.g. "1: ld0 st0; 3: ld1"
+    string getGroupsText();
+
+    // They use the data port of the last load added
+    pair <Block*, int> getConnectedPort() override;
+    void setConnectedPort(Block* block, int idxPort) override;
+    void setConnectedPort(pair <Block*, int> connection) override;
+    bool connectionAvailable() override;
+    unsigned int getOutputPortIndex() override;
+    const Port& getInputPort(unsigned int index) override;
+    unsigned int getNumInputPorts() override;
+    unsigned int getNumOutputPorts() override;
+    const Port& getOutputPort(unsigned int index) override;
+    pair <Block*, int> getOutputConnection(unsigned int index) override;
+
+    void printBlock(DotBuffer& file) override;
+    void printChannels(DotBuffer& file) override;
+
+private:
+
+    unsigned int depth;
+    // Control ports of the groups and ports of the accesses, in the order they are added
+    ArenaVector <Port> dataIn;
+    ArenaVector <Port> dataOut;
+    ArenaVector <pair <Block*, int> > connectedPorts;
+    ArenaVector <unsigned int> groupBBs;
+    // Accesses of each group, as the name they have in the ports
+    ArenaVector <ArenaVector <ArenaString> > groupAccesses;
+    ArenaVector <unsigned int> loadAddressPorts;
+    ArenaVector <unsigned int> storeAddressPorts;
+
+};
+
+/* Entry of a loop pipelined with tagged tokens. It waits for a value in each of its inputs,
+    the ones an execution of the loop starts with, and sends them to the loop with a tag
+    that is free, so the executions can overlap and the blocks of the loop only join values
+    with the same tag. It has numTags tags, and it stalls when all of them are in the loop.
+    The Untagger that closes the loop gives the tags back through the last input, free */
+class Tagger : public Block {
+
+public:
+
+    Tagger(const BasicBlock* parentBB = nullptr, unsigned int numTags = 8,
+        double blockDelay = 0);
+    ~Tagger();
+
+    unsigned int getNumTags();
+    void setNumTags(unsigned int numTags);
+
+    // Adds an input and its output, with the same index, that is returned
+    unsigned int addValue(int width = -1);
+    unsigned int getNumValues();
+    unsigned int getFreePort();
+    void setOutPort(unsigned int index, pair <Block*, int> connection);
+
+    // They use the output of the last value added
+    pair <Block*, int> getConnectedPort() override;
+    void setConnectedPort(Block* block, int idxPort) override;
+    void setConnectedPort(pair <Block*, int> connection) override;
+    bool connectionAvailable() override;
+    unsigned int getOutputPortIndex() override;
+    const Port& getInputPort(unsigned int index) override;
+    unsigned int getNumInputPorts() override;
+    unsigned int getNumOutputPorts() override;
+    const Port& getOutputPort(unsigned int index) override;
+    pair <Block*, int> getOutputConnection(unsigned int index) override;
+
+    void printBlock(DotBuffer& file) override;
+    void printChannels(DotBuffer& file) override;
+
+private:
+
+    unsigned int numTags;
+    ArenaVector <Port> dataIn;
+    ArenaVector <Port> dataOut;
+    ArenaVector <pair <Block*, int> > connectedPorts;
+    Port freeIn;
+
+};
+
+/* Exit of a loop pipelined with tagged tokens. It keeps the values that leave the loop
+    until it has one in each input with the same tag, and sends them without the tag in
+    the order the Tagger gave the tags, so the blocks after the loop get the values of
+    each execution in program order. Then the tag goes back to the Tagger through the
+    last output, free */
+class Untagger : public Block {
+
+public:
+
+    Untagger(const BasicBlock* parentBB = nullptr, unsigned int numTags = 8,
+        double blockDelay = 0);
+    ~Untagger();
+
+    unsigned int getNumTags();
+    void setNumTags(unsigned int numTags);
+
+    // Adds an input and its output, with the same index, that is returned
+    unsigned int addValue(int width = -1);
+    unsigned int getNumValues();
+    unsigned int getFreePort();
+    void setOutPort(unsigned int index, pair <Block*, int> connection);
+
+    // They use the output of the last value added
+    pair <Block*, int> getConnectedPort() override;
+    void setConnectedPort(Block* block, int idxPort) override;
+    void setConnectedPort(pair <Block*, int> connection) override;
+    bool connectionAvailable() override;
+    unsigned int getOutputPortIndex() override;
+    const Port& getInputPort(unsigned int index) override;
+    unsigned int getNumInputPorts() override;
+    unsigned int getNumOutputPorts() override;
+    const Port& getOutputPort(unsigned int index) override;
+    pair <Block*, int> getOutputConnection(unsigned int index) override;
+
+    void printBlock(DotBuffer& file) override;
+    void printChannels(DotBuffer& file) override;
+
+private:
+
+    unsigned int numTags;
+    ArenaVector <Port> dataIn;
+    ArenaVector <Port> dataOut;
+    // The last one is the one of the free port
+    ArenaVector <pair <Block*, int> > connectedPorts;
+    Port freeOut;
 
 };
 
@@ -576,16 +879,20 @@ public:
     pair <Block*, int> getConnecControlPort();
 
     const Port& getInputPort(unsigned int index) override;
+    unsigned int getNumInputPorts() override;
+    unsigned int getNumOutputPorts() override;
+    const Port& getOutputPort(unsigned int index) override;
+    pair <Block*, int> getOutputConnection(unsigned int index) override;
 
-    void printBlock(ostream &file) override;
-    void printChannels(ostream& file) override;
+    void printBlock(DotBuffer& file) override;
+    void printChannels(DotBuffer& file) override;
 
 private:
     /* Used to store the connections the first time we call each function, 
         of each parameter passed, that we do not know if we need the wrapper or only simply channels. 
         We connect them to this dummy block, storing the connections (Block + port index)
         to later modify them when we have defined the called function */
-    vector <pair <Block*, int> > inputArgumentPorts;
+    ArenaVector <pair <Block*, int> > inputArgumentPorts;
     /* The same as the one above, but we only store the connection passing the input control signals */
     pair <Block*, int> inputControlPort;
     /* Used to store the connection that the called function will have to connect the block storing
@@ -0,0 +1,103 @@
+
+#include "BlockArena.h"
+#include <cstddef>
+
+
+namespace DFGraphComp
+{
+
+
+/*
+ * =================================
+ *  Class BlockArena
+ * =================================
+*/
+
+
+atomic <unsigned int> BlockArena::nextPoolId(0);
+
+BlockArena::BlockArena() : memory(new ArenaMemory()) {
+    allocatedBytes = 0;
+}
+
+BlockArena::BlockArena(BlockArena&& arena) : memory(new ArenaMemory()) {
+    pools = std::move(arena.pools);
+    memory.swap(arena.memory);
+    blocks = std::move(arena.blocks);
+    allocatedBytes = arena.allocatedBytes;
+    arena.allocatedBytes = 0;
+}
+
+BlockArena& BlockArena::operator = (BlockArena&& arena) {
+    if (this != &arena) {
+        reset();
+        pools = std::move(arena.pools);
+        memory.swap(arena.memory);
+        blocks = std::move(arena.blocks);
+        allocatedBytes = arena.allocatedBytes;
+        arena.allocatedBytes = 0;
+    }
+    return *this;
+}
+
+BlockArena::~BlockArena() {
+    reset();
+}
+
+unsigned int BlockArena::getNumBlocks() {
+    return blocks.size();
+}
+
+size_t BlockArena::getAllocatedBytes() {
+    return allocatedBytes + memory->getAllocatedBytes();
+}
+
+const vector <Block*>& BlockArena::getBlocks() {
+    return blocks;
+}
+
+void BlockArena::destroyBlocks(const unordered_set <Block*>& removed) {
+    unsigned int numBlocks = 0;
+    for (unsigned int i = 0; i < blocks.size(); ++i) {
+        if (removed.count(blocks[i]) == 0) blocks[numBlocks++] = blocks[i];
+    }
+    blocks.resize(numBlocks);
+}
+
+void BlockArena::reset() {
+    /* All that the blocks own is in the memory of the arena, so they are dropped with
+        their slabs without running their destructors */
+    blocks.clear();
+    pools.clear();
+    memory->release();
+    allocatedBytes = 0;
+}
+
+void* BlockArena::allocate(unsigned int poolId, size_t size, size_t align) {
+    assert(align <= alignof(max_align_t) && "Block alignment not supported");
+    if (poolId >= pools.size()) {
+        pools.resize(poolId+1);
+    }
+    Pool& pool = pools[poolId];
+    if (pool.slabs.empty()) {
+        // Round the size so every element of the slab is aligned
+        pool.elemSize = (size + align - 1) / align * align;
+        pool.capacity = 0;
+        pool.used = 0;
+    }
+    if (pool.used == pool.capacity) {
+        /* Slabs grow with the number of blocks of the type, so small functions
+            do not reserve memory they will not use */
+        if (pool.capacity == 0) pool.capacity = minSlabElems;
+        else if (pool.capacity < maxSlabElems) pool.capacity *= 2;
+        pool.slabs.push_back(unique_ptr <char[]>(new char[pool.elemSize*pool.capacity]));
+        pool.used = 0;
+        allocatedBytes += pool.elemSize*pool.capacity;
+    }
+    void* memory = pool.slabs.back().get() + pool.elemSize*pool.used;
+    ++pool.used;
+    return memory;
+}
+
+
+} // Close namespace
@@ -0,0 +1,101 @@
+#ifndef BLOCKARENA_H
+#define BLOCKARENA_H
+
+#include <vector>
+#include <unordered_set>
+#include <memory>
+#include <atomic>
+#include <utility>
+#include <assert.h>
+#include "Block.h"
+#include "ArenaMemory.h"
+
+using namespace std;
+
+namespace DFGraphComp
+{
+
+
+/* Memory of the blocks of a FunctionGraph. Instead of allocating each block on its own,
+    each type of block has a pool made of big slabs where the blocks of that type are
+    placed one after the other. What the blocks own, their ports, names and connections,
+    is kept in the ArenaMemory of the arena, so no block needs its destructor: reset gives
+    back the slabs all together, without walking the blocks */
+class BlockArena {
+
+public:
+
+    BlockArena();
+    BlockArena(BlockArena&& arena);
+    BlockArena& operator = (BlockArena&& arena);
+    ~BlockArena();
+
+    BlockArena(const BlockArena&) = delete;
+    BlockArena& operator = (const BlockArena&) = delete;
+
+    template <typename T, typename... Args>
+    T* create(Args&&... args);
+
+    unsigned int getNumBlocks();
+    // Bytes reserved by the slabs of the pools and of the memory of the ports
+    size_t getAllocatedBytes();
+
+    // Blocks in the order they were created
+    const vector <Block*>& getBlocks();
+
+    /* Takes some blocks out before the others. Their memory is not given back until the
+        arena is reset */
+    void destroyBlocks(const unordered_set <Block*>& removed);
+
+    void reset();
+
+private:
+
+    struct Pool
+    {
+        size_t elemSize;
+        vector <unique_ptr <char[]> > slabs;
+        // Elements that fit and elements used in the last slab
+        unsigned int capacity;
+        unsigned int used;
+    };
+
+    // Number of blocks of the first slab of a pool and maximum of a slab
+    static const unsigned int minSlabElems = 8;
+    static const unsigned int maxSlabElems = 1024;
+
+    vector <Pool> pools;
+    // Kept apart so the containers of the blocks still find it when the arena is moved
+    unique_ptr <ArenaMemory> memory;
+    vector <Block*> blocks;
+    size_t allocatedBytes;
+
+    void* allocate(unsigned int poolId, size_t size, size_t align);
+
+    // Each type of block gets its own pool id the first time it is created
+    static atomic <unsigned int> nextPoolId;
+    template <typename T>
+    static unsigned int getPoolId();
+
+};
+
+
+template <typename T>
+unsigned int BlockArena::getPoolId() {
+    static const unsigned int poolId = nextPoolId++;
+    return poolId;
+}
+
+template <typename T, typename... Args>
+T* BlockArena::create(Args&&... args) {
+    void* blockMemory = allocate(getPoolId<T>(), sizeof(T), alignof(T));
+    ArenaMemory::Scope scope(memory.get());
+    T* block = new (blockMemory) T(std::forward<Args>(args)...);
+    blocks.push_back(block);
+    return block;
+}
+
+
+} // Close namespace
+
+#endif // BLOCKARENA_H
@@ -0,0 +1,396 @@
+#include "BufferPlacement.h"
+#include <algorithm>
+
+
+namespace DFGraphComp
+{
+
+
+/*
+ * =================================
+ *  Class BufferPlacement
+ * =================================
+*/
+
+
+const unsigned int BufferPlacement::cycleBufferSlots;
+const unsigned int BufferPlacement::maxCycles;
+const unsigned int BufferPlacement::maxCycleSteps;
+
+BufferPlacement::BufferPlacement(FunctionGraph& graph, double clockPeriod) 
+    : BufferPlacement(vector <FunctionGraph*>(1, &graph), clockPeriod) {}
+
+BufferPlacement::BufferPlacement(const vector <FunctionGraph*>& graphs, double clockPeriod)
+    : clockPeriod(clockPeriod), channelGraph(graphs),
+    blocks(channelGraph.getBlocks()), channels(channelGraph.getChannels()),
+    outChannels(channelGraph.getOutChannels()), sequential(channelGraph.getSequential())
+{
+    opaqueBuffers.assign(channels.size(), false);
+    transparentSlots.assign(channels.size(), 0);
+    timingBuffers.assign(channels.size(), false);
+    numOpaque = 0;
+    numTransparent = 0;
+    numSlots = 0;
+    numTiming = 0;
+    numViolations = 0;
+}
+
+BufferPlacement::~BufferPlacement() {}
+
+void BufferPlacement::placeBuffers() {
+    breakCombinationalCycles();
+    if (clockPeriod > 0) meetClockPeriod();
+    balancePaths();
+    insertBuffers();
+}
+
+unsigned int BufferPlacement::getNumOpaqueBuffers() {
+    return numOpaque;
+}
+
+unsigned int BufferPlacement::getNumTransparentBuffers() {
+    return numTransparent;
+}
+
+unsigned int BufferPlacement::getNumSlots() {
+    return numSlots;
+}
+
+unsigned int BufferPlacement::getNumTimingBuffers() {
+    return numTiming;
+}
+
+unsigned int BufferPlacement::getNumTimingViolations() {
+    return numViolations;
+}
+
+template <typename Accept>
+void BufferPlacement::findBackEdges(Accept accept, const vector <unsigned int>& components,
+    const vector <unsigned int>& sizes, vector <bool>& backEdges)
+{
+    unsigned int numBlocks = blocks.size();
+    backEdges.assign(channels.size(), false);
+    // 0 not visited, 1 in the current path, 2 finished
+    vector <unsigned char> state(numBlocks, 0);
+    vector <pair <unsigned int, unsigned int> > callStack;
+    /* The merges are the headers of the loops, starting from them the back edges are the
+        channels that return to the header */
+    vector <unsigned int> roots;
+    for (unsigned int i = 0; i < numBlocks; ++i) {
+        if (blocks[i]->getBlockType() == BlockType::Merge_Block) roots.push_back(i);
+    }
+    for (unsigned int i = 0; i < numBlocks; ++i) {
+        if (blocks[i]->getBlockType() != BlockType::Merge_Block) roots.push_back(i);
+    }
+    for (unsigned int i = 0; i < roots.size(); ++i) {
+        unsigned int root = roots[i];
+        if (state[root] != 0) continue;
+        // Blocks out of any cycle have no back edges
+        if (sizes[components[root]] == 1) {
+            bool selfLoop = false;
+            for (unsigned int channel : outChannels[root]) {
+                if (accept(channel) and channels[channel].to == root) selfLoop = true;
+            }
+            if (!selfLoop) continue;
+        }
+        state[root] = 1;
+        callStack.push_back(make_pair(root, 0));
+        while (!callStack.empty()) {
+            unsigned int block = callStack.back().first;
+            unsigned int& next = callStack.back().second;
+            if (next < outChannels[block].size()) {
+                unsigned int channel = outChannels[block][next++];
+                unsigned int to = channels[channel].to;
+                if (!accept(channel) or components[to] != components[block]) continue;
+                if (state[to] == 1) backEdges[channel] = true;
+                else if (state[to] == 0) {
+                    state[to] = 1;
+                    callStack.push_back(make_pair(to, 0));
+                }
+                continue;
+            }
+            state[block] = 2;
+            callStack.pop_back();
+        }
+    }
+}
+
+template <typename Accept>
+bool BufferPlacement::findSimpleCycles(Accept accept, const vector <unsigned int>& members,
+    const vector <unsigned int>& components, vector <vector <unsigned int> >& cycles)
+{
+    unsigned int numMembers = members.size();
+    unsigned int component = components[members[0]];
+    unordered_map <unsigned int, unsigned int> localIds;
+    for (unsigned int i = 0; i < numMembers; ++i) localIds[members[i]] = i;
+    vector <vector <unsigned int> > memberChannels(numMembers);
+    for (unsigned int i = 0; i < numMembers; ++i) {
+        for (unsigned int channel : outChannels[members[i]]) {
+            if (accept(channel) and components[channels[channel].to] == component) {
+                memberChannels[i].push_back(channel);
+            }
+        }
+    }
+    cycles.clear();
+    unsigned int numSteps = 0;
+    vector <bool> onPath(numMembers, false);
+    vector <unsigned int> path;
+    vector <pair <unsigned int, unsigned int> > callStack;
+    // Each cycle is found once, from its block with the lowest id
+    for (unsigned int start = 0; start < numMembers; ++start) {
+        onPath[start] = true;
+        callStack.push_back(make_pair(start, 0));
+        while (!callStack.empty()) {
+            unsigned int member = callStack.back().first;
+            unsigned int& next = callStack.back().second;
+            if (next == memberChannels[member].size()) {
+                onPath[member] = false;
+                callStack.pop_back();
+                if (!path.empty()) path.pop_back();
+                continue;
+            }
+            unsigned int channel = memberChannels[member][next++];
+            if (++numSteps > maxCycleSteps) return false;
+            unsigned int to = localIds[channels[channel].to];
+            if (to == start) {
+                cycles.push_back(path);
+                cycles.back().push_back(channel);
+                if (cycles.size() > maxCycles) return false;
+            }
+            else if (to > start and !onPath[to]) {
+                onPath[to] = true;
+                path.push_back(channel);
+                callStack.push_back(make_pair(to, 0));
+            }
+        }
+    }
+    return true;
+}
+
+template <typename Accept>
+void BufferPlacement::spreadCuts(Accept accept, const vector <unsigned int>& components,
+    const vector <unsigned int>& sizes, vector <bool>& cuts)
+{
+    vector <vector <unsigned int> > componentBlocks(sizes.size());
+    for (unsigned int i = 0; i < blocks.size(); ++i) {
+        if (sizes[components[i]] > 1) componentBlocks[components[i]].push_back(i);
+    }
+    vector <vector <unsigned int> > cycles;
+    for (unsigned int i = 0; i < componentBlocks.size(); ++i) {
+        if (componentBlocks[i].empty()) continue;
+        // Components with too many cycles keep the cuts of the search
+        if (!findSimpleCycles(accept, componentBlocks[i], components, cycles)) continue;
+        // Cycles of each channel, and cuts of each cycle
+        unordered_map <unsigned int, vector <unsigned int> > channelCycles;
+        vector <unsigned int> numCuts(cycles.size(), 0);
+        for (unsigned int j = 0; j < cycles.size(); ++j) {
+            for (unsigned int channel : cycles[j]) {
+                channelCycles[channel].push_back(j);
+                if (cuts[channel]) ++numCuts[j];
+            }
+        }
+        /* Moves a cut to another channel, or drops it when the channel is none, if no
+            cycle is left without cuts and fewer cycles have more than one, or the same
+            with one cut less. Each move makes it better, so it ends */
+        const unsigned int none = ~0u;
+        auto tryMove = [&](unsigned int from, unsigned int to) {
+            int sharedChange = 0;
+            for (unsigned int cycle : channelCycles[from]) {
+                if (numCuts[cycle] == 2) --sharedChange;
+                --numCuts[cycle];
+            }
+            if (to != none) {
+                for (unsigned int cycle : channelCycles[to]) {
+                    if (numCuts[cycle] == 1) ++sharedChange;
+                    ++numCuts[cycle];
+                }
+            }
+            bool broken = true;
+            for (unsigned int cycle : channelCycles[from]) {
+                if (numCuts[cycle] == 0) broken = false;
+            }
+            if (broken and (sharedChange < 0 or (sharedChange == 0 and to == none))) {
+                cuts[from] = false;
+                if (to != none) cuts[to] = true;
+                return true;
+            }
+            if (to != none) {
+                for (unsigned int cycle : channelCycles[to]) --numCuts[cycle];
+            }
+            for (unsigned int cycle : channelCycles[from]) ++numCuts[cycle];
+            return false;
+        };
+        vector <unsigned int> cycleChannels;
+        for (unordered_map <unsigned int, vector <unsigned int> >::const_iterator it =
+            channelCycles.begin(); it != channelCycles.end(); ++it)
+        {
+            cycleChannels.push_back(it->first);
+        }
+        sort(cycleChannels.begin(), cycleChannels.end());
+        bool moved = true;
+        while (moved) {
+            moved = false;
+            for (unsigned int j = 0; j < cycleChannels.size() and !moved; ++j) {
+                unsigned int from = cycleChannels[j];
+                if (!cuts[from]) continue;
+                moved = tryMove(from, none);
+                for (unsigned int k = 0; k < cycleChannels.size() and !moved; ++k) {
+                    if (!cuts[cycleChannels[k]]) moved = tryMove(from, cycleChannels[k]);
+                }
+            }
+        }
+    }
+}
+
+void BufferPlacement::breakCombinationalCycles() {
+    // A channel is combinational unless its source has a register
+    auto combinational = [this](unsigned int channel) {
+        return !sequential[channels[channel].from];
+    };
+    vector <unsigned int> components;
+    vector <unsigned int> sizes;
+    channelGraph.findComponents(combinational, components, sizes);
+    findBackEdges(combinational, components, sizes, opaqueBuffers);
+    spreadCuts(combinational, components, sizes, opaqueBuffers);
+}
+
+void BufferPlacement::meetClockPeriod() {
+    unsigned int numBlocks = blocks.size();
+    vector <vector <unsigned int> > inChannels(numBlocks);
+    vector <unsigned int> numPreds(numBlocks, 0);
+    for (unsigned int i = 0; i < channels.size(); ++i) {
+        inChannels[channels[i].to].push_back(i);
+        // Only the paths without a register need to be known before the next block
+        if (!sequential[channels[i].from] and !opaqueBuffers[i]) ++numPreds[channels[i].to];
+    }
+    // Delay from the last register to each output port, the registers start a path
+    vector <vector <double> > departures(numBlocks);
+    vector <unsigned int> order;
+    for (unsigned int i = 0; i < numBlocks; ++i) {
+        for (unsigned int j = 0; j < blocks[i]->getNumOutputPorts(); ++j) {
+            departures[i].push_back(blocks[i]->getOutputPort(j).getDelay());
+        }
+        if (numPreds[i] == 0) order.push_back(i);
+    }
+    for (unsigned int i = 0; i < order.size(); ++i) {
+        unsigned int block = order[i];
+        Block* b = blocks[block];
+        double outDelay = 0;
+        for (unsigned int j = 0; j < departures[block].size(); ++j) {
+            outDelay = max(outDelay, b->getOutputPort(j).getDelay());
+        }
+        // Delay after the input ports, none when they end at a register
+        double after = sequential[block] ? 0 : b->getBlockDelay() + outDelay;
+        double arrival = 0;
+        for (unsigned int channel : inChannels[block]) {
+            const Channel& c = channels[channel];
+            double inDelay = b->getInputPort(c.toPort).getDelay();
+            double start = 0;
+            if (!opaqueBuffers[channel]) start = departures[c.from][c.fromPort];
+            // A buffer only helps when the path does not start at this block
+            if (start > 0 and start + inDelay + after > clockPeriod) {
+                timingBuffers[channel] = true;
+                start = 0;
+            }
+            arrival = max(arrival, start + inDelay);
+        }
+        bool fits;
+        if (sequential[block]) {
+            fits = arrival <= clockPeriod and b->getBlockDelay() <= clockPeriod and
+                outDelay <= clockPeriod;
+        }
+        else {
+            fits = arrival + after <= clockPeriod;
+            for (unsigned int j = 0; j < departures[block].size(); ++j) {
+                departures[block][j] = arrival + b->getBlockDelay() + 
+                    b->getOutputPort(j).getDelay();
+            }
+        }
+        if (!fits) ++numViolations;
+        if (sequential[block]) continue;
+        for (unsigned int channel : outChannels[block]) {
+            if (opaqueBuffers[channel]) continue;
+            unsigned int to = channels[channel].to;
+            if (--numPreds[to] == 0) order.push_back(to);
+        }
+    }
+    assert(order.size() == numBlocks && "Combinational cycle left in the graph");
+}
+
+void BufferPlacement::balancePaths() {
+    /* Cycles left go through some register, and the channels closing them carry the
+        tokens of the next iteration, so they are not balanced with the rest */
+    auto notBuffered = [this](unsigned int channel) {
+        return !opaqueBuffers[channel];
+    };
+    vector <unsigned int> components;
+    vector <unsigned int> sizes;
+    channelGraph.findComponents(notBuffered, components, sizes);
+    vector <bool> loopEdges;
+    findBackEdges(notBuffered, components, sizes, loopEdges);
+
+    // Stages from the inputs of the graph to the inputs and outputs of each block
+    unsigned int numBlocks = blocks.size();
+    vector <unsigned int> numPreds(numBlocks, 0);
+    vector <bool> inDAG(channels.size(), false);
+    for (unsigned int i = 0; i < channels.size(); ++i) {
+        inDAG[i] = !opaqueBuffers[i] and !loopEdges[i];
+        if (inDAG[i]) ++numPreds[channels[i].to];
+    }
+    vector <unsigned int> stagesIn(numBlocks, 0);
+    vector <unsigned int> stagesOut(numBlocks, 0);
+    vector <unsigned int> order;
+    for (unsigned int i = 0; i < numBlocks; ++i) {
+        if (numPreds[i] == 0) order.push_back(i);
+    }
+    for (unsigned int i = 0; i < order.size(); ++i) {
+        unsigned int block = order[i];
+        stagesOut[block] = stagesIn[block] + channelGraph.getLatency(block);
+        for (unsigned int channel : outChannels[block]) {
+            if (!inDAG[channel]) continue;
+            unsigned int to = channels[channel].to;
+            unsigned int arrival = stagesOut[block] + (timingBuffers[channel] ? 1 : 0);
+            stagesIn[to] = max(stagesIn[to], arrival);
+            if (--numPreds[to] == 0) order.push_back(to);
+        }
+    }
+    assert(order.size() == numBlocks && "Cycle left in the graph");
+    for (unsigned int i = 0; i < channels.size(); ++i) {
+        if (!inDAG[i]) continue;
+        unsigned int arrival = stagesOut[channels[i].from] + (timingBuffers[i] ? 1 : 0);
+        unsigned int required = stagesIn[channels[i].to];
+        if (required > arrival) transparentSlots[i] = required - arrival;
+    }
+}
+
+void BufferPlacement::insertBuffers() {
+    for (unsigned int i = 0; i < channels.size(); ++i) {
+        bool opaque = opaqueBuffers[i] or timingBuffers[i];
+        if (!opaque and transparentSlots[i] == 0) continue;
+        const Channel& channel = channels[i];
+        Block* from = blocks[channel.from];
+        FunctionGraph& graph = channelGraph.getGraph(channel.from);
+        int width = from->getOutputPort(channel.fromPort).getWidth();
+        Buffer* buffer;
+        if (opaque) {
+            // A timing buffer also keeps the tokens of the path it makes longer
+            unsigned int slots = cycleBufferSlots + transparentSlots[i];
+            buffer = graph.createBlock<Buffer>(from->getParentBB(), width, 0, slots, false);
+            ++numOpaque;
+            if (timingBuffers[i]) ++numTiming;
+            numSlots += slots;
+        }
+        else {
+            buffer = graph.createBlock<Buffer>(from->getParentBB(), width, 0,
+                transparentSlots[i], true);
+            ++numTransparent;
+            numSlots += transparentSlots[i];
+        }
+        from->setOutputConnection(channel.fromPort, make_pair(buffer, 0));
+        buffer->setConnectedPort(blocks[channel.to], channel.toPort);
+        graph.addBlockNextTo(buffer, from, width == 0);
+    }
+}
+
+
+}
@@ -0,0 +1,118 @@
+#ifndef BUFFERPLACEMENT_H
+#define BUFFERPLACEMENT_H
+
+#include <vector>
+#include "ChannelGraph.h"
+
+using namespace std;
+
+namespace DFGraphComp
+{
+
+
+/* Places elastic buffers in the channels of a function graph once it is complete.
+
+    Throughput follows the usual model of elastic circuits: a loop carries a single token,
+    so a cycle with N sequential stages (opaque buffers and operators with latency) can
+    only start an iteration every N cycles, and a cycle without any is a combinational
+    loop that cannot be implemented. Every such cycle gets an opaque buffer, placed first on
+    the back edges of a depth first search started at the merges, that is on the channels
+    going back to the header of each loop. Each back edge closes a cycle through the tree
+    that no other buffer breaks, but a cycle that takes a forward edge can get two, and
+    then a stage more than it needs. So the simple cycles of each combinational component
+    are listed, when there are not too many, and the buffers are moved to other channels
+    of the cycles, or dropped, while fewer cycles get more than one. Some cycles may keep
+    two, as in some graphs no cut gives a single buffer to every cycle.
+
+    Then paths that fork and join again with a different number of stages are balanced:
+    the shorter one gets a transparent buffer with the difference as slots, so it can keep
+    the tokens that wait for the longer one without stalling the fork.
+
+    When a clock period is given, the combinational paths are also cut where they are
+    longer than it. A path adds the delay of each input port it enters, of the block and
+    of the output port it leaves, and it starts again at a register: at the output of an
+    opaque buffer, or inside an operator with latency, where the inputs end and the
+    outputs start. The paths are walked in topological order and a channel gets an opaque
+    buffer when the path through it would not fit in the block it enters, so the delays
+    are in the same units as the period. A block that does not fit even with all its
+    inputs buffered is a timing violation, as no buffer can fix it.
+
+    The graphs of the functions linked by their calls have to be given together, as the
+    channels to the blocks of functions that are not given are not considered: a cycle
+    through a called function is only seen, and broken, when both graphs are there. The
+    buffer of a channel goes to the graph of the block it leaves */
+class BufferPlacement {
+
+public:
+
+    // A clock period of 0 does not cut the paths for timing
+    BufferPlacement(FunctionGraph& graph, double clockPeriod = 0);
+    BufferPlacement(const vector <FunctionGraph*>& graphs, double clockPeriod = 0);
+    ~BufferPlacement();
+
+    void placeBuffers();
+
+    unsigned int getNumOpaqueBuffers();
+    unsigned int getNumTransparentBuffers();
+    unsigned int getNumSlots();
+    // Opaque buffers placed only to meet the clock period, included in the opaque ones
+    unsigned int getNumTimingBuffers();
+    unsigned int getNumTimingViolations();
+
+private:
+
+    typedef ChannelGraph::Channel Channel;
+
+    // Slots of the buffers that break cycles, so a token can enter while another leaves
+    static const unsigned int cycleBufferSlots = 2;
+    // Bounds of the cycles listed in a component, and of the steps to find them
+    static const unsigned int maxCycles = 4096;
+    static const unsigned int maxCycleSteps = 1 << 18;
+
+    double clockPeriod;
+    // The channels found before placing any buffer
+    ChannelGraph channelGraph;
+    const vector <Block*>& blocks;
+    const vector <Channel>& channels;
+    const vector <vector <unsigned int> >& outChannels;
+    const vector <bool>& sequential;
+    // For each channel, whether it gets an opaque buffer, or the slots of a transparent one
+    vector <bool> opaqueBuffers;
+    vector <unsigned int> transparentSlots;
+    /* Channels cut to meet the clock period. Unlike the cycle ones they are in the paths
+        that are balanced, with a stage more */
+    vector <bool> timingBuffers;
+
+    unsigned int numOpaque;
+    unsigned int numTransparent;
+    unsigned int numSlots;
+    unsigned int numTiming;
+    unsigned int numViolations;
+
+    // Back edges of a depth first search inside each component, starting from the merges
+    template <typename Accept>
+    void findBackEdges(Accept accept, const vector <unsigned int>& components,
+        const vector <unsigned int>& sizes, vector <bool>& backEdges);
+
+    /* Simple cycles of a component through the channels accepted, false when there are
+        more than the bound */
+    template <typename Accept>
+    bool findSimpleCycles(Accept accept, const vector <unsigned int>& members,
+        const vector <unsigned int>& components, vector <vector <unsigned int> >& cycles);
+    // Moves or drops the cuts of the cycles so they share as few cycles as possible
+    template <typename Accept>
+    void spreadCuts(Accept accept, const vector <unsigned int>& components,
+        const vector <unsigned int>& sizes, vector <bool>& cuts);
+
+    void breakCombinationalCycles();
+    void meetClockPeriod();
+    void balancePaths();
+    void insertBuffers();
+
+};
+
+
+}
+
+
+#endif // BUFFERPLACEMENT_H
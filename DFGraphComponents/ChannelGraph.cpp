@@ -0,0 +1,158 @@
+#include "ChannelGraph.h"
+
+
+namespace DFGraphComp
+{
+
+
+/*
+ * =================================
+ *  Class ChannelGraph
+ * =================================
+*/
+
+
+ChannelGraph::ChannelGraph(FunctionGraph& graph)
+    : ChannelGraph(vector <FunctionGraph*>(1, &graph)) {}
+
+ChannelGraph::ChannelGraph(const vector <FunctionGraph*>& graphs) : graphs(graphs) {
+    findChannels();
+}
+
+ChannelGraph::~ChannelGraph() {}
+
+vector <vector <unsigned int> > ChannelGraph::findLinkedGraphs(
+    const vector <FunctionGraph*>& graphs)
+{
+    unordered_map <Block*, unsigned int> blockGraphs;
+    for (unsigned int i = 0; i < graphs.size(); ++i) {
+        const vector <Block*>& createdBlocks = graphs[i]->getCreatedBlocks();
+        for (unsigned int j = 0; j < createdBlocks.size(); ++j) {
+            blockGraphs[createdBlocks[j]] = i;
+        }
+    }
+    // Union-find of the graphs, each group is represented by its first graph
+    vector <unsigned int> parents(graphs.size());
+    for (unsigned int i = 0; i < graphs.size(); ++i) parents[i] = i;
+    auto findRoot = [&parents](unsigned int graph) {
+        while (parents[graph] != graph) {
+            parents[graph] = parents[parents[graph]];
+            graph = parents[graph];
+        }
+        return graph;
+    };
+    for (unsigned int i = 0; i < graphs.size(); ++i) {
+        const vector <Block*>& createdBlocks = graphs[i]->getCreatedBlocks();
+        for (unsigned int j = 0; j < createdBlocks.size(); ++j) {
+            Block* block = createdBlocks[j];
+            if (block->getBlockType() == BlockType::FunctionCall_Block) continue;
+            for (unsigned int k = 0; k < block->getNumOutputPorts(); ++k) {
+                Block* to = block->getOutputConnection(k).first;
+                if (to == nullptr) continue;
+                unordered_map <Block*, unsigned int>::const_iterator it = blockGraphs.find(to);
+                if (it == blockGraphs.end() or it->second == i) continue;
+                unsigned int root = findRoot(i);
+                unsigned int otherRoot = findRoot(it->second);
+                if (root != otherRoot) parents[max(root, otherRoot)] = min(root, otherRoot);
+            }
+        }
+    }
+    vector <vector <unsigned int> > groups;
+    vector <int> groupIds(graphs.size(), -1);
+    for (unsigned int i = 0; i < graphs.size(); ++i) {
+        unsigned int root = findRoot(i);
+        if (groupIds[root] < 0) {
+            groupIds[root] = groups.size();
+            groups.push_back(vector <unsigned int>());
+        }
+        groups[groupIds[root]].push_back(i);
+    }
+    return groups;
+}
+
+const vector <FunctionGraph*>& ChannelGraph::getGraphs() {
+    return graphs;
+}
+
+FunctionGraph& ChannelGraph::getGraph(unsigned int block) {
+    return *graphs[blockGraphs[block]];
+}
+
+string ChannelGraph::getFunctionNames() {
+    if (graphs.size() == 1) return "Function " + graphs[0]->getFunctionName();
+    string names = "Functions ";
+    for (unsigned int i = 0; i < graphs.size(); ++i) {
+        if (i > 0) names += ", ";
+        names += graphs[i]->getFunctionName();
+    }
+    return names + " (linked by their calls)";
+}
+
+const vector <Block*>& ChannelGraph::getBlocks() {
+    return blocks;
+}
+
+const vector <ChannelGraph::Channel>& ChannelGraph::getChannels() {
+    return channels;
+}
+
+const vector <vector <unsigned int> >& ChannelGraph::getInChannels() {
+    return inChannels;
+}
+
+const vector <vector <unsigned int> >& ChannelGraph::getOutChannels() {
+    return outChannels;
+}
+
+const vector <bool>& ChannelGraph::getSequential() {
+    return sequential;
+}
+
+unsigned int ChannelGraph::getLatency(unsigned int block) {
+    Block* b = blocks[block];
+    if (b->getBlockType() == BlockType::Buffer_Block) {
+        return ((Buffer*)b)->isTransparent() ? 0 : 1;
+    }
+    if (b->getBlockType() == BlockType::Operator_Block) return ((Operator*)b)->getLatency();
+    // The accesses are registered in the queue
+    if (b->getBlockType() == BlockType::LSQ_Block) return 1;
+    // The tagger registers the values with their tag
+    if (b->getBlockType() == BlockType::Tagger_Block) return 1;
+    return 0;
+}
+
+void ChannelGraph::findChannels() {
+    for (unsigned int i = 0; i < graphs.size(); ++i) {
+        const vector <Block*>& createdBlocks = graphs[i]->getCreatedBlocks();
+        for (unsigned int j = 0; j < createdBlocks.size(); ++j) {
+            if (createdBlocks[j]->getBlockType() == BlockType::FunctionCall_Block) continue;
+            blockIds[createdBlocks[j]] = blocks.size();
+            blocks.push_back(createdBlocks[j]);
+            blockGraphs.push_back(i);
+        }
+    }
+    inChannels.resize(blocks.size());
+    outChannels.resize(blocks.size());
+    sequential.resize(blocks.size());
+    for (unsigned int i = 0; i < blocks.size(); ++i) {
+        sequential[i] = getLatency(i) > 0;
+        for (unsigned int j = 0; j < blocks[i]->getNumOutputPorts(); ++j) {
+            pair <Block*, int> connection = blocks[i]->getOutputConnection(j);
+            if (connection.first == nullptr) continue;
+            unordered_map <Block*, unsigned int>::const_iterator it =
+                blockIds.find(connection.first);
+            if (it == blockIds.end()) continue; // Block of a graph not included
+            Channel channel;
+            channel.from = i;
+            channel.fromPort = j;
+            channel.to = it->second;
+            channel.toPort = connection.second;
+            outChannels[i].push_back(channels.size());
+            inChannels[it->second].push_back(channels.size());
+            channels.push_back(channel);
+        }
+    }
+}
+
+
+}
@@ -0,0 +1,152 @@
+#ifndef CHANNELGRAPH_H
+#define CHANNELGRAPH_H
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include "Graph.h"
+
+using namespace std;
+
+namespace DFGraphComp
+{
+
+
+/* Blocks and channels of a complete function graph, numbered so the analyses that walk
+    the whole graph can keep their data in vectors. The blocks follow the order they were
+    created, without the dummy blocks of the calls, that are not connected once the calls
+    are linked. Channels to the blocks of graphs not included are left out.
+    It can also hold several graphs linked by their calls, the blocks of each one after
+    the ones of the graph before, with the channels between them, so the cycles and paths
+    that go through a called function are seen as a whole.
+    It is a snapshot: blocks or channels added to the graph later are not in it */
+class ChannelGraph {
+
+public:
+
+    struct Channel
+    {
+        unsigned int from;
+        unsigned int fromPort;
+        unsigned int to;
+        int toPort;
+    };
+
+    ChannelGraph(FunctionGraph& graph);
+    ChannelGraph(const vector <FunctionGraph*>& graphs);
+    ~ChannelGraph();
+
+    /* Groups of graphs linked by the channels between them, each one with the indexes of
+        its graphs in order, and the groups in the order of their first graph */
+    static vector <vector <unsigned int> > findLinkedGraphs(
+        const vector <FunctionGraph*>& graphs);
+
+    const vector <FunctionGraph*>& getGraphs();
+    // The graph a block belongs to
+    FunctionGraph& getGraph(unsigned int block);
+    // Name of the function, or of all the functions linked, to start the reports
+    string getFunctionNames();
+
+    const vector <Block*>& getBlocks();
+    const vector <Channel>& getChannels();
+    // Indexes of the channels that enter and leave each block
+    const vector <vector <unsigned int> >& getInChannels();
+    const vector <vector <unsigned int> >& getOutChannels();
+
+    /* Blocks with a register between their inputs and outputs: opaque buffers, pipelined
+        operators, load-store queues and taggers */
+    const vector <bool>& getSequential();
+
+    // Number of cycles between the inputs and outputs of a block
+    unsigned int getLatency(unsigned int block);
+
+    /* Strongly connected components of the blocks through the channels accepted, and
+        the number of blocks in each. Components are numbered so the channels between
+        them go from higher to lower numbers */
+    template <typename Accept>
+    unsigned int findComponents(Accept accept, vector <unsigned int>& components,
+        vector <unsigned int>& sizes);
+
+private:
+
+    vector <FunctionGraph*> graphs;
+    vector <Block*> blocks;
+    // Index of the graph of each block
+    vector <unsigned int> blockGraphs;
+    unordered_map <Block*, unsigned int> blockIds;
+    vector <Channel> channels;
+    vector <vector <unsigned int> > inChannels;
+    vector <vector <unsigned int> > outChannels;
+    vector <bool> sequential;
+
+    void findChannels();
+
+};
+
+
+template <typename Accept>
+unsigned int ChannelGraph::findComponents(Accept accept, vector <unsigned int>& components,
+    vector <unsigned int>& sizes)
+{
+    // Tarjan's algorithm without recursion, as the graphs of big functions are deep
+    const unsigned int unvisited = ~0u;
+    unsigned int numBlocks = blocks.size();
+    vector <unsigned int> index(numBlocks, unvisited);
+    vector <unsigned int> lowLink(numBlocks, 0);
+    vector <bool> onStack(numBlocks, false);
+    vector <unsigned int> stack;
+    vector <pair <unsigned int, unsigned int> > callStack;
+    unsigned int nextIndex = 0;
+    unsigned int numComponents = 0;
+    components.assign(numBlocks, 0);
+    sizes.clear();
+    for (unsigned int root = 0; root < numBlocks; ++root) {
+        if (index[root] != unvisited) continue;
+        callStack.push_back(make_pair(root, 0));
+        index[root] = lowLink[root] = nextIndex++;
+        stack.push_back(root);
+        onStack[root] = true;
+        while (!callStack.empty()) {
+            unsigned int block = callStack.back().first;
+            unsigned int& next = callStack.back().second;
+            if (next < outChannels[block].size()) {
+                unsigned int channel = outChannels[block][next++];
+                if (!accept(channel)) continue;
+                unsigned int to = channels[channel].to;
+                if (index[to] == unvisited) {
+                    index[to] = lowLink[to] = nextIndex++;
+                    stack.push_back(to);
+                    onStack[to] = true;
+                    callStack.push_back(make_pair(to, 0));
+                }
+                else if (onStack[to]) lowLink[block] = min(lowLink[block], index[to]);
+                continue;
+            }
+            callStack.pop_back();
+            if (!callStack.empty()) {
+                unsigned int parent = callStack.back().first;
+                lowLink[parent] = min(lowLink[parent], lowLink[block]);
+            }
+            if (lowLink[block] != index[block]) continue;
+            unsigned int size = 0;
+            unsigned int member;
+            do {
+                member = stack.back();
+                stack.pop_back();
+                onStack[member] = false;
+                components[member] = numComponents;
+                ++size;
+            } while (member != block);
+            sizes.push_back(size);
+            ++numComponents;
+        }
+    }
+    return numComponents;
+}
+
+
+}
+
+
+#endif // CHANNELGRAPH_H
@@ -0,0 +1,91 @@
+
+#include "DotBuffer.h"
+
+
+namespace DFGraphComp
+{
+
+
+/*
+ * =================================
+ *  Class DotBuffer
+ * =================================
+*/
+
+
+DotBuffer::DotBuffer() {}
+
+DotBuffer::~DotBuffer() {}
+
+DotBuffer& DotBuffer::operator << (const string& text) {
+    this->text.append(text);
+    return *this;
+}
+
+DotBuffer& DotBuffer::operator << (string_view text) {
+    this->text.append(text);
+    return *this;
+}
+
+DotBuffer& DotBuffer::operator << (const char* text) {
+    this->text.append(text);
+    return *this;
+}
+
+DotBuffer& DotBuffer::operator << (char character) {
+    text.push_back(character);
+    return *this;
+}
+
+DotBuffer& DotBuffer::operator << (int value) {
+    appendInteger(value);
+    return *this;
+}
+
+DotBuffer& DotBuffer::operator << (unsigned int value) {
+    appendInteger(value);
+    return *this;
+}
+
+DotBuffer& DotBuffer::operator << (long value) {
+    appendInteger(value);
+    return *this;
+}
+
+DotBuffer& DotBuffer::operator << (unsigned long value) {
+    appendInteger(value);
+    return *this;
+}
+
+DotBuffer& DotBuffer::operator << (float value) {
+    appendFloat(value);
+    return *this;
+}
+
+DotBuffer& DotBuffer::operator << (double value) {
+    appendFloat(value);
+    return *this;
+}
+
+void DotBuffer::append(const DotBuffer& buffer) {
+    text.append(buffer.text);
+}
+
+const string& DotBuffer::getText() const {
+    return text;
+}
+
+size_t DotBuffer::size() const {
+    return text.size();
+}
+
+void DotBuffer::clear() {
+    text.clear();
+}
+
+void DotBuffer::writeTo(ostream& file) const {
+    file.write(text.data(), text.size());
+}
+
+
+} // Close namespace
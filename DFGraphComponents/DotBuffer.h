@@ -0,0 +1,81 @@
+#ifndef DOTBUFFER_H
+#define DOTBUFFER_H
+
+#include <string>
+#include <string_view>
+#include <ostream>
+#include <charconv>
+
+using namespace std;
+
+namespace DFGraphComp
+{
+
+
+/* Text of (a part of) a DOT file kept in memory. Each function can be printed in its
+    own buffer, and the whole text is written to the file at once, instead of flushing
+    every line. Numbers are formatted with to_chars, that does not depend on the locale */
+class DotBuffer {
+
+public:
+
+    DotBuffer();
+    ~DotBuffer();
+
+    DotBuffer& operator << (const string& text);
+    // Text of the strings that do not use the standard allocator, like the block names
+    DotBuffer& operator << (string_view text);
+    DotBuffer& operator << (const char* text);
+    DotBuffer& operator << (char character);
+    DotBuffer& operator << (int value);
+    DotBuffer& operator << (unsigned int value);
+    DotBuffer& operator << (long value);
+    DotBuffer& operator << (unsigned long value);
+    // Same format than an ostream with the default precision
+    DotBuffer& operator << (float value);
+    DotBuffer& operator << (double value);
+
+    void append(const DotBuffer& buffer);
+
+    const string& getText() const;
+    size_t size() const;
+    void clear();
+
+    // Single write of all the text
+    void writeTo(ostream& file) const;
+
+private:
+
+    string text;
+
+    // Bigger than the longest integer or float printed with 6 digits
+    static const unsigned int maxNumberChars = 32;
+
+    template <typename T>
+    void appendInteger(T value);
+
+    template <typename T>
+    void appendFloat(T value);
+
+};
+
+
+template <typename T>
+void DotBuffer::appendInteger(T value) {
+    char digits[maxNumberChars];
+    to_chars_result result = to_chars(digits, digits + maxNumberChars, value);
+    text.append(digits, result.ptr);
+}
+
+template <typename T>
+void DotBuffer::appendFloat(T value) {
+    char digits[maxNumberChars];
+    to_chars_result result = to_chars(digits, digits + maxNumberChars, value, 
+        chars_format::general, 6);
+    text.append(digits, result.ptr);
+}
+
+
+} // Close namespace
+
+#endif // DOTBUFFER_H
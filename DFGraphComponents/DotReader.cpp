@@ -0,0 +1,838 @@
+
+#include "DotReader.h"
+#include <charconv>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+namespace DFGraphComp
+{
+
+
+static bool parseInteger(string_view text, long& value) {
+    const char* end = text.data() + text.size();
+    from_chars_result result = from_chars(text.data(), end, value);
+    return result.ec == errc() and result.ptr == end and text.size() > 0;
+}
+
+static bool parseReal(string_view text, double& value) {
+    const char* end = text.data() + text.size();
+    from_chars_result result = from_chars(text.data(), end, value);
+    return result.ec == errc() and result.ptr == end and text.size() > 0;
+}
+
+static bool isIdChar(char c) {
+    return (c >= 'a' and c <= 'z') or (c >= 'A' and c <= 'Z') or
+        (c >= '0' and c <= '9') or c == '_' or c == '.';
+}
+
+static string_view stripCluster(string_view name) {
+    if (name.substr(0, 8) == "cluster_") return name.substr(8);
+    return name;
+}
+
+
+/*
+ * =================================
+ *  Class DotReader
+ * =================================
+*/
+
+
+DotReader::DotReader() {
+    position = 0;
+    line = 1;
+    defaultPortWidth = -1;
+    topGraph = -1;
+    numChannels = 0;
+}
+
+DotReader::~DotReader() {}
+
+bool DotReader::readFile(const string& fileName) {
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) return setError(0, "Cannot open " + fileName);
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) < 0) {
+        ::close(fd);
+        return setError(0, "Cannot read " + fileName);
+    }
+    size_t size = fileStat.st_size;
+    if (size == 0) {
+        ::close(fd);
+        return read(string_view());
+    }
+    void* memory = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) return setError(0, "Cannot map " + fileName);
+    // The blocks keep their own copy of the names, so the file is not needed afterwards
+    bool correct = read(string_view((const char*)memory, size));
+    munmap(memory, size);
+    return correct;
+}
+
+bool DotReader::read(string_view text) {
+    this->text = text;
+    position = 0;
+    line = 1;
+    error.clear();
+    graphName.clear();
+    graphs.clear();
+    defaultPortWidth = -1;
+    topGraph = -1;
+    numChannels = 0;
+    bool correct = parseGraph() and connectChannels();
+    // Both point to the text
+    blocks.clear();
+    channels.clear();
+    this->text = string_view();
+    return correct;
+}
+
+const string& DotReader::getError() {
+    return error;
+}
+
+string DotReader::getGraphName() {
+    return graphName;
+}
+
+unsigned int DotReader::getNumGraphs() {
+    return graphs.size();
+}
+
+FunctionGraph& DotReader::getGraph(unsigned int index) {
+    assert(index < graphs.size() && "Wrong graph");
+    return graphs[index];
+}
+
+unsigned int DotReader::getNumChannels() {
+    return numChannels;
+}
+
+void DotReader::nextToken() {
+    // Skip blanks and comments
+    while (position < text.size()) {
+        char c = text[position];
+        if (c == '\n') {
+            ++line;
+            ++position;
+        }
+        else if (c == ' ' or c == '\t' or c == '\r') ++position;
+        else if (c == '#' or text.substr(position, 2) == "//") {
+            while (position < text.size() and text[position] != '\n') ++position;
+        }
+        else if (text.substr(position, 2) == "/*") {
+            size_t end = text.find("*/", position + 2);
+            if (end == string_view::npos) end = text.size();
+            else end += 2;
+            for (size_t i = position; i < end; ++i) {
+                if (text[i] == '\n') ++line;
+            }
+            position = end;
+        }
+        else break;
+    }
+    token.line = line;
+    if (position >= text.size()) {
+        token.kind = End;
+        token.text = string_view();
+        return;
+    }
+    size_t start = position;
+    char c = text[position];
+    token.kind = Invalid;
+    switch (c)
+    {
+        case '{': token.kind = LeftBrace; break;
+        case '}': token.kind = RightBrace; break;
+        case '[': token.kind = LeftBracket; break;
+        case ']': token.kind = RightBracket; break;
+        case '=': token.kind = Equal; break;
+        case ';': token.kind = Semicolon; break;
+        case ',': token.kind = Comma; break;
+        default: break;
+    }
+    if (token.kind != Invalid) {
+        ++position;
+        token.text = text.substr(start, 1);
+        return;
+    }
+    if (c == '"') {
+        // Quoted strings keep their escape sequences, none of the values need them
+        ++position;
+        while (position < text.size() and text[position] != '"') {
+            if (text[position] == '\\' and position + 1 < text.size()) ++position;
+            if (text[position] == '\n') ++line;
+            ++position;
+        }
+        if (position >= text.size()) {
+            token.text = text.substr(start);
+            return;
+        }
+        token.kind = String;
+        token.text = text.substr(start + 1, position - start - 1);
+        ++position;
+        return;
+    }
+    if (c == '-' and position + 1 < text.size() and
+        (text[position + 1] == '>' or text[position + 1] == '-'))
+    {
+        position += 2;
+        token.kind = Arrow;
+        token.text = text.substr(start, 2);
+        return;
+    }
+    if (isIdChar(c) or c == '-') {
+        ++position;
+        bool number = (c == '-' or c == '.' or (c >= '0' and c <= '9'));
+        while (position < text.size()) {
+            char next = text[position];
+            // Exponents of the real values, like 1e+10
+            bool exponentSign = number and (next == '+' or next == '-') and
+                (text[position - 1] == 'e' or text[position - 1] == 'E');
+            if (!isIdChar(next) and !exponentSign) break;
+            ++position;
+        }
+        token.kind = ID;
+        token.text = text.substr(start, position - start);
+        return;
+    }
+    token.text = text.substr(start, 1);
+    ++position;
+}
+
+bool DotReader::expect(TokenKind kind, const char* what) {
+    if (token.kind != kind) {
+        if (token.kind == End) return setError(token.line, string("Expected ") + what +
+            " before the end of the file");
+        return setError(token.line, string("Expected ") + what + " instead of '" +
+            string(token.text) + "'");
+    }
+    nextToken();
+    return true;
+}
+
+bool DotReader::setError(unsigned int line, const string& message) {
+    if (line > 0) error = "line " + to_string(line) + ": " + message;
+    else error = message;
+    return false;
+}
+
+bool DotReader::parseGraph() {
+    nextToken();
+    if (token.kind == ID and token.text == "strict") nextToken();
+    if (token.kind != ID or (token.text != "digraph" and token.text != "graph")) {
+        return setError(token.line, "Expected a digraph");
+    }
+    nextToken();
+    if (token.kind == ID or token.kind == String) {
+        graphName = string(token.text);
+        nextToken();
+    }
+    if (!expect(LeftBrace, "'{'")) return false;
+    if (!parseStatements(0, -1, -1, false)) return false;
+    if (!expect(RightBrace, "'}'")) return false;
+    if (token.kind != End) return setError(token.line, "Text after the end of the digraph");
+    return true;
+}
+
+bool DotReader::parseStatements(unsigned int depth, int graph, int BB, bool control) {
+    while (token.kind != RightBrace and token.kind != End) {
+        if (token.kind == Semicolon or token.kind == Comma) {
+            nextToken();
+            continue;
+        }
+        if (token.kind == LeftBrace or (token.kind == ID and token.text == "subgraph")) {
+            if (!parseSubgraph(depth + 1, graph, BB, control)) return false;
+            continue;
+        }
+        if (token.kind != ID and token.kind != String) {
+            if (token.kind == Invalid) {
+                return setError(token.line, "Unexpected '" + string(token.text) + "'");
+            }
+            return setError(token.line, "Expected a statement instead of '" +
+                string(token.text) + "'");
+        }
+        Token first = token;
+        nextToken();
+        vector <Attribute> attributes;
+        // Default attributes of the graph, nodes or edges, not used by the dialect
+        if (first.kind == ID and token.kind == LeftBracket and (first.text == "graph" or
+            first.text == "node" or first.text == "edge"))
+        {
+            if (!parseAttributes(attributes)) return false;
+        }
+        else if (token.kind == Equal) {
+            nextToken();
+            if (token.kind != ID and token.kind != String) {
+                return setError(token.line, "Expected the value of " + string(first.text));
+            }
+            if (first.text == "channel_width") {
+                long width;
+                if (!parseInteger(token.text, width) or width < 0) {
+                    return setError(token.line, "Wrong channel_width");
+                }
+                if (graph >= 0) graphs[graph].setDefaultPortWidth(width);
+                else defaultPortWidth = width;
+            }
+            else if (first.text == "calls") {
+                if (token.text != "shared" and token.text != "copied") {
+                    return setError(token.line, "Wrong calls");
+                }
+                if (graph >= 0) graphs[graph].setCallLinking(string(token.text));
+            }
+            else if (first.text == "copy_of" and graph >= 0) {
+                graphs[graph].setCopyOf(string(token.text));
+            }
+            nextToken();
+        }
+        else if (token.kind == Arrow) {
+            vector <string_view> path(1, first.text);
+            while (token.kind == Arrow) {
+                nextToken();
+                if (token.kind != ID and token.kind != String) {
+                    return setError(token.line, "Expected the destination of the channel");
+                }
+                path.push_back(token.text);
+                nextToken();
+            }
+            if (token.kind == LeftBracket and !parseAttributes(attributes)) return false;
+            string_view from = findAttribute(attributes, "from");
+            string_view to = findAttribute(attributes, "to");
+            for (unsigned int i = 0; i + 1 < path.size(); ++i) {
+                Channel channel;
+                channel.fromBlock = path[i];
+                channel.fromPort = from;
+                channel.toBlock = path[i + 1];
+                channel.toPort = to;
+                channel.line = first.line;
+                channels.push_back(channel);
+            }
+        }
+        else {
+            if (token.kind == LeftBracket and !parseAttributes(attributes)) return false;
+            if (!addBlock(first.text, attributes, first.line, graph, BB, control)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool DotReader::parseSubgraph(unsigned int depth, int graph, int BB, bool control) {
+    string_view name;
+    if (token.kind == ID and token.text == "subgraph") {
+        nextToken();
+        if (token.kind == ID or token.kind == String) {
+            name = token.text;
+            nextToken();
+        }
+    }
+    if (!expect(LeftBrace, "'{'")) return false;
+    if (depth == 1) {
+        graph = graphs.size();
+        graphs.push_back(FunctionGraph(string(stripCluster(name))));
+        if (defaultPortWidth >= 0) graphs[graph].setDefaultPortWidth(defaultPortWidth);
+    }
+    else if (depth == 2) {
+        BB = graphs[graph].addBasicBlock(string(stripCluster(name)));
+    }
+    else control = true;
+    if (!parseStatements(depth, graph, BB, control)) return false;
+    return expect(RightBrace, "'}'");
+}
+
+bool DotReader::parseAttributes(vector <Attribute>& attributes) {
+    if (!expect(LeftBracket, "'['")) return false;
+    while (token.kind != RightBracket) {
+        if (token.kind != ID and token.kind != String) {
+            return setError(token.line, "Expected an attribute");
+        }
+        Attribute attribute;
+        attribute.name = token.text;
+        nextToken();
+        if (!expect(Equal, "'='")) return false;
+        if (token.kind != ID and token.kind != String) {
+            return setError(token.line, "Expected the value of " + string(attribute.name));
+        }
+        attribute.value = token.text;
+        attributes.push_back(attribute);
+        nextToken();
+        if (token.kind == Comma or token.kind == Semicolon) nextToken();
+    }
+    nextToken();
+    return true;
+}
+
+bool DotReader::addBlock(string_view name, const vector <Attribute>& attributes,
+    unsigned int line, int graph, int BB, bool control)
+{
+    if (blocks.find(name) != blocks.end()) {
+        return setError(line, "Block " + string(name) + " declared twice");
+    }
+    if (graph < 0) graph = getTopGraph();
+    Block* block = createBlock(graphs[graph], attributes, line);
+    if (block == nullptr) {
+        error += " in block " + string(name);
+        return false;
+    }
+    block->setBlockName(string(name));
+    blocks[name] = block;
+    if (BB < 0) graphs[graph].addOuterBlock(block);
+    else if (control) graphs[graph].getBB(BB).addControlBlock(block);
+    else graphs[graph].getBB(BB).addBlock(block);
+    return true;
+}
+
+Block* DotReader::createBlock(FunctionGraph& graph, const vector <Attribute>& attributes,
+    unsigned int line)
+{
+    vector <Port> inPorts;
+    vector <Port> outPorts;
+    if (!parsePorts(findAttribute(attributes, "in"), inPorts, line) or
+        !parsePorts(findAttribute(attributes, "out"), outPorts, line))
+    {
+        return nullptr;
+    }
+    string_view type = findAttribute(attributes, "type");
+    Block* block = nullptr;
+    // The blocks are created with the number of ports declared, then the ports are replaced
+    if (type.empty() or type == "Operator") {
+        OpType opType = OpType::Synchronization;
+        string_view opName = findAttribute(attributes, "op");
+        if (!opName.empty()) {
+            int i = 0;
+            while (i < numberOperators and opName != getOpDotName((OpType)i)) ++i;
+            if (i == numberOperators) {
+                setError(line, "Unknown operation " + string(opName));
+                return nullptr;
+            }
+            opType = (OpType)i;
+        }
+        unsigned int numInPorts = 0;
+        if (isUnary(opType)) numInPorts = 1;
+        else if (isBinary(opType)) numInPorts = 2;
+        /* Loads and stores can also have order and queue ports after their operands and
+            result (see Operator) */
+        bool memory = isMemory(opType);
+        if (numInPorts > 0 and (inPorts.size() < numInPorts or
+            (!memory and inPorts.size() != numInPorts)))
+        {
+            setError(line, "Operation " + string(opName) + " needs " +
+                to_string(numInPorts) + " input ports");
+            return nullptr;
+        }
+        unsigned int numOutPorts = (opType == OpType::Store ? 0 : 1);
+        if (outPorts.size() < numOutPorts or (!memory and outPorts.size() != numOutPorts)) {
+            setError(line, "Operators have " + to_string(numOutPorts) + " output ports");
+            return nullptr;
+        }
+        Operator* op = graph.createBlock<Operator>(opType);
+        if (numInPorts == 0) {
+            for (unsigned int i = 0; i < inPorts.size(); ++i) op->addInputPort();
+        }
+        if (memory) {
+            for (unsigned int i = numInPorts; i < inPorts.size(); ++i) {
+                const string& name = inPorts[i].getName();
+                if (name != "data" and name.compare(0, 5, "order") != 0) {
+                    setError(line, "Unknown memory input port " + name);
+                    return nullptr;
+                }
+                op->addMemoryInputPort(name, inPorts[i].getWidth());
+            }
+            for (unsigned int i = numOutPorts; i < outPorts.size(); ++i) {
+                const string& name = outPorts[i].getName();
+                if (name != "done" and name != "addr" and name != "data") {
+                    setError(line, "Unknown memory output port " + name);
+                    return nullptr;
+                }
+                op->addMemoryOutputPort(name, outPorts[i].getWidth());
+            }
+        }
+        long value;
+        string_view latency = findAttribute(attributes, "latency");
+        string_view II = findAttribute(attributes, "II");
+        if (!latency.empty()) {
+            if (!parseInteger(latency, value) or value < 0) {
+                setError(line, "Wrong latency");
+                return nullptr;
+            }
+            op->setLatency(value);
+        }
+        if (!II.empty()) {
+            if (!parseInteger(II, value) or value < 0) {
+                setError(line, "Wrong II");
+                return nullptr;
+            }
+            op->setII(value);
+        }
+        block = op;
+    }
+    else if (type == "Buffer") {
+        Buffer* buffer = graph.createBlock<Buffer>();
+        long slots;
+        string_view slotsText = findAttribute(attributes, "slots");
+        string_view transparent = findAttribute(attributes, "transparent");
+        if (!slotsText.empty()) {
+            if (!parseInteger(slotsText, slots) or slots < 0) {
+                setError(line, "Wrong number of slots");
+                return nullptr;
+            }
+            buffer->setNumSlots(slots);
+        }
+        if (!transparent.empty()) {
+            if (transparent != "true" and transparent != "false") {
+                setError(line, "transparent has to be true or false");
+                return nullptr;
+            }
+            buffer->setTransparent(transparent == "true");
+        }
+        block = buffer;
+    }
+    else if (type == "Constant") {
+        string_view valueText = findAttribute(attributes, "value");
+        long integer;
+        double real;
+        if (valueText.empty()) {
+            setError(line, "Constant without value");
+            return nullptr;
+        }
+        if (parseInteger(valueText, integer)) {
+            block = graph.createBlock<Constant<long> >(integer);
+        }
+        else if (parseReal(valueText, real)) {
+            block = graph.createBlock<Constant<double> >(real);
+        }
+        else block = graph.createBlock<Constant<ArenaString> >(ArenaString(valueText));
+        // Without the control port it is a source
+        if (inPorts.empty()) ((ConstantInterf*)block)->setSource(true);
+    }
+    else if (type == "Fork") {
+        Fork* fork = graph.createBlock<Fork>();
+        // Each connection adds an output port to the fork
+        for (unsigned int i = 0; i < outPorts.size(); ++i) {
+            fork->setConnectedPort(nullptr, -1);
+        }
+        block = fork;
+    }
+    else if (type == "Merge") {
+        Merge* merge = graph.createBlock<Merge>();
+        for (unsigned int i = 0; i < inPorts.size(); ++i) merge->addDataInPort();
+        block = merge;
+    }
+    else if (type == "Select") block = graph.createBlock<Select>();
+    else if (type == "Branch") block = graph.createBlock<Branch>();
+    else if (type == "Demux") {
+        if (inPorts.size() != outPorts.size() + 1) {
+            setError(line, "Demux needs one input port more than output ports");
+            return nullptr;
+        }
+        Demux* demux = graph.createBlock<Demux>();
+        for (unsigned int i = 0; i < outPorts.size(); ++i) {
+            demux->addControlInPort();
+            demux->addDataOutPort();
+        }
+        // The data port is the last one declared, but the first one of the block
+        inPorts.insert(inPorts.begin(), inPorts.back());
+        inPorts.pop_back();
+        block = demux;
+    }
+    else if (type == "LSQ") {
+        LSQ* queue = graph.createBlock<LSQ>();
+        long depth;
+        string_view depthText = findAttribute(attributes, "depth");
+        if (!depthText.empty()) {
+            if (!parseInteger(depthText, depth) or depth <= 0) {
+                setError(line, "Wrong depth");
+                return nullptr;
+            }
+            queue->setDepth(depth);
+        }
+        if (!parseGroups(queue, findAttribute(attributes, "groups"), line)) return nullptr;
+        block = queue;
+    }
+    else if (type == "Tagger" or type == "Untagger") {
+        long tags = 8;
+        string_view tagsText = findAttribute(attributes, "tags");
+        if (!tagsText.empty() and (!parseInteger(tagsText, tags) or tags <= 0)) {
+            setError(line, "Wrong number of tags");
+            return nullptr;
+        }
+        // The free port, the last input of a tagger or output of an untagger, is not a value
+        if (type == "Tagger") {
+            Tagger* tagger = graph.createBlock<Tagger>(nullptr, tags);
+            for (unsigned int i = 0; i < outPorts.size(); ++i) tagger->addValue();
+            block = tagger;
+        }
+        else {
+            Untagger* untagger = graph.createBlock<Untagger>(nullptr, tags);
+            for (unsigned int i = 0; i < inPorts.size(); ++i) untagger->addValue();
+            block = untagger;
+        }
+    }
+    // Only the control ports have 0 width
+    else if (type == "Entry") {
+        if (outPorts.size() == 1 and outPorts[0].getWidth() == 0) {
+            block = graph.createBlock<Entry>();
+        }
+        else block = graph.createBlock<Argument>();
+    }
+    else if (type == "Exit") {
+        if (inPorts.size() == 1 and inPorts[0].getWidth() == 0) {
+            block = graph.createBlock<Exit>();
+        }
+        else block = graph.createBlock<Return>();
+    }
+    else if (type == "Sink") {
+        if (inPorts.size() != 1 or !outPorts.empty()) {
+            setError(line, "Sink needs one input port and no output ports");
+            return nullptr;
+        }
+        block = graph.createBlock<Sink>();
+    }
+    else {
+        setError(line, "Unknown block type " + string(type));
+        return nullptr;
+    }
+    if (!setPorts(block, inPorts, outPorts, line)) return nullptr;
+    string_view delays = findAttribute(attributes, "delay");
+    if (!delays.empty() and !setDelays(block, delays, line)) return nullptr;
+    return block;
+}
+
+bool DotReader::parsePorts(string_view list, vector <Port>& ports, unsigned int line) {
+    size_t i = 0;
+    while (i < list.size()) {
+        if (list[i] == ' ' or list[i] == '\t') {
+            ++i;
+            continue;
+        }
+        size_t end = list.find_first_of(" \t", i);
+        if (end == string_view::npos) end = list.size();
+        string_view item = list.substr(i, end - i);
+        i = end;
+        size_t nameEnd = item.find_first_of("?+-:");
+        string_view name = item.substr(0, nameEnd);
+        if (name.empty()) return setError(line, "Port without name");
+        Port::PortType type = Port::Base;
+        int width = -1;
+        if (nameEnd != string_view::npos) {
+            string_view suffix = item.substr(nameEnd);
+            if (suffix[0] == '?') type = Port::Condition;
+            else if (suffix[0] == '+') type = Port::True;
+            else if (suffix[0] == '-') type = Port::False;
+            if (type != Port::Base) suffix = suffix.substr(1);
+            if (!suffix.empty()) {
+                long value;
+                if (suffix[0] != ':' or !parseInteger(suffix.substr(1), value) or value < 0) {
+                    return setError(line, "Wrong port " + string(item));
+                }
+                width = value;
+            }
+        }
+        ports.push_back(Port(string(name), width, type));
+    }
+    return true;
+}
+
+bool DotReader::setPorts(Block* block, const vector <Port>& inPorts,
+    const vector <Port>& outPorts, unsigned int line)
+{
+    BlockType type = block->getBlockType();
+    if (type == BlockType::Select_Block or type == BlockType::Branch_Block) {
+        // The ports with special meaning are placed following their suffix
+        vector <Port> ports[2] = {inPorts, outPorts};
+        unsigned int numPorts[2] = {block->getNumInputPorts(), block->getNumOutputPorts()};
+        for (unsigned int i = 0; i < 2; ++i) {
+            if (ports[i].size() != numPorts[i]) {
+                return setError(line, "Wrong number of ports");
+            }
+            vector <bool> used(numPorts[i], false);
+            for (unsigned int j = 0; j < ports[i].size(); ++j) {
+                int index = -1;
+                Port::PortType portType = ports[i][j].getType();
+                if (type == BlockType::Select_Block and i == 0) {
+                    if (portType == Port::True) index = 0;
+                    else if (portType == Port::False) index = 1;
+                    else if (portType == Port::Condition) index = 2;
+                }
+                else if (type == BlockType::Select_Block) index = 0;
+                else if (i == 0) index = (portType == Port::Condition ? 1 : 0);
+                else if (portType == Port::True) index = 1;
+                else if (portType == Port::False) index = 0;
+                if (index < 0 or used[index]) {
+                    return setError(line, "Ports with wrong suffixes ?, + and -");
+                }
+                used[index] = true;
+                if (i == 0) block->setInputPort(index, ports[i][j]);
+                else block->setOutputPort(index, ports[i][j]);
+            }
+        }
+        return true;
+    }
+    if (inPorts.size() != block->getNumInputPorts() or
+        outPorts.size() != block->getNumOutputPorts())
+    {
+        return setError(line, "Wrong number of ports");
+    }
+    for (unsigned int i = 0; i < inPorts.size(); ++i) block->setInputPort(i, inPorts[i]);
+    for (unsigned int i = 0; i < outPorts.size(); ++i) block->setOutputPort(i, outPorts[i]);
+    return true;
+}
+
+bool DotReader::setDelays(Block* block, string_view delays, unsigned int line) {
+    size_t i = 0;
+    while (i < delays.size()) {
+        if (delays[i] == ' ' or delays[i] == '\t') {
+            ++i;
+            continue;
+        }
+        size_t end = delays.find_first_of(" \t", i);
+        if (end == string_view::npos) end = delays.size();
+        string_view item = delays.substr(i, end - i);
+        i = end;
+        size_t colon = item.rfind(':');
+        string_view portName;
+        if (colon != string_view::npos) {
+            portName = item.substr(0, colon);
+            item = item.substr(colon + 1);
+        }
+        double delay;
+        if (!parseReal(item, delay) or delay < 0) return setError(line, "Wrong delay");
+        if (portName.empty()) {
+            block->setBlockDelay(delay);
+            continue;
+        }
+        bool found = false;
+        for (unsigned int j = 0; j < block->getNumInputPorts() and !found; ++j) {
+            if (block->getInputPort(j).getName() == portName) {
+                Port port = block->getInputPort(j);
+                port.setDelay(delay);
+                block->setInputPort(j, port);
+                found = true;
+            }
+        }
+        for (unsigned int j = 0; j < block->getNumOutputPorts() and !found; ++j) {
+            if (block->getOutputPort(j).getName() == portName) {
+                Port port = block->getOutputPort(j);
+                port.setDelay(delay);
+                block->setOutputPort(j, port);
+                found = true;
+            }
+        }
+        if (!found) return setError(line, "Delay of unknown port " + string(portName));
+    }
+    return true;
+}
+
+bool DotReader::parseGroups(LSQ* queue, string_view groups, unsigned int line) {
+    size_t start = 0;
+    while (start < groups.size()) {
+        size_t end = groups.find(';', start);
+        if (end == string_view::npos) end = groups.size();
+        string_view group = groups.substr(start, end - start);
+        start = end + 1;
+        size_t colon = group.find(':');
+        if (colon == string_view::npos) return setError(line, "Group without BB");
+        string_view BBText = group.substr(0, colon);
+        size_t first = BBText.find_first_not_of(" \t");
+        if (first != string_view::npos) BBText = BBText.substr(first);
+        long BB;
+        if (!parseInteger(BBText, BB) or BB < 0) {
+            return setError(line, "Wrong BB of group " + string(group));
+        }
+        queue->addGroup(BB);
+        // The accesses have to be numbered in the order they appear
+        size_t i = colon + 1;
+        while (i < group.size()) {
+            if (group[i] == ' ' or group[i] == '\t') {
+                ++i;
+                continue;
+            }
+            size_t accessEnd = group.find_first_of(" \t", i);
+            if (accessEnd == string_view::npos) accessEnd = group.size();
+            string_view access = group.substr(i, accessEnd - i);
+            i = accessEnd;
+            long number;
+            bool load = access.substr(0, 2) == "ld";
+            if ((!load and access.substr(0, 2) != "st") or
+                !parseInteger(access.substr(2), number) or number != (long)(load ?
+                queue->getNumLoads() : queue->getNumStores()))
+            {
+                return setError(line, "Wrong access " + string(access));
+            }
+            if (load) queue->addLoad();
+            else queue->addStore();
+        }
+    }
+    return true;
+}
+
+bool DotReader::connectChannels() {
+    for (unsigned int i = 0; i < channels.size(); ++i) {
+        const Channel& channel = channels[i];
+        unordered_map <string_view, Block*>::const_iterator fromIt =
+            blocks.find(channel.fromBlock);
+        unordered_map <string_view, Block*>::const_iterator toIt =
+            blocks.find(channel.toBlock);
+        if (fromIt == blocks.end()) {
+            return setError(channel.line, "Unknown block " + string(channel.fromBlock));
+        }
+        if (toIt == blocks.end()) {
+            return setError(channel.line, "Unknown block " + string(channel.toBlock));
+        }
+        Block* from = fromIt->second;
+        Block* to = toIt->second;
+        // Without from or to, the block has to have a single port
+        int fromPort = -1;
+        if (channel.fromPort.empty() and from->getNumOutputPorts() == 1) fromPort = 0;
+        for (unsigned int j = 0; j < from->getNumOutputPorts() and fromPort < 0; ++j) {
+            if (from->getOutputPort(j).getName() == channel.fromPort) fromPort = j;
+        }
+        int toPort = -1;
+        if (channel.toPort.empty() and to->getNumInputPorts() == 1) toPort = 0;
+        for (unsigned int j = 0; j < to->getNumInputPorts() and toPort < 0; ++j) {
+            if (to->getInputPort(j).getName() == channel.toPort) toPort = j;
+        }
+        if (fromPort < 0) {
+            return setError(channel.line, "Unknown output port " + string(channel.fromPort) +
+                " of " + from->getBlockName());
+        }
+        if (toPort < 0) {
+            return setError(channel.line, "Unknown input port " + string(channel.toPort) +
+                " of " + to->getBlockName());
+        }
+        if (from->getOutputConnection(fromPort).first != nullptr) {
+            return setError(channel.line, "Output port " +
+                from->getOutputPort(fromPort).getName() + " of " + from->getBlockName() +
+                " connected twice");
+        }
+        from->setOutputConnection(fromPort, make_pair(to, toPort));
+        ++numChannels;
+    }
+    return true;
+}
+
+int DotReader::getTopGraph() {
+    if (topGraph < 0) {
+        topGraph = graphs.size();
+        graphs.push_back(FunctionGraph(graphName.empty() ? "graph" : graphName));
+        if (defaultPortWidth >= 0) graphs[topGraph].setDefaultPortWidth(defaultPortWidth);
+    }
+    return topGraph;
+}
+
+string_view DotReader::findAttribute(const vector <Attribute>& attributes,
+    string_view name)
+{
+    for (unsigned int i = 0; i < attributes.size(); ++i) {
+        if (attributes[i].name == name) return attributes[i].value;
+    }
+    return string_view();
+}
+
+
+} // Close namespace
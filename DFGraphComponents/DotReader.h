@@ -0,0 +1,134 @@
+#ifndef DOTREADER_H
+#define DOTREADER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <assert.h>
+#include "Graph.h"
+
+using namespace std;
+
+namespace DFGraphComp
+{
+
+
+/* Reads a file in the DOT dialect of Dataflow.md and builds the same blocks than
+    DFGraphPass, so the graphs can be analysed or transformed without the LLVM IR.
+    The text is split in tokens in place, only the names kept by the blocks are copied.
+    The subgraphs follow the layout of the files printed by DFGraphPass: each subgraph
+    of the digraph is a function, the subgraphs inside a function are its BB and the ones
+    inside a BB hold its control blocks. The blocks outside any function belong to a
+    function named as the digraph, and the blocks outside any BB are outer blocks */
+class DotReader {
+
+public:
+
+    DotReader();
+    ~DotReader();
+
+    DotReader(const DotReader&) = delete;
+    DotReader& operator = (const DotReader&) = delete;
+
+    // Both return false if the graph cannot be built, leaving the reason in getError
+    bool readFile(const string& fileName);
+    bool read(string_view text);
+
+    const string& getError();
+
+    string getGraphName();
+    unsigned int getNumGraphs();
+    FunctionGraph& getGraph(unsigned int index);
+    unsigned int getNumChannels();
+
+private:
+
+    enum TokenKind {
+        ID = 0,
+        String,
+        LeftBrace,
+        RightBrace,
+        LeftBracket,
+        RightBracket,
+        Equal,
+        Semicolon,
+        Comma,
+        Arrow,
+        End,
+        Invalid
+    };
+
+    struct Token
+    {
+        TokenKind kind;
+        string_view text;
+        unsigned int line;
+    };
+
+    struct Attribute
+    {
+        string_view name;
+        string_view value;
+    };
+
+    // Channels are connected once all the blocks are known
+    struct Channel
+    {
+        string_view fromBlock;
+        string_view fromPort;
+        string_view toBlock;
+        string_view toPort;
+        unsigned int line;
+    };
+
+    string_view text;
+    size_t position;
+    unsigned int line;
+    Token token;
+    string error;
+
+    string graphName;
+    vector <FunctionGraph> graphs;
+    // Width given with channel_width outside any function
+    int defaultPortWidth;
+    // Function of the blocks found outside any subgraph, created when the first one is found
+    int topGraph;
+    unordered_map <string_view, Block*> blocks;
+    vector <Channel> channels;
+    unsigned int numChannels;
+
+    void nextToken();
+    bool expect(TokenKind kind, const char* what);
+    bool setError(unsigned int line, const string& message);
+
+    bool parseGraph();
+    // graph is -1 outside the functions, BB is -1 outside the BB
+    bool parseStatements(unsigned int depth, int graph, int BB, bool control);
+    bool parseSubgraph(unsigned int depth, int graph, int BB, bool control);
+    bool parseAttributes(vector <Attribute>& attributes);
+    // Empty if the attribute is not present
+    static string_view findAttribute(const vector <Attribute>& attributes,
+        string_view name);
+
+    bool addBlock(string_view name, const vector <Attribute>& attributes,
+        unsigned int line, int graph, int BB, bool control);
+    Block* createBlock(FunctionGraph& graph, const vector <Attribute>& attributes,
+        unsigned int line);
+    bool parsePorts(string_view list, vector <Port>& ports, unsigned int line);
+    bool setPorts(Block* block, const vector <Port>& inPorts,
+        const vector <Port>& outPorts, unsigned int line);
+    bool setDelays(Block* block, string_view delays, unsigned int line);
+    // Groups of a load-store queue, as "1: ld0 st0; 3: ld1", adding its ports in order
+    bool parseGroups(LSQ* queue, string_view groups, unsigned int line);
+
+    bool connectChannels();
+
+    int getTopGraph();
+
+};
+
+
+} // Close namespace
+
+#endif // DOTREADER_H
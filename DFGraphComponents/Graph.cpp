@@ -1,5 +1,6 @@
 
 #include "Graph.h"
+#include <algorithm>
 
 
 namespace DFGraphComp
@@ -41,46 +42,52 @@ string BBGraph::getBBName() {
     return BBName;
 }
 
-void BBGraph::freeBB() {
-    for (unsigned int i = 0; i < blocks.size(); ++i) {
-        delete blocks[i];
-    }
-    for (unsigned int i = 0; i < controlBlocks.size(); ++i) {
-        delete controlBlocks[i];
-    }
+const vector <Block*>& BBGraph::getBlocks() {
+    return blocks;
+}
+
+const vector <Block*>& BBGraph::getControlBlocks() {
+    return controlBlocks;
+}
+
+void BBGraph::removeBlocks(const unordered_set <Block*>& removed) {
+    auto isRemoved = [&removed](Block* block) { return removed.count(block) > 0; };
+    blocks.erase(remove_if(blocks.begin(), blocks.end(), isRemoved), blocks.end());
+    controlBlocks.erase(remove_if(controlBlocks.begin(), controlBlocks.end(), isRemoved),
+        controlBlocks.end());
 }
 
-void BBGraph::printBBNodes(ostream &file) {
+void BBGraph::printBBNodes(DotBuffer& file) {
     assert(BBName.length() > 0 && "Needed name");
-    file << "\t\tsubgraph cluster_" << BBName << " {" << endl;
+    file << "\t\tsubgraph cluster_" << BBName << " {\n";
     for (unsigned int i = 0; i < blocks.size(); ++i) {
         file << "\t\t\t";
         blocks[i]->printBlock(file);
     }
     if (controlBlocks.size() > 0) {
-        file << "\t\t\tsubgraph cluster_Control_" << BBName << " {" << endl;
+        file << "\t\t\tsubgraph cluster_Control_" << BBName << " {\n";
         for (unsigned int i = 0; i < controlBlocks.size(); ++i) {
             file << "\t\t\t\t";
             controlBlocks[i]->printBlock(file);
         }
-        file << "\t\t\t\tlabel = \"Control_" << BBName << "\"" << endl;
-        file << "\t\t\t\tcolor = red" << endl;
-        file << "\t\t\t}" << endl;
+        file << "\t\t\t\tlabel = \"Control_" << BBName << "\"\n";
+        file << "\t\t\t\tcolor = red\n";
+        file << "\t\t\t}\n";
     }
-    file << "\t\t\tlabel = \"" << BBName << "\"" << endl;
-    file << "\t\t}" << endl;
+    file << "\t\t\tlabel = \"" << BBName << "\"\n";
+    file << "\t\t}\n";
 }
 
-void BBGraph::printBBEdges(ostream& file) {
+void BBGraph::printBBEdges(DotBuffer& file) {
     for (unsigned int i = 0; i < blocks.size(); ++i) {
         if (i == 0 and blocks[i]->getConnectedPort().first != nullptr)
-            file << "\t// " << BBName << endl;
+            file << "\t// " << BBName << '\n';
         blocks[i]->printChannels(file);
     }
     if (controlBlocks.size() > 0) {
         for (unsigned int i = 0; i < controlBlocks.size(); ++i) {
             if (i == 0 and controlBlocks[i]->getConnectedPort().first != nullptr)
-                file << "\t// Control_" << BBName << endl;
+                file << "\t// Control_" << BBName << '\n';
             controlBlocks[i]->printChannels(file);
         }
     }
@@ -99,6 +106,7 @@ FunctionGraph::FunctionGraph() {}
 FunctionGraph::FunctionGraph(const string &functionName) {
     this->functionName = functionName;
     defaultPortWidth = -1;
+    currentBB = 0;
     result = nullptr;
     controlOut = nullptr;
     controlIn = nullptr;
@@ -110,52 +118,83 @@ FunctionGraph::FunctionGraph(const string &functionName) {
 
 FunctionGraph::~FunctionGraph() {}
 
-void FunctionGraph::addBasicBlock(StringRef BBName, int id) {
+unsigned int FunctionGraph::addBasicBlock(const BasicBlock* BB) {
+    assert(BBIds.find(BB) == BBIds.end() && "BB already added");
+    unsigned int id = basicBlocks.size();
     /* Stored a name like BB0 or BB1 because some names LLVM creates are
         incompatible with what DOT permits in the creation of a subgraph */
-    basicBlocks[BBName] = BBGraph("BB" + to_string(basicBlocks.size()), id);
-    currentBB = &basicBlocks[BBName];
+    basicBlocks.push_back(BBGraph("BB" + to_string(id), id));
+    BBIds[BB] = id;
+    currentBB = id;
+    return id;
+}
+
+unsigned int FunctionGraph::addBasicBlock(const string& BBName) {
+    unsigned int id = basicBlocks.size();
+    basicBlocks.push_back(BBGraph(BBName, id));
+    currentBB = id;
+    return id;
 }
 
-bool FunctionGraph::existsBB(StringRef BBName) {
-    return (basicBlocks.find(BBName) != basicBlocks.end());
+unsigned int FunctionGraph::getNumBBs() {
+    return basicBlocks.size();
 }
 
-void FunctionGraph::setCurrentBB(StringRef BBName) {
-    assert(basicBlocks.find(BBName) != basicBlocks.end() && "BB not found");
-    currentBB = &basicBlocks[BBName];
+void FunctionGraph::setCurrentBB(const BasicBlock* BB) {
+    currentBB = getBBId(BB);
 }
 
 void FunctionGraph::addBlockToBB(Block* block) {
-    currentBB->addBlock(block);
+    basicBlocks[currentBB].addBlock(block);
 }
 
-void FunctionGraph::addBlockToBB(StringRef BBName, Block* block) {
-    basicBlocks[BBName].addBlock(block);
+void FunctionGraph::addBlockToBB(const BasicBlock* BB, Block* block) {
+    basicBlocks[getBBId(BB)].addBlock(block);
 }
 
 void FunctionGraph::addControlBlockToBB(Block* block) {
-    currentBB->addControlBlock(block);
+    basicBlocks[currentBB].addControlBlock(block);
 }
 
-void FunctionGraph::addControlBlockToBB(StringRef BBName, Block* block) {
-    basicBlocks[BBName].addControlBlock(block);
+void FunctionGraph::addControlBlockToBB(const BasicBlock* BB, Block* block) {
+    basicBlocks[getBBId(BB)].addControlBlock(block);
 }
 
 unsigned int FunctionGraph::getBBId() {
-    return currentBB->getId();
+    return basicBlocks[currentBB].getId();
 }
 
-unsigned int FunctionGraph::getBBId(StringRef BBName) {
-    return basicBlocks[BBName].getId();
+unsigned int FunctionGraph::getBBId(const BasicBlock* BB) {
+    unordered_map <const BasicBlock*, unsigned int>::const_iterator it = BBIds.find(BB);
+    assert(it != BBIds.end() && "BB not found");
+    return it->second;
 }
 
-void FunctionGraph::setBBId(unsigned int id) {
-    currentBB->setId(id);
+BBGraph& FunctionGraph::getBB(unsigned int id) {
+    assert(id < basicBlocks.size() && "BB not found");
+    return basicBlocks[id];
 }
 
-void FunctionGraph::setBBId(StringRef BBName, unsigned int id) {
-    basicBlocks[BBName].setId(id);
+void FunctionGraph::addBlockNextTo(Block* block, Block* neighbour, bool control) {
+    unordered_map <const BasicBlock*, unsigned int>::const_iterator it = 
+        BBIds.find(neighbour->getParentBB());
+    if (neighbour->getParentBB() == nullptr or it == BBIds.end()) addOuterBlock(block);
+    else if (control) basicBlocks[it->second].addControlBlock(block);
+    else basicBlocks[it->second].addBlock(block);
+}
+
+const vector <Block*>& FunctionGraph::getCreatedBlocks() {
+    return arena.getBlocks();
+}
+
+void FunctionGraph::removeBlocks(const unordered_set <Block*>& removed) {
+    if (removed.empty()) return;
+    for (unsigned int i = 0; i < basicBlocks.size(); ++i) {
+        basicBlocks[i].removeBlocks(removed);
+    }
+    outerBlocks.erase(remove_if(outerBlocks.begin(), outerBlocks.end(),
+        [&removed](Block* block) { return removed.count(block) > 0; }), outerBlocks.end());
+    arena.destroyBlocks(removed);
 }
 
 void FunctionGraph::addArgument(Argument* block) {
@@ -270,34 +309,104 @@ void FunctionGraph::setDefaultPortWidth(unsigned int width) {
     defaultPortWidth = width;
 }
 
-void FunctionGraph::freeGraph() {
-    for (map <StringRef, BBGraph>::iterator it = basicBlocks.begin();
-        it != basicBlocks.end(); ++it) 
-    {
-        it->second.freeBB();
+string FunctionGraph::getCallLinking() {
+    return callLinking;
+}
+
+void FunctionGraph::setCallLinking(const string& linking) {
+    callLinking = linking;
+}
+
+string FunctionGraph::getCopyOf() {
+    return copyOf;
+}
+
+void FunctionGraph::setCopyOf(const string& functionName) {
+    copyOf = functionName;
+}
+
+void FunctionGraph::getOuterBlocks(vector <Block*>& blocks) {
+    if (controlOut != nullptr and controlOut->getBlockType() == BlockType::Merge_Block) {
+        blocks.push_back(controlOut);
+        if (result != nullptr) blocks.push_back(result);
+    }
+    if (wrapper.timesCalled > 1) {
+        blocks.push_back(wrapper.controlIn);
+        blocks.insert(blocks.end(), wrapper.argsCall.begin(), wrapper.argsCall.end());
+        blocks.insert(blocks.end(), wrapper.controlInForks.begin(), 
+            wrapper.controlInForks.end());
+        if (wrapper.result != nullptr) blocks.push_back(wrapper.result);
+        blocks.push_back(wrapper.controlOut);
+    }
+    blocks.insert(blocks.end(), outerBlocks.begin(), outerBlocks.end());
+}
+
+void FunctionGraph::addOuterBlock(Block* block) {
+    outerBlocks.push_back(block);
+}
+
+void FunctionGraph::countBlockTypes(map <BlockType, unsigned int>& blockTypes,
+    map <OpType, unsigned int>& opTypes)
+{
+    const vector <Block*>& blocks = arena.getBlocks();
+    for (unsigned int i = 0; i < blocks.size(); ++i) {
+        ++blockTypes[blocks[i]->getBlockType()];
+        if (blocks[i]->getBlockType() == BlockType::Operator_Block) {
+            ++opTypes[((Operator*)blocks[i])->getOpType()];
+        }
     }
+}
+
+size_t FunctionGraph::getAllocatedBytes() {
+    return arena.getAllocatedBytes();
+}
+
+void FunctionGraph::countBlockNames(map <string, unsigned int>& counters) {
+    const vector <Block*>& blocks = arena.getBlocks();
+    for (unsigned int i = 0; i < blocks.size(); ++i) {
+        // Dummy blocks are not printed, so they do not have a name
+        if (blocks[i]->getBlockType() == BlockType::FunctionCall_Block) continue;
+        ++counters[blocks[i]->getNamePrefix()];
+    }
+}
+
+void FunctionGraph::numberBlocks(map <string, unsigned int> firstNumbers) {
+    const vector <Block*>& blocks = arena.getBlocks();
+    for (unsigned int i = 0; i < blocks.size(); ++i) {
+        if (blocks[i]->getBlockType() == BlockType::FunctionCall_Block) continue;
+        blocks[i]->setInstanceNumber(++firstNumbers[blocks[i]->getNamePrefix()]);
+    }
+}
+
+void FunctionGraph::freeGraph() {
+    // The blocks are owned by the arena, the BB only keep references
     basicBlocks.clear();
+    BBIds.clear();
+    outerBlocks.clear();
+    arena.reset();
 }
 
-void FunctionGraph::printNodes(ostream &file, Function& F) {
+void FunctionGraph::printNodes(DotBuffer& file) {
     assert(functionName.length() > 0 && "Need function name");
-    file << "\tsubgraph cluster_" + functionName + " {" << endl;
-    file << "\t\tlabel = \"DataFlow Graph for '" + functionName + "' function\";" << endl;
+    file << "\tsubgraph cluster_" + functionName + " {\n";
+    file << "\t\tlabel = \"DataFlow Graph for '" + functionName + "' function\";\n";
     if (defaultPortWidth >= 0) {
-        file << "\t\tchannel_width = " << defaultPortWidth << endl;
+        file << "\t\tchannel_width = " << defaultPortWidth << '\n';
     }
-    for (const BasicBlock& BB : F.getBasicBlockList()) {
-        basicBlocks[BB.getName()].printBBNodes(file);
+    if (!callLinking.empty()) file << "\t\tcalls = " << callLinking << '\n';
+    if (!copyOf.empty()) file << "\t\tcopy_of = \"" << copyOf << "\"\n";
+    for (unsigned int i = 0; i < basicBlocks.size(); ++i) {
+        basicBlocks[i].printBBNodes(file);
     }
     if (controlOut != nullptr and controlOut->getBlockType() == BlockType::Merge_Block) {
-        file << "\t\t// Outter blocks" << endl;
+        file << "\t\t// Outter blocks\n";
         file << "\t\t";
         controlOut->printBlock(file);
         file << "\t\t";
         result->printBlock(file);
     }
     if (wrapper.timesCalled > 1) {
-        file << "\t\t// Call wrapper blocks" << endl;
+        file << "\t\t// Call wrapper blocks\n";
         file << "\t\t";
         wrapper.controlIn->printBlock(file);
         for (unsigned int i = 0; i < wrapper.argsCall.size(); ++i) {
@@ -313,21 +422,28 @@ void FunctionGraph::printNodes(ostream &file, Function& F) {
         file << "\t\t";
         wrapper.controlOut->printBlock(file);
     }
-    file << "\t}" << endl;
+    if (outerBlocks.size() > 0) {
+        file << "\t\t// Other outter blocks\n";
+        for (unsigned int i = 0; i < outerBlocks.size(); ++i) {
+            file << "\t\t";
+            outerBlocks[i]->printBlock(file);
+        }
+    }
+    file << "\t}\n";
 }
 
-void FunctionGraph::printEdges(ostream& file, Function& F) {
-    file << "\t// " << functionName << " Channels" << endl; 
-    for (const BasicBlock& BB : F.getBasicBlockList()) {
-        basicBlocks[BB.getName()].printBBEdges(file);
+void FunctionGraph::printEdges(DotBuffer& file) {
+    file << "\t// " << functionName << " Channels\n"; 
+    for (unsigned int i = 0; i < basicBlocks.size(); ++i) {
+        basicBlocks[i].printBBEdges(file);
     }
     if (controlOut != nullptr and controlOut->getBlockType() == BlockType::Merge_Block) {
-        file << "\t// Outter blocks channels" << endl;
+        file << "\t// Outter blocks channels\n";
         controlOut->printChannels(file);
         result->printChannels(file);
     }
     if (wrapper.timesCalled > 1) {
-        file << "\t// Call wrapper channels" << endl;
+        file << "\t// Call wrapper channels\n";
         wrapper.controlIn->printChannels(file);
         for (unsigned int i = 0; i < wrapper.argsCall.size(); ++i) {
             wrapper.argsCall[i]->printChannels(file);
@@ -338,6 +454,12 @@ void FunctionGraph::printEdges(ostream& file, Function& F) {
         wrapper.result->printChannels(file);
         wrapper.controlOut->printChannels(file);
     }
+    if (outerBlocks.size() > 0) {
+        file << "\t// Other outter blocks channels\n";
+        for (unsigned int i = 0; i < outerBlocks.size(); ++i) {
+            outerBlocks[i]->printChannels(file);
+        }
+    }
 }
 
 
@@ -3,12 +3,12 @@
 
 #include <map>
 #include <vector>
+#include <unordered_map>
+#include <unordered_set>
 #include <fstream>
 #include <assert.h>
 #include "Block.h"
-#include "llvm/ADT/StringRef.h"
-#include "llvm/IR/Function.h"
-#include "llvm/IR/BasicBlock.h"
+#include "BlockArena.h"
 
 using namespace std;
 using namespace llvm;
@@ -34,10 +34,13 @@ public:
 
     string getBBName();
 
-    void freeBB();
+    const vector <Block*>& getBlocks();
+    const vector <Block*>& getControlBlocks();
 
-    void printBBNodes(ostream &file);
-    void printBBEdges(ostream &file);
+    void removeBlocks(const unordered_set <Block*>& removed);
+
+    void printBBNodes(DotBuffer& file);
+    void printBBEdges(DotBuffer& file);
 
 private:
 
@@ -60,24 +63,47 @@ public:
 
     FunctionGraph();
     FunctionGraph(const string& functionName);
+    FunctionGraph(FunctionGraph&& graph) = default;
+    FunctionGraph& operator = (FunctionGraph&& graph) = default;
     ~FunctionGraph();
 
-    void addBasicBlock(StringRef BBName, int id);
+    // Every block of the function is created in the arena of its graph
+    template <typename T, typename... Args>
+    T* createBlock(Args&&... args);
 
-    bool existsBB(StringRef BBName);
+    unsigned int addBasicBlock(const BasicBlock* BB);
+    // BB that does not come from the LLVM IR, like the ones read from a DOT file
+    unsigned int addBasicBlock(const string& BBName);
+    unsigned int getNumBBs();
 
-    void setCurrentBB(StringRef BBName);
+    void setCurrentBB(const BasicBlock* BB);
 
     void addBlockToBB(Block* block);
-    void addBlockToBB(StringRef BBName, Block* block);
+    void addBlockToBB(const BasicBlock* BB, Block* block);
 
     void addControlBlockToBB(Block* block);
-    void addControlBlockToBB(StringRef BBName, Block* block);
+    void addControlBlockToBB(const BasicBlock* BB, Block* block);
 
     unsigned int getBBId();
-    unsigned int getBBId(StringRef BBName);
-    void setBBId(unsigned int id);
-    void setBBId(StringRef BBName, unsigned int id);
+    unsigned int getBBId(const BasicBlock* BB);
+    BBGraph& getBB(unsigned int id);
+
+    /* Blocks that do not belong to any BB (the merges of several exits and the call wrapper),
+        in the order they are printed */
+    void getOuterBlocks(vector <Block*>& blocks);
+    // Any other block outside the BB, like the ones of a graph read from a DOT file
+    void addOuterBlock(Block* block);
+    /* Place a block created once the graph is built, like a buffer, in the BB of another
+        block, or outside the BB if that one does not belong to a BB of the IR */
+    void addBlockNextTo(Block* block, Block* neighbour, bool control);
+
+    // Every block created in the graph, in creation order, the dummy blocks of the calls too
+    const vector <Block*>& getCreatedBlocks();
+
+    /* Takes out of the BB and destroys blocks that nothing is connected to anymore. Only
+        the blocks of the BB and the other outer blocks can be removed, not the ones the
+        graph keeps for the calls */
+    void removeBlocks(const unordered_set <Block*>& removed);
 
     void addArgument(Argument* block);
     Argument* getArgument(unsigned int index);
@@ -119,17 +145,47 @@ public:
     int getDefaultPortWidth();
     void setDefaultPortWidth(unsigned int width);
 
+    /* How the function is linked with its call sites when it has more than one, "shared"
+        through the call wrapper or "copied" with a graph for each one of them */
+    string getCallLinking();
+    void setCallLinking(const string& linking);
+
+    // Function the graph is a copy of, made for one of its call sites
+    string getCopyOf();
+    void setCopyOf(const string& functionName);
+
+    // Adds the blocks of the graph to the counter of their type, and the operators to their operation
+    void countBlockTypes(map <BlockType, unsigned int>& blockTypes,
+        map <OpType, unsigned int>& opTypes);
+    // Bytes reserved for the blocks of the graph and their ports
+    size_t getAllocatedBytes();
+
+    // Adds to the counter of each name prefix the blocks of the graph with that prefix
+    void countBlockNames(map <string, unsigned int>& counters);
+    /* Gives to each block the number following the ones in firstNumbers for its prefix,
+        in the order the blocks were created */
+    void numberBlocks(map <string, unsigned int> firstNumbers);
+
+    // Frees all the blocks of the graph at once, giving back the slabs of its arena
     void freeGraph();
 
-    void printNodes(ostream &file, Function& F);
-    void printEdges(ostream &file, Function& F);
+    void printNodes(DotBuffer& file);
+    void printEdges(DotBuffer& file);
 
 private:
 
     int defaultPortWidth;
     string functionName;
-    map <StringRef, BBGraph> basicBlocks;
-    BBGraph* currentBB;
+    string callLinking;
+    string copyOf;
+    BlockArena arena;
+    /* BB are numbered densely in the order they are added, and this number
+        is the index in the vector. The number does not depend on the name,
+        as LLVM can leave some BB unnamed */
+    vector <BBGraph> basicBlocks;
+    unordered_map <const BasicBlock*, unsigned int> BBIds;
+    unsigned int currentBB;
+    vector <Block*> outerBlocks;
 
     /* In addition to storing the BB, we also store the possible blocks that will
         form the wrapper, as well as keeping references of the blocks that will be
@@ -159,6 +215,12 @@ private:
 };
 
 
+template <typename T, typename... Args>
+T* FunctionGraph::createBlock(Args&&... args) {
+    return arena.create<T>(std::forward<Args>(args)...);
+}
+
+
 
 }
 
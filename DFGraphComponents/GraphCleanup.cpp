@@ -0,0 +1,164 @@
+#include "GraphCleanup.h"
+
+
+namespace DFGraphComp
+{
+
+
+/*
+ * =================================
+ *  Class GraphCleanup
+ * =================================
+*/
+
+
+GraphCleanup::GraphCleanup(FunctionGraph& graph)
+    : GraphCleanup(vector <FunctionGraph*>(1, &graph)) {}
+
+GraphCleanup::GraphCleanup(const vector <FunctionGraph*>& graphs)
+    : channelGraph(graphs), blocks(channelGraph.getBlocks()),
+    channels(channelGraph.getChannels()), inChannels(channelGraph.getInChannels()),
+    numRemoved(0), numCollapsed(0), numSinks(0) {}
+
+GraphCleanup::~GraphCleanup() {}
+
+void GraphCleanup::cleanGraph() {
+    for (unsigned int i = 0; i < blocks.size(); ++i) blockIds[blocks[i]] = i;
+    inBB.assign(blocks.size(), false);
+    const vector <FunctionGraph*>& graphs = channelGraph.getGraphs();
+    for (FunctionGraph* graph : graphs) {
+        for (unsigned int i = 0; i < graph->getNumBBs(); ++i) {
+            const vector <Block*>* BBBlocks[2] = {&graph->getBB(i).getBlocks(),
+                &graph->getBB(i).getControlBlocks()};
+            for (unsigned int j = 0; j < 2; ++j) {
+                for (Block* block : *BBBlocks[j]) {
+                    unordered_map <Block*, unsigned int>::const_iterator it =
+                        blockIds.find(block);
+                    if (it != blockIds.end()) inBB[it->second] = true;
+                }
+            }
+        }
+    }
+    markLive();
+    for (unsigned int i = 0; i < blocks.size(); ++i) {
+        if (live[i]) continue;
+        removed.insert(blocks[i]);
+        ++numRemoved;
+    }
+    for (unsigned int i = 0; i < blocks.size(); ++i) {
+        if (live[i]) connectFreeOutputs(i);
+    }
+    collapseForks();
+    for (FunctionGraph* graph : graphs) graph->removeBlocks(removed);
+}
+
+unsigned int GraphCleanup::getNumBlocksRemoved() {
+    return numRemoved;
+}
+
+unsigned int GraphCleanup::getNumForksCollapsed() {
+    return numCollapsed;
+}
+
+unsigned int GraphCleanup::getNumSinks() {
+    return numSinks;
+}
+
+bool GraphCleanup::canRemove(unsigned int block) {
+    if (!inBB[block]) return false;
+    Block* b = blocks[block];
+    switch (b->getBlockType())
+    {
+        case BlockType::Operator_Block:
+            return !isMemory(((Operator*)b)->getOpType());
+        case BlockType::Constant_Block:
+        case BlockType::Fork_Block:
+        case BlockType::Merge_Block:
+        case BlockType::Select_Block:
+        case BlockType::Branch_Block:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void GraphCleanup::markLive() {
+    live.assign(blocks.size(), false);
+    vector <unsigned int> pending;
+    for (unsigned int i = 0; i < blocks.size(); ++i) {
+        bool keep = !canRemove(i);
+        // The blocks of other functions are not in the channels, they are always kept
+        for (unsigned int j = 0; j < blocks[i]->getNumOutputPorts() and !keep; ++j) {
+            Block* to = blocks[i]->getOutputConnection(j).first;
+            keep = to != nullptr and blockIds.find(to) == blockIds.end();
+        }
+        if (!keep) continue;
+        live[i] = true;
+        pending.push_back(i);
+    }
+    while (!pending.empty()) {
+        unsigned int block = pending.back();
+        pending.pop_back();
+        for (unsigned int channel : inChannels[block]) {
+            unsigned int from = channels[channel].from;
+            if (live[from]) continue;
+            live[from] = true;
+            pending.push_back(from);
+        }
+    }
+}
+
+void GraphCleanup::connectFreeOutputs(unsigned int block) {
+    Block* b = blocks[block];
+    FunctionGraph& graph = channelGraph.getGraph(block);
+    bool exit = b->getBlockType() == BlockType::Exit_Block;
+    bool fork = b->getBlockType() == BlockType::Fork_Block;
+    bool dropped = false;
+    for (unsigned int i = 0; i < b->getNumOutputPorts(); ++i) {
+        pair <Block*, int> connection = b->getOutputConnection(i);
+        // The exit of a function called from nowhere is left free
+        if (connection.first == nullptr and exit) continue;
+        if (connection.first != nullptr and !removed.count(connection.first)) continue;
+        if (fork) {
+            ((Fork*)b)->setOutPort(i, make_pair(nullptr, -1));
+            dropped = true;
+            continue;
+        }
+        int width = b->getOutputPort(i).getWidth();
+        Sink* sink = graph.createBlock<Sink>(b->getParentBB(), width);
+        b->setOutputConnection(i, make_pair(sink, 0));
+        graph.addBlockNextTo(sink, b, width == 0);
+        ++numSinks;
+    }
+    if (dropped) ((Fork*)b)->removeDisconnectedPorts();
+}
+
+void GraphCleanup::collapseForks() {
+    /* Output that feeds each fork, updated when the block that fed it is collapsed. The
+        ports of the forks are numbered again, so they are not the ones of the channels */
+    vector <pair <Block*, unsigned int> > sources(blocks.size(), make_pair(nullptr, 0));
+    for (unsigned int i = 0; i < blocks.size(); ++i) {
+        if (!live[i]) continue;
+        for (unsigned int j = 0; j < blocks[i]->getNumOutputPorts(); ++j) {
+            unordered_map <Block*, unsigned int>::const_iterator it =
+                blockIds.find(blocks[i]->getOutputConnection(j).first);
+            if (it != blockIds.end()) sources[it->second] = make_pair(blocks[i], j);
+        }
+    }
+    for (unsigned int i = 0; i < blocks.size(); ++i) {
+        Block* b = blocks[i];
+        if (!live[i] or !inBB[i] or b->getBlockType() != BlockType::Fork_Block) continue;
+        if (b->getNumOutputPorts() != 1 or sources[i].first == nullptr) continue;
+        if (sources[i].first == b) continue;
+        pair <Block*, int> connection = b->getOutputConnection(0);
+        sources[i].first->setOutputConnection(sources[i].second, connection);
+        unordered_map <Block*, unsigned int>::const_iterator it =
+            blockIds.find(connection.first);
+        if (it != blockIds.end()) sources[it->second] = sources[i];
+        removed.insert(b);
+        ++numCollapsed;
+    }
+}
+
+
+}
@@ -0,0 +1,77 @@
+#ifndef GRAPHCLEANUP_H
+#define GRAPHCLEANUP_H
+
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include "ChannelGraph.h"
+
+using namespace std;
+
+namespace DFGraphComp
+{
+
+
+/* Removes from a function graph what is left behind by the builder and the linking of the
+    calls. The blocks whose values nobody uses are removed: operators other than the memory
+    accesses, constants, forks, merges, selects and branches of the BB. A block is kept if
+    any of its outputs reaches a block that is always kept, so the dead cycles of the loops
+    go too, marked in one walk over the channels, backwards from the blocks kept.
+
+    Then the forks drop the outputs to the blocks removed, and the forks with a single
+    output left are replaced by a direct channel. Every other output that is not connected,
+    like the unused side of a branch, the result of a load nobody reads or an argument
+    the function does not use, is connected to a new Sink block.
+
+    The blocks outside the BB (the wrapper of the calls and the merges of the exits) are
+    always kept.
+
+    The graphs of the functions linked by their calls have to be cleaned together, as a
+    block that only feeds a dead block of its caller, like the exit of the function, has
+    to get a sink when that block goes. A block with an output to a graph not given is
+    kept, but nothing is known about the blocks of other graphs that feed this one */
+class GraphCleanup {
+
+public:
+
+    GraphCleanup(FunctionGraph& graph);
+    GraphCleanup(const vector <FunctionGraph*>& graphs);
+    ~GraphCleanup();
+
+    void cleanGraph();
+
+    unsigned int getNumBlocksRemoved();
+    unsigned int getNumForksCollapsed();
+    unsigned int getNumSinks();
+
+private:
+
+    typedef ChannelGraph::Channel Channel;
+
+    ChannelGraph channelGraph;
+    const vector <Block*>& blocks;
+    const vector <Channel>& channels;
+    const vector <vector <unsigned int> >& inChannels;
+    unordered_map <Block*, unsigned int> blockIds;
+    // Blocks placed in a BB, the only ones that can be removed
+    vector <bool> inBB;
+    vector <bool> live;
+    unordered_set <Block*> removed;
+
+    unsigned int numRemoved;
+    unsigned int numCollapsed;
+    unsigned int numSinks;
+
+    bool canRemove(unsigned int block);
+    void markLive();
+    // Disconnects the outputs to the blocks removed and gives a sink to the others left free
+    void connectFreeOutputs(unsigned int block);
+    void collapseForks();
+
+};
+
+
+}
+
+
+#endif // GRAPHCLEANUP_H
@@ -0,0 +1,222 @@
+#include "LoopTagging.h"
+
+
+namespace DFGraphComp
+{
+
+
+/*
+ * =================================
+ *  Class LoopTagging
+ * =================================
+*/
+
+
+LoopTagging::LoopTagging(FunctionGraph& graph, const unordered_set <const BasicBlock*>& loopBBs,
+    const BasicBlock* header, unsigned int numTags)
+    : graph(graph), channelGraph(graph), blocks(channelGraph.getBlocks()),
+    channels(channelGraph.getChannels()), inChannels(channelGraph.getInChannels()),
+    outChannels(channelGraph.getOutChannels()), loopBBs(loopBBs), header(header),
+    numTags(numTags), numBypassed(0) {}
+
+LoopTagging::~LoopTagging() {}
+
+bool LoopTagging::tagLoop() {
+    for (unsigned int i = 0; i < blocks.size(); ++i) blockIds[blocks[i]] = i;
+    findLoopBlocks();
+    if (!findBorder()) return false;
+    // Exits of the values that do not change in the loop, by the channel they enter through
+    map <unsigned int, vector <unsigned int> > bypasses;
+    vector <bool> bypassed(exits.size(), false);
+    for (unsigned int i = 0; i < exits.size(); ++i) {
+        int entry = findBypass(exits[i]);
+        if (entry < 0) continue;
+        bypasses[entry].push_back(exits[i]);
+        bypassed[i] = true;
+        ++numBypassed;
+    }
+
+    Tagger* tagger = graph.createBlock<Tagger>(header, numTags);
+    graph.addBlockNextTo(tagger, blocks[channels[entries[0]].to], false);
+    for (unsigned int entry : entries) {
+        const Channel& channel = channels[entry];
+        Block* from = blocks[channel.from];
+        int width = from->getOutputPort(channel.fromPort).getWidth();
+        unsigned int value = tagger->addValue(width);
+        tagger->setOutPort(value, make_pair(blocks[channel.to], channel.toPort));
+        map <unsigned int, vector <unsigned int> >::const_iterator it = bypasses.find(entry);
+        if (it == bypasses.end()) {
+            from->setOutputConnection(channel.fromPort, make_pair(tagger, value));
+            continue;
+        }
+        // The value also goes to the blocks after the loop
+        Fork* fork;
+        if (from->getBlockType() == BlockType::Fork_Block) {
+            fork = (Fork*)from;
+            fork->setOutPort(channel.fromPort, make_pair(tagger, value));
+        }
+        else {
+            fork = graph.createBlock<Fork>(from->getParentBB(), width);
+            from->setOutputConnection(channel.fromPort, make_pair(fork, 0));
+            fork->setConnectedPort(tagger, value);
+            graph.addBlockNextTo(fork, from, width == 0);
+        }
+        for (unsigned int exit : it->second) {
+            fork->setConnectedPort(blocks[channels[exit].to], channels[exit].toPort);
+        }
+    }
+
+    Block* exitBranch = blocks[channels[exits[0]].from];
+    Untagger* untagger = graph.createBlock<Untagger>(exitBranch->getParentBB(), numTags);
+    graph.addBlockNextTo(untagger, exitBranch, false);
+    for (unsigned int i = 0; i < exits.size(); ++i) {
+        const Channel& channel = channels[exits[i]];
+        Block* from = blocks[channel.from];
+        int width = from->getOutputPort(channel.fromPort).getWidth();
+        if (bypassed[i] and width != 0) {
+            addSink(from, channel.fromPort);
+            continue;
+        }
+        unsigned int value = untagger->addValue(width);
+        from->setOutputConnection(channel.fromPort, make_pair(untagger, value));
+        if (bypassed[i]) addSink(untagger, value);
+        else untagger->setOutPort(value, make_pair(blocks[channel.to], channel.toPort));
+    }
+    untagger->setOutPort(untagger->getFreePort(), make_pair(tagger, tagger->getFreePort()));
+    return true;
+}
+
+unsigned int LoopTagging::getNumBypassed() {
+    return numBypassed;
+}
+
+void LoopTagging::findLoopBlocks() {
+    inLoop.assign(blocks.size(), false);
+    auto inLoopBB = [this](unsigned int block) {
+        BlockType type = blocks[block]->getBlockType();
+        if (type == BlockType::Fork_Block or type == BlockType::Sink_Block) return false;
+        return loopBBs.count(blocks[block]->getParentBB()) > 0;
+    };
+    vector <unsigned int> pending;
+    for (unsigned int i = 0; i < blocks.size(); ++i) {
+        BlockType type = blocks[i]->getBlockType();
+        if (type != BlockType::Fork_Block and type != BlockType::Sink_Block) {
+            inLoop[i] = inLoopBB(i);
+            continue;
+        }
+        // The block that produces the value, going up through the forks
+        unsigned int producer = i;
+        while (blocks[producer]->getBlockType() == BlockType::Fork_Block or producer == i) {
+            if (inChannels[producer].empty()) break;
+            producer = channels[inChannels[producer][0]].from;
+        }
+        if (!inLoopBB(producer)) continue;
+        if (type == BlockType::Sink_Block) {
+            inLoop[i] = true;
+            continue;
+        }
+        // A fork of a value of the loop is out if all the blocks it feeds are out
+        bool feedsLoop = false;
+        bool feedsOut = false;
+        pending.assign(1, i);
+        while (!pending.empty() and !feedsLoop) {
+            unsigned int block = pending.back();
+            pending.pop_back();
+            for (unsigned int channel : outChannels[block]) {
+                unsigned int to = channels[channel].to;
+                BlockType toType = blocks[to]->getBlockType();
+                if (toType == BlockType::Fork_Block) pending.push_back(to);
+                else if (toType == BlockType::Sink_Block) continue;
+                else if (inLoopBB(to)) feedsLoop = true;
+                else feedsOut = true;
+            }
+        }
+        inLoop[i] = feedsLoop or !feedsOut;
+    }
+}
+
+bool LoopTagging::findBorder() {
+    entries.clear();
+    exits.clear();
+    const BasicBlock* exitBB = nullptr;
+    unsigned int numControl = 0;
+    for (unsigned int i = 0; i < blocks.size(); ++i) {
+        if (!inLoop[i]) continue;
+        Block* block = blocks[i];
+        // The accesses of the queue are in program order, they cannot be mixed
+        if (block->getBlockType() == BlockType::LSQ_Block) return false;
+        // The channels to the blocks of other functions are not in the channel graph
+        for (unsigned int j = 0; j < block->getNumOutputPorts(); ++j) {
+            Block* to = block->getOutputConnection(j).first;
+            if (to != nullptr and blockIds.find(to) == blockIds.end()) return false;
+        }
+        for (unsigned int channel : inChannels[i]) {
+            if (inLoop[channels[channel].from]) continue;
+            if (block->getBlockType() != BlockType::Merge_Block or
+                block->getParentBB() != header)
+            {
+                return false;
+            }
+            entries.push_back(channel);
+        }
+        for (unsigned int channel : outChannels[i]) {
+            if (inLoop[channels[channel].to]) continue;
+            if (block->getBlockType() != BlockType::Branch_Block) return false;
+            if (exitBB == nullptr) exitBB = block->getParentBB();
+            else if (block->getParentBB() != exitBB) return false;
+            if (block->getOutputPort(channels[channel].fromPort).getWidth() == 0) {
+                ++numControl;
+            }
+            exits.push_back(channel);
+        }
+    }
+    return !entries.empty() and numControl == 1;
+}
+
+int LoopTagging::findBypass(unsigned int exit) {
+    unsigned int branch = channels[exit].from;
+    int entry = -1;
+    vector <unsigned int> pending;
+    vector <bool> visited(blocks.size(), false);
+    visited[branch] = true;
+    // Only the data input of the branches, not their condition
+    for (unsigned int channel : inChannels[branch]) {
+        if (channels[channel].toPort == 0) pending.push_back(channel);
+    }
+    while (!pending.empty()) {
+        unsigned int channel = pending.back();
+        pending.pop_back();
+        unsigned int from = channels[channel].from;
+        if (!inLoop[from]) {
+            // Each channel that enters the loop carries a different value
+            if (entry >= 0 and entry != (int)channel) return -1;
+            entry = channel;
+            continue;
+        }
+        if (visited[from]) continue;
+        visited[from] = true;
+        BlockType type = blocks[from]->getBlockType();
+        if (type != BlockType::Fork_Block and type != BlockType::Merge_Block and
+            type != BlockType::Branch_Block)
+        {
+            return -1;
+        }
+        for (unsigned int inChannel : inChannels[from]) {
+            if (type != BlockType::Branch_Block or channels[inChannel].toPort == 0) {
+                pending.push_back(inChannel);
+            }
+        }
+    }
+    return entry;
+}
+
+Block* LoopTagging::addSink(Block* block, unsigned int port) {
+    int width = block->getOutputPort(port).getWidth();
+    Sink* sink = graph.createBlock<Sink>(block->getParentBB(), width);
+    block->setOutputConnection(port, make_pair(sink, 0));
+    graph.addBlockNextTo(sink, block, width == 0);
+    return sink;
+}
+
+
+}
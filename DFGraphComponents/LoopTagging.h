@@ -0,0 +1,87 @@
+#ifndef LOOPTAGGING_H
+#define LOOPTAGGING_H
+
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include "ChannelGraph.h"
+
+using namespace std;
+
+namespace DFGraphComp
+{
+
+
+/* Pipelines a loop with tagged tokens, so the executions of the loop that start before
+    the previous ones finish, e.g. the ones of an inner loop from the iterations of the
+    outer one, are in the loop at the same time instead of waiting for it to be empty.
+
+    The loop is given by its BB and its header. Its blocks are the ones of those BB, with
+    the forks and sinks where the value they copy or discard comes from (a fork outside
+    the BB that only feeds blocks outside stays out). A Tagger takes every channel that
+    enters the loop, that has to end in a merge of the header, and an Untagger every one
+    that leaves it, that has to start in a branch of the single BB the loop exits from.
+    The Untagger gives the tags back to the Tagger through a 0-width channel.
+
+    The values that leave the loop as they entered it, walking back from the branch through
+    forks, branches and merges only to one channel that enters it, do not wait for the
+    loop: they go from before the Tagger to the blocks after the loop, and their branch
+    goes to a sink. The control always goes through the Untagger, so the tag is given back
+    when the execution ends, but if it is not changed in the loop either its output goes to
+    a sink too. As every value after the loop is then in program order, the blocks outside
+    never see the tags.
+
+    The loop is not tagged if other channels cross its border, like the ones of memory
+    accesses ordered with accesses outside or of a load-store queue, or if it calls other
+    functions */
+class LoopTagging {
+
+public:
+
+    LoopTagging(FunctionGraph& graph, const unordered_set <const BasicBlock*>& loopBBs,
+        const BasicBlock* header, unsigned int numTags);
+    ~LoopTagging();
+
+    // Returns false, without changing the graph, if the loop cannot be tagged
+    bool tagLoop();
+
+    // Values that leave the loop without going through it, the control included
+    unsigned int getNumBypassed();
+
+private:
+
+    typedef ChannelGraph::Channel Channel;
+
+    FunctionGraph& graph;
+    ChannelGraph channelGraph;
+    const vector <Block*>& blocks;
+    const vector <Channel>& channels;
+    const vector <vector <unsigned int> >& inChannels;
+    const vector <vector <unsigned int> >& outChannels;
+    unordered_map <Block*, unsigned int> blockIds;
+    const unordered_set <const BasicBlock*>& loopBBs;
+    const BasicBlock* header;
+    unsigned int numTags;
+    vector <bool> inLoop;
+    vector <unsigned int> entries;
+    vector <unsigned int> exits;
+
+    unsigned int numBypassed;
+
+    void findLoopBlocks();
+    // Finds the channels that cross the border of the loop, false if it cannot be tagged
+    bool findBorder();
+    /* Channel that enters the loop with the value that leaves it through a channel, or -1
+        if the value changes in the loop */
+    int findBypass(unsigned int exit);
+    // Adds the output of a block that takes the place of a channel
+    Block* addSink(Block* block, unsigned int port);
+
+};
+
+
+}
+
+
+#endif // LOOPTAGGING_H
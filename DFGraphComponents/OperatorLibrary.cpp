@@ -0,0 +1,207 @@
+#include "OperatorLibrary.h"
+#include <fstream>
+#include <sstream>
+#include <charconv>
+
+
+namespace DFGraphComp
+{
+
+
+/* Figures of a generic FPGA clocked at around 200 MHz, with the delays in ns: logic and
+    narrow integer arithmetic are combinational, while multipliers, dividers and the
+    floating point units are pipelined with an II of 1. The moves between types that
+    only change the width have no logic */
+static const char* defaultTable = R"(
+# operation     width  latency  II  delay
+add             32     0        0   1.5
+add             *      0        0   2.2
+sub             32     0        0   1.5
+sub             *      0        0   2.2
+mul             18     3        1   2.8
+mul             32     4        1   2.8
+mul             *      6        1   3.0
+div             32     36       1   2.0
+div             *      68       1   2.2
+rem             32     36       1   2.0
+rem             *      68       1   2.2
+and             *      0        0   0.6
+or              *      0        0   0.6
+xor             *      0        0   0.6
+shl             *      0        0   1.6
+shr             *      0        0   1.6
+eq              *      0        0   1.2
+ne              *      0        0   1.2
+gt              *      0        0   1.4
+ge              *      0        0   1.4
+lt              *      0        0   1.4
+le              *      0        0   1.4
+fadd            32     10       1   2.5
+fadd            *      12       1   2.8
+fsub            32     10       1   2.5
+fsub            *      12       1   2.8
+fmul            32     6        1   2.5
+fmul            *      9        1   2.8
+fdiv            32     30       1   2.5
+fdiv            *      57       1   2.8
+frem            32     30       1   2.5
+frem            *      57       1   2.8
+feq             *      2        1   1.5
+fne             *      2        1   1.5
+fgt             *      2        1   1.5
+fge             *      2        1   1.5
+flt             *      2        1   1.5
+fle             *      2        1   1.5
+fneg            *      0        0   0.4
+fpointtouint    *      6        1   2.3
+fpointtosint    *      6        1   2.3
+uinttofpoint    *      6        1   2.3
+sinttofpoint    *      6        1   2.3
+fpointtrunc     *      3        1   2.0
+fpointext       *      2        1   1.8
+inttrunc        *      0        0   0
+intzext         *      0        0   0
+intsext         *      0        0   0
+ptrtoint        *      0        0   0
+inttoptr        *      0        0   0
+bitcast         *      0        0   0
+addrspacecast   *      0        0   0
+)";
+
+
+static bool parseUnsigned(string_view text, unsigned int& value) {
+    const char* end = text.data() + text.size();
+    from_chars_result result = from_chars(text.data(), end, value);
+    return result.ec == errc() and result.ptr == end and text.size() > 0;
+}
+
+static bool parseReal(string_view text, double& value) {
+    const char* end = text.data() + text.size();
+    from_chars_result result = from_chars(text.data(), end, value);
+    return result.ec == errc() and result.ptr == end and text.size() > 0;
+}
+
+
+/*
+ * =================================
+ *  Class OperatorLibrary
+ * =================================
+*/
+
+
+OperatorLibrary::OperatorLibrary() {}
+
+OperatorLibrary::~OperatorLibrary() {}
+
+bool OperatorLibrary::readFile(const string& fileName) {
+    ifstream file(fileName);
+    if (!file.is_open()) return setError(0, "Cannot open " + fileName);
+    stringstream text;
+    text << file.rdbuf();
+    return read(text.str());
+}
+
+bool OperatorLibrary::read(string_view text) {
+    table.clear();
+    error.clear();
+    unsigned int line = 1;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == string_view::npos) end = text.size();
+        if (!parseLine(text.substr(start, end - start), line)) return false;
+        start = end + 1;
+        ++line;
+    }
+    return true;
+}
+
+void OperatorLibrary::readDefault() {
+    if (!read(defaultTable)) assert(0 && "Wrong built-in operator table");
+}
+
+const string& OperatorLibrary::getError() {
+    return error;
+}
+
+bool OperatorLibrary::isEmpty() {
+    return table.empty();
+}
+
+const OperatorLibrary::Characterization* OperatorLibrary::find(OpType op, unsigned int width) {
+    map <OpType, map <unsigned int, Characterization> >::const_iterator it = table.find(op);
+    if (it == table.end()) return nullptr;
+    // The * lines have the highest width, so they are the last choice
+    map <unsigned int, Characterization>::const_iterator widthIt = it->second.lower_bound(width);
+    if (widthIt == it->second.end()) return nullptr;
+    return &widthIt->second;
+}
+
+unsigned int OperatorLibrary::characterize(FunctionGraph& graph) {
+    unsigned int numFound = 0;
+    const vector <Block*>& blocks = graph.getCreatedBlocks();
+    for (unsigned int i = 0; i < blocks.size(); ++i) {
+        if (blocks[i]->getBlockType() != BlockType::Operator_Block) continue;
+        Operator* op = (Operator*)blocks[i];
+        int width = 0;
+        for (unsigned int j = 0; j < op->getNumOutputPorts(); ++j) {
+            width = max(width, op->getOutputPort(j).getWidth());
+        }
+        for (unsigned int j = 0; j < op->getNumInputPorts(); ++j) {
+            width = max(width, op->getInputPort(j).getWidth());
+        }
+        const Characterization* figures = find(op->getOpType(), width);
+        if (figures == nullptr) continue;
+        op->setLatency(figures->latency);
+        op->setII(figures->II);
+        op->setBlockDelay(figures->delay);
+        ++numFound;
+    }
+    return numFound;
+}
+
+bool OperatorLibrary::setError(unsigned int line, const string& message) {
+    if (line > 0) error = "line " + to_string(line) + ": " + message;
+    else error = message;
+    return false;
+}
+
+bool OperatorLibrary::parseLine(string_view text, unsigned int line) {
+    size_t comment = text.find('#');
+    if (comment != string_view::npos) text = text.substr(0, comment);
+    vector <string_view> fields;
+    size_t i = 0;
+    while (i < text.size()) {
+        if (text[i] == ' ' or text[i] == '\t' or text[i] == '\r') {
+            ++i;
+            continue;
+        }
+        size_t end = text.find_first_of(" \t\r", i);
+        if (end == string_view::npos) end = text.size();
+        fields.push_back(text.substr(i, end - i));
+        i = end;
+    }
+    if (fields.empty()) return true;
+    if (fields.size() != 5) return setError(line, "Expected: operation width latency II delay");
+    int op = 0;
+    while (op < numberOperators and fields[0] != getOpDotName((OpType)op)) ++op;
+    if (op == numberOperators) return setError(line, "Unknown operation " + string(fields[0]));
+    Characterization figures;
+    unsigned int width;
+    if (fields[1] == "*") width = anyWidth;
+    else if (!parseUnsigned(fields[1], width)) return setError(line, "Wrong width");
+    if (!parseUnsigned(fields[2], figures.latency)) return setError(line, "Wrong latency");
+    if (!parseUnsigned(fields[3], figures.II)) return setError(line, "Wrong II");
+    if (!parseReal(fields[4], figures.delay) or figures.delay < 0) {
+        return setError(line, "Wrong delay");
+    }
+    map <unsigned int, Characterization>& widths = table[(OpType)op];
+    if (widths.count(width)) {
+        return setError(line, "Operation " + string(fields[0]) + " already characterized");
+    }
+    widths[width] = figures;
+    return true;
+}
+
+
+}
@@ -0,0 +1,78 @@
+#ifndef OPERATORLIBRARY_H
+#define OPERATORLIBRARY_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include "Graph.h"
+
+using namespace std;
+
+namespace DFGraphComp
+{
+
+
+/* Latency, II and delay of the operators of a target, read from a text file so each
+    FPGA family can have its own table. Each line characterizes an operation, by the name
+    it has in the DOT files, for a width:
+
+        # operation  width  latency  II  delay
+        fmul         32     4        1   2.3
+        add          *      0        0   1.1
+
+    The width is the widest data port of the operator, and * gives the figures of the
+    widths without a line of their own. An operator takes the line of its width, or else
+    the one of the next wider width, or else the * line. The delay is the delay of the
+    block, that for a pipelined operator (latency > 0) is the delay between its internal
+    registers, as in Dataflow.md. Everything after # is a comment.
+    A built-in table of a generic FPGA, with delays in ns, is used when no file is given */
+class OperatorLibrary {
+
+public:
+
+    struct Characterization
+    {
+        unsigned int latency;
+        unsigned int II;
+        double delay;
+    };
+
+    OperatorLibrary();
+    ~OperatorLibrary();
+
+    // Both return false if the table is not correct, leaving the reason in getError
+    bool readFile(const string& fileName);
+    bool read(string_view text);
+    // The built-in table, in OperatorLibrary.cpp
+    void readDefault();
+
+    const string& getError();
+    bool isEmpty();
+
+    // Figures for an operation of the width given, nullptr if the table has none
+    const Characterization* find(OpType op, unsigned int width);
+
+    /* Sets the figures of every operator of the graph in the table, and returns how many
+        of them were found */
+    unsigned int characterize(FunctionGraph& graph);
+
+private:
+
+    // Wildcard width of the * lines
+    static const unsigned int anyWidth = ~0u;
+
+    // For each operation, its lines by width
+    map <OpType, map <unsigned int, Characterization> > table;
+    string error;
+
+    bool setError(unsigned int line, const string& message);
+    bool parseLine(string_view text, unsigned int line);
+
+};
+
+
+}
+
+
+#endif // OPERATORLIBRARY_H
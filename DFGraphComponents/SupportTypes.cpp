@@ -46,6 +46,18 @@ ostream &operator << (ostream &out, BlockType blockType) {
         case BlockType::Exit_Block:
             out << "Exit";
             break;
+        case BlockType::LSQ_Block:
+            out << "LSQ";
+            break;
+        case BlockType::Sink_Block:
+            out << "Sink";
+            break;
+        case BlockType::Tagger_Block:
+            out << "Tagger";
+            break;
+        case BlockType::Untagger_Block:
+            out << "Untagger";
+            break;
         default:
             break;
     }
@@ -222,154 +234,121 @@ bool isBinary(OpType op) {
 }
 
 
+bool isMemory(OpType op) {
+    return (op == OpType::Load or op == OpType::Store);
+}
 
-ostream &operator << (ostream& out, OpType op) {
+
+
+const char* getOpDotName(OpType op) {
     switch (op)
     {
         case Add:
-            out << "add";
-            break;
+            return "add";
         case FAdd:
-            out << "fadd";
-            break;
+            return "fadd";
         case Sub:
-            out << "sub";
-            break;
+            return "sub";
         case FSub:
-            out << "fsub";
-            break;
+            return "fsub";
         case Mul:
-            out << "mul";
-            break;
+            return "mul";
         case FMul:
-            out << "fmul";
-            break;
+            return "fmul";
         case Div:
-            out << "div";
-            break;
+            return "div";
         case FDiv:
-            out << "fdiv";
-            break;
+            return "fdiv";
         case Rem:
-            out << "rem";
-            break;
+            return "rem";
         case FRem:
-            out << "frem";
-            break;
+            return "frem";
         case ShiftL:
-            out << "shl";
-            break;
+            return "shl";
         case ShiftR:
-            out << "shr";
-            break;
+            return "shr";
         case And:
-            out << "and";
-            break;
+            return "and";
         case Or:
-            out << "or";
-            break;
+            return "or";
         case Xor:
-            out << "xor";
-            break;
+            return "xor";
         case Eq:
-            out << "eq";
-            break;
+            return "eq";
         case FEq:
-            out << "feq";
-            break;
+            return "feq";
         case NE:
-            out << "ne";
-            break;
+            return "ne";
         case FNE:
-            out << "fne";
-            break;
+            return "fne";
         case GT:
-            out << "gt";
-            break;
+            return "gt";
         case FGT:
-            out << "fgt";
-            break;
+            return "fgt";
         case LT:
-            out << "lt";
-            break;
+            return "lt";
         case FLT:
-            out << "flt";
-            break;
+            return "flt";
         case GE:
-            out << "ge";
-            break;
+            return "ge";
         case FGE:
-            out << "fge";
-            break;
+            return "fge";
         case LE:
-            out << "le";
-            break;
+            return "le";
         case FLE:
-            out << "fle";
-            break;
+            return "fle";
         case True:
-            out << "true";
-            break;
+            return "true";
         case False:
-            out << "false";
-            break;        
+            return "false";        
         case Store:
-            out << "store";
-            break;
+            return "store";
         case Load:
-            out << "load";
-            break;
+            return "load";
         case Alloca:
-            out << "alloca";
-            break;
+            return "alloca";
         case FNeg:
-            out << "fneg";
-            break;
+            return "fneg";
         case IntTrunc:
-            out << "inttrunc";
-            break;
+            return "inttrunc";
         case IntZExt:
-            out << "intzext";
-            break;
+            return "intzext";
         case IntSExt:
-            out << "intsext";
-            break;
+            return "intsext";
         case FPointToUInt:
-            out << "fpointtouint";
-            break;
+            return "fpointtouint";
         case FPointToSInt:
-            out << "fpointtosint";
-            break;
+            return "fpointtosint";
         case UIntToFPoint:
-            out << "uinttofpoint";
-            break;
+            return "uinttofpoint";
         case SIntToFPoint:
-            out << "sinttofpoint";
-            break;
+            return "sinttofpoint";
         case FPointTrunc:
-            out << "fpointtrunc";
-            break;
+            return "fpointtrunc";
         case FPointExt:
-            out << "fpointext";
-            break;
+            return "fpointext";
         case PtrToInt:
-            out << "ptrtoint";
-            break;
+            return "ptrtoint";
         case IntToPtr:
-            out << "inttoptr";
-            break;
+            return "inttoptr";
         case BitCast:
-            out << "bitcast";
-            break;
+            return "bitcast";
         case AddrSpaceCast:
-            out << "addrspacecast";
-            break;
+            return "addrspacecast";
         case Synchronization:
-            out << "synchronization";
-            break;
+            return "synchronization";
         default:
-            break;
+            return "";
     }
+}
+
+ostream &operator << (ostream& out, OpType op) {
+    out << getOpDotName(op);
+    return out;
+}
+
+DotBuffer &operator << (DotBuffer& out, OpType op) {
+    out << getOpDotName(op);
     return out;
 }
 
@@ -384,7 +363,7 @@ ostream &operator << (ostream& out, OpType op) {
 Port::Port() {}
 
 Port::Port(const string &name, int width, Port::PortType type, 
-    unsigned int delay) {
+    double delay) {
     assert(width >= -1);
     this->name = name;
     this->type = type;
@@ -399,10 +378,18 @@ Port::Port(const Port &port) {
     delay = port.delay;
 }
 
+Port::Port(const allocator_type& allocator) : name(allocator) {}
+
+Port::Port(const Port &port, const allocator_type& allocator) : name(port.name, allocator) {
+    width = port.width;
+    type = port.type;
+    delay = port.delay;
+}
+
 Port::~Port() {}
 
 string Port::getName() const {
-    return name;
+    return string(name.data(), name.size());
 }
 
 Port::PortType Port::getType() const {
@@ -413,7 +400,7 @@ int Port::getWidth() const {
     return width;
 }
 
-int Port::getDelay() const {
+double Port::getDelay() const {
     return delay;
 }
 
@@ -429,7 +416,7 @@ void Port::setWidth(unsigned int width) {
     this->width = width;
 }
 
-void Port::setDelay(unsigned int delay) {
+void Port::setDelay(double delay) {
     this->delay = delay;
 }
 
@@ -453,5 +440,25 @@ ostream &operator << (ostream &out, const Port &p) {
     return out;
 }
 
+DotBuffer &operator << (DotBuffer &out, const Port &p) {
+    out << p.name;
+    switch (p.type)
+    {
+        case Port::PortType::Condition:
+            out << '?';
+            break;
+        case Port::PortType::True:
+            out << '+';
+            break;
+        case Port::PortType::False:
+            out << '-';
+            break;
+        default:
+            break;
+    }
+    if (p.width > -1) out << ':' << p.width;
+    return out;
+}
+
 
 } // Close namespace
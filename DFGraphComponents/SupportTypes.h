@@ -4,6 +4,8 @@
 #include <string>
 #include <fstream>
 #include <assert.h>
+#include "DotBuffer.h"
+#include "ArenaMemory.h"
 using namespace std;
 
 
@@ -22,7 +24,11 @@ enum BlockType {
     Demux_Block,
     Entry_Block,
     Exit_Block,
-    FunctionCall_Block // Dummy block
+    FunctionCall_Block, // Dummy block
+    LSQ_Block,
+    Sink_Block,
+    Tagger_Block,
+    Untagger_Block
 };
 
 ostream &operator << (ostream &out, BlockType blockType);
@@ -90,8 +96,14 @@ string getOpName(OpType op);
 
 bool isUnary(OpType op);
 bool isBinary(OpType op);
+// Loads and stores
+bool isMemory(OpType op);
+
+// Name of the operation in the DOT file
+const char* getOpDotName(OpType op);
 
 ostream &operator << (ostream& out, OpType op);
+DotBuffer &operator << (DotBuffer& out, OpType op);
 
 
 
@@ -106,29 +118,36 @@ public:
         False
     };
 
+    /* The name is kept with the allocator of the container of the port, so the ports of
+        a block live in the arena of its graph */
+    typedef ArenaAllocator <char> allocator_type;
+
     Port();
     Port(const string &name, int width = -1, PortType type = Base,  
-        unsigned int delay = 0);
+        double delay = 0);
     Port(const Port &port);
+    Port(const allocator_type& allocator);
+    Port(const Port &port, const allocator_type& allocator);
     ~Port();
 
     string getName() const;
     PortType getType() const;
     int getWidth() const;
-    int getDelay() const;
+    double getDelay() const;
     void setName(string name);
     void setType(PortType type);
     void setWidth(unsigned int width);
-    void setDelay(unsigned int delay);
+    void setDelay(double delay);
     
     friend ostream &operator << (ostream &out, const Port &p); 
+    friend DotBuffer &operator << (DotBuffer &out, const Port &p);
 
 private:
 
-    string name;
+    ArenaString name;
     PortType type;
     int width;
-    unsigned int delay;
+    double delay;
 
 };
 
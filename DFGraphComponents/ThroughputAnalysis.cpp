@@ -0,0 +1,300 @@
+#include "ThroughputAnalysis.h"
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+
+namespace DFGraphComp
+{
+
+
+/*
+ * =================================
+ *  Class ThroughputAnalysis
+ * =================================
+*/
+
+
+ThroughputAnalysis::ThroughputAnalysis(FunctionGraph& graph)
+    : ThroughputAnalysis(vector <FunctionGraph*>(1, &graph)) {}
+
+ThroughputAnalysis::ThroughputAnalysis(const vector <FunctionGraph*>& graphs)
+    : channelGraph(graphs), blocks(channelGraph.getBlocks()),
+    channels(channelGraph.getChannels()), inChannels(channelGraph.getInChannels()),
+    outChannels(channelGraph.getOutChannels()) {}
+
+ThroughputAnalysis::~ThroughputAnalysis() {}
+
+unsigned int ThroughputAnalysis::findComponents() {
+    vector <unsigned int> components;
+    vector <unsigned int> sizes;
+    channelGraph.findComponents([](unsigned int) { return true; }, components, sizes);
+    // A component of a single block only has a cycle with a channel to itself
+    vector <bool> cyclic(sizes.size(), false);
+    for (unsigned int i = 0; i < sizes.size(); ++i) cyclic[i] = sizes[i] > 1;
+    for (unsigned int i = 0; i < channels.size(); ++i) {
+        if (channels[i].from == channels[i].to) cyclic[components[channels[i].from]] = true;
+    }
+    vector <int> numbers(sizes.size(), -1);
+    componentBlocks.clear();
+    blockComponents.assign(blocks.size(), -1);
+    localIds.assign(blocks.size(), 0);
+    for (unsigned int i = 0; i < blocks.size(); ++i) {
+        unsigned int component = components[i];
+        if (!cyclic[component]) continue;
+        if (numbers[component] < 0) {
+            numbers[component] = componentBlocks.size();
+            componentBlocks.push_back(vector <unsigned int>());
+        }
+        vector <unsigned int>& members = componentBlocks[numbers[component]];
+        blockComponents[i] = numbers[component];
+        localIds[i] = members.size();
+        members.push_back(i);
+    }
+    cycles.assign(componentBlocks.size(), CriticalCycle());
+    return componentBlocks.size();
+}
+
+void ThroughputAnalysis::analyzeComponent(unsigned int component) {
+    assert(component < componentBlocks.size() && "Wrong component");
+    vector <unsigned int> cycleChannels = findEmptyCycle(component);
+    if (cycleChannels.empty()) cycleChannels = findMaxRatioCycle(component);
+    CriticalCycle& cycle = cycles[component];
+    cycle.blocks.clear();
+    cycle.graphs.clear();
+    cycle.latency = 0;
+    cycle.capacity = 0;
+    for (unsigned int i = 0; i < cycleChannels.size(); ++i) {
+        unsigned int block = channels[cycleChannels[i]].from;
+        cycle.blocks.push_back(blocks[block]);
+        cycle.graphs.push_back(&channelGraph.getGraph(block));
+        cycle.latency += channelGraph.getLatency(block);
+        cycle.capacity += getCapacity(block);
+    }
+    if (cycle.capacity == 0) cycle.ratio = numeric_limits<double>::infinity();
+    else cycle.ratio = (double)cycle.latency / cycle.capacity;
+    cycle.componentSize = componentBlocks[component].size();
+}
+
+void ThroughputAnalysis::analyze() {
+    findComponents();
+    for (unsigned int i = 0; i < componentBlocks.size(); ++i) analyzeComponent(i);
+}
+
+unsigned int ThroughputAnalysis::getNumComponents() {
+    return componentBlocks.size();
+}
+
+const ThroughputAnalysis::CriticalCycle& ThroughputAnalysis::getCriticalCycle(
+    unsigned int component)
+{
+    assert(component < cycles.size() && "Wrong component");
+    return cycles[component];
+}
+
+unsigned int ThroughputAnalysis::getCapacity(unsigned int block) {
+    Block* b = blocks[block];
+    if (b->getBlockType() == BlockType::Buffer_Block) return ((Buffer*)b)->getNumSlots();
+    if (b->getBlockType() == BlockType::Operator_Block) {
+        Operator* op = (Operator*)b;
+        unsigned int II = max(op->getII(), 1u);
+        return (op->getLatency() + II - 1) / II;
+    }
+    if (b->getBlockType() == BlockType::LSQ_Block) return ((LSQ*)b)->getDepth();
+    /* The executions of a tagged loop that can be in it at the same time. The untagger
+        keeps the values of the same executions, so it adds nothing */
+    if (b->getBlockType() == BlockType::Tagger_Block) return ((Tagger*)b)->getNumTags();
+    return 0;
+}
+
+bool ThroughputAnalysis::isInside(unsigned int channel, unsigned int component) {
+    return blockComponents[channels[channel].from] == (int)component and
+        blockComponents[channels[channel].to] == (int)component;
+}
+
+vector <unsigned int> ThroughputAnalysis::findEmptyCycle(unsigned int component) {
+    const vector <unsigned int>& members = componentBlocks[component];
+    auto empty = [&](unsigned int channel) {
+        return isInside(channel, component) and getCapacity(channels[channel].from) == 0;
+    };
+    // Blocks without capacity are removed from the sources, what is left has a cycle
+    vector <unsigned int> numPreds(members.size(), 0);
+    for (unsigned int i = 0; i < members.size(); ++i) {
+        for (unsigned int channel : outChannels[members[i]]) {
+            if (empty(channel)) ++numPreds[localIds[channels[channel].to]];
+        }
+    }
+    vector <unsigned int> sources;
+    for (unsigned int i = 0; i < members.size(); ++i) {
+        if (numPreds[i] == 0) sources.push_back(i);
+    }
+    for (unsigned int i = 0; i < sources.size(); ++i) {
+        for (unsigned int channel : outChannels[members[sources[i]]]) {
+            if (!empty(channel)) continue;
+            unsigned int to = localIds[channels[channel].to];
+            if (--numPreds[to] == 0) sources.push_back(to);
+        }
+    }
+    vector <unsigned int> cycle;
+    if (sources.size() == members.size()) return cycle;
+    // Going back from a block left always finds another one left, until one repeats
+    vector <int> positions(members.size(), -1);
+    vector <unsigned int> path;
+    unsigned int block = 0;
+    while (numPreds[block] == 0) ++block;
+    while (positions[block] < 0) {
+        positions[block] = path.size();
+        for (unsigned int channel : inChannels[members[block]]) {
+            if (!empty(channel) or numPreds[localIds[channels[channel].from]] == 0) continue;
+            path.push_back(channel);
+            block = localIds[channels[channel].from];
+            break;
+        }
+    }
+    cycle.assign(path.begin() + positions[block], path.end());
+    reverse(cycle.begin(), cycle.end());
+    return cycle;
+}
+
+vector <unsigned int> ThroughputAnalysis::findMaxRatioCycle(unsigned int component) {
+    const vector <unsigned int>& members = componentBlocks[component];
+    unsigned int numMembers = members.size();
+    const double epsilon = 1e-9;
+    const unsigned int maxIterations = 1000;
+    // Out channels inside the component of each block, and the one the policy follows
+    vector <vector <unsigned int> > edges(numMembers);
+    vector <unsigned int> policy(numMembers);
+    vector <double> latencies(numMembers);
+    vector <double> capacities(numMembers);
+    for (unsigned int i = 0; i < numMembers; ++i) {
+        for (unsigned int channel : outChannels[members[i]]) {
+            if (isInside(channel, component)) edges[i].push_back(channel);
+        }
+        assert(!edges[i].empty() && "Block of a cycle without successor");
+        policy[i] = edges[i][0];
+        latencies[i] = channelGraph.getLatency(members[i]);
+        capacities[i] = getCapacity(members[i]);
+    }
+    auto next = [&](unsigned int channel) { return localIds[channels[channel].to]; };
+
+    // Ratio of the cycle each block reaches with the policy, and its distance to it
+    vector <double> ratios(numMembers);
+    vector <double> values(numMembers);
+    vector <unsigned char> states(numMembers);
+    vector <unsigned int> path;
+    for (unsigned int iteration = 0; iteration < maxIterations; ++iteration) {
+        // Each block has a single successor, so each walk ends in a cycle
+        states.assign(numMembers, 0);
+        for (unsigned int start = 0; start < numMembers; ++start) {
+            if (states[start] != 0) continue;
+            path.clear();
+            unsigned int block = start;
+            while (states[block] == 0) {
+                states[block] = 1;
+                path.push_back(block);
+                block = next(policy[block]);
+            }
+            if (states[block] == 1) {
+                double latency = 0;
+                double capacity = 0;
+                unsigned int member = block;
+                do {
+                    latency += latencies[member];
+                    capacity += capacities[member];
+                    member = next(policy[member]);
+                } while (member != block);
+                double ratio = latency / capacity;
+                ratios[block] = ratio;
+                values[block] = 0;
+                states[block] = 2;
+                for (unsigned int i = path.size(); path[i - 1] != block; --i) {
+                    member = path[i - 1];
+                    ratios[member] = ratio;
+                    values[member] = latencies[member] - ratio * capacities[member] +
+                        values[next(policy[member])];
+                    states[member] = 2;
+                }
+            }
+            for (unsigned int i = path.size(); i-- > 0; ) {
+                unsigned int member = path[i];
+                if (states[member] == 2) continue;
+                unsigned int successor = next(policy[member]);
+                ratios[member] = ratios[successor];
+                values[member] = latencies[member] - ratios[member] * capacities[member] +
+                    values[successor];
+                states[member] = 2;
+            }
+        }
+
+        // Follow the successor that reaches a higher ratio, or else a longer distance
+        bool changed = false;
+        for (unsigned int i = 0; i < numMembers; ++i) {
+            double bestRatio = ratios[i];
+            for (unsigned int channel : edges[i]) {
+                if (ratios[next(channel)] > bestRatio + epsilon) {
+                    bestRatio = ratios[next(channel)];
+                    policy[i] = channel;
+                    changed = true;
+                }
+            }
+        }
+        if (changed) continue;
+        for (unsigned int i = 0; i < numMembers; ++i) {
+            double bestValue = values[i];
+            for (unsigned int channel : edges[i]) {
+                unsigned int successor = next(channel);
+                if (fabs(ratios[successor] - ratios[i]) > epsilon) continue;
+                double value = latencies[i] - ratios[i] * capacities[i] + values[successor];
+                if (value > bestValue + epsilon) {
+                    bestValue = value;
+                    policy[i] = channel;
+                    changed = true;
+                }
+            }
+        }
+        if (!changed) break;
+    }
+
+    unsigned int block = max_element(ratios.begin(), ratios.end()) - ratios.begin();
+    vector <int> positions(numMembers, -1);
+    vector <unsigned int> walk;
+    while (positions[block] < 0) {
+        positions[block] = walk.size();
+        walk.push_back(policy[block]);
+        block = next(policy[block]);
+    }
+    return vector <unsigned int>(walk.begin() + positions[block], walk.end());
+}
+
+void ThroughputAnalysis::printReport(ostream& out, const vector <string>& origins) {
+    out << channelGraph.getFunctionNames() << ": ";
+    if (cycles.empty()) {
+        out << "no cycles" << endl;
+        return;
+    }
+    out << cycles.size() << " components with cycles" << endl;
+    vector <unsigned int> sorted;
+    for (unsigned int i = 0; i < cycles.size(); ++i) sorted.push_back(i);
+    stable_sort(sorted.begin(), sorted.end(), [this](unsigned int a, unsigned int b) {
+        return cycles[a].ratio > cycles[b].ratio;
+    });
+    for (unsigned int i = 0; i < sorted.size(); ++i) {
+        const CriticalCycle& cycle = cycles[sorted[i]];
+        out << "  Cycle ratio ";
+        if (cycle.capacity == 0) out << "infinite";
+        else out << cycle.ratio;
+        out << " (latency " << cycle.latency << ", capacity " << cycle.capacity << "), " <<
+            cycle.componentSize << " blocks in the component";
+        if (sorted[i] < origins.size() and !origins[sorted[i]].empty()) {
+            out << ", " << origins[sorted[i]];
+        }
+        out << endl << "   ";
+        for (unsigned int j = 0; j < cycle.blocks.size(); ++j) {
+            out << " " << cycle.blocks[j]->getBlockName();
+        }
+        out << endl;
+    }
+}
+
+
+}
@@ -0,0 +1,98 @@
+#ifndef THROUGHPUTANALYSIS_H
+#define THROUGHPUTANALYSIS_H
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include "ChannelGraph.h"
+
+using namespace std;
+
+namespace DFGraphComp
+{
+
+
+/* Bound of the steady state throughput of each cycle of a function graph, from its
+    maximum cycle ratio.
+
+    Each block adds to the cycles it is in its latency, the cycles a token takes to go
+    through it, and its capacity, the tokens it can hold at the same time: the slots of a
+    buffer (only the opaque ones add a cycle of latency), for a pipelined operator its
+    latency over its II, as it starts a new operation every II cycles, the depth of a
+    load-store queue and the tags of a tagger. A cycle with latency L and capacity C
+    cannot move more than C tokens every L cycles, so the ratio L / C is
+    a lower bound of the cycles between consecutive tokens (the II of a loop), and the
+    cycle with the highest ratio of each strongly connected component limits it.
+    A cycle without capacity cannot move any token, its ratio is infinite.
+
+    The ratio of each component is found with Howard's policy iteration. The components
+    are independent, so once they are found each can be analysed in a different thread.
+    The graphs of the functions linked by their calls are analysed together, as a loop
+    that calls a function has its cycles through the blocks of both */
+class ThroughputAnalysis {
+
+public:
+
+    struct CriticalCycle
+    {
+        // Blocks in the order of the cycle
+        vector <Block*> blocks;
+        // Graph of each block, they differ when the cycle goes through a call
+        vector <FunctionGraph*> graphs;
+        unsigned int latency;
+        unsigned int capacity;
+        double ratio;
+        // Blocks of the component the cycle belongs to
+        unsigned int componentSize;
+    };
+
+    ThroughputAnalysis(FunctionGraph& graph);
+    ThroughputAnalysis(const vector <FunctionGraph*>& graphs);
+    ~ThroughputAnalysis();
+
+    // Components with cycles, numbered in the order of their first block
+    unsigned int findComponents();
+    void analyzeComponent(unsigned int component);
+    // Finds and analyses all the components in this thread
+    void analyze();
+
+    unsigned int getNumComponents();
+    const CriticalCycle& getCriticalCycle(unsigned int component);
+
+    /* Critical cycle of each component, from the highest ratio. The origins, when given,
+        describe where each component comes from, e.g. the loop of the IR */
+    void printReport(ostream& out, const vector <string>& origins = vector <string>());
+
+private:
+
+    typedef ChannelGraph::Channel Channel;
+
+    ChannelGraph channelGraph;
+    const vector <Block*>& blocks;
+    const vector <Channel>& channels;
+    const vector <vector <unsigned int> >& inChannels;
+    const vector <vector <unsigned int> >& outChannels;
+
+    // Blocks of each component with cycles
+    vector <vector <unsigned int> > componentBlocks;
+    // For each block its component, -1 if it is in no cycle, and its index inside it
+    vector <int> blockComponents;
+    vector <unsigned int> localIds;
+    vector <CriticalCycle> cycles;
+
+    unsigned int getCapacity(unsigned int block);
+    bool isInside(unsigned int channel, unsigned int component);
+
+    /* Channels of a component that form a cycle through blocks without capacity, empty
+        when there is none */
+    vector <unsigned int> findEmptyCycle(unsigned int component);
+    // Howard's algorithm on a component where every cycle has some capacity
+    vector <unsigned int> findMaxRatioCycle(unsigned int component);
+
+};
+
+
+}
+
+
+#endif // THROUGHPUTANALYSIS_H
@@ -0,0 +1,238 @@
+#include "TimingAnalysis.h"
+#include <algorithm>
+#include <limits>
+
+
+namespace DFGraphComp
+{
+
+
+/*
+ * =================================
+ *  Class TimingAnalysis
+ * =================================
+*/
+
+
+TimingAnalysis::TimingAnalysis(FunctionGraph& graph) 
+    : TimingAnalysis(vector <FunctionGraph*>(1, &graph)) {}
+
+TimingAnalysis::TimingAnalysis(const vector <FunctionGraph*>& graphs)
+    : channelGraph(graphs), blocks(channelGraph.getBlocks()), 
+    channels(channelGraph.getChannels()), inChannels(channelGraph.getInChannels()), 
+    outChannels(channelGraph.getOutChannels()), sequential(channelGraph.getSequential())
+{
+    clockPeriod = 0;
+    cyclePeriod = 0;
+    combinationalCycle = false;
+}
+
+TimingAnalysis::~TimingAnalysis() {}
+
+void TimingAnalysis::analyze(double clockPeriod) {
+    this->clockPeriod = clockPeriod;
+    vector <unsigned int> order;
+    combinationalCycle = !propagateArrivals(order);
+    criticalPath.clear();
+    slacks.clear();
+    if (combinationalCycle) {
+        cyclePeriod = numeric_limits<double>::infinity();
+        return;
+    }
+    findCriticalPath();
+    propagateRequired(order);
+}
+
+double TimingAnalysis::getCyclePeriod() {
+    return cyclePeriod;
+}
+
+bool TimingAnalysis::hasCombinationalCycle() {
+    return combinationalCycle;
+}
+
+const vector <pair <Block*, double> >& TimingAnalysis::getCriticalPath() {
+    return criticalPath;
+}
+
+unsigned int TimingAnalysis::getNumChannels() {
+    return channels.size();
+}
+
+pair <Block*, unsigned int> TimingAnalysis::getChannelSource(unsigned int index) {
+    assert(index < channels.size() && "Wrong channel");
+    return make_pair(blocks[channels[index].from], channels[index].fromPort);
+}
+
+pair <Block*, int> TimingAnalysis::getChannelDestination(unsigned int index) {
+    assert(index < channels.size() && "Wrong channel");
+    return make_pair(blocks[channels[index].to], channels[index].toPort);
+}
+
+double TimingAnalysis::getArrival(unsigned int index) {
+    assert(index < channels.size() && "Wrong channel");
+    assert(!combinationalCycle && "No arrival times with a combinational cycle");
+    return departures[channels[index].from][channels[index].fromPort];
+}
+
+double TimingAnalysis::getSlack(unsigned int index) {
+    assert(index < slacks.size() && "Wrong channel or combinational cycle");
+    return slacks[index];
+}
+
+double TimingAnalysis::getInputArrival(unsigned int block) {
+    double arrival = 0;
+    criticalInputs[block] = -1;
+    for (unsigned int channel : inChannels[block]) {
+        const Channel& c = channels[channel];
+        double time = departures[c.from][c.fromPort] +
+            blocks[block]->getInputPort(c.toPort).getDelay();
+        if (criticalInputs[block] < 0 or time > arrival) {
+            arrival = time;
+            criticalInputs[block] = channel;
+        }
+    }
+    return arrival;
+}
+
+bool TimingAnalysis::propagateArrivals(vector <unsigned int>& order) {
+    unsigned int numBlocks = blocks.size();
+    vector <unsigned int> numPreds(numBlocks, 0);
+    for (unsigned int i = 0; i < channels.size(); ++i) {
+        if (!sequential[channels[i].from]) ++numPreds[channels[i].to];
+    }
+    // The registers start the paths, so their outputs are known from the beginning
+    departures.assign(numBlocks, vector <double>());
+    criticalInputs.assign(numBlocks, -1);
+    for (unsigned int i = 0; i < numBlocks; ++i) {
+        for (unsigned int j = 0; j < blocks[i]->getNumOutputPorts(); ++j) {
+            departures[i].push_back(blocks[i]->getOutputPort(j).getDelay());
+        }
+        if (numPreds[i] == 0) order.push_back(i);
+    }
+    for (unsigned int i = 0; i < order.size(); ++i) {
+        unsigned int block = order[i];
+        if (sequential[block]) continue;
+        double inside = getInputArrival(block) + blocks[block]->getBlockDelay();
+        for (unsigned int j = 0; j < departures[block].size(); ++j) {
+            departures[block][j] += inside;
+        }
+        for (unsigned int channel : outChannels[block]) {
+            unsigned int to = channels[channel].to;
+            if (--numPreds[to] == 0) order.push_back(to);
+        }
+    }
+    return order.size() == numBlocks;
+}
+
+void TimingAnalysis::findCriticalPath() {
+    cyclePeriod = 0;
+    int endBlock = -1;
+    // Whether the path comes from the inputs of the last block or is only inside it
+    bool throughInputs = false;
+    for (unsigned int i = 0; i < blocks.size(); ++i) {
+        Block* block = blocks[i];
+        double inputArrival = getInputArrival(i);
+        vector <pair <double, bool> > ends;
+        if (sequential[i]) {
+            ends.push_back(make_pair(inputArrival, true));
+            ends.push_back(make_pair(block->getBlockDelay(), false));
+        }
+        else if (block->getNumOutputPorts() == 0) {
+            ends.push_back(make_pair(inputArrival + block->getBlockDelay(), true));
+        }
+        vector <bool> connected(block->getNumOutputPorts(), false);
+        for (unsigned int channel : outChannels[i]) connected[channels[channel].fromPort] = true;
+        for (unsigned int j = 0; j < connected.size(); ++j) {
+            if (!connected[j]) ends.push_back(make_pair(departures[i][j], !sequential[i]));
+        }
+        for (unsigned int j = 0; j < ends.size(); ++j) {
+            if (endBlock >= 0 and ends[j].first <= cyclePeriod) continue;
+            cyclePeriod = ends[j].first;
+            endBlock = i;
+            throughInputs = ends[j].second;
+        }
+    }
+    if (endBlock < 0) return;
+    criticalPath.push_back(make_pair(blocks[endBlock], cyclePeriod));
+    unsigned int block = endBlock;
+    while (throughInputs and criticalInputs[block] >= 0) {
+        const Channel& channel = channels[criticalInputs[block]];
+        block = channel.from;
+        criticalPath.push_back(make_pair(blocks[block], departures[block][channel.fromPort]));
+        if (sequential[block]) break;
+    }
+    reverse(criticalPath.begin(), criticalPath.end());
+}
+
+void TimingAnalysis::propagateRequired(const vector <unsigned int>& order) {
+    double period = (clockPeriod > 0 ? clockPeriod : cyclePeriod);
+    const double unknown = numeric_limits<double>::infinity();
+    // Latest time the data can be inside each combinational block
+    vector <double> required(blocks.size(), period);
+    auto channelRequired = [&](unsigned int channel) {
+        const Channel& c = channels[channel];
+        double inDelay = blocks[c.to]->getInputPort(c.toPort).getDelay();
+        return (sequential[c.to] ? period : required[c.to]) - inDelay;
+    };
+    for (unsigned int i = order.size(); i-- > 0; ) {
+        unsigned int block = order[i];
+        if (sequential[block]) continue;
+        Block* b = blocks[block];
+        vector <double> outRequired(b->getNumOutputPorts(), unknown);
+        for (unsigned int channel : outChannels[block]) {
+            double& time = outRequired[channels[channel].fromPort];
+            time = min(time, channelRequired(channel));
+        }
+        double inside = period;
+        for (unsigned int j = 0; j < outRequired.size(); ++j) {
+            // An output port not connected ends the path
+            if (outRequired[j] == unknown) outRequired[j] = period;
+            inside = min(inside, outRequired[j] - b->getOutputPort(j).getDelay());
+        }
+        required[block] = inside - b->getBlockDelay();
+    }
+    slacks.resize(channels.size());
+    for (unsigned int i = 0; i < channels.size(); ++i) {
+        slacks[i] = channelRequired(i) - getArrival(i);
+    }
+}
+
+void TimingAnalysis::printReport(ostream& out, bool printChannels) {
+    out << channelGraph.getFunctionNames() << ": ";
+    if (combinationalCycle) {
+        out << "combinational cycle, no cycle period" << endl;
+        return;
+    }
+    out << "cycle period " << cyclePeriod;
+    if (cyclePeriod > 0) out << " (" << 1000 / cyclePeriod << " MHz with delays in ns)";
+    out << endl;
+    if (!criticalPath.empty()) {
+        out << "  Critical path:" << endl;
+        for (unsigned int i = 0; i < criticalPath.size(); ++i) {
+            out << "    " << criticalPath[i].first->getBlockName() << " " <<
+                criticalPath[i].second << endl;
+        }
+    }
+    if (!printChannels) return;
+    vector <unsigned int> sorted;
+    for (unsigned int i = 0; i < channels.size(); ++i) sorted.push_back(i);
+    stable_sort(sorted.begin(), sorted.end(), [this](unsigned int a, unsigned int b) {
+        return slacks[a] < slacks[b];
+    });
+    out << "  Channels (arrival, slack";
+    if (clockPeriod > 0) out << " for a period of " << clockPeriod;
+    out << "):" << endl;
+    for (unsigned int i = 0; i < sorted.size(); ++i) {
+        const Channel& channel = channels[sorted[i]];
+        Block* from = blocks[channel.from];
+        Block* to = blocks[channel.to];
+        out << "    " << from->getBlockName() << ":" <<
+            from->getOutputPort(channel.fromPort).getName() << " -> " << to->getBlockName() <<
+            ":" << to->getInputPort(channel.toPort).getName() << " " << getArrival(sorted[i]) <<
+            " " << slacks[sorted[i]] << endl;
+    }
+}
+
+
+}
@@ -0,0 +1,95 @@
+#ifndef TIMINGANALYSIS_H
+#define TIMINGANALYSIS_H
+
+#include <vector>
+#include <ostream>
+#include "ChannelGraph.h"
+
+using namespace std;
+
+namespace DFGraphComp
+{
+
+
+/* Static timing analysis of a function graph, from the delays of its blocks and ports.
+
+    A combinational path adds the delay of each input port it enters, of the block and of
+    the output port it leaves, the channels themselves have no delay. The paths start and
+    end at the registers: an opaque buffer starts a path at its output, and an operator
+    with latency, as it is pipelined, ends the paths at its inputs and starts them at its
+    outputs, with a path of its own delay inside each stage. The II does not change the
+    paths, only how often the operator takes new data. Output ports not connected and
+    blocks without outputs also end a path.
+
+    The cycle period of the function is the longest path. The slack of a channel is how
+    much later its data could arrive without making the period longer than the one given,
+    or than the cycle period when none is given. A function with a combinational cycle
+    has no period, it is infinite and no slack is computed.
+
+    The graphs of the functions linked by their calls are analysed together, so the paths
+    that go through a call are followed into the called function */
+class TimingAnalysis {
+
+public:
+
+    TimingAnalysis(FunctionGraph& graph);
+    TimingAnalysis(const vector <FunctionGraph*>& graphs);
+    ~TimingAnalysis();
+
+    // A clock period of 0 computes the slack against the cycle period of the function
+    void analyze(double clockPeriod = 0);
+
+    double getCyclePeriod();
+    bool hasCombinationalCycle();
+
+    /* Blocks of the longest path in order, from the block where it starts, each with the
+        time the path leaves it, or reaches the end in the last one */
+    const vector <pair <Block*, double> >& getCriticalPath();
+
+    unsigned int getNumChannels();
+    // The output port of the source and the input port of the destination of a channel
+    pair <Block*, unsigned int> getChannelSource(unsigned int index);
+    pair <Block*, int> getChannelDestination(unsigned int index);
+    // Time the data of the channel leaves its source, from the start of the cycle
+    double getArrival(unsigned int index);
+    double getSlack(unsigned int index);
+
+    /* Period and critical path of the function, and with printChannels every channel
+        from the lowest slack */
+    void printReport(ostream& out, bool printChannels);
+
+private:
+
+    typedef ChannelGraph::Channel Channel;
+
+    ChannelGraph channelGraph;
+    const vector <Block*>& blocks;
+    const vector <Channel>& channels;
+    const vector <vector <unsigned int> >& inChannels;
+    const vector <vector <unsigned int> >& outChannels;
+    const vector <bool>& sequential;
+
+    double clockPeriod;
+    double cyclePeriod;
+    bool combinationalCycle;
+    // Time each output port is left, and the channel of the latest input of each block
+    vector <vector <double> > departures;
+    vector <int> criticalInputs;
+    vector <double> slacks;
+    vector <pair <Block*, double> > criticalPath;
+
+    // Latest time the data of all the inputs of a block is inside it
+    double getInputArrival(unsigned int block);
+
+    // Visits the blocks in order of their paths, false if some of them form a cycle
+    bool propagateArrivals(vector <unsigned int>& order);
+    void findCriticalPath();
+    void propagateRequired(const vector <unsigned int>& order);
+
+};
+
+
+}
+
+
+#endif // TIMINGANALYSIS_H
@@ -0,0 +1,139 @@
+#include "WidthMinimization.h"
+
+
+namespace DFGraphComp
+{
+
+
+/*
+ * =================================
+ *  Class WidthMinimization
+ * =================================
+*/
+
+
+WidthMinimization::WidthMinimization(FunctionGraph& graph)
+    : channelGraph(graph), blocks(channelGraph.getBlocks()),
+    channels(channelGraph.getChannels()), inChannels(channelGraph.getInChannels()),
+    outChannels(channelGraph.getOutChannels()), numPorts(0), numBits(0) {}
+
+WidthMinimization::~WidthMinimization() {}
+
+void WidthMinimization::minimizeWidths() {
+    // Every block that moves values starts empty, and only grows with what enters it
+    widths.assign(blocks.size(), -1);
+    vector <unsigned int> pending;
+    vector <bool> isPending(blocks.size(), false);
+    for (unsigned int i = 0; i < blocks.size(); ++i) {
+        if (!movesValues(blocks[i]) or blocks[i]->getNumOutputPorts() == 0) continue;
+        if (blocks[i]->getOutputPort(0).getWidth() <= 0) continue;
+        widths[i] = 0;
+        pending.push_back(i);
+        isPending[i] = true;
+    }
+    while (!pending.empty()) {
+        unsigned int block = pending.back();
+        pending.pop_back();
+        isPending[block] = false;
+        int width = findWidth(block);
+        if (width <= widths[block]) continue;
+        widths[block] = width;
+        for (unsigned int channel : outChannels[block]) {
+            unsigned int to = channels[channel].to;
+            if (widths[to] < 0 or isPending[to]) continue;
+            pending.push_back(to);
+            isPending[to] = true;
+        }
+    }
+
+    for (unsigned int i = 0; i < blocks.size(); ++i) {
+        if (widths[i] < 0) continue;
+        for (unsigned int j = 0; j < blocks[i]->getNumOutputPorts(); ++j) {
+            narrowPort(blocks[i], j, false, widths[i]);
+        }
+    }
+    for (unsigned int i = 0; i < channels.size(); ++i) {
+        Block* to = blocks[channels[i].to];
+        if (to->getBlockType() != BlockType::Operator_Block and !movesValues(to)) continue;
+        if (channels[i].toPort < 0) continue;
+        narrowPort(to, channels[i].toPort, true, getChannelWidth(i));
+    }
+}
+
+unsigned int WidthMinimization::getNumPortsNarrowed() {
+    return numPorts;
+}
+
+unsigned int WidthMinimization::getNumBitsRemoved() {
+    return numBits;
+}
+
+bool WidthMinimization::movesValues(Block* block) {
+    switch (block->getBlockType())
+    {
+        case BlockType::Fork_Block:
+        case BlockType::Merge_Block:
+        case BlockType::Branch_Block:
+        case BlockType::Select_Block:
+        case BlockType::Demux_Block:
+        case BlockType::Buffer_Block:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool WidthMinimization::isDataInput(Block* block, unsigned int port) {
+    switch (block->getBlockType())
+    {
+        case BlockType::Branch_Block:
+        case BlockType::Demux_Block:
+            return port == 0;
+        case BlockType::Select_Block:
+            return port < 2;
+        default:
+            return true;
+    }
+}
+
+int WidthMinimization::getChannelWidth(unsigned int channel) {
+    const Channel& c = channels[channel];
+    if (widths[c.from] >= 0) return widths[c.from];
+    return blocks[c.from]->getOutputPort(c.fromPort).getWidth();
+}
+
+int WidthMinimization::findWidth(unsigned int block) {
+    Block* b = blocks[block];
+    int original = b->getOutputPort(0).getWidth();
+    vector <int> inWidths(b->getNumInputPorts(), -1);
+    // The values that come from other functions keep the width of the port
+    for (unsigned int i = 0; i < inWidths.size(); ++i) {
+        inWidths[i] = b->getInputPort(i).getWidth();
+    }
+    for (unsigned int channel : inChannels[block]) {
+        if (channels[channel].toPort >= 0) {
+            inWidths[channels[channel].toPort] = getChannelWidth(channel);
+        }
+    }
+    int width = 0;
+    for (unsigned int i = 0; i < inWidths.size(); ++i) {
+        if (!isDataInput(b, i)) continue;
+        // A value of unknown width, or wider than the block, is not narrowed
+        if (inWidths[i] < 0 or inWidths[i] > original) return original;
+        width = max(width, inWidths[i]);
+    }
+    return width;
+}
+
+void WidthMinimization::narrowPort(Block* block, unsigned int port, bool input, int width) {
+    Port newPort = (input ? block->getInputPort(port) : block->getOutputPort(port));
+    if (newPort.getWidth() <= 0 or width <= 0 or width >= newPort.getWidth()) return;
+    numBits += newPort.getWidth() - width;
+    ++numPorts;
+    newPort.setWidth(width);
+    if (input) block->setInputPort(port, newPort);
+    else block->setOutputPort(port, newPort);
+}
+
+
+}
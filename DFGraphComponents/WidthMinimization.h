@@ -0,0 +1,69 @@
+#ifndef WIDTHMINIMIZATION_H
+#define WIDTHMINIMIZATION_H
+
+#include <vector>
+#include "ChannelGraph.h"
+
+using namespace std;
+
+namespace DFGraphComp
+{
+
+
+/* Narrows the data ports of a function graph to the widths its values need, starting
+    from the widths of the blocks that create the values (operators and constants, that
+    the builder already narrows from the ranges of the IR) and propagating them through
+    the blocks that only move the values: forks, merges, branches, selects, demuxes and
+    buffers. Each of those carries the widest of its data inputs, found as the least fixed
+    point over the graph, so a merge of a loop is only as wide as the values that enter it.
+    Then every input port of those blocks and of the operators takes the width of the
+    channel that feeds it.
+
+    A narrowed value is never negative and keeps a 0 as its top bit, so a block can extend
+    it again with zeros or with its sign and get the same value. The control ports, of
+    width 0, and the ports of unknown width are not changed, and neither are the ports
+    connected to other functions */
+class WidthMinimization {
+
+public:
+
+    WidthMinimization(FunctionGraph& graph);
+    ~WidthMinimization();
+
+    void minimizeWidths();
+
+    unsigned int getNumPortsNarrowed();
+    // Sum of the bits removed from all the ports narrowed
+    unsigned int getNumBitsRemoved();
+
+private:
+
+    typedef ChannelGraph::Channel Channel;
+
+    ChannelGraph channelGraph;
+    const vector <Block*>& blocks;
+    const vector <Channel>& channels;
+    const vector <vector <unsigned int> >& inChannels;
+    const vector <vector <unsigned int> >& outChannels;
+    /* Width carried by each block that moves values, -1 for the other blocks and for the
+        ones that move control */
+    vector <int> widths;
+
+    unsigned int numPorts;
+    unsigned int numBits;
+
+    static bool movesValues(Block* block);
+    // The conditions of the branches and selects and the controls of the demuxes are not
+    static bool isDataInput(Block* block, unsigned int port);
+    // Width of the value that goes through a channel
+    int getChannelWidth(unsigned int channel);
+    int findWidth(unsigned int block);
+    void narrowPort(Block* block, unsigned int port, bool input, int width);
+
+};
+
+
+}
+
+
+#endif // WIDTHMINIMIZATION_H
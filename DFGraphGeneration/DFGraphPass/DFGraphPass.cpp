@@ -3,6 +3,102 @@
 
 char DFGraphPass::ID = 0;
 
+static cl::opt <unsigned int> numThreads("dfgraph-threads", 
+    cl::desc("Threads used to build the graphs of the functions (0 to use all the cores)"),
+    cl::init(0));
+
+enum GraphFormat {
+    DotFormat,
+    BinaryFormat,
+    AllFormats
+};
+
+static cl::opt <GraphFormat> graphFormat("dfgraph-format", 
+    cl::desc("Format of the file with the graph"),
+    cl::values(clEnumValN(DotFormat, "dot", "DOT file (.dot)"),
+        clEnumValN(BinaryFormat, "binary", "Binary file to be mapped in memory (.dfg)"),
+        clEnumValN(AllFormats, "all", "Both files")),
+    cl::init(DotFormat));
+
+static cl::opt <string> operatorLibrary("dfgraph-operator-library",
+    cl::desc("File with the latency, II and delay of each operation for the target, "
+        "replacing the built-in table of a generic FPGA (see OperatorLibrary.cpp)"),
+    cl::value_desc("filename"), cl::init(""));
+
+static cl::opt <bool> orderMemory("dfgraph-memory-order",
+    cl::desc("Order with 0-width channels the loads and stores of each BB that may access "
+        "the same address, found with alias analysis and MemorySSA"),
+    cl::init(true));
+
+static cl::opt <bool> queueMemory("dfgraph-lsq",
+    cl::desc("Send through a load-store queue the loads and stores that conflict with "
+        "accesses of other BB or of other iterations (with -dfgraph-memory-order)"),
+    cl::init(true));
+
+static cl::opt <unsigned int> queueDepth("dfgraph-lsq-depth",
+    cl::desc("Accesses that the load-store queue of each function can hold"),
+    cl::init(16));
+
+enum CallLinking {
+    SharedCalls,
+    CopiedCalls,
+    AutoCalls
+};
+
+static cl::opt <CallLinking> callLinking("dfgraph-calls",
+    cl::desc("How the functions called more than once are linked with their call sites"),
+    cl::values(clEnumValN(SharedCalls, "shared", "One graph shared through a call wrapper"),
+        clEnumValN(CopiedCalls, "copied", "A copy of the graph for each call site"),
+        clEnumValN(AutoCalls, "auto", "Copied when two call sites can run at the same "
+            "time and the copies fit in -dfgraph-call-copy-blocks")),
+    cl::init(AutoCalls));
+
+static cl::opt <unsigned int> copyBlocks("dfgraph-call-copy-blocks",
+    cl::desc("Blocks that the copies of a function can add with -dfgraph-calls=auto"),
+    cl::init(1000));
+
+static cl::opt <bool> cleanGraph("dfgraph-cleanup",
+    cl::desc("Remove the blocks whose values are not used and the forks with a single "
+        "output, and connect the outputs left free to sinks"),
+    cl::init(true));
+
+static cl::opt <bool> minimizeWidths("dfgraph-minimize-widths",
+    cl::desc("Narrow the data ports to the widths the values need, from the ranges of "
+        "LazyValueInfo and ScalarEvolution propagated through the graph"),
+    cl::init(true));
+
+static cl::opt <bool> constantSources("dfgraph-constant-sources",
+    cl::desc("Create as sources, without a control input, the constants of the operators "
+        "that also wait for a value that is not constant"),
+    cl::init(true));
+
+static cl::opt <unsigned int> loopTags("dfgraph-loop-tags",
+    cl::desc("Tags of the loops inside other loops pipelined with a tagger and an untagger, "
+        "so the executions of the inner loop overlap (0 to not pipeline them)"),
+    cl::init(0));
+
+static cl::opt <bool> insertBuffers("dfgraph-buffers",
+    cl::desc("Insert buffers to break the combinational cycles and balance the paths"),
+    cl::init(true));
+
+static cl::opt <double> clockPeriod("dfgraph-clock-period",
+    cl::desc("Insert buffers where a combinational path is longer than this period, in "
+        "the units of the delays of the blocks (0 to not look at the delays)"),
+    cl::init(0));
+
+static cl::opt <bool> printTiming("dfgraph-timing",
+    cl::desc("Print the cycle period and the critical path of each function"),
+    cl::init(false));
+
+static cl::opt <bool> printTimingChannels("dfgraph-timing-channels",
+    cl::desc("Print also the arrival time and slack of each channel"),
+    cl::init(false));
+
+static cl::opt <bool> printThroughput("dfgraph-throughput",
+    cl::desc("Print the critical cycle of each strongly connected component, with the "
+        "loop of the IR it comes from"),
+    cl::init(false));
+
 DFGraphPass::DFGraphPass() : ModulePass(ID), DL("") {}
 
 DFGraphPass::~DFGraphPass() {}
@@ -10,580 +106,451 @@ DFGraphPass::~DFGraphPass() {}
 void DFGraphPass::getAnalysisUsage(AnalysisUsage &AU) const {
     /* Pass that will be needed to execute before this one */
     AU.addRequired<LiveVarsPass>();
+    AU.addRequired<AAResultsWrapperPass>();
+    AU.addRequired<MemorySSAWrapperPass>();
+    AU.addRequired<LazyValueInfoWrapperPass>();
+    AU.addRequired<ScalarEvolutionWrapperPass>();
     AU.setPreservesAll();
 }
 
 
 bool DFGraphPass::runOnModule(Module& M) {
-    string fileName = M.getModuleIdentifier();
-    file.open(fileName.substr(0, fileName.size()-3) + ".dot");
-    DL = DataLayout(&M);
-    for (Module::iterator it = M.begin(); it != M.end(); ++it) {
-        processFunction(*it);
-        clearStructures();
-    }
-    for (Module::iterator it = M.begin(); it != M.end(); ++it) {
-        connectFunctionCall(*it);
-    }
-    printGraph(M);
-    file.close();
+    {
+        // Closed before the report, so the time of the whole pass is in it
+        PassProfiler::Scope scope("DFGraphPass");
+        if (operatorLibrary.empty()) library.readDefault();
+        else if (!library.readFile(operatorLibrary)) {
+            errs() << "Error: " << operatorLibrary << ": " << library.getError() << '\n';
+            return false;
+        }
+        DL = DataLayout(&M);
+        buildGraphs(M);
+        copyCalledFunctions(M);
+        linkFunctionCalls(M);
+        if (cleanGraph) cleanGraphs(M);
+        if (minimizeWidths) narrowWidths(M);
+        if (loopTags > 0) tagLoops(M);
+        characterizeOperators(M);
+        if (insertBuffers) placeBuffers(M);
+        if (PassProfiler::isEnabled()) countBlocks(M);
+        numberBlocks(M);
+        if (printTiming or printTimingChannels) analyzeTiming(M);
+        if (printThroughput) analyzeThroughput(M);
+        builders.clear();
+        memoryDependences.clear();
+        valueRanges.clear();
+        string fileName = M.getModuleIdentifier();
+        fileName = fileName.substr(0, fileName.size()-3);
+        if (graphFormat != BinaryFormat) {
+            file.open(fileName + ".dot");
+            printGraph(M);
+            file.close();
+        }
+        if (graphFormat != DotFormat) {
+            file.open(fileName + ".dfg", ios::binary);
+            writeBinaryGraph(M);
+            file.close();
+        }
+        for (unsigned int i = 0; i < graphs.size(); ++i) graphs[i].freeGraph();
+        graphs.clear();
+        graphFunctions.clear();
+        functionGraphs.clear();
+    }
+    vector <string> functionNames;
     for (Module::iterator it = M.begin(); it != M.end(); ++it) {
-        FunctionGraph& funcGraph = graphs[it->getName()];
-        funcGraph.freeGraph();
+        functionNames.push_back(it->getName().str());
     }
+    PassProfiler::get().report(M.getModuleIdentifier(), functionNames);
     return false;
 }
 
 
-void DFGraphPass::processFunction(Function &F) {
-    BBNumber = 0;
-    if (F.isDeclaration()) {
-        assert(0 && "Function without body cannot be handled");
-    }
-    liveness = &getAnalysis<LiveVarsPass>(F);
-    StringRef funcName = F.getName();
-    if (graphs.find(funcName) == graphs.end()) {
-        graphs[funcName] = FunctionGraph(funcName.str());
-    }
-    graph = &graphs[funcName];
-    bool firstBB = true;
-    for (const BasicBlock& BB : F.getBasicBlockList()) {
-        controlSynch = nullptr;
-        StringRef BBName = BB.getName();
-        if (!graph->existsBB(BBName)) {
-            varsMapping.insert(make_pair(BBName, map <const Value*, Block*>()));
-            varsMerges.insert(make_pair(&BB, map <const Value*, Merge*>()));
-            graph->addBasicBlock(BBName, BBNumber);
-        }
-        else {
-            graph->setCurrentBB(BBName);
-            graph->setBBId(BBNumber);
-        }
-        ++BBNumber;
-        processBBEntryControl(&BB);
-        if (firstBB) {
-            firstBB = false;
-            for (Function::const_arg_iterator arg_it = F.arg_begin(); arg_it != F.arg_end(); 
-                ++arg_it) 
-            {
-                unsigned int argTypeSize = DL.getTypeSizeInBits(arg_it->getType());
-                DFGraphComp::Argument* argBlock = new DFGraphComp::Argument(&BB, argTypeSize);
-                graph->addBlockToBB(argBlock);
-                varsMapping[BBName][arg_it] = argBlock;
-                graph->addArgument(argBlock);
-            }
-        }
-        else {
-            processLiveIn(&BB);
-        }
-        processPhiConstants(&BB);
-        for (BasicBlock::const_iterator inst_it = BB.begin(); inst_it != BB.end(); 
-            ++inst_it) 
-        {
-            if (isa <llvm::BinaryOperator>(inst_it)) {
-                processBinaryInst(*inst_it);
-            }
-            else if (isa<llvm::CmpInst>(inst_it)) {
-                processCmpInst(*inst_it);
-            }
-            // Uncomment if version >= 8
-            // else if (inst_it->getOpcode() == Instruction::FNeg) {
-            //     processFNegInst(*inst_it);
-            // }
-            else if (isa<AllocaInst>(inst_it)) {
-                processAllocaInst(*inst_it);
-            }
-            else if (isa<LoadInst>(inst_it)) {
-                processLoadInst(*inst_it);
-            }
-            else if (isa<StoreInst>(inst_it)) {
-                processStoreInst(*inst_it);
-            }
-            else if (isa<PHINode>(inst_it)) {
-                processPhiInst(*inst_it);
-            }
-            else if (isa<CastInst>(inst_it)) {
-                processCastInst(*inst_it);
-            }
-            else if (isa<GetElementPtrInst>(inst_it) or 
-                isa<SwitchInst>(*inst_it)) 
-            {
-                assert(0 && "Not should appear (lowered with a pass");
-            }
-            else if (isa<SelectInst>(inst_it)) {
-                processSelectInst(*inst_it);
-            }
-            else if (isa<ReturnInst>(inst_it)) {
-                processReturnInst(*inst_it);
-            }
-            else if (isa<BranchInst>(inst_it)) {
-                processBranchInst(*inst_it);
-            }
-            else if (isa<CallInst>(inst_it)) {
-                processCallInst(*inst_it);
-            }
-            else {
-                assert(0 && "Instruction not currently supported");
-            }
-        }
-        processBBExitControl(&BB);
-    }
-    connectMerges();
-    connectControlMerges();
-}
-
-
-
-void DFGraphPass::processBinaryInst(const Instruction &inst) 
-{
-    OpType opType;
-    unsigned int opCode = inst.getOpcode();
-    if (opCode == Instruction::Add) {
-        opType = OpType::Add;
-    }
-    else if (opCode == Instruction::FAdd) {
-        opCode = OpType::FAdd;
-    }
-    else if (opCode == Instruction::Sub) {
-        opType = OpType::Sub;
-    }
-    else if (opCode == Instruction::FSub) {
-        opCode = OpType::FSub;
-    }
-    else if (opCode == Instruction::Mul) {
-        opType = OpType::Mul;
-    }
-    else if (opCode == Instruction::FMul) {
-        opCode = OpType::FMul;
-    }
-    else if (opCode == Instruction::UDiv || opCode == Instruction::SDiv) {
-        opType = OpType::Div;
-    }
-    else if (opCode == Instruction::FDiv) {
-        opCode = OpType::FDiv;
-    }
-    else if (opCode == Instruction::URem || opCode == Instruction::SRem) {
-        opType = OpType::Rem;
-    }
-    else if (opCode == Instruction::FRem) {
-        opType = OpType::FRem;
-    }
-    else if (opCode == Instruction::And) {
-        opType = OpType::And;
-    }
-    else if (opCode == Instruction::Or) {
-        opType = OpType::Or;
-    }
-    else if (opCode == Instruction::Xor) {
-        opType = OpType::Xor;
-    }
-    else if (opCode == Instruction::Shl) {
-        opType = OpType::ShiftL;
-    }
-    else if (opCode == Instruction::LShr or opCode == Instruction::AShr) {
-        opType = OpType::ShiftR;
-    }
-    unsigned int typeSize = DL.getTypeSizeInBits(inst.getType());
-    const BasicBlock* BB = inst.getParent();
-    DFGraphComp::Operator* op = new DFGraphComp::Operator(opType, BB, typeSize);
-    processOperator(inst.getOperand(0), op, 0, BB);
-    processOperator(inst.getOperand(1), op, 1, BB);
-    graph->addBlockToBB(op);
-    varsMapping[BB->getName()][&inst] = op;
+void DFGraphPass::buildGraphs(Module& M) {
+    PassProfiler::Scope scope("buildGraphs");
+    /* The graphs are created beforehand so the deque is not modified while the threads
+        run. The live variables of all the functions are already computed */
+    LiveVarsPass& liveVars = getAnalysis<LiveVarsPass>();
+    for (Module::iterator it = M.begin(); it != M.end(); ++it) {
+        Function& F = *it;
+        if (F.isDeclaration()) {
+            assert(0 && "Function without body cannot be handled");
+        }
+        functionGraphs[&F].push_back(graphs.size());
+        graphs.push_back(FunctionGraph(F.getName().str()));
+        graphFunctions.push_back(&F);
+        MemoryDependences* dependences = nullptr;
+        if (orderMemory) {
+            PassProfiler::Scope dependencesScope("findMemoryDependences", F.getName());
+            /* Each request runs again the analyses of the function, so the results are
+                taken once both passes are there */
+            AAResultsWrapperPass& AAPass = getAnalysis<AAResultsWrapperPass>(F);
+            MemorySSAWrapperPass& MSSAPass = getAnalysis<MemorySSAWrapperPass>(F);
+            AAResults& AA = AAPass.getAAResults();
+            MemorySSA& MSSA = MSSAPass.getMSSA();
+            dependences = new MemoryDependences(F, AA, MSSA, queueMemory);
+            PassProfiler& profiler = PassProfiler::get();
+            profiler.addCount("memory order channels", dependences->getNumOrdered());
+            profiler.addCount("memory conflicts not ordered", dependences->getNumUnordered());
+            profiler.addCount("memory accesses queued", dependences->getNumQueued());
+            if (dependences->getNumQueued() > 0) profiler.addCount("load-store queues", 1);
+        }
+        memoryDependences.push_back(unique_ptr <MemoryDependences>(dependences));
+        ValueRanges* ranges = nullptr;
+        if (minimizeWidths) {
+            PassProfiler::Scope rangesScope("findValueRanges", F.getName());
+            /* The memory dependences are complete, so their analyses can run again. As
+                for them, the results are taken once both passes are there */
+            LazyValueInfoWrapperPass& LVIPass = getAnalysis<LazyValueInfoWrapperPass>(F);
+            ScalarEvolutionWrapperPass& SEPass = getAnalysis<ScalarEvolutionWrapperPass>(F);
+            ranges = new ValueRanges(F, LVIPass.getLVI(), SEPass.getSE());
+            PassProfiler::get().addCount("values narrowed", ranges->getNumNarrowed());
+        }
+        valueRanges.push_back(unique_ptr <ValueRanges>(ranges));
+        builders.push_back(unique_ptr <FunctionGraphBuilder>(new FunctionGraphBuilder(F, 
+            &graphs.back(), DL, liveVars.getLiveVars(F), dependences, queueDepth, ranges,
+            constantSources)));
+    }
+    ThreadPool pool(hardware_concurrency(PassProfiler::getNumThreads(numThreads)));
+    for (unsigned int i = 0; i < builders.size(); ++i) {
+        FunctionGraphBuilder* builder = builders[i].get();
+        pool.async([builder] { builder->buildGraph(); });
+    }
+    pool.wait();
 }
 
 
-
-void DFGraphPass::processCmpInst(const Instruction &inst) {
-    OpType opType;
-    unsigned int opCode = inst.getOpcode();
-    if (opCode == Instruction::ICmp) {
-        const ICmpInst* cmp = cast<ICmpInst> (&inst);
-        ICmpInst::Predicate pred = cmp->getPredicate();
-        if (pred == ICmpInst::ICMP_EQ) {
-            opType = OpType::Eq;
-        }
-        else if (pred == ICmpInst::ICMP_NE) {
-            opType = OpType::NE;
-        }
-        else if (pred == ICmpInst::ICMP_SGT || pred == ICmpInst::ICMP_UGT) {
-            opType = OpType::GT;
+void changeConnection(pair <Block*, int> origin, pair <Block*, int> newEnd) {
+    Block* originBlock = origin.first;
+    if (originBlock->getBlockType() != BlockType::Fork_Block) {
+        if (originBlock->getBlockType() == BlockType::Branch_Block) {
+            Branch* originBranch = (Branch*)originBlock;
+            if (origin.second == 0) originBranch->setCurrentPort(false);
+            else originBranch->setCurrentPort(true);
         }
-        else if (pred == ICmpInst::ICMP_SGE || pred == ICmpInst::ICMP_UGE) {
-            opType = OpType::GE;
+        else if (originBlock->getBlockType() == BlockType::Demux_Block) {
+            Demux* originDemux = (Demux*)originBlock;
+            originDemux->setCurrentConnectedPort(origin.second);
         }
-        else if (pred == ICmpInst::ICMP_SLT || pred == ICmpInst::ICMP_ULT) {
-            opType = OpType::LT;
+        pair <Block*, int> connection = originBlock->getConnectedPort();
+        if (connection.first->getBlockType() == BlockType::Fork_Block) {
+            Fork* originFork = (Fork*)connection.first;
+            originFork->setOutPort(0, newEnd);
         }
-        else if (pred == ICmpInst::ICMP_SLE || pred == ICmpInst::ICMP_ULE) {
-            opType = OpType::LE;
+        else {
+            originBlock->setConnectedPort(newEnd);
         }
     }
     else {
-        const FCmpInst* cmp = cast<FCmpInst> (&inst);
-        FCmpInst::Predicate predicate = cmp->getPredicate();
-        if (predicate == FCmpInst::FCMP_OEQ || predicate == FCmpInst::FCMP_UEQ) {
-            opType = OpType::FEq;
-        }
-        else if (predicate == FCmpInst::FCMP_ONE || predicate == FCmpInst::FCMP_UNE) {
-            opType = OpType::FNE;
-        }
-        else if (predicate == FCmpInst::FCMP_OGT || predicate == FCmpInst::FCMP_UGT) {
-            opType = OpType::FGT;
-        }
-        else if (predicate == FCmpInst::FCMP_OGE || predicate == FCmpInst::FCMP_UGE) {
-            opType = OpType::FGE;
-        }
-        else if (predicate == FCmpInst::FCMP_OLT || predicate == FCmpInst::FCMP_ULT) {
-            opType = OpType::FLT;
-        }
-        else if (predicate == FCmpInst::FCMP_OLE || predicate == FCmpInst::FCMP_ULE) {
-            opType = OpType::FLE;
-        }
-        else if (predicate == FCmpInst::FCMP_TRUE) {
-            opType = OpType::True;
-        }
-        else if (predicate == FCmpInst::FCMP_FALSE) {
-            opType = OpType::False;
-        }
-    } 
-    const BasicBlock* BB = inst.getParent();
-    DFGraphComp::Operator* op = new DFGraphComp::Operator(opType, BB, 
-        DL.getTypeSizeInBits(inst.getOperand(0)->getType()));
-    op->setDataOutPortWidth(DL.getTypeSizeInBits(inst.getType()));
-    processOperator(inst.getOperand(0), op, 0, BB);
-    processOperator(inst.getOperand(1), op, 1, BB);
-    graph->addBlockToBB(op);
-    varsMapping[BB->getName()][&inst] = op;
-}
-
-
-
-void DFGraphPass::processFNegInst(const Instruction &inst) {
-   const BasicBlock* BB = inst.getParent(); 
-   unsigned int typeSize = DL.getTypeSizeInBits(inst.getType());
-   DFGraphComp::Operator* op = new DFGraphComp::Operator(OpType::FNeg, BB, typeSize);
-   processOperator(inst.getOperand(0), op, 0, BB);
-   graph->addBlockToBB(op);
-   varsMapping[BB->getName()][&inst] = op;
-}
-
-
-
-void DFGraphPass::processPhiInst(const Instruction &inst) {
-    const BasicBlock* BB = inst.getParent();
-    const PHINode* phi = cast<PHINode>(&inst);
-    if (varsMerges[BB].find(phi) == varsMerges[BB].end()) {
-        unsigned int typeSize = DL.getTypeSizeInBits(phi->getType());
-        Merge* merge = new Merge(BB, typeSize);
-        varsMerges[BB][&inst] = merge;
-        varsMapping[BB->getName()][&inst] = merge;
-        graph->addBlockToBB(merge);
+        Fork* originFork = (Fork*)originBlock;
+        originFork->setOutPort(origin.second, newEnd);
     }
+    
 }
 
 
 
-void DFGraphPass::processAllocaInst(const Instruction &inst) {
-    const BasicBlock* BB = inst.getParent();
-    const AllocaInst* allocaInst = cast<AllocaInst>(&inst);
-    unsigned int allocBytes = DL.getTypeAllocSize(allocaInst->getAllocatedType());
-    if (allocaInst->isArrayAllocation()) {
-        const ConstantInt* cstSize = cast<ConstantInt>(allocaInst->getArraySize());
-        unsigned int nElems = cstSize->getZExtValue();
-        allocBytes *= nElems;
+// Whether the result of an instruction gets to another one through the values that use it
+static bool reachesThroughUses(const Instruction* from, const Instruction* to) {
+    SmallPtrSet <const Instruction*, 32> visited;
+    vector <const Instruction*> pending(1, from);
+    while (!pending.empty()) {
+        const Instruction* inst = pending.back();
+        pending.pop_back();
+        for (const User* user : inst->users()) {
+            const Instruction* userInst = dyn_cast<Instruction>(user);
+            if (userInst == nullptr or !visited.insert(userInst).second) continue;
+            if (userInst == to) return true;
+            pending.push_back(userInst);
+        }
     }
-    DFGraphComp::Constant<unsigned int>* allocBytesCst = 
-        new DFGraphComp::Constant<unsigned int>(allocBytes, BB);
-    connectOrphanCst(allocBytesCst);
-    DFGraphComp::Operator* allocaBlock = new DFGraphComp::Operator(OpType::Alloca, BB);
-    allocaBlock->setDataInPortWidth(0, sizeof(unsigned int));
-    unsigned int ptrSize = DL.getTypeAllocSizeInBits(allocaInst->getType());
-    allocaBlock->setDataOutPortWidth(ptrSize);
-    allocBytesCst->setConnectedPort(allocaBlock, 0);
-    graph->addBlockToBB(allocBytesCst);
-    graph->addBlockToBB(allocaBlock);
-    varsMapping[BB->getName()][&inst] = allocaBlock;
-}
-
-
-
-void DFGraphPass::processLoadInst(const Instruction &inst) 
-{
-    const BasicBlock* BB = inst.getParent();
-    const LoadInst* loadInst = cast<LoadInst>(&inst);
-    unsigned int pointerSize = DL.getTypeSizeInBits(loadInst->getPointerOperandType());
-    unsigned int valueSize = DL.getTypeSizeInBits(loadInst->getType());
-    DFGraphComp::Operator* loadOp = new DFGraphComp::Operator(OpType::Load, BB);
-    loadOp->setDataInPortWidth(0, pointerSize);
-    loadOp->setDataOutPortWidth(valueSize);
-    processOperator(loadInst->getPointerOperand(), loadOp, 0, BB);
-    varsMapping[BB->getName()][&inst] = loadOp;
-    graph->addBlockToBB(loadOp);
-}
-
-
-
-void DFGraphPass::processStoreInst(const Instruction &inst) 
-{
-    const BasicBlock* BB = inst.getParent();
-    const StoreInst* storeInst = cast<StoreInst>(&inst);
-    unsigned int storedValueSize = DL.getTypeSizeInBits(storeInst->getValueOperand()->getType());
-    unsigned int pointerSize = DL.getTypeSizeInBits(storeInst->getPointerOperandType());
-    DFGraphComp::Operator* store = new DFGraphComp::Operator(OpType::Store, BB);
-    store->setDataInPortWidth(0, storedValueSize);
-    store->setDataInPortWidth(1, pointerSize);
-    processOperator(storeInst->getValueOperand(), store, 0, BB);
-    processOperator(storeInst->getPointerOperand(), store, 1, BB);
-    graph->addBlockToBB(store);
+    return false;
 }
 
 
-
-void DFGraphPass::processCastInst(const Instruction &inst) 
-{
-    const CastInst* castInst = cast<CastInst>(&inst);
-    unsigned int operandSize = DL.getTypeSizeInBits(castInst->getSrcTy());
-    unsigned int castTypeSize = DL.getTypeSizeInBits(castInst->getDestTy());
-    Value* operand = castInst->getOperand(0);
-    OpType castOpType;
-    unsigned int opCode = castInst->getOpcode();
-    if (opCode == Instruction::Trunc) {
-        castOpType = OpType::IntTrunc;
-    }
-    else if (opCode == Instruction::ZExt) {
-        castOpType = OpType::IntZExt;
-    }
-    else if (opCode == Instruction::SExt) {
-        castOpType = OpType::IntSExt;
-    }
-    else if (opCode == Instruction::FPToUI) {
-        castOpType = OpType::FPointToUInt;
-    }
-    else if (opCode == Instruction::FPToSI) {
-        castOpType = OpType::FPointToSInt;
-    }
-    else if (opCode == Instruction::UIToFP) {
-        castOpType = OpType::UIntToFPoint;
-    }
-    else if (opCode == Instruction::SIToFP) {
-        castOpType = OpType::SIntToFPoint;
-    }
-    else if (opCode == Instruction::FPTrunc) {
-        castOpType = OpType::FPointTrunc;
-    }
-    else if (opCode == Instruction::FPExt) {
-        castOpType = OpType::FPointExt;
-    }
-    else if (opCode == Instruction::PtrToInt) {
-        castOpType = OpType::PtrToInt;
-    }
-    else if (opCode == Instruction::IntToPtr) {
-        castOpType = OpType::IntToPtr;
-    }
-    else if (opCode == Instruction::BitCast) {
-        castOpType = OpType::BitCast;
+void DFGraphPass::copyCalledFunctions(Module& M) {
+    PassProfiler::Scope scope("copyCalledFunctions");
+    // Functions called by each one, from the graphs of the module
+    map <const Function*, vector <Function*> > callees;
+    for (unsigned int i = 0; i < builders.size(); ++i) {
+        const vector <pair <const CallInst*, FunctionCall*> >& callSites =
+            builders[i]->getCallSites();
+        for (unsigned int j = 0; j < callSites.size(); ++j) {
+            callees[graphFunctions[i]].push_back(callSites[j].first->getCalledFunction());
+        }
     }
-    else if (opCode == Instruction::AddrSpaceCast) {
-        castOpType = OpType::AddrSpaceCast;
+    /* Reverse postorder of the calls, so a function comes after all its callers unless
+        they call each other */
+    vector <Function*> order;
+    set <const Function*> visited;
+    for (Module::iterator it = M.begin(); it != M.end(); ++it) {
+        if (!visited.insert(&(*it)).second) continue;
+        vector <pair <Function*, unsigned int> > pending(1, make_pair(&(*it), 0));
+        while (!pending.empty()) {
+            Function* F = pending.back().first;
+            unsigned int next = pending.back().second++;
+            const vector <Function*>& FCallees = callees[F];
+            if (next == FCallees.size()) {
+                order.push_back(F);
+                pending.pop_back();
+            }
+            else if (visited.insert(FCallees[next]).second) {
+                pending.push_back(make_pair(FCallees[next], 0));
+            }
+        }
+    }
+    reverse(order.begin(), order.end());
+    // Functions that can end up calling themselves
+    set <const Function*> recursive;
+    for (Function* F : order) {
+        set <const Function*> reached;
+        vector <Function*> pending(callees[F]);
+        while (!pending.empty() and reached.count(F) == 0) {
+            Function* callee = pending.back();
+            pending.pop_back();
+            if (!reached.insert(callee).second) continue;
+            pending.insert(pending.end(), callees[callee].begin(), callees[callee].end());
+        }
+        if (reached.count(F) > 0) recursive.insert(F);
+    }
+
+    LiveVarsPass& liveVars = getAnalysis<LiveVarsPass>();
+    PassProfiler& profiler = PassProfiler::get();
+    for (Function* F : order) {
+        // Call sites in the graphs built so far, that are all the ones of its callers
+        vector <pair <unsigned int, const CallInst*> > sites;
+        for (unsigned int i = 0; i < builders.size(); ++i) {
+            const vector <pair <const CallInst*, FunctionCall*> >& callSites =
+                builders[i]->getCallSites();
+            for (unsigned int j = 0; j < callSites.size(); ++j) {
+                if (callSites[j].first->getCalledFunction() != F) continue;
+                sites.push_back(make_pair(i, callSites[j].first));
+            }
+        }
+        if (sites.size() < 2) continue;
+        // The graph of the module has the index of the function in it
+        unsigned int original = functionGraphs[F][0];
+        bool copied = callLinking == CopiedCalls;
+        if (callLinking == AutoCalls) copied = isCopyWorth(*F, sites);
+        if (recursive.count(F) > 0) copied = false;
+        graphs[original].setCallLinking(copied ? "copied" : "shared");
+        if (!copied) {
+            profiler.addCount("functions shared by their calls", 1);
+            continue;
+        }
+        profiler.addCount("functions copied for their calls", 1);
+        profiler.addCount("function copies", sites.size() - 1);
+        // The first call site keeps the graph of the module
+        unsigned int firstCopy = graphs.size();
+        for (unsigned int i = 1; i < sites.size(); ++i) {
+            string name = F->getName().str() + "_copy" + to_string(i);
+            while (M.getFunction(name) != nullptr) name += "_";
+            functionGraphs[F].push_back(graphs.size());
+            graphs.push_back(FunctionGraph(name));
+            graphs.back().setCopyOf(F->getName().str());
+            graphFunctions.push_back(F);
+            builders.push_back(unique_ptr <FunctionGraphBuilder>(new FunctionGraphBuilder(*F,
+                &graphs.back(), DL, liveVars.getLiveVars(*F), memoryDependences[original].get(),
+                queueDepth, valueRanges[original].get(), constantSources)));
+        }
+        ThreadPool pool(hardware_concurrency(PassProfiler::getNumThreads(numThreads)));
+        for (unsigned int i = firstCopy; i < builders.size(); ++i) {
+            FunctionGraphBuilder* builder = builders[i].get();
+            pool.async([builder] { builder->buildGraph(); });
+        }
+        pool.wait();
     }
-    const BasicBlock* BB = inst.getParent();
-    DFGraphComp::Operator* castOp = new DFGraphComp::Operator(castOpType, BB);
-    castOp->setDataInPortWidth(0, operandSize);
-    castOp->setDataOutPortWidth(castTypeSize);
-    processOperator(operand, castOp, 0, BB);
-    varsMapping[BB->getName()][&inst] = castOp;
-    graph->addBlockToBB(castOp);
 }
 
 
-
-void DFGraphPass::processSelectInst(const Instruction &inst) 
+bool DFGraphPass::isCopyWorth(Function& F,
+    const vector <pair <unsigned int, const CallInst*> >& sites)
 {
-    const BasicBlock* BB = inst.getParent();
-    const SelectInst* selectInst = cast<SelectInst>(&inst);
-    unsigned int typeSize = DL.getTypeSizeInBits(selectInst->getType());
-    Select* selectBlock = new Select(BB, typeSize);
-    processOperator(selectInst->getTrueValue(), selectBlock, 0, BB);
-    processOperator(selectInst->getFalseValue(), selectBlock, 1, BB);
-    processOperator(selectInst->getCondition(), selectBlock, 2, BB);
-    graph->addBlockToBB(selectBlock);
-    varsMapping[BB->getName()][&inst] = selectBlock;
-}
-
-
-
-void DFGraphPass::processReturnInst(const Instruction &inst) 
-{
-    const BasicBlock* BB = inst.getParent();
-    if (inst.getNumOperands() > 0) {
-        Value* operand = inst.getOperand(0);
-        unsigned int typeSize = DL.getTypeSizeInBits(operand->getType());
-        Return* retBlock = new Return(BB, typeSize);
-        processOperator(operand, retBlock, 0, BB);
-        graph->addBlockToBB(retBlock);
-        varsMapping[BB->getName()][&inst] = retBlock;
-        Block* functionReturn = graph->getFunctionResult();
-        if (functionReturn != nullptr) {
-            Merge* mergeRet;
-            if (functionReturn->getBlockType() == BlockType::Exit_Block) {
-                mergeRet = new Merge(nullptr, typeSize);
-                functionReturn->setConnectedPort(mergeRet, mergeRet->addDataInPort());
-                graph->setFunctionResult(mergeRet);
-            }
-            else {
-                mergeRet = (Merge*)functionReturn;
+    size_t numBlocks = graphs[functionGraphs[&F][0]].getCreatedBlocks().size();
+    if (numBlocks*(sites.size() - 1) > copyBlocks) return false;
+    /* Calls that reach each graph, given as linkFunctionCalls does. The callers are
+        decided before, so their copies and calls are already there */
+    vector <vector <pair <unsigned int, const CallInst*> > > callers(graphs.size());
+    map <const Function*, unsigned int> numGiven;
+    for (unsigned int i = 0; i < builders.size(); ++i) {
+        const vector <pair <const CallInst*, FunctionCall*> >& callSites =
+            builders[i]->getCallSites();
+        for (unsigned int j = 0; j < callSites.size(); ++j) {
+            const Function* callee = callSites[j].first->getCalledFunction();
+            const vector <unsigned int>& calleeGraphs = functionGraphs[callee];
+            unsigned int graph = calleeGraphs[0];
+            if (calleeGraphs.size() > 1) graph = calleeGraphs[numGiven[callee]++];
+            callers[graph].push_back(make_pair(i, callSites[j].first));
+        }
+    }
+    /* For each call site, the calls of each graph above it in the call graph that lead
+        to it, starting with the site itself */
+    vector <map <unsigned int, set <const CallInst*> > > ancestors(sites.size());
+    map <const Function*, unique_ptr <LoopInfo> > loops;
+    for (unsigned int i = 0; i < sites.size(); ++i) {
+        map <unsigned int, set <const CallInst*> >& siteAncestors = ancestors[i];
+        siteAncestors[sites[i].first].insert(sites[i].second);
+        vector <unsigned int> pending(1, sites[i].first);
+        while (!pending.empty()) {
+            unsigned int graph = pending.back();
+            pending.pop_back();
+            for (unsigned int j = 0; j < callers[graph].size(); ++j) {
+                unsigned int caller = callers[graph][j].first;
+                if (siteAncestors.count(caller) == 0) pending.push_back(caller);
+                siteAncestors[caller].insert(callers[graph][j].second);
+            }
+        }
+        // The loops of each caller are found once, before comparing the sites
+        for (map <unsigned int, set <const CallInst*> >::const_iterator it =
+            siteAncestors.begin(); it != siteAncestors.end(); ++it)
+        {
+            unique_ptr <LoopInfo>& LI = loops[graphFunctions[it->first]];
+            if (LI) continue;
+            DominatorTree DT(*graphFunctions[it->first]);
+            LI.reset(new LoopInfo(DT));
+        }
+    }
+    // Whether two calls of the same graph can run at the same time
+    auto concurrent = [&](unsigned int graph, const CallInst* first, const CallInst* second) {
+        if (first != second) {
+            bool forward = reachesThroughUses(first, second);
+            bool backward = reachesThroughUses(second, first);
+            if (!forward and !backward) return true;
+            if (forward and backward) return false;
+        }
+        /* One waits for the other, or it is the same call, but the next iteration of a
+            loop with both can start the first one before the second ends */
+        const Loop* loop = loops[graphFunctions[graph]]->getLoopFor(first->getParent());
+        while (loop != nullptr and !loop->contains(second->getParent())) {
+            loop = loop->getParentLoop();
+        }
+        return loop != nullptr;
+    };
+    /* Two sites can run at the same time when the calls that lead to them in some graph
+        above both can, or when no graph is above both, as in different top functions */
+    for (unsigned int i = 0; i < sites.size(); ++i) {
+        for (unsigned int j = i + 1; j < sites.size(); ++j) {
+            bool common = false;
+            for (map <unsigned int, set <const CallInst*> >::const_iterator it =
+                ancestors[i].begin(); it != ancestors[i].end(); ++it)
+            {
+                map <unsigned int, set <const CallInst*> >::const_iterator other =
+                    ancestors[j].find(it->first);
+                if (other == ancestors[j].end()) continue;
+                common = true;
+                for (const CallInst* first : it->second) {
+                    for (const CallInst* second : other->second) {
+                        if (concurrent(it->first, first, second)) return true;
+                    }
+                }
             }
-            retBlock->setConnectedPort(mergeRet, mergeRet->addDataInPort());
-        }
-        else {
-            graph->setFunctionResult(retBlock);
+            if (!common) return true;
         }
     }
+    return false;
 }
 
 
-void changeConnection(pair <Block*, int> origin, pair <Block*, int> newEnd) {
-    Block* originBlock = origin.first;
-    if (originBlock->getBlockType() != BlockType::Fork_Block) {
-        if (originBlock->getBlockType() == BlockType::Branch_Block) {
-            Branch* originBranch = (Branch*)originBlock;
-            if (origin.second == 0) originBranch->setCurrentPort(false);
-            else originBranch->setCurrentPort(true);
-        }
-        else if (originBlock->getBlockType() == BlockType::Demux_Block) {
-            Demux* originDemux = (Demux*)originBlock;
-            originDemux->setCurrentConnectedPort(origin.second);
+void DFGraphPass::linkFunctionCalls(Module& M) {
+    PassProfiler::Scope scope("linkFunctionCalls");
+    /* Calls are given to the called functions in the order of the graphs, each call of a
+        copied function to the next of its graphs */
+    map <const Function*, unsigned int> numLinked;
+    for (unsigned int i = 0; i < builders.size(); ++i) {
+        const vector <pair <const CallInst*, FunctionCall*> >& callSites = 
+            builders[i]->getCallSites();
+        for (unsigned int j = 0; j < callSites.size(); ++j) {
+            const Function* callee = callSites[j].first->getCalledFunction();
+            const vector <unsigned int>& calleeGraphs = functionGraphs[callee];
+            unsigned int graph = calleeGraphs[0];
+            if (calleeGraphs.size() > 1) graph = calleeGraphs[numLinked[callee]++];
+            FunctionGraph& funcGraph = graphs[graph];
+            funcGraph.addFunctionCallBlock(callSites[j].second);
+            funcGraph.increaseTimesCalled();
         }
-        pair <Block*, int> connection = originBlock->getConnectedPort();
-        if (connection.first->getBlockType() == BlockType::Fork_Block) {
-            Fork* originFork = (Fork*)connection.first;
-            originFork->setOutPort(0, newEnd);
-        }
-        else {
-            originBlock->setConnectedPort(newEnd);
+    }
+    for (unsigned int i = 0; i < graphs.size(); ++i) {
+        if (graphs[i].getTimesCalled() > 1) {
+            createCallWrapper(*graphFunctions[i], graphs[i]);
         }
     }
-    else {
-        Fork* originFork = (Fork*)originBlock;
-        originFork->setOutPort(origin.second, newEnd);
+    for (unsigned int i = 0; i < graphs.size(); ++i) {
+        connectCallInputs(graphs[i]);
+    }
+    for (unsigned int i = 0; i < graphs.size(); ++i) {
+        connectCallOutputs(graphs[i]);
     }
-    
 }
 
 
 
-void DFGraphPass::processCallInst(const Instruction& inst) {
-    const BasicBlock* BB = inst.getParent();
-    StringRef BBName = BB->getName();
-    const Value* value;
-    Block* blockVar;
-    const CallInst& callInst = cast<CallInst>(inst);
-    StringRef funcName = callInst.getCalledFunction()->getName();
-    if (graphs.find(funcName) == graphs.end()) {
-        graphs[funcName] = FunctionGraph(funcName.str());
+void DFGraphPass::createCallWrapper(Function& F, FunctionGraph& funcGraph) {
+    unsigned int typeSize;
+    Merge* wrapControlIn = funcGraph.createBlock<Merge>(nullptr, 0);
+    funcGraph.setWrapperControlIn(wrapControlIn);
+    for (unsigned int i = 0; i < funcGraph.getNumArguments(); ++i) {
+        typeSize = DL.getTypeSizeInBits(F.getArg(i)->getType());
+        funcGraph.addWrapperCallArg(funcGraph.createBlock<Merge>(nullptr, typeSize));
+    }
+    Demux* wrapControlOut = funcGraph.createBlock<Demux>(nullptr, 0);
+    funcGraph.setWrapperControlOut(wrapControlOut);
+    Demux* wrapResult = nullptr;
+    if (!F.getReturnType()->isVoidTy()) {
+        typeSize = DL.getTypeAllocSize(F.getReturnType());
+        wrapResult = funcGraph.createBlock<Demux>(nullptr, typeSize);
+        funcGraph.setWrapperResult(wrapResult);
     }
-    FunctionGraph& funcGraph = graphs[funcName];
-    int timesCalled = funcGraph.getTimesCalled();
-    FunctionCall* callBlock = new FunctionCall(BB);
-    funcGraph.addFunctionCallBlock(callBlock);
-    if (timesCalled == 0) {
-        blockVar = controlBlocks[BBName];
-        connectBlocks(blockVar, callBlock, 0);
-        blockVar = controlBlocks[BBName];
-        callBlock->setInputContPort(blockVar, blockVar->getOutputPortIndex());
+}
+
+
+
+void DFGraphPass::connectCallInputs(FunctionGraph& funcGraph) {
+    FunctionCall* callBlock;
+    if (funcGraph.getTimesCalled() == 1) {
+        callBlock = funcGraph.getFunctionCallBlock(0);
+        changeConnection(callBlock->getInputContPort(), 
+            make_pair(funcGraph.getFunctionControlIn(), 0));
         for (unsigned int i = 0; i < funcGraph.getNumArguments(); ++i) {
-            value = callInst.getArgOperand(i);
-            if (isa<llvm::Constant>(value)) {
-                blockVar = createConstant(value, BB);
-                graph->addBlockToBB(blockVar);
-            }
-            else {
-                blockVar = varsMapping[BBName][value];
-            }
-            connectBlocks(blockVar, callBlock, i+1, value);
-            if (!isa<llvm::Constant>(value)) blockVar = varsMapping[BBName][value];
-            callBlock->addInputArgPort(blockVar, blockVar->getOutputPortIndex());
-        }
-        if (!callInst.getType()->isVoidTy()) {
-            varsMapping[BBName][&inst] = callBlock;
+            changeConnection(callBlock->getInputArgPort(i), 
+                make_pair(funcGraph.getArgument(i), 0));
         }
     }
-    else {
-        if (timesCalled == 1) {
-            FunctionCall* prevCallBlock = funcGraph.getFunctionCallBlock(0);
-            Fork* wrapForkControl = new Fork(nullptr, 0);
-            changeConnection(prevCallBlock->getInputContPort(), make_pair(wrapForkControl, 0));
+    else if (funcGraph.getTimesCalled() > 1) {
+        // Each call triggers the wrapper with a fork of its control
+        Merge* wrapControlIn = funcGraph.getWrapperControlIn();
+        Demux* wrapControlOut = funcGraph.getWrapperControlOut();
+        Demux* wrapResult = funcGraph.getWrapperResult();
+        Merge* wrapParam;
+        for (unsigned int i = 0; i < funcGraph.getTimesCalled(); ++i) {
+            callBlock = funcGraph.getFunctionCallBlock(i);
+            Fork* wrapForkControl = funcGraph.createBlock<Fork>(nullptr, 0);
+            changeConnection(callBlock->getInputContPort(), make_pair(wrapForkControl, 0));
             funcGraph.addWrapperControlFork(wrapForkControl);
-            Merge* wrapControlIn = new Merge(nullptr, 0);
             wrapForkControl->setConnectedPort(wrapControlIn, wrapControlIn->addDataInPort());
-            funcGraph.setWrapperControlIn(wrapControlIn);
-            unsigned int typeSize;
-            Merge* wrapParam;
-            for (unsigned int i = 0; i < funcGraph.getNumArguments(); ++i) {
-                typeSize = DL.getTypeSizeInBits(callInst.getArgOperand(i)->getType());
-                wrapParam = new Merge(nullptr, typeSize);
-                changeConnection(prevCallBlock->getInputArgPort(i), 
-                    make_pair(wrapParam, wrapParam->addDataInPort()));
-                funcGraph.addWrapperCallArg(wrapParam);
-            }
-            Demux* wrapControlOut = new Demux(nullptr, 0);
-            wrapForkControl->setConnectedPort(wrapControlOut, wrapControlOut->addControlInPort());
-            funcGraph.setWrapperControlOut(wrapControlOut);
-            if (!callInst.getType()->isVoidTy()) {
-                typeSize = DL.getTypeAllocSize(callInst.getType());
-                Demux* wrapResult = new Demux(nullptr, typeSize);
+            wrapForkControl->setConnectedPort(wrapControlOut, 
+                wrapControlOut->addControlInPort());
+            if (wrapResult != nullptr) {
                 wrapForkControl->setConnectedPort(wrapResult, wrapResult->addControlInPort());
-                funcGraph.setWrapperResult(wrapResult);
+            }
+            for (unsigned int j = 0; j < funcGraph.getNumArguments(); ++j) {
+                wrapParam = funcGraph.getWrapperCallArg(j);
+                changeConnection(callBlock->getInputArgPort(j), 
+                    make_pair(wrapParam, wrapParam->addDataInPort()));
             }
         }
-        Merge* wrapControlIn = funcGraph.getWrapperControlIn();
-        Fork* wrapForkControl = new Fork(nullptr, 0);
-        funcGraph.addWrapperControlFork(wrapForkControl);
-        blockVar = controlBlocks[BBName];
-        connectBlocks(blockVar, wrapForkControl, 0);
-        wrapForkControl->setConnectedPort(wrapControlIn, wrapControlIn->addDataInPort());
-        Demux* wrapControlOut = funcGraph.getWrapperControlOut();
-        wrapForkControl->setConnectedPort(wrapControlOut, wrapControlOut->addControlInPort());
-        if (!callInst.getType()->isVoidTy()) {
-            Demux* wrapResult = funcGraph.getWrapperResult();
-            wrapForkControl->setConnectedPort(wrapResult, wrapResult->addControlInPort());
-            varsMapping[BBName][&inst] = callBlock;
-        }
-        Merge* wrapParam;
+        wrapControlIn->setConnectedPort(funcGraph.getFunctionControlIn(), 0);
         for (unsigned int i = 0; i < funcGraph.getNumArguments(); ++i) {
-            value = callInst.getArgOperand(i);
-            if (isa<llvm::Constant>(value)) {
-                blockVar = createConstant(value, BB);
-                graph->addBlockToBB(blockVar);
-            }
-            else {
-                blockVar = varsMapping[BBName][callInst.getArgOperand(i)];
-            }
             wrapParam = funcGraph.getWrapperCallArg(i);
-            connectBlocks(blockVar, wrapParam, wrapParam->addDataInPort(), value);
+            wrapParam->setConnectedPort(funcGraph.getArgument(i), 0);
         }
     }
-    if (controlSynch == nullptr) {
-        controlSynch = new DFGraphComp::Operator(OpType::Synchronization, BB, 0);
-    }
-    callBlock->setConnectedControlPort(controlSynch, controlSynch->addInputPort(0));
-    funcGraph.increaseTimesCalled();
 }
 
 
 
-void DFGraphPass::connectFunctionCall(Function& F) {
-    FunctionGraph& funcGraph = graphs[F.getName()];
+void DFGraphPass::connectCallOutputs(FunctionGraph& funcGraph) {
     FunctionCall* callBlock;
     if (funcGraph.getTimesCalled() == 1) {
         callBlock = funcGraph.getFunctionCallBlock(0);
-        changeConnection(callBlock->getInputContPort(), 
-            make_pair(funcGraph.getFunctionControlIn(), 0));
-        for (unsigned int i = 0; i < funcGraph.getNumArguments(); ++i) {
-            changeConnection(callBlock->getInputArgPort(i), 
-                make_pair(funcGraph.getArgument(i), 0));
-        }
         Block* funcResult = funcGraph.getFunctionResult();
         if (funcResult != nullptr) {
             funcResult->setConnectedPort(callBlock->getConnecDataPort());
@@ -592,14 +559,6 @@ void DFGraphPass::connectFunctionCall(Function& F) {
         funcControlOut->setConnectedPort(callBlock->getConnecControlPort());
     }
     else if (funcGraph.getTimesCalled() > 1) {
-        Merge* wrapControlIn = (Merge*)funcGraph.getWrapperControlIn();
-        Entry* funcControlIn = funcGraph.getFunctionControlIn();
-        wrapControlIn->setConnectedPort(funcControlIn, 0);
-        for (unsigned int i = 0; i < funcGraph.getNumArguments(); ++i) {
-            Merge* wrapParam = (Merge*)funcGraph.getWrapperCallArg(i);
-            DFGraphComp::Argument* funcArg = funcGraph.getArgument(i);
-            wrapParam->setConnectedPort(funcArg, 0);
-        }
         Block* funcResult = funcGraph.getFunctionResult();
         if (funcResult != nullptr) {
             Demux* wrapResult = funcGraph.getWrapperResult();
@@ -623,415 +582,397 @@ void DFGraphPass::connectFunctionCall(Function& F) {
 
 
 
-void DFGraphPass::processBranchInst(const Instruction &inst)
-{
-    const BasicBlock* BB = inst.getParent();
-    StringRef BBName = BB->getName();
-    const BranchInst* branchInst = cast<BranchInst>(&inst);
-    if (branchInst->isConditional()) {
-        Value* condition = branchInst->getCondition();
-        const Value* value;
-        unsigned int typeSize;
-        Branch* branch;
-        const set <const Value*>& BBLiveOut = liveness->liveOutVars[BBName];
-        for (set <const Value*>::const_iterator it = BBLiveOut.begin();
-            it != BBLiveOut.end(); ++it)
-        {
-            value = *it;
-            typeSize = DL.getTypeSizeInBits(value->getType());
-            branch = new Branch(BB, typeSize);
-            processOperator(value, branch, 0, BB);
-            processOperator(condition, branch, 1, BB);
-            graph->addBlockToBB(branch);
-            varsMapping[BBName][value] = branch;
-        }
+void DFGraphPass::cleanGraphs(Module& M) {
+    PassProfiler::Scope scope("cleanGraphs");
+    /* The exit of a function and the wrappers of its calls feed the blocks of the callers,
+        so the graphs linked by their calls are cleaned together */
+    vector <vector <FunctionGraph*> > linkedGraphs = getLinkedGraphs();
+    vector <unique_ptr <GraphCleanup> > cleanups(linkedGraphs.size());
+    ThreadPool pool(hardware_concurrency(numThreads));
+    unsigned int i;
+    for (i = 0; i < linkedGraphs.size(); ++i) {
+        const vector <FunctionGraph*>* group = &linkedGraphs[i];
+        unique_ptr <GraphCleanup>* cleanup = &cleanups[i];
+        pool.async([group, cleanup] {
+            cleanup->reset(new GraphCleanup(*group));
+            (*cleanup)->cleanGraph();
+        });
+    }
+    pool.wait();
+    PassProfiler& profiler = PassProfiler::get();
+    for (i = 0; i < cleanups.size(); ++i) {
+        profiler.addCount("dead blocks removed", cleanups[i]->getNumBlocksRemoved());
+        profiler.addCount("forks collapsed", cleanups[i]->getNumForksCollapsed());
+        profiler.addCount("sinks inserted", cleanups[i]->getNumSinks());
     }
 }
 
 
-
-void DFGraphPass::processOperator(const Value* operand, 
-    Block* connecBlock, int connecPort, const BasicBlock* BB) 
-{
-    if (isa<llvm::Constant>(operand)) {
-        ConstantInterf* constant = createConstant(operand, BB);
-        constant->setConnectedPort(connecBlock, connecPort);
-        graph->addBlockToBB(constant);
-    }
-    else if (isa<Instruction>(operand) || isa<llvm::Argument>(operand)) {
-        Block* block = varsMapping[BB->getName()][operand];
-        connectBlocks(block, connecBlock, connecPort, operand);
+void DFGraphPass::narrowWidths(Module& M) {
+    PassProfiler::Scope scope("narrowWidths");
+    vector <unique_ptr <WidthMinimization> > minimizations(graphs.size());
+    ThreadPool pool(hardware_concurrency(numThreads));
+    unsigned int i;
+    for (i = 0; i < graphs.size(); ++i) {
+        FunctionGraph* funcGraph = &graphs[i];
+        unique_ptr <WidthMinimization>* minimization = &minimizations[i];
+        pool.async([funcGraph, minimization] {
+            minimization->reset(new WidthMinimization(*funcGraph));
+            (*minimization)->minimizeWidths();
+        });
+    }
+    pool.wait();
+    PassProfiler& profiler = PassProfiler::get();
+    for (i = 0; i < minimizations.size(); ++i) {
+        profiler.addCount("ports narrowed", minimizations[i]->getNumPortsNarrowed());
+        profiler.addCount("port bits removed", minimizations[i]->getNumBitsRemoved());
     }
 }
 
 
+namespace {
 
-void DFGraphPass::processLiveIn(const BasicBlock* BB) {
-    StringRef BBName = BB->getName();
-    set <const Value*> liveIn = liveness->liveInVars[BBName];
-    const Value* value;
-    unsigned int typeSize;
-    if (pred_size(BB) > 1) {
-        for (set <const Value*>::const_iterator it = liveIn.begin();
-            it != liveIn.end(); ++it)
-        {
-            value = *it;
-            typeSize = DL.getTypeSizeInBits(value->getType());
-            Merge* merge = new Merge(BB, typeSize);
-            varsMapping[BBName][value] = merge;
-            graph->addBlockToBB(merge);
-            varsMerges[BB][value] = merge;
-        }
-    }
-    else { // pred_size(BB) == 1
-        const BasicBlock* predBB = *pred_begin(BB);
-        for (set <const Value*>::const_iterator it = liveIn.begin();
-            it != liveIn.end(); ++it) 
-        {
-            value = *it;
-            varsMapping[BBName][value] = varsMapping[predBB->getName()][value];
-        }
-    }
-}
+// Loop that can be tagged, with the candidate of its closest loop that can also be tagged
+struct TaggedLoop
+{
+    unordered_set <const BasicBlock*> loopBBs;
+    const BasicBlock* header;
+    int parent;
+    bool tagged;
+};
 
+}
 
-void DFGraphPass::processPhiConstants(const BasicBlock* BB) {
-    StringRef BBName = BB->getName();
-    const PHINode* phi;
-    const BasicBlock* phiBB;
-    const Value* value;
-    // Stored each phi instruction and the index of the operand from BB
-    for (set <pair <const PHINode*, unsigned int> >::const_iterator it = 
-        liveness->phiConstants[BBName].begin();
-        it != liveness->phiConstants[BBName].end(); ++it)
-    {
-        phi = it->first;
-        phiBB = phi->getParent();
-        value = phi->getIncomingValue(it->second);
-        ConstantInterf* cst = createConstant(value, BB);
-        graph->addBlockToBB(cst);
-        bool createdBB = false;
-        /* Constants are only connected once, and we need to connect them here to input the
-            control signals. Therefore, we create the merge representing the phi, it will 
-            connect with */
-        if (varsMerges.find(phiBB) == varsMerges.end()) {
-            varsMapping.insert(make_pair(phiBB->getName(), map <const Value*, Block*>()));
-            varsMerges.insert(make_pair(phiBB, map <const Value*, Merge*>()));
-            graph->addBasicBlock(phiBB->getName(), BBNumber);
-            createdBB = true;
-        }
-        Merge* phiMerge;
-        if (varsMerges[phiBB].find(phi) == varsMerges[phiBB].end()) {
-            phiMerge = new Merge(phiBB, DL.getTypeSizeInBits(phi->getType()));
-            if (createdBB) {
-                graph->addBlockToBB(phiMerge);
-                graph->setCurrentBB(BBName); // restore current BB to the one at the beginning of the function
+void DFGraphPass::tagLoops(Module& M) {
+    PassProfiler::Scope scope("tagLoops");
+    vector <vector <TaggedLoop> > candidates(graphs.size());
+    unsigned int i;
+    for (i = 0; i < graphs.size(); ++i) {
+        // The copies of a function have the BB of the function
+        Function& F = *graphFunctions[i];
+        DominatorTree DT(F);
+        PostDominatorTree PDT(F);
+        LoopInfo LI(DT);
+        // In preorder, so the outer loops are tried first
+        map <const Loop*, int> ids;
+        for (const Loop* L : LI.getLoopsInPreorder()) {
+            const Loop* parent = L->getParentLoop();
+            /* The iterations of the outer loop that do not go through this one would get
+                ahead of the ones that are still in it */
+            if (parent == nullptr or L->getExitBlock() == nullptr or
+                !PDT.dominates(L->getHeader(), parent->getHeader()))
+            {
+                continue;
+            }
+            TaggedLoop candidate;
+            candidate.loopBBs.insert(L->block_begin(), L->block_end());
+            candidate.header = L->getHeader();
+            candidate.parent = -1;
+            candidate.tagged = false;
+            for (; parent != nullptr; parent = parent->getParentLoop()) {
+                map <const Loop*, int>::iterator found = ids.find(parent);
+                if (found == ids.end()) continue;
+                candidate.parent = found->second;
+                break;
+            }
+            ids[L] = candidates[i].size();
+            candidates[i].push_back(move(candidate));
+        }
+    }
+
+    vector <unsigned int> numBypassed(graphs.size(), 0);
+    ThreadPool pool(hardware_concurrency(numThreads));
+    for (i = 0; i < graphs.size(); ++i) {
+        if (candidates[i].empty()) continue;
+        FunctionGraph* funcGraph = &graphs[i];
+        vector <TaggedLoop>* loops = &candidates[i];
+        unsigned int* bypassed = &numBypassed[i];
+        pool.async([funcGraph, loops, bypassed] {
+            for (TaggedLoop& loop : *loops) {
+                // The executions of a loop inside a tagged one are already mixed
+                bool insideTagged = false;
+                for (int j = loop.parent; j >= 0 and !insideTagged; j = (*loops)[j].parent) {
+                    insideTagged = (*loops)[j].tagged;
+                }
+                if (insideTagged) continue;
+                LoopTagging tagging(*funcGraph, loop.loopBBs, loop.header, loopTags);
+                loop.tagged = tagging.tagLoop();
+                *bypassed += tagging.getNumBypassed();
             }
-            else graph->addBlockToBB(phiBB->getName(), phiMerge);
-            varsMapping[phiBB->getName()][phi] = phiMerge;
-            varsMerges[phiBB][phi] = phiMerge;
-        }
-        else {
-            phiMerge = varsMerges[phiBB][phi];
+        });
+    }
+    pool.wait();
+    PassProfiler& profiler = PassProfiler::get();
+    for (i = 0; i < candidates.size(); ++i) {
+        for (const TaggedLoop& loop : candidates[i]) {
+            profiler.addCount(loop.tagged ? "loops tagged" : "loops not tagged", 1);
         }
-        cst->setConnectedPort(phiMerge, phiMerge->addDataInPort());
+        profiler.addCount("values bypassing tagged loops", numBypassed[i]);
     }
 }
 
 
-void DFGraphPass::processBBEntryControl(const BasicBlock* BB) 
-{
-    Block* controlEntry;
-    if (pred_empty(BB)) {
-        Entry* entry = new Entry(BB);
-        graph->addControlBlockToBB(entry);
-        graph->setFunctionControlIn(entry);
-        controlEntry = entry;
-    }
-    else if (pred_size(BB) > 1) {
-        Merge* merge = new Merge(BB, 0);
-        graph->addControlBlockToBB(merge);
-        controlMerges[BB] = merge;
-        controlEntry = merge;
-    }
-    else {
-        controlEntry = controlBlocks[(*pred_begin(BB))->getName()];
+void DFGraphPass::characterizeOperators(Module& M) {
+    PassProfiler::Scope scope("characterizeOperators");
+    unsigned int numFound = 0;
+    for (unsigned int i = 0; i < graphs.size(); ++i) {
+        numFound += library.characterize(graphs[i]);
     }
-    controlBlocks[BB->getName()] = controlEntry;
+    PassProfiler::get().addCount("operators characterized", numFound);
 }
 
 
-
-void DFGraphPass::processBBExitControl(const BasicBlock* BB) {
-    StringRef BBName = BB->getName();
-    Block* controlExit;
-    Block* control = controlBlocks[BBName];
-    if (controlSynch != nullptr) {
-        connectBlocks(control, controlSynch, controlSynch->addInputPort(0));
-        graph->addControlBlockToBB(controlSynch);
-        control = controlSynch;
-    }
-    if (succ_empty(BB)) {
-        Exit* exitBlock = new Exit(BB);
-        connectBlocks(control, exitBlock, 0);
-        graph->addControlBlockToBB(exitBlock);
-        controlExit = exitBlock;
-        Block* controlOut = graph->getFunctionControlOut();
-        if (controlOut != nullptr) {
-            Merge* mergeControlOut;
-            if (controlOut->getBlockType() == BlockType::Exit_Block) {
-                mergeControlOut = new Merge(nullptr, 0);
-                controlOut->setConnectedPort(mergeControlOut, mergeControlOut->addDataInPort());
-                graph->setFunctionControlOut(mergeControlOut);
-            }
-            else {
-                mergeControlOut = (Merge*)controlOut;
-            }
-            controlExit->setConnectedPort(mergeControlOut, mergeControlOut->addDataInPort());
+vector <vector <FunctionGraph*> > DFGraphPass::getLinkedGraphs() {
+    vector <FunctionGraph*> allGraphs;
+    for (unsigned int i = 0; i < graphs.size(); ++i) allGraphs.push_back(&graphs[i]);
+    vector <vector <unsigned int> > groups = ChannelGraph::findLinkedGraphs(allGraphs);
+    vector <vector <FunctionGraph*> > linkedGraphs(groups.size());
+    for (unsigned int i = 0; i < groups.size(); ++i) {
+        for (unsigned int j = 0; j < groups[i].size(); ++j) {
+            linkedGraphs[i].push_back(allGraphs[groups[i][j]]);
         }
-        else {
-            graph->setFunctionControlOut(controlExit);
-        }
-    }
-    else if (succ_size(BB) > 1) {
-        const BranchInst* branchInst = cast<BranchInst>(BB->getTerminator());
-        Branch* branch = new Branch(BB, 0);
-        controlExit = branch;
-        processOperator(branchInst->getCondition(), branch, 1, BB);
-        connectBlocks(control, branch, 0);
-        graph->addControlBlockToBB(branch);
     }
-    else controlExit = controlSynch;
-    if (controlExit != nullptr) controlBlocks[BBName] = controlExit;
+    return linkedGraphs;
 }
 
 
-
-void DFGraphPass::connectOrphanCst(ConstantInterf* connecBlock) 
-{
-    const BasicBlock* parentBB = connecBlock->getParentBB();
-    StringRef parentBBName = parentBB->getName();
-    Block* control = controlBlocks[parentBBName];
-    connectBlocks(control, connecBlock, 0);
+void DFGraphPass::placeBuffers(Module& M) {
+    PassProfiler::Scope scope("placeBuffers");
+    vector <vector <FunctionGraph*> > linkedGraphs = getLinkedGraphs();
+    vector <unique_ptr <BufferPlacement> > placements(linkedGraphs.size());
+    ThreadPool pool(hardware_concurrency(numThreads));
+    unsigned int i;
+    for (i = 0; i < linkedGraphs.size(); ++i) {
+        const vector <FunctionGraph*>* group = &linkedGraphs[i];
+        unique_ptr <BufferPlacement>* placement = &placements[i];
+        pool.async([group, placement] {
+            placement->reset(new BufferPlacement(*group, clockPeriod));
+            (*placement)->placeBuffers();
+        });
+    }
+    pool.wait();
+    PassProfiler& profiler = PassProfiler::get();
+    for (i = 0; i < placements.size(); ++i) {
+        profiler.addCount("buffers opaque", placements[i]->getNumOpaqueBuffers());
+        profiler.addCount("buffers transparent", placements[i]->getNumTransparentBuffers());
+        profiler.addCount("buffer slots", placements[i]->getNumSlots());
+        if (clockPeriod == 0) continue;
+        profiler.addCount("buffers timing", placements[i]->getNumTimingBuffers());
+        unsigned int numViolations = placements[i]->getNumTimingViolations();
+        profiler.addCount("timing violations", numViolations);
+        if (numViolations > 0) {
+            errs() << "Warning: " << numViolations << " blocks of " <<
+                linkedGraphs[i][0]->getFunctionName();
+            if (linkedGraphs[i].size() > 1) errs() << " and the functions linked to it";
+            errs() << " are slower than the clock period " << clockPeriod << '\n';
+        }
+    }
 }
 
 
-
-void DFGraphPass::connectBlocks(Block* block, Block* connecBlock,
-    int connecPort, const Value* value) 
-{
-    if (block->getBlockType() == BlockType::Branch_Block) {
-        const BasicBlock* branchBB = block->getParentBB();
-        Branch* branch = (Branch*)block;
-        const BranchInst* branchInst = cast<BranchInst>(branchBB->getTerminator());
-        const BasicBlock* BBFalse = branchInst->getSuccessor(1);
-        if (connecBlock->getBlockType() != BlockType::Merge_Block) {
-            if (varsMapping.find(BBFalse->getName()) == varsMapping.end()) {
-                branch->setCurrentPort(true);
-            }
-            else branch->setCurrentPort(false);
-        }
-    }
-    if (block->connectionAvailable()) {
-        block->setConnectedPort(connecBlock, connecPort);
+void DFGraphPass::countBlocks(Module& M) {
+    map <BlockType, unsigned int> blockTypes;
+    map <OpType, unsigned int> opTypes;
+    for (unsigned int i = 0; i < graphs.size(); ++i) {
+        graphs[i].countBlockTypes(blockTypes, opTypes);
     }
-    else {
-        pair <Block*, int> prevConnection = block->getConnectedPort();
-        const BasicBlock* prevBB = prevConnection.first->getParentBB();
-        const BasicBlock* currBB = connecBlock->getParentBB();
-        const BasicBlock* oldBB = block->getParentBB();
-        int portWidth = 0;
-        if (value != nullptr) portWidth = DL.getTypeSizeInBits(value->getType());
-        Fork* fork;
-        if (currBB != nullptr) fork = new Fork(currBB, portWidth);
-        else if (prevBB != nullptr) fork = new Fork(prevBB, portWidth);
-        else fork = new Fork(oldBB, portWidth);
-        fork->setConnectedPort(prevConnection);
-        fork->setConnectedPort(connecBlock, connecPort);
-        block->setConnectedPort(fork, 0);
-        if (value != nullptr) {
-            if (prevBB != nullptr) {
-                StringRef prevBBName = prevBB->getName();
-                if (prevBB == currBB) graph->addBlockToBB(fork);
-                else graph->addBlockToBB(prevBBName, fork);
-                varsMapping[prevBBName][value] = fork;
-            }
-            else if (currBB != nullptr) {
-                graph->addBlockToBB(fork);
-                varsMapping[currBB->getName()][value] = fork;
-            }
-            else {
-                StringRef oldBBName = oldBB->getName();
-                if (oldBB == currBB) graph->addBlockToBB(fork);
-                else graph->addBlockToBB(oldBBName, fork);
-                varsMapping[oldBBName][value] = fork;
-            }
-        }
-        else {
-            if (prevBB != nullptr) {
-                StringRef prevBBName = prevBB->getName();
-                if (prevBB == currBB) graph->addControlBlockToBB(fork);
-                else graph->addControlBlockToBB(prevBBName, fork);
-                controlBlocks[prevBBName] = fork;
-            }
-            else if (currBB != nullptr) {
-                graph->addControlBlockToBB(fork);
-                controlBlocks[currBB->getName()] = fork;
-            }
-            else {
-                StringRef oldBBName = oldBB->getName();
-                if (oldBB == currBB) graph->addControlBlockToBB(fork);
-                else graph->addControlBlockToBB(oldBBName, fork);
-                controlBlocks[oldBBName] = fork;
-            }
-        }
+    PassProfiler& profiler = PassProfiler::get();
+    for (map <BlockType, unsigned int>::const_iterator it = blockTypes.begin();
+        it != blockTypes.end(); ++it)
+    {
+        ostringstream name;
+        // The dummy blocks of the calls have no name of their own
+        if (it->first == BlockType::FunctionCall_Block) name << "blocks FunctionCall";
+        else name << "blocks " << it->first;
+        profiler.addCount(name.str(), it->second);
+    }
+    for (map <OpType, unsigned int>::const_iterator it = opTypes.begin();
+        it != opTypes.end(); ++it)
+    {
+        profiler.addCount("operators " + getOpName(it->first), it->second);
     }
 }
 
 
-void DFGraphPass::connectMerge(Merge* merge, Block* block,
-    const BasicBlock* predBB, const Value* value)
-{
-    if (block->getBlockType() == BlockType::Branch_Block) {
-        Branch* branch = (Branch*)block;
-        const BasicBlock* BBBranch = branch->getParentBB();
-        const BranchInst* brInst = cast<BranchInst>(BBBranch->getTerminator());
-        const BasicBlock* BBTrue = brInst->getSuccessor(0);
-        const BasicBlock* BBFalse = brInst->getSuccessor(1);
-        int idBBMerge = graph->getBBId(merge->getParentBB()->getName());
-        int idBBTrue = graph->getBBId(BBTrue->getName());
-        int idBBFalse = graph->getBBId(BBFalse->getName());
-        int idPredBB = graph->getBBId(predBB->getName());
-        if ((idPredBB >= idBBTrue and idPredBB < idBBFalse) or idBBMerge == idBBTrue) {
-            branch->setCurrentPort(true);
-        }
-        else if ((idPredBB >= idBBFalse and idPredBB < idBBMerge) or idBBMerge == idBBFalse) {
-            branch->setCurrentPort(false);
-        }
-        else assert(0 && "Cannot find branch output to merge");
-    }
-    connectBlocks(block, merge, merge->addDataInPort(), value);
+void DFGraphPass::numberBlocks(Module& M) {
+    PassProfiler::Scope scope("numberBlocks");
+    /* Blocks created before in the module for each name, that is where the numbering
+        of each function starts */
+    vector <map <string, unsigned int> > firstNumbers;
+    map <string, unsigned int> counters;
+    for (unsigned int i = 0; i < graphs.size(); ++i) {
+        firstNumbers.push_back(counters);
+        graphs[i].countBlockNames(counters);
+    }
+    ThreadPool pool(hardware_concurrency(numThreads));
+    for (unsigned int i = 0; i < graphs.size(); ++i) {
+        FunctionGraph* funcGraph = &graphs[i];
+        map <string, unsigned int>* funcFirstNumbers = &firstNumbers[i];
+        pool.async([funcGraph, funcFirstNumbers] { 
+            funcGraph->numberBlocks(*funcFirstNumbers); 
+        });
+    }
+    pool.wait();
 }
 
 
-void DFGraphPass::connectMerges() {
-    const BasicBlock* BB;
-    const BasicBlock* predBB;
-    const Value* value;
-    const Value* predValue;
-    Merge* merge;
-    Block* predBlock;
-    for (map <const BasicBlock*, map <const Value*, Merge*> >::const_iterator it =
-        varsMerges.begin(); it != varsMerges.end(); ++it)
-    {
-        BB = it->first;
-        for (map <const Value*, Merge*>::const_iterator it2 = varsMerges[BB].begin();
-            it2 != varsMerges[BB].end(); ++it2) 
-        {
-            value = it2->first;
-            merge = it2->second;
-            if (isa<PHINode>(value) and cast<PHINode>(value)->getParent() == BB) {
-                const PHINode* phi = cast<PHINode>(value);
-                for (unsigned int i = 0; i < phi->getNumIncomingValues(); ++i) {
-                    predValue = phi->getIncomingValue(i);
-                    if (isa<Instruction>(predValue) || isa<llvm::Argument>(predValue)) {
-                        predBB = phi->getIncomingBlock(i);
-                        predBlock = varsMapping[predBB->getName()][predValue];
-                        connectMerge(merge, predBlock, predBB, predValue);
-                    }
-                }
-            }
-            else {
-                for (const_pred_iterator it3 = pred_begin(BB); it3 != pred_end(BB); ++it3) {
-                    predBB = *it3;
-                    predBlock = varsMapping[predBB->getName()][value];
-                    connectMerge(merge, predBlock, predBB, value);
-                }
-            }
-        }
-    }
+void DFGraphPass::analyzeTiming(Module& M) {
+    PassProfiler::Scope scope("analyzeTiming");
+    vector <vector <FunctionGraph*> > linkedGraphs = getLinkedGraphs();
+    unsigned int numGroups = linkedGraphs.size();
+    vector <ostringstream> reports(numGroups);
+    ThreadPool pool(hardware_concurrency(numThreads));
+    unsigned int i;
+    for (i = 0; i < numGroups; ++i) {
+        const vector <FunctionGraph*>* group = &linkedGraphs[i];
+        ostringstream* report = &reports[i];
+        pool.async([group, report] {
+            TimingAnalysis timing(*group);
+            timing.analyze(clockPeriod);
+            timing.printReport(*report, printTimingChannels);
+        });
+    }
+    pool.wait();
+    for (i = 0; i < numGroups; ++i) errs() << reports[i].str();
 }
 
 
-
-void DFGraphPass::connectControlMerges() 
-{
-    const BasicBlock* BB;
-    const BasicBlock* predBB;
-    Merge* merge;
-    Block* predBlock;
-    for (map <const BasicBlock*, Merge*>::const_iterator it = controlMerges.begin(); 
-        it != controlMerges.end(); ++it) 
-    {
-        BB = it->first;
-        merge = it->second;
-        for (const_pred_iterator it2 = pred_begin(BB); it2 != pred_end(BB); ++it2) {
-            predBB = (*it2);
-            predBlock = controlBlocks[predBB->getName()];
-            connectMerge(merge, predBlock, predBB);
+// Innermost loop with all the BB of the blocks of a cycle, empty if they are in none
+static string getLoopName(const LoopInfo& LI, const vector <Block*>& blocks) {
+    const Loop* loop = nullptr;
+    bool first = true;
+    for (unsigned int i = 0; i < blocks.size(); ++i) {
+        const BasicBlock* BB = blocks[i]->getParentBB();
+        if (BB == nullptr) continue;
+        const Loop* BBLoop = LI.getLoopFor(BB);
+        if (first) loop = BBLoop;
+        while (loop != nullptr and (BBLoop == nullptr or !loop->contains(BBLoop))) {
+            loop = loop->getParentLoop();
         }
+        first = false;
     }
+    if (loop == nullptr) return "";
+    return "loop " + loop->getHeader()->getName().str() + " (depth " + 
+        to_string(loop->getLoopDepth()) + ")";
 }
 
 
-
-ConstantInterf* DFGraphPass::createConstant(const Value* operand, const BasicBlock* BB) 
-{
-    ConstantInterf* constant;
-    Type* type = operand->getType();
-    if (type->isIntegerTy()) {
-        const ConstantInt* cst = cast<ConstantInt>(operand);
-        if (cst->getBitWidth() <= 32) {
-            constant = new DFGraphComp::Constant<int>((int)cst->getSExtValue(), BB);
-        }
-        else {
-            constant = new DFGraphComp::Constant<long>(cst->getSExtValue(), BB);
+void DFGraphPass::analyzeThroughput(Module& M) {
+    PassProfiler::Scope scope("analyzeThroughput");
+    vector <vector <FunctionGraph*> > linkedGraphs = getLinkedGraphs();
+    vector <unique_ptr <ThroughputAnalysis> > analyses;
+    for (unsigned int i = 0; i < linkedGraphs.size(); ++i) {
+        analyses.push_back(unique_ptr <ThroughputAnalysis>(
+            new ThroughputAnalysis(linkedGraphs[i])));
+        analyses.back()->findComponents();
+    }
+    // The components of all the groups at once, as a group may have only one
+    ThreadPool pool(hardware_concurrency(numThreads));
+    for (unsigned int i = 0; i < analyses.size(); ++i) {
+        ThroughputAnalysis* analysis = analyses[i].get();
+        for (unsigned int j = 0; j < analysis->getNumComponents(); ++j) {
+            pool.async([analysis, j] { analysis->analyzeComponent(j); });
+        }
+    }
+    pool.wait();
+    // The loops of each function are only found when a cycle goes through it
+    map <const FunctionGraph*, unsigned int> graphIds;
+    for (unsigned int i = 0; i < graphs.size(); ++i) graphIds[&graphs[i]] = i;
+    map <const Function*, unique_ptr <DominatorTree> > dominators;
+    map <const Function*, unique_ptr <LoopInfo> > loops;
+    auto getLoops = [&](const FunctionGraph* funcGraph) -> const LoopInfo& {
+        Function* F = graphFunctions[graphIds[funcGraph]];
+        unique_ptr <LoopInfo>& LI = loops[F];
+        if (!LI) {
+            dominators[F].reset(new DominatorTree(*F));
+            LI.reset(new LoopInfo(*dominators[F]));
+        }
+        return *LI;
+    };
+    for (unsigned int i = 0; i < analyses.size(); ++i) {
+        vector <string> origins;
+        for (unsigned int j = 0; j < analyses[i]->getNumComponents(); ++j) {
+            const ThroughputAnalysis::CriticalCycle& cycle = analyses[i]->getCriticalCycle(j);
+            // Blocks of the cycle split by their graph, in the order the cycle enters them
+            vector <FunctionGraph*> cycleGraphs;
+            vector <vector <Block*> > cycleBlocks;
+            for (unsigned int k = 0; k < cycle.blocks.size(); ++k) {
+                unsigned int index = find(cycleGraphs.begin(), cycleGraphs.end(),
+                    cycle.graphs[k]) - cycleGraphs.begin();
+                if (index == cycleGraphs.size()) {
+                    cycleGraphs.push_back(cycle.graphs[k]);
+                    cycleBlocks.push_back(vector <Block*>());
+                }
+                cycleBlocks[index].push_back(cycle.blocks[k]);
+            }
+            // The loop of the caller, as the blocks of the called function are in none
+            int owner = -1;
+            string origin;
+            for (unsigned int k = 0; k < cycleGraphs.size() and owner < 0; ++k) {
+                origin = getLoopName(getLoops(cycleGraphs[k]), cycleBlocks[k]);
+                if (!origin.empty()) owner = k;
+            }
+            if (owner < 0) origin = "not in a loop of the IR";
+            else if (linkedGraphs[i].size() > 1) {
+                origin += " of " + cycleGraphs[owner]->getFunctionName();
+            }
+            if (cycleGraphs.size() > 1) {
+                origin += ", through";
+                for (unsigned int k = 0; k < cycleGraphs.size(); ++k) {
+                    if ((int)k != owner) origin += " " + cycleGraphs[k]->getFunctionName();
+                }
+            }
+            origins.push_back(origin);
         }
+        ostringstream report;
+        analyses[i]->printReport(report, origins);
+        errs() << report.str();
     }
-    else if (type->isPointerTy()) { 
-        // Created as string to print the value nullptr, but with the correct width
-        constant = new DFGraphComp::Constant<string>("nullptr", BB, 32);
-    }
-    else if (type->isFloatTy()) {
-        const ConstantFP* cst = cast<ConstantFP>(operand);
-        constant = new DFGraphComp::Constant<float>(cst->getValueAPF().convertToFloat(), BB);
-    }
-    else if (type->isDoubleTy()) {
-        const ConstantFP* cst = cast<ConstantFP>(operand);
-        constant = new DFGraphComp::Constant<double>(cst->getValueAPF().convertToFloat(), BB);
-    }
-    else {
-        assert(0 && "Constant type not supported");
-    }
-    connectOrphanCst(constant);
-    return constant;
 }
 
 
 void DFGraphPass::printGraph(Module& M) 
 {
-    file << "digraph \"DataFlow Graph for '" << M.getModuleIdentifier() << "' file\" {" << endl;
-    file << "\tlabel=\"DataFlow Graph for '" << M.getModuleIdentifier() << "' file\";" << endl;
-    for (Module::iterator it = M.begin(); it != M.end(); ++it) {
-        Function& F = *it;
-        file << endl;
-        graphs[F.getName()].printNodes(file, F);
-    }
-    for (Module::iterator it = M.begin(); it != M.end(); ++it) {
-        Function& F = *it;
-        file << endl;
-        graphs[F.getName()].printEdges(file, F);
-    }
-    file << endl;
-    file << '}' << endl;
+    PassProfiler::Scope scope("printGraph");
+    // Each function is printed in its own buffers, and they are written in the module order
+    unsigned int numFunctions = graphs.size();
+    vector <DotBuffer> nodes(numFunctions);
+    vector <DotBuffer> edges(numFunctions);
+    ThreadPool pool(hardware_concurrency(numThreads));
+    unsigned int i;
+    for (i = 0; i < graphs.size(); ++i) {
+        FunctionGraph* funcGraph = &graphs[i];
+        DotBuffer* funcNodes = &nodes[i];
+        DotBuffer* funcEdges = &edges[i];
+        pool.async([funcGraph, funcNodes, funcEdges] {
+            *funcNodes << '\n';
+            funcGraph->printNodes(*funcNodes);
+            *funcEdges << '\n';
+            funcGraph->printEdges(*funcEdges);
+        });
+    }
+    pool.wait();
+    DotBuffer header;
+    header << "digraph \"DataFlow Graph for '" << M.getModuleIdentifier() << "' file\" {\n";
+    header << "\tlabel=\"DataFlow Graph for '" << M.getModuleIdentifier() << "' file\";\n";
+    header.writeTo(file);
+    for (i = 0; i < numFunctions; ++i) {
+        nodes[i].writeTo(file);
+    }
+    for (i = 0; i < numFunctions; ++i) {
+        edges[i].writeTo(file);
+    }
+    file << "\n}\n";
 }
 
 
-void DFGraphPass::clearStructures() {
-    varsMapping.clear();
-    controlBlocks.clear();
-    varsMerges.clear();
-    controlMerges.clear();
+void DFGraphPass::writeBinaryGraph(Module& M) {
+    PassProfiler::Scope scope("writeBinaryGraph");
+    BinaryGraphWriter writer;
+    for (unsigned int i = 0; i < graphs.size(); ++i) {
+        writer.addFunction(graphs[i]);
+    }
+    writer.write(file);
 }
 
 
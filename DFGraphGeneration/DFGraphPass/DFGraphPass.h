@@ -5,12 +5,37 @@
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/CFG.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/PostDominators.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Analysis/MemorySSA.h"
+#include "llvm/Analysis/LazyValueInfo.h"
+#include "llvm/Analysis/ScalarEvolution.h"
 #include "llvm/Pass.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/GetElementPtrTypeIterator.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/MapVector.h"
 #include "llvm/Support/raw_ostream.h"
 #include "../../DFGraphComponents/Graph.h"
+#include "../../DFGraphComponents/BinaryGraph.h"
+#include "../../DFGraphComponents/BufferPlacement.h"
+#include "../../DFGraphComponents/TimingAnalysis.h"
+#include "../../DFGraphComponents/ThroughputAnalysis.h"
+#include "../../DFGraphComponents/OperatorLibrary.h"
+#include "../../DFGraphComponents/WidthMinimization.h"
+#include "../../DFGraphComponents/GraphCleanup.h"
+#include "../../DFGraphComponents/LoopTagging.h"
 #include "../../LiveVarsAnalysis/LiveVarsPass/LiveVarsPass.h"
+#include "FunctionGraphBuilder.h"
+#include "MemoryDependences.h"
+#include "ValueRanges.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ThreadPool.h"
+#include <deque>
+#include <memory>
+#include <sstream>
 
 using namespace std;
 using namespace llvm;
@@ -32,94 +57,95 @@ public:
 private:
     // Used to get the width of the different operands of a instruction
     DataLayout DL;
-    // Print the final graph
+    // Print the final graph, in DOT and/or binary format
     ofstream file;
-    map <StringRef, FunctionGraph> graphs;
-    // Number that will become the id of each BB
-    unsigned int BBNumber;
-
-    LiveVarsPass* liveness; // Result of the previous Pass
-    FunctionGraph* graph;
-    // For each BB keep track of which block carries each temporal in the LLVM IR
-    map <StringRef, map <const Value*, Block*> > varsMapping;
-    // The same but with the control block, that do not have a Value
-    map <StringRef, Block*> controlBlocks;
-    /* Used to keep a reference of the merge blocks that we will connect
-        at the end of each function as it may need connecting one of its
-        input to a block that is not yet processed, like in a loop
-    */
-    map <const BasicBlock*, map <const Value*, Merge*> > varsMerges;
-    map <const BasicBlock*, Merge*> controlMerges;
-    /* Reference of the block that will be used to synchronize the control of each called
-        function in each BB */
-    DFGraphComp::Operator* controlSynch;
-
-    void processFunction(Function& F);
-
-    void clearStructures();
-
-    void processBinaryInst(const Instruction &inst);
-
-    void processCmpInst(const Instruction &inst);
-    
-    void processPhiInst(const Instruction &inst);
-    
-    // Not available in LLVM version <= 7, commented in the source code
-    void processFNegInst(const Instruction &inst);
-
-    void processAllocaInst(const Instruction &inst);
-    
-    void processLoadInst(const Instruction &inst);
-
-    void processStoreInst(const Instruction &inst);
-    
-    void processCastInst(const Instruction &inst);
-
-    void processSelectInst(const Instruction &inst);
-
-    void processReturnInst(const Instruction &inst);
-
-    // Used to create branches for the live variables at the end of a BB
-    void processBranchInst(const Instruction &inst);
-
-    void processCallInst(const Instruction& inst);
-
-    void processOperator(const Value* operand, Block* connecBlock,
-        int connecPort, const BasicBlock* BB);
-
-    // Add merges to represent live variables at th beginning of a BB
-    void processLiveIn(const BasicBlock* BB);
-
-    /* We have to create the constants that can appear in some phi, but they will
-        appear as Values in the BB of the phi, not in the BB that they should be placed.
-        Therefore, we keep a reference when we compute the live variable analysis,
-        and then when we process the BB, we create all the constants. We have to create them 
-        at the moment the BB is processed, otherwise we will lose reference of the control block
-        that should connect with that constant and trigger it */
-    void processPhiConstants(const BasicBlock* BB);
-
-    // Create control modules to trigger constants
-    void processBBEntryControl(const BasicBlock* BB); 
-    void processBBExitControl(const BasicBlock* BB);
-    
-    void connectOrphanCst(ConstantInterf* connecBlock);
-
-    void connectBlocks(Block* block, Block* connecBlock,
-        int connecPort, const Value* value = nullptr);
-
-    void connectMerge(Merge* merge, Block* block,
-        const BasicBlock* predBB, const Value* value = nullptr);
-    void connectMerges();
-    void connectControlMerges();
-
-    /* Method to change all the connections made to dummy blocks to the real blocks
-        of the called function */
-    void connectFunctionCall(Function& F);
-
-    ConstantInterf* createConstant(const Value* operand, const BasicBlock* BB);
+    /* Graph of each function in the order of the module, followed by the copies made for
+        the call sites of the functions that are not shared (-dfgraph-calls). A deque, as
+        the builders keep the address of their graph */
+    deque <FunctionGraph> graphs;
+    // Function of each graph
+    vector <Function*> graphFunctions;
+    // Graphs of each function, the one of the module first and then its copies
+    map <const Function*, vector <unsigned int> > functionGraphs;
+    // Read before building the graphs, so a wrong table stops the pass early
+    OperatorLibrary library;
+    // One per graph, the copies included
+    vector <unique_ptr <FunctionGraphBuilder> > builders;
+    // One per function, in the order of the module, also used by its copies
+    vector <unique_ptr <MemoryDependences> > memoryDependences;
+    vector <unique_ptr <ValueRanges> > valueRanges;
+
+    /* Build the graph of every function in parallel. The memory dependences and the
+        value ranges are found before, serially, as the analyses of the functions cannot
+        be requested from the threads (-dfgraph-memory-order, -dfgraph-minimize-widths) */
+    void buildGraphs(Module& M);
+
+    /* Decide for each function called more than once whether its call sites share its
+        graph through the call wrapper or each one gets a copy of it, and build the copies
+        in parallel. The callers are decided before the functions they call, as their
+        copies add call sites, and the recursive functions are always shared (-dfgraph-calls) */
+    void copyCalledFunctions(Module& M);
+    /* Cost model of -dfgraph-calls=auto: the copies are worth their blocks when two of the
+        call sites can run at the same time, in their callers or in the functions above them
+        in the call graph, and they fit in -dfgraph-call-copy-blocks */
+    bool isCopyWorth(Function& F, const vector <pair <unsigned int, const CallInst*> >& sites);
+
+    /* Link the dummy blocks of the calls with the called functions. It is done serially
+        after all the graphs are built, adding a wrapper to the graphs called more than
+        once. All the inputs are linked first, as a call result can be an argument of
+        another call */
+    void linkFunctionCalls(Module& M);
+    void createCallWrapper(Function& F, FunctionGraph& funcGraph);
+    void connectCallInputs(FunctionGraph& funcGraph);
+    void connectCallOutputs(FunctionGraph& funcGraph);
+
+    /* Remove the blocks whose values are not used and the forks of a single output, and
+        give a sink to the outputs left free, once the calls are linked (-dfgraph-cleanup) */
+    void cleanGraphs(Module& M);
+
+    /* Propagate the widths of the values the builders narrowed through the blocks that
+        carry them, once the calls are linked (-dfgraph-minimize-widths) */
+    void narrowWidths(Module& M);
+
+    /* Pipeline with a tagger and an untagger the loops inside other loops that every
+        iteration of the outer loop goes through, so the executions of the inner loop
+        overlap. The loops are found serially and the functions tagged in parallel, and a
+        loop inside a tagged one is not tagged (-dfgraph-loop-tags) */
+    void tagLoops(Module& M);
+
+    /* Latency, II and delay of the operators from the table of -dfgraph-operator-library,
+        or else from the built-in one, before the buffers are placed so they use them */
+    void characterizeOperators(Module& M);
+
+    /* Groups of graphs linked by their calls, in the order of their first graph. The
+        buffers and the analyses work on each group as a whole, so they see the cycles and
+        paths through the called functions */
+    vector <vector <FunctionGraph*> > getLinkedGraphs();
+
+    /* Place the elastic buffers of every group of linked graphs in parallel, once the
+        calls are linked so the whole graph is known (-dfgraph-buffers) */
+    void placeBuffers(Module& M);
+
+    // Counters of the blocks of each type and operation, for -dfgraph-profile
+    void countBlocks(Module& M);
+
+    /* Number the blocks of each kind following the order of the functions in the module,
+        so the names do not depend on the order the threads build the graphs */
+    void numberBlocks(Module& M);
+
+    /* Cycle period and critical path of each group of linked graphs, with the slack
+        against -dfgraph-clock-period when it is given (-dfgraph-timing) */
+    void analyzeTiming(Module& M);
+
+    /* Critical cycle of each strongly connected component of every group of linked
+        graphs, with the components analysed in parallel (-dfgraph-throughput) */
+    void analyzeThroughput(Module& M);
 
     void printGraph(Module& M);
 
+    // Same graph than the DOT file in the binary format of BinaryGraph.h
+    void writeBinaryGraph(Module& M);
+
 };
 
 
@@ -0,0 +1,969 @@
+#include "FunctionGraphBuilder.h"
+
+
+FunctionGraphBuilder::FunctionGraphBuilder(const Function& F, FunctionGraph* graph,
+    const DataLayout& DL, FunctionLiveVars& liveness,
+    const MemoryDependences* memoryDependences, unsigned int queueDepth,
+    const ValueRanges* valueRanges, bool constantSources) : 
+    F(F), DL(DL), liveness(liveness), memoryDependences(memoryDependences),
+    valueRanges(valueRanges), constantSources(constantSources), graph(graph),
+    controlSynch(nullptr), numForks(0), queue(nullptr), queueDepth(queueDepth),
+    lastQueueBB(-1) {}
+
+FunctionGraphBuilder::~FunctionGraphBuilder() {}
+
+
+const vector <pair <const CallInst*, FunctionCall*> >& FunctionGraphBuilder::getCallSites() {
+    return callSites;
+}
+
+
+void FunctionGraphBuilder::buildGraph() {
+    PassProfiler::Scope scope("Build function graph", F.getName());
+    // A copy of the function has its own graph, so it gets its own peak
+    PassProfiler::HeapPeak heapPeak(graph->getFunctionName());
+    /* Number all the BB before processing them, as a BB can need
+        the tables of a successor that is not yet processed */
+    for (const BasicBlock& BB : F.getBasicBlockList()) {
+        graph->addBasicBlock(&BB);
+    }
+    unsigned int numBBs = graph->getNumBBs();
+    varsMapping.resize(numBBs);
+    controlBlocks.resize(numBBs, nullptr);
+    varsMerges.resize(numBBs);
+    controlMerges.resize(numBBs, nullptr);
+    bool firstBB = true;
+    for (const BasicBlock& BB : F.getBasicBlockList()) {
+        PassProfiler::Scope BBScope("Process BB", F.getName(), BB.getName());
+        controlSynch = nullptr;
+        triggeredConstants.clear();
+        sourceConstants.clear();
+        graph->setCurrentBB(&BB);
+        processBBEntryControl(&BB);
+        if (firstBB) {
+            firstBB = false;
+            for (Function::const_arg_iterator arg_it = F.arg_begin(); arg_it != F.arg_end(); 
+                ++arg_it) 
+            {
+                unsigned int argTypeSize = DL.getTypeSizeInBits(arg_it->getType());
+                DFGraphComp::Argument* argBlock = 
+                    graph->createBlock<DFGraphComp::Argument>(&BB, argTypeSize);
+                graph->addBlockToBB(argBlock);
+                varsMapping[graph->getBBId()][arg_it] = argBlock;
+                graph->addArgument(argBlock);
+            }
+        }
+        else {
+            processLiveIn(&BB);
+        }
+        processPhiConstants(&BB);
+        for (BasicBlock::const_iterator inst_it = BB.begin(); inst_it != BB.end(); 
+            ++inst_it) 
+        {
+            if (isa <llvm::BinaryOperator>(inst_it)) {
+                processBinaryInst(*inst_it);
+            }
+            else if (isa<llvm::CmpInst>(inst_it)) {
+                processCmpInst(*inst_it);
+            }
+            // Uncomment if version >= 8
+            // else if (inst_it->getOpcode() == Instruction::FNeg) {
+            //     processFNegInst(*inst_it);
+            // }
+            else if (isa<AllocaInst>(inst_it)) {
+                processAllocaInst(*inst_it);
+            }
+            else if (isa<LoadInst>(inst_it)) {
+                processLoadInst(*inst_it);
+            }
+            else if (isa<StoreInst>(inst_it)) {
+                processStoreInst(*inst_it);
+            }
+            else if (isa<PHINode>(inst_it)) {
+                processPhiInst(*inst_it);
+            }
+            else if (isa<CastInst>(inst_it)) {
+                processCastInst(*inst_it);
+            }
+            else if (isa<GetElementPtrInst>(inst_it) or 
+                isa<SwitchInst>(*inst_it)) 
+            {
+                assert(0 && "Not should appear (lowered with a pass");
+            }
+            else if (isa<SelectInst>(inst_it)) {
+                processSelectInst(*inst_it);
+            }
+            else if (isa<ReturnInst>(inst_it)) {
+                processReturnInst(*inst_it);
+            }
+            else if (isa<BranchInst>(inst_it)) {
+                processBranchInst(*inst_it);
+            }
+            else if (isa<CallInst>(inst_it)) {
+                processCallInst(*inst_it);
+            }
+            else {
+                assert(0 && "Instruction not currently supported");
+            }
+            if (valueRanges != nullptr) narrowValue(*inst_it);
+        }
+        processBBExitControl(&BB);
+        heapPeak.sample();
+    }
+    {
+        PassProfiler::Scope mergesScope("connectMerges", F.getName());
+        connectMerges();
+    }
+    {
+        PassProfiler::Scope mergesScope("connectControlMerges", F.getName());
+        connectControlMerges();
+    }
+    PassProfiler& profiler = PassProfiler::get();
+    profiler.addCount("forks inserted by connectBlocks", numForks);
+}
+
+
+
+void FunctionGraphBuilder::processBinaryInst(const Instruction &inst) 
+{
+    OpType opType = OpType::Add;
+    unsigned int opCode = inst.getOpcode();
+    if (opCode == Instruction::Add) {
+        opType = OpType::Add;
+    }
+    else if (opCode == Instruction::FAdd) {
+        opType = OpType::FAdd;
+    }
+    else if (opCode == Instruction::Sub) {
+        opType = OpType::Sub;
+    }
+    else if (opCode == Instruction::FSub) {
+        opType = OpType::FSub;
+    }
+    else if (opCode == Instruction::Mul) {
+        opType = OpType::Mul;
+    }
+    else if (opCode == Instruction::FMul) {
+        opType = OpType::FMul;
+    }
+    else if (opCode == Instruction::UDiv || opCode == Instruction::SDiv) {
+        opType = OpType::Div;
+    }
+    else if (opCode == Instruction::FDiv) {
+        opType = OpType::FDiv;
+    }
+    else if (opCode == Instruction::URem || opCode == Instruction::SRem) {
+        opType = OpType::Rem;
+    }
+    else if (opCode == Instruction::FRem) {
+        opType = OpType::FRem;
+    }
+    else if (opCode == Instruction::And) {
+        opType = OpType::And;
+    }
+    else if (opCode == Instruction::Or) {
+        opType = OpType::Or;
+    }
+    else if (opCode == Instruction::Xor) {
+        opType = OpType::Xor;
+    }
+    else if (opCode == Instruction::Shl) {
+        opType = OpType::ShiftL;
+    }
+    else if (opCode == Instruction::LShr or opCode == Instruction::AShr) {
+        opType = OpType::ShiftR;
+    }
+    else assert(0 && "Binary operation not supported");
+    unsigned int typeSize = DL.getTypeSizeInBits(inst.getType());
+    const BasicBlock* BB = inst.getParent();
+    DFGraphComp::Operator* op = graph->createBlock<DFGraphComp::Operator>(opType, BB, typeSize);
+    bool sources = canUseSources(inst);
+    processOperator(inst.getOperand(0), op, 0, BB, sources);
+    processOperator(inst.getOperand(1), op, 1, BB, sources);
+    graph->addBlockToBB(op);
+    varsMapping[graph->getBBId()][&inst] = op;
+}
+
+
+
+void FunctionGraphBuilder::processCmpInst(const Instruction &inst) {
+    OpType opType = OpType::Eq;
+    unsigned int opCode = inst.getOpcode();
+    if (opCode == Instruction::ICmp) {
+        const ICmpInst* cmp = cast<ICmpInst> (&inst);
+        ICmpInst::Predicate pred = cmp->getPredicate();
+        if (pred == ICmpInst::ICMP_EQ) {
+            opType = OpType::Eq;
+        }
+        else if (pred == ICmpInst::ICMP_NE) {
+            opType = OpType::NE;
+        }
+        else if (pred == ICmpInst::ICMP_SGT || pred == ICmpInst::ICMP_UGT) {
+            opType = OpType::GT;
+        }
+        else if (pred == ICmpInst::ICMP_SGE || pred == ICmpInst::ICMP_UGE) {
+            opType = OpType::GE;
+        }
+        else if (pred == ICmpInst::ICMP_SLT || pred == ICmpInst::ICMP_ULT) {
+            opType = OpType::LT;
+        }
+        else if (pred == ICmpInst::ICMP_SLE || pred == ICmpInst::ICMP_ULE) {
+            opType = OpType::LE;
+        }
+    }
+    else {
+        const FCmpInst* cmp = cast<FCmpInst> (&inst);
+        FCmpInst::Predicate predicate = cmp->getPredicate();
+        if (predicate == FCmpInst::FCMP_OEQ || predicate == FCmpInst::FCMP_UEQ) {
+            opType = OpType::FEq;
+        }
+        else if (predicate == FCmpInst::FCMP_ONE || predicate == FCmpInst::FCMP_UNE) {
+            opType = OpType::FNE;
+        }
+        else if (predicate == FCmpInst::FCMP_OGT || predicate == FCmpInst::FCMP_UGT) {
+            opType = OpType::FGT;
+        }
+        else if (predicate == FCmpInst::FCMP_OGE || predicate == FCmpInst::FCMP_UGE) {
+            opType = OpType::FGE;
+        }
+        else if (predicate == FCmpInst::FCMP_OLT || predicate == FCmpInst::FCMP_ULT) {
+            opType = OpType::FLT;
+        }
+        else if (predicate == FCmpInst::FCMP_OLE || predicate == FCmpInst::FCMP_ULE) {
+            opType = OpType::FLE;
+        }
+        else if (predicate == FCmpInst::FCMP_TRUE) {
+            opType = OpType::True;
+        }
+        else if (predicate == FCmpInst::FCMP_FALSE) {
+            opType = OpType::False;
+        }
+        else assert(0 && "Comparison not supported");
+    } 
+    const BasicBlock* BB = inst.getParent();
+    DFGraphComp::Operator* op = graph->createBlock<DFGraphComp::Operator>(opType, BB, 
+        DL.getTypeSizeInBits(inst.getOperand(0)->getType()));
+    op->setDataOutPortWidth(DL.getTypeSizeInBits(inst.getType()));
+    bool sources = canUseSources(inst);
+    processOperator(inst.getOperand(0), op, 0, BB, sources);
+    processOperator(inst.getOperand(1), op, 1, BB, sources);
+    graph->addBlockToBB(op);
+    varsMapping[graph->getBBId()][&inst] = op;
+}
+
+
+
+void FunctionGraphBuilder::processFNegInst(const Instruction &inst) {
+   const BasicBlock* BB = inst.getParent(); 
+   unsigned int typeSize = DL.getTypeSizeInBits(inst.getType());
+   DFGraphComp::Operator* op = graph->createBlock<DFGraphComp::Operator>(OpType::FNeg, 
+       BB, typeSize);
+   processOperator(inst.getOperand(0), op, 0, BB);
+   graph->addBlockToBB(op);
+   varsMapping[graph->getBBId()][&inst] = op;
+}
+
+
+
+void FunctionGraphBuilder::processPhiInst(const Instruction &inst) {
+    const BasicBlock* BB = inst.getParent();
+    const PHINode* phi = cast<PHINode>(&inst);
+    unsigned int BBId = graph->getBBId();
+    if (varsMerges[BBId].find(phi) == varsMerges[BBId].end()) {
+        unsigned int typeSize = DL.getTypeSizeInBits(phi->getType());
+        Merge* merge = graph->createBlock<Merge>(BB, typeSize);
+        varsMerges[BBId][&inst] = merge;
+        varsMapping[BBId][&inst] = merge;
+        graph->addBlockToBB(merge);
+    }
+}
+
+
+
+void FunctionGraphBuilder::processAllocaInst(const Instruction &inst) {
+    const BasicBlock* BB = inst.getParent();
+    const AllocaInst* allocaInst = cast<AllocaInst>(&inst);
+    unsigned int allocBytes = DL.getTypeAllocSize(allocaInst->getAllocatedType());
+    if (allocaInst->isArrayAllocation()) {
+        const ConstantInt* cstSize = cast<ConstantInt>(allocaInst->getArraySize());
+        unsigned int nElems = cstSize->getZExtValue();
+        allocBytes *= nElems;
+    }
+    DFGraphComp::Constant<unsigned int>* allocBytesCst = 
+        graph->createBlock<DFGraphComp::Constant<unsigned int> >(allocBytes, BB);
+    connectOrphanCst(allocBytesCst);
+    DFGraphComp::Operator* allocaBlock = 
+        graph->createBlock<DFGraphComp::Operator>(OpType::Alloca, BB);
+    allocaBlock->setDataInPortWidth(0, sizeof(unsigned int));
+    unsigned int ptrSize = DL.getTypeAllocSizeInBits(allocaInst->getType());
+    allocaBlock->setDataOutPortWidth(ptrSize);
+    allocBytesCst->setConnectedPort(allocaBlock, 0);
+    graph->addBlockToBB(allocBytesCst);
+    graph->addBlockToBB(allocaBlock);
+    varsMapping[graph->getBBId()][&inst] = allocaBlock;
+}
+
+
+
+void FunctionGraphBuilder::processLoadInst(const Instruction &inst) 
+{
+    const BasicBlock* BB = inst.getParent();
+    const LoadInst* loadInst = cast<LoadInst>(&inst);
+    unsigned int pointerSize = DL.getTypeSizeInBits(loadInst->getPointerOperandType());
+    unsigned int valueSize = DL.getTypeSizeInBits(loadInst->getType());
+    DFGraphComp::Operator* loadOp = graph->createBlock<DFGraphComp::Operator>(OpType::Load, BB);
+    loadOp->setDataInPortWidth(0, pointerSize);
+    loadOp->setDataOutPortWidth(valueSize);
+    processOperator(loadInst->getPointerOperand(), loadOp, 0, BB);
+    varsMapping[graph->getBBId()][&inst] = loadOp;
+    graph->addBlockToBB(loadOp);
+    orderMemoryAccess(inst, loadOp);
+}
+
+
+
+void FunctionGraphBuilder::processStoreInst(const Instruction &inst) 
+{
+    const BasicBlock* BB = inst.getParent();
+    const StoreInst* storeInst = cast<StoreInst>(&inst);
+    unsigned int storedValueSize = DL.getTypeSizeInBits(storeInst->getValueOperand()->getType());
+    unsigned int pointerSize = DL.getTypeSizeInBits(storeInst->getPointerOperandType());
+    DFGraphComp::Operator* store = graph->createBlock<DFGraphComp::Operator>(OpType::Store, BB);
+    store->setDataInPortWidth(0, storedValueSize);
+    store->setDataInPortWidth(1, pointerSize);
+    bool sources = canUseSources(inst);
+    processOperator(storeInst->getValueOperand(), store, 0, BB, sources);
+    processOperator(storeInst->getPointerOperand(), store, 1, BB, sources);
+    graph->addBlockToBB(store);
+    orderMemoryAccess(inst, store);
+}
+
+
+
+void FunctionGraphBuilder::orderMemoryAccess(const Instruction &inst,
+    DFGraphComp::Operator* op)
+{
+    if (memoryDependences == nullptr) return;
+    if (memoryDependences->isQueued(&inst)) {
+        queueMemoryAccess(inst, op);
+        return;
+    }
+    memoryOps[&inst] = op;
+    const vector <const Instruction*>& preds = memoryDependences->getPredecessors(&inst);
+    for (unsigned int i = 0; i < preds.size(); ++i) {
+        DFGraphComp::Operator* predOp = memoryOps.lookup(preds[i]);
+        assert(predOp != nullptr && "Memory access ordered before one not processed");
+        unsigned int port = op->addOrderInputPort();
+        if (!predOp->hasOrderOutputPort()) {
+            predOp->addOrderOutputPort();
+            predOp->setOrderConnection(op, port);
+            continue;
+        }
+        pair <Block*, int> prevConnection =
+            predOp->getOutputConnection(predOp->getNumOutputPorts()-1);
+        if (prevConnection.first->getBlockType() == BlockType::Fork_Block) {
+            prevConnection.first->setConnectedPort(op, port);
+            continue;
+        }
+        Fork* fork = graph->createBlock<Fork>(inst.getParent(), 0);
+        fork->setConnectedPort(prevConnection);
+        fork->setConnectedPort(op, port);
+        predOp->setOrderConnection(fork, 0);
+        graph->addBlockToBB(fork);
+    }
+}
+
+
+
+void FunctionGraphBuilder::queueMemoryAccess(const Instruction &inst,
+    DFGraphComp::Operator* op)
+{
+    if (queue == nullptr) {
+        queue = graph->createBlock<LSQ>(nullptr, queueDepth);
+        graph->addOuterBlock(queue);
+    }
+    int BBId = graph->getBBId(inst.getParent());
+    if (BBId != lastQueueBB) {
+        // The control of the BB allocates its accesses in the queue
+        connectBlocks(controlBlocks[BBId], queue, queue->addGroup(BBId));
+        lastQueueBB = BBId;
+    }
+    const Value* pointer = getLoadStorePointerOperand(&inst);
+    unsigned int pointerSize = DL.getTypeSizeInBits(pointer->getType());
+    if (const LoadInst* loadInst = dyn_cast<LoadInst>(&inst)) {
+        unsigned int valueSize = DL.getTypeSizeInBits(loadInst->getType());
+        unsigned int load = queue->addLoad(pointerSize, valueSize);
+        unsigned int address = op->addMemoryOutputPort("addr", pointerSize);
+        op->setOutPort(address, make_pair(queue, queue->getLoadAddressPort(load)));
+        unsigned int data = op->addMemoryInputPort("data", valueSize);
+        queue->setOutPort(queue->getLoadDataPort(load), make_pair(op, data));
+        return;
+    }
+    const StoreInst* storeInst = cast<StoreInst>(&inst);
+    unsigned int valueSize = DL.getTypeSizeInBits(storeInst->getValueOperand()->getType());
+    unsigned int store = queue->addStore(pointerSize, valueSize);
+    unsigned int address = op->addMemoryOutputPort("addr", pointerSize);
+    op->setOutPort(address, make_pair(queue, queue->getStoreAddressPort(store)));
+    unsigned int data = op->addMemoryOutputPort("data", valueSize);
+    op->setOutPort(data, make_pair(queue, queue->getStoreDataPort(store)));
+}
+
+
+
+void FunctionGraphBuilder::narrowValue(const Instruction &inst) 
+{
+    unsigned int width = valueRanges->getWidth(&inst);
+    if (width == 0) return;
+    // The other blocks that carry a value take its width from the graph later
+    Block* block = varsMapping[graph->getBBId()].lookup(&inst);
+    if (block == nullptr or block->getBlockType() != BlockType::Operator_Block) return;
+    ((DFGraphComp::Operator*)block)->setDataOutPortWidth(width);
+}
+
+
+
+void FunctionGraphBuilder::processCastInst(const Instruction &inst) 
+{
+    const CastInst* castInst = cast<CastInst>(&inst);
+    unsigned int operandSize = DL.getTypeSizeInBits(castInst->getSrcTy());
+    unsigned int castTypeSize = DL.getTypeSizeInBits(castInst->getDestTy());
+    Value* operand = castInst->getOperand(0);
+    OpType castOpType = OpType::BitCast;
+    unsigned int opCode = castInst->getOpcode();
+    if (opCode == Instruction::Trunc) {
+        castOpType = OpType::IntTrunc;
+    }
+    else if (opCode == Instruction::ZExt) {
+        castOpType = OpType::IntZExt;
+    }
+    else if (opCode == Instruction::SExt) {
+        castOpType = OpType::IntSExt;
+    }
+    else if (opCode == Instruction::FPToUI) {
+        castOpType = OpType::FPointToUInt;
+    }
+    else if (opCode == Instruction::FPToSI) {
+        castOpType = OpType::FPointToSInt;
+    }
+    else if (opCode == Instruction::UIToFP) {
+        castOpType = OpType::UIntToFPoint;
+    }
+    else if (opCode == Instruction::SIToFP) {
+        castOpType = OpType::SIntToFPoint;
+    }
+    else if (opCode == Instruction::FPTrunc) {
+        castOpType = OpType::FPointTrunc;
+    }
+    else if (opCode == Instruction::FPExt) {
+        castOpType = OpType::FPointExt;
+    }
+    else if (opCode == Instruction::PtrToInt) {
+        castOpType = OpType::PtrToInt;
+    }
+    else if (opCode == Instruction::IntToPtr) {
+        castOpType = OpType::IntToPtr;
+    }
+    else if (opCode == Instruction::BitCast) {
+        castOpType = OpType::BitCast;
+    }
+    else if (opCode == Instruction::AddrSpaceCast) {
+        castOpType = OpType::AddrSpaceCast;
+    }
+    else assert(0 && "Cast not supported");
+    const BasicBlock* BB = inst.getParent();
+    DFGraphComp::Operator* castOp = graph->createBlock<DFGraphComp::Operator>(castOpType, BB);
+    castOp->setDataInPortWidth(0, operandSize);
+    castOp->setDataOutPortWidth(castTypeSize);
+    processOperator(operand, castOp, 0, BB);
+    varsMapping[graph->getBBId()][&inst] = castOp;
+    graph->addBlockToBB(castOp);
+}
+
+
+
+void FunctionGraphBuilder::processSelectInst(const Instruction &inst) 
+{
+    const BasicBlock* BB = inst.getParent();
+    const SelectInst* selectInst = cast<SelectInst>(&inst);
+    unsigned int typeSize = DL.getTypeSizeInBits(selectInst->getType());
+    Select* selectBlock = graph->createBlock<Select>(BB, typeSize);
+    processOperator(selectInst->getTrueValue(), selectBlock, 0, BB);
+    processOperator(selectInst->getFalseValue(), selectBlock, 1, BB);
+    processOperator(selectInst->getCondition(), selectBlock, 2, BB);
+    graph->addBlockToBB(selectBlock);
+    varsMapping[graph->getBBId()][&inst] = selectBlock;
+}
+
+
+
+void FunctionGraphBuilder::processReturnInst(const Instruction &inst) 
+{
+    const BasicBlock* BB = inst.getParent();
+    if (inst.getNumOperands() > 0) {
+        Value* operand = inst.getOperand(0);
+        unsigned int typeSize = DL.getTypeSizeInBits(operand->getType());
+        Return* retBlock = graph->createBlock<Return>(BB, typeSize);
+        processOperator(operand, retBlock, 0, BB);
+        graph->addBlockToBB(retBlock);
+        varsMapping[graph->getBBId()][&inst] = retBlock;
+        Block* functionReturn = graph->getFunctionResult();
+        if (functionReturn != nullptr) {
+            Merge* mergeRet;
+            if (functionReturn->getBlockType() == BlockType::Exit_Block) {
+                mergeRet = graph->createBlock<Merge>(nullptr, typeSize);
+                functionReturn->setConnectedPort(mergeRet, mergeRet->addDataInPort());
+                graph->setFunctionResult(mergeRet);
+            }
+            else {
+                mergeRet = (Merge*)functionReturn;
+            }
+            retBlock->setConnectedPort(mergeRet, mergeRet->addDataInPort());
+        }
+        else {
+            graph->setFunctionResult(retBlock);
+        }
+    }
+}
+
+
+void FunctionGraphBuilder::processCallInst(const Instruction& inst) {
+    const BasicBlock* BB = inst.getParent();
+    unsigned int BBId = graph->getBBId();
+    const Value* value;
+    Block* blockVar;
+    const CallInst& callInst = cast<CallInst>(inst);
+    /* The called function may be processed at the same time by another thread, so the call
+        is represented by a dummy block that is linked with the function (or its wrapper)
+        once all the graphs are built */
+    FunctionCall* callBlock = graph->createBlock<FunctionCall>(BB);
+    blockVar = controlBlocks[BBId];
+    connectBlocks(blockVar, callBlock, 0);
+    blockVar = controlBlocks[BBId];
+    callBlock->setInputContPort(blockVar, blockVar->getOutputPortIndex());
+    for (unsigned int i = 0; i < callInst.arg_size(); ++i) {
+        value = callInst.getArgOperand(i);
+        if (isa<llvm::Constant>(value)) {
+            blockVar = createConstant(value, BB);
+            graph->addBlockToBB(blockVar);
+        }
+        else {
+            blockVar = varsMapping[BBId][value];
+        }
+        connectBlocks(blockVar, callBlock, i+1, value);
+        if (!isa<llvm::Constant>(value)) blockVar = varsMapping[BBId][value];
+        callBlock->addInputArgPort(blockVar, blockVar->getOutputPortIndex());
+    }
+    if (!callInst.getType()->isVoidTy()) {
+        varsMapping[BBId][&inst] = callBlock;
+    }
+    if (controlSynch == nullptr) {
+        controlSynch = graph->createBlock<DFGraphComp::Operator>(OpType::Synchronization, 
+            BB, 0);
+    }
+    callBlock->setConnectedControlPort(controlSynch, controlSynch->addInputPort(0));
+    callSites.push_back(make_pair(&callInst, callBlock));
+}
+
+
+
+void FunctionGraphBuilder::processBranchInst(const Instruction &inst)
+{
+    const BasicBlock* BB = inst.getParent();
+    unsigned int BBId = graph->getBBId();
+    const BranchInst* branchInst = cast<BranchInst>(&inst);
+    if (branchInst->isConditional()) {
+        Value* condition = branchInst->getCondition();
+        const Value* value;
+        unsigned int typeSize;
+        Branch* branch;
+        // Values in the order of the IR, so the graph does not depend on their addresses
+        for (unsigned int valueNum : liveness.getLiveOutBits(BB).set_bits()) {
+            value = liveness.getValue(valueNum);
+            typeSize = DL.getTypeSizeInBits(value->getType());
+            branch = graph->createBlock<Branch>(BB, typeSize);
+            processOperator(value, branch, 0, BB);
+            processOperator(condition, branch, 1, BB);
+            graph->addBlockToBB(branch);
+            varsMapping[BBId][value] = branch;
+        }
+    }
+}
+
+
+
+void FunctionGraphBuilder::processOperator(const Value* operand, 
+    Block* connecBlock, int connecPort, const BasicBlock* BB, bool source) 
+{
+    if (isa<llvm::Constant>(operand)) {
+        Block*& constant = (source ? sourceConstants : triggeredConstants)[operand];
+        if (constant == nullptr) {
+            constant = createConstant(operand, BB, source);
+            constant->setConnectedPort(connecBlock, connecPort);
+            graph->addBlockToBB(constant);
+        }
+        else if (constant->connectionAvailable()) {
+            constant->setConnectedPort(connecBlock, connecPort);
+        }
+        else {
+            // The fork takes the place of the constant for the next uses
+            Fork* fork = graph->createBlock<Fork>(BB, constant->getOutputPort(0).getWidth());
+            fork->setConnectedPort(constant->getConnectedPort());
+            fork->setConnectedPort(connecBlock, connecPort);
+            constant->setConnectedPort(fork, 0);
+            graph->addBlockToBB(fork);
+            ++numForks;
+            constant = fork;
+        }
+    }
+    else if (isa<Instruction>(operand) || isa<llvm::Argument>(operand)) {
+        Block* block = varsMapping[graph->getBBId(BB)][operand];
+        connectBlocks(block, connecBlock, connecPort, operand);
+    }
+}
+
+
+
+bool FunctionGraphBuilder::canUseSources(const Instruction &inst) {
+    if (!constantSources) return false;
+    if (!isa<llvm::BinaryOperator>(inst) and !isa<CmpInst>(inst) and !isa<StoreInst>(inst)) {
+        return false;
+    }
+    for (unsigned int i = 0; i < inst.getNumOperands(); ++i) {
+        if (!isa<llvm::Constant>(inst.getOperand(i))) return true;
+    }
+    return false;
+}
+
+
+
+void FunctionGraphBuilder::processLiveIn(const BasicBlock* BB) {
+    unsigned int BBId = graph->getBBId(BB);
+    const BitVector& liveIn = liveness.getLiveInBits(BB);
+    const Value* value;
+    unsigned int typeSize;
+    if (pred_size(BB) > 1) {
+        for (unsigned int valueNum : liveIn.set_bits()) {
+            value = liveness.getValue(valueNum);
+            typeSize = DL.getTypeSizeInBits(value->getType());
+            Merge* merge = graph->createBlock<Merge>(BB, typeSize);
+            varsMapping[BBId][value] = merge;
+            graph->addBlockToBB(merge);
+            varsMerges[BBId][value] = merge;
+        }
+    }
+    else { // pred_size(BB) == 1
+        unsigned int predBBId = graph->getBBId(*pred_begin(BB));
+        for (unsigned int valueNum : liveIn.set_bits()) {
+            value = liveness.getValue(valueNum);
+            varsMapping[BBId][value] = varsMapping[predBBId][value];
+        }
+    }
+}
+
+
+void FunctionGraphBuilder::processPhiConstants(const BasicBlock* BB) {
+    const PHINode* phi;
+    const BasicBlock* phiBB;
+    const Value* value;
+    // Stored each phi instruction and the index of the operand from BB
+    const vector <pair <const PHINode*, unsigned int> >& phiConstants =
+        liveness.getPhiConstants(BB);
+    for (vector <pair <const PHINode*, unsigned int> >::const_iterator it = 
+        phiConstants.begin(); it != phiConstants.end(); ++it)
+    {
+        phi = it->first;
+        phiBB = phi->getParent();
+        value = phi->getIncomingValue(it->second);
+        ConstantInterf* cst = createConstant(value, BB);
+        graph->addBlockToBB(cst);
+        /* Constants are only connected once, and we need to connect them here to input the
+            control signals. Therefore, we create the merge representing the phi, it will 
+            connect with */
+        unsigned int phiBBId = graph->getBBId(phiBB);
+        Merge* phiMerge = varsMerges[phiBBId].lookup(phi);
+        if (phiMerge == nullptr) {
+            phiMerge = graph->createBlock<Merge>(phiBB, DL.getTypeSizeInBits(phi->getType()));
+            graph->addBlockToBB(phiBB, phiMerge);
+            varsMapping[phiBBId][phi] = phiMerge;
+            varsMerges[phiBBId][phi] = phiMerge;
+        }
+        cst->setConnectedPort(phiMerge, phiMerge->addDataInPort());
+    }
+}
+
+
+void FunctionGraphBuilder::processBBEntryControl(const BasicBlock* BB) 
+{
+    Block* controlEntry;
+    if (pred_empty(BB)) {
+        Entry* entry = graph->createBlock<Entry>(BB);
+        graph->addControlBlockToBB(entry);
+        graph->setFunctionControlIn(entry);
+        controlEntry = entry;
+    }
+    else if (pred_size(BB) > 1) {
+        Merge* merge = graph->createBlock<Merge>(BB, 0);
+        graph->addControlBlockToBB(merge);
+        controlMerges[graph->getBBId(BB)] = merge;
+        controlEntry = merge;
+    }
+    else {
+        controlEntry = controlBlocks[graph->getBBId(*pred_begin(BB))];
+    }
+    controlBlocks[graph->getBBId(BB)] = controlEntry;
+}
+
+
+
+void FunctionGraphBuilder::processBBExitControl(const BasicBlock* BB) {
+    unsigned int BBId = graph->getBBId(BB);
+    Block* controlExit;
+    Block* control = controlBlocks[BBId];
+    if (controlSynch != nullptr) {
+        connectBlocks(control, controlSynch, controlSynch->addInputPort(0));
+        graph->addControlBlockToBB(controlSynch);
+        control = controlSynch;
+    }
+    if (succ_empty(BB)) {
+        Exit* exitBlock = graph->createBlock<Exit>(BB);
+        connectBlocks(control, exitBlock, 0);
+        graph->addControlBlockToBB(exitBlock);
+        controlExit = exitBlock;
+        Block* controlOut = graph->getFunctionControlOut();
+        if (controlOut != nullptr) {
+            Merge* mergeControlOut;
+            if (controlOut->getBlockType() == BlockType::Exit_Block) {
+                mergeControlOut = graph->createBlock<Merge>(nullptr, 0);
+                controlOut->setConnectedPort(mergeControlOut, mergeControlOut->addDataInPort());
+                graph->setFunctionControlOut(mergeControlOut);
+            }
+            else {
+                mergeControlOut = (Merge*)controlOut;
+            }
+            controlExit->setConnectedPort(mergeControlOut, mergeControlOut->addDataInPort());
+        }
+        else {
+            graph->setFunctionControlOut(controlExit);
+        }
+    }
+    else if (succ_size(BB) > 1) {
+        const BranchInst* branchInst = cast<BranchInst>(BB->getTerminator());
+        Branch* branch = graph->createBlock<Branch>(BB, 0);
+        controlExit = branch;
+        processOperator(branchInst->getCondition(), branch, 1, BB);
+        connectBlocks(control, branch, 0);
+        graph->addControlBlockToBB(branch);
+    }
+    else controlExit = controlSynch;
+    if (controlExit != nullptr) controlBlocks[BBId] = controlExit;
+}
+
+
+
+void FunctionGraphBuilder::connectOrphanCst(ConstantInterf* connecBlock) 
+{
+    const BasicBlock* parentBB = connecBlock->getParentBB();
+    Block* control = controlBlocks[graph->getBBId(parentBB)];
+    connectBlocks(control, connecBlock, 0);
+}
+
+
+
+void FunctionGraphBuilder::connectBlocks(Block* block, Block* connecBlock,
+    int connecPort, const Value* value) 
+{
+    if (block->getBlockType() == BlockType::Branch_Block) {
+        const BasicBlock* branchBB = block->getParentBB();
+        Branch* branch = (Branch*)block;
+        const BranchInst* branchInst = cast<BranchInst>(branchBB->getTerminator());
+        const BasicBlock* BBFalse = branchInst->getSuccessor(1);
+        if (connecBlock->getBlockType() != BlockType::Merge_Block) {
+            // The false successor has not been processed yet
+            if (graph->getBBId(BBFalse) > graph->getBBId()) {
+                branch->setCurrentPort(true);
+            }
+            else branch->setCurrentPort(false);
+        }
+    }
+    if (block->connectionAvailable()) {
+        block->setConnectedPort(connecBlock, connecPort);
+    }
+    else {
+        pair <Block*, int> prevConnection = block->getConnectedPort();
+        const BasicBlock* prevBB = prevConnection.first->getParentBB();
+        const BasicBlock* currBB = connecBlock->getParentBB();
+        const BasicBlock* oldBB = block->getParentBB();
+        int portWidth = 0;
+        if (value != nullptr) portWidth = DL.getTypeSizeInBits(value->getType());
+        // The fork belongs to the BB it is placed in, the one of the first use if it has one
+        const BasicBlock* forkBB = oldBB;
+        if (prevBB != nullptr) forkBB = prevBB;
+        else if (currBB != nullptr) forkBB = currBB;
+        Fork* fork = graph->createBlock<Fork>(forkBB, portWidth);
+        fork->setConnectedPort(prevConnection);
+        fork->setConnectedPort(connecBlock, connecPort);
+        block->setConnectedPort(fork, 0);
+        ++numForks;
+        if (value != nullptr) {
+            if (prevBB != nullptr) {
+                if (prevBB == currBB) graph->addBlockToBB(fork);
+                else graph->addBlockToBB(prevBB, fork);
+                varsMapping[graph->getBBId(prevBB)][value] = fork;
+            }
+            else if (currBB != nullptr) {
+                graph->addBlockToBB(fork);
+                varsMapping[graph->getBBId(currBB)][value] = fork;
+            }
+            else {
+                if (oldBB == currBB) graph->addBlockToBB(fork);
+                else graph->addBlockToBB(oldBB, fork);
+                varsMapping[graph->getBBId(oldBB)][value] = fork;
+            }
+        }
+        else {
+            if (prevBB != nullptr) {
+                if (prevBB == currBB) graph->addControlBlockToBB(fork);
+                else graph->addControlBlockToBB(prevBB, fork);
+                controlBlocks[graph->getBBId(prevBB)] = fork;
+            }
+            else if (currBB != nullptr) {
+                graph->addControlBlockToBB(fork);
+                controlBlocks[graph->getBBId(currBB)] = fork;
+            }
+            else {
+                if (oldBB == currBB) graph->addControlBlockToBB(fork);
+                else graph->addControlBlockToBB(oldBB, fork);
+                controlBlocks[graph->getBBId(oldBB)] = fork;
+            }
+        }
+    }
+}
+
+
+void FunctionGraphBuilder::connectMerge(Merge* merge, Block* block,
+    const BasicBlock* predBB, const Value* value)
+{
+    if (block->getBlockType() == BlockType::Branch_Block) {
+        Branch* branch = (Branch*)block;
+        const BasicBlock* BBBranch = branch->getParentBB();
+        const BranchInst* brInst = cast<BranchInst>(BBBranch->getTerminator());
+        const BasicBlock* BBTrue = brInst->getSuccessor(0);
+        const BasicBlock* BBFalse = brInst->getSuccessor(1);
+        int idBBMerge = graph->getBBId(merge->getParentBB());
+        int idBBTrue = graph->getBBId(BBTrue);
+        int idBBFalse = graph->getBBId(BBFalse);
+        int idPredBB = graph->getBBId(predBB);
+        if ((idPredBB >= idBBTrue and idPredBB < idBBFalse) or idBBMerge == idBBTrue) {
+            branch->setCurrentPort(true);
+        }
+        else if ((idPredBB >= idBBFalse and idPredBB < idBBMerge) or idBBMerge == idBBFalse) {
+            branch->setCurrentPort(false);
+        }
+        else assert(0 && "Cannot find branch output to merge");
+    }
+    connectBlocks(block, merge, merge->addDataInPort(), value);
+}
+
+
+void FunctionGraphBuilder::connectMerges() {
+    const BasicBlock* predBB;
+    const Value* value;
+    const Value* predValue;
+    Merge* merge;
+    Block* predBlock;
+    for (const BasicBlock& BB : F.getBasicBlockList()) {
+        MapVector <const Value*, Merge*>& BBMerges = varsMerges[graph->getBBId(&BB)];
+        for (MapVector <const Value*, Merge*>::const_iterator it = BBMerges.begin();
+            it != BBMerges.end(); ++it) 
+        {
+            value = it->first;
+            merge = it->second;
+            if (isa<PHINode>(value) and cast<PHINode>(value)->getParent() == &BB) {
+                const PHINode* phi = cast<PHINode>(value);
+                for (unsigned int i = 0; i < phi->getNumIncomingValues(); ++i) {
+                    predValue = phi->getIncomingValue(i);
+                    if (isa<Instruction>(predValue) || isa<llvm::Argument>(predValue)) {
+                        predBB = phi->getIncomingBlock(i);
+                        predBlock = varsMapping[graph->getBBId(predBB)][predValue];
+                        connectMerge(merge, predBlock, predBB, predValue);
+                    }
+                }
+            }
+            else {
+                for (const_pred_iterator it2 = pred_begin(&BB); it2 != pred_end(&BB); ++it2) {
+                    predBB = *it2;
+                    predBlock = varsMapping[graph->getBBId(predBB)][value];
+                    connectMerge(merge, predBlock, predBB, value);
+                }
+            }
+        }
+    }
+}
+
+
+
+void FunctionGraphBuilder::connectControlMerges() 
+{
+    const BasicBlock* predBB;
+    Merge* merge;
+    Block* predBlock;
+    for (const BasicBlock& BB : F.getBasicBlockList()) {
+        merge = controlMerges[graph->getBBId(&BB)];
+        if (merge == nullptr) continue;
+        for (const_pred_iterator it = pred_begin(&BB); it != pred_end(&BB); ++it) {
+            predBB = (*it);
+            predBlock = controlBlocks[graph->getBBId(predBB)];
+            connectMerge(merge, predBlock, predBB);
+        }
+    }
+}
+
+
+
+ConstantInterf* FunctionGraphBuilder::createConstant(const Value* operand, const BasicBlock* BB,
+    bool source) 
+{
+    ConstantInterf* constant = nullptr;
+    Type* type = operand->getType();
+    if (type->isIntegerTy()) {
+        const ConstantInt* cst = cast<ConstantInt>(operand);
+        if (cst->getBitWidth() <= 32) {
+            constant = graph->createBlock<DFGraphComp::Constant<int> >(
+                (int)cst->getSExtValue(), BB);
+        }
+        else {
+            constant = graph->createBlock<DFGraphComp::Constant<long> >(
+                cst->getSExtValue(), BB);
+        }
+        if (valueRanges != nullptr) {
+            const APInt& value = cst->getValue();
+            unsigned int width = ValueRanges::getNeededBits(value, !value.isNegative());
+            // The negative values only need the width of their type
+            if (width == 0 or width > cst->getBitWidth()) width = cst->getBitWidth();
+            if ((int)width < constant->getOutputPort(0).getWidth()) {
+                constant->setDataPortWidth(width);
+            }
+        }
+    }
+    else if (type->isPointerTy()) { 
+        // Created as string to print the value nullptr, but with the correct width
+        constant = graph->createBlock<DFGraphComp::Constant<DFGraphComp::ArenaString> >(
+            "nullptr", BB, 32);
+    }
+    else if (type->isFloatTy()) {
+        const ConstantFP* cst = cast<ConstantFP>(operand);
+        constant = graph->createBlock<DFGraphComp::Constant<float> >(
+            cst->getValueAPF().convertToFloat(), BB);
+    }
+    else if (type->isDoubleTy()) {
+        const ConstantFP* cst = cast<ConstantFP>(operand);
+        constant = graph->createBlock<DFGraphComp::Constant<double> >(
+            cst->getValueAPF().convertToFloat(), BB);
+    }
+    else {
+        assert(0 && "Constant type not supported");
+    }
+    if (source) constant->setSource(true);
+    else connectOrphanCst(constant);
+    return constant;
+}
@@ -0,0 +1,166 @@
+#ifndef FUNCTIONGRAPHBUILDER_H
+#define FUNCTIONGRAPHBUILDER_H
+
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/MapVector.h"
+#include "../../DFGraphComponents/Graph.h"
+#include "../../LiveVarsAnalysis/LiveVarsPass/LiveVarsPass.h"
+#include "../../LiveVarsAnalysis/LiveVarsPass/PassProfiler.h"
+#include "MemoryDependences.h"
+#include "ValueRanges.h"
+#include <map>
+#include <set>
+#include <vector>
+
+using namespace std;
+using namespace llvm;
+using namespace DFGraphComp;
+
+
+/* Builds the graph of a single function. All the state needed while processing the
+    function lives here, so different functions can be built at the same time.
+    Calls to other functions are left as dummy blocks, linked afterwards by DFGraphPass */
+class FunctionGraphBuilder {
+
+public:
+
+    /* Without memory dependences the loads and stores are not ordered. The ones they
+        queue go through a load-store queue of queueDepth accesses. Without value ranges
+        the values keep the width of their type. With constantSources the constants that
+        an operator waits for together with another operand are sources */
+    FunctionGraphBuilder(const Function& F, FunctionGraph* graph, const DataLayout& DL,
+        FunctionLiveVars& liveness, const MemoryDependences* memoryDependences = nullptr,
+        unsigned int queueDepth = 16, const ValueRanges* valueRanges = nullptr,
+        bool constantSources = false);
+    ~FunctionGraphBuilder();
+
+    void buildGraph();
+
+    /* Call instruction and dummy block of each call, in the order they appear in the
+        function */
+    const vector <pair <const CallInst*, FunctionCall*> >& getCallSites();
+
+private:
+
+    const Function& F;
+    // Own copy, as the DataLayout caches the layout of the structs when queried
+    DataLayout DL;
+    // Computed for the whole module by LiveVarsPass, only read here
+    FunctionLiveVars& liveness;
+    const MemoryDependences* memoryDependences;
+    const ValueRanges* valueRanges;
+    bool constantSources;
+    FunctionGraph* graph;
+    /* The following tables are indexed by the id the FunctionGraph gives to each BB,
+        that is the order in which the BB are processed */
+    // For each BB keep track of which block carries each temporal in the LLVM IR
+    vector <DenseMap <const Value*, Block*> > varsMapping;
+    // The same but with the control block, that do not have a Value
+    vector <Block*> controlBlocks;
+    /* Used to keep a reference of the merge blocks that we will connect
+        at the end of each function as it may need connecting one of its
+        input to a block that is not yet processed, like in a loop.
+        MapVector keeps the order of insertion, so the connections do not
+        depend on the addresses of the Values
+    */
+    vector <MapVector <const Value*, Merge*> > varsMerges;
+    vector <Merge*> controlMerges;
+    /* Reference of the block that will be used to synchronize the control of each called
+        function in each BB */
+    DFGraphComp::Operator* controlSynch;
+    vector <pair <const CallInst*, FunctionCall*> > callSites;
+    // Forks added by connectBlocks to give a value to more than one block
+    unsigned int numForks;
+    // Block of each load and store, to order the ones after them
+    DenseMap <const Instruction*, DFGraphComp::Operator*> memoryOps;
+    // Created with the first queued access, with a group for each BB that has one
+    LSQ* queue;
+    unsigned int queueDepth;
+    int lastQueueBB;
+    /* Constants of the operands of the BB being processed, triggered by its control and
+        sources, so each value is created once and forked to all its uses */
+    DenseMap <const Value*, Block*> triggeredConstants;
+    DenseMap <const Value*, Block*> sourceConstants;
+
+    void processBinaryInst(const Instruction &inst);
+
+    void processCmpInst(const Instruction &inst);
+
+    void processPhiInst(const Instruction &inst);
+
+    // Not available in LLVM version <= 7, commented in the source code
+    void processFNegInst(const Instruction &inst);
+
+    void processAllocaInst(const Instruction &inst);
+
+    void processLoadInst(const Instruction &inst);
+
+    void processStoreInst(const Instruction &inst);
+
+    /* Connect the done port of the loads and stores the access has to wait for with an
+        order input of it, through a fork when a done port is already used */
+    void orderMemoryAccess(const Instruction &inst, DFGraphComp::Operator* op);
+
+    /* Connects a queued access with the load-store queue, starting the group of its BB
+        if it is the first one of the BB */
+    void queueMemoryAccess(const Instruction &inst, DFGraphComp::Operator* op);
+
+    void processCastInst(const Instruction &inst);
+
+    // Narrows the output of the operator of an instruction to the width of its range
+    void narrowValue(const Instruction &inst);
+
+    void processSelectInst(const Instruction &inst);
+
+    void processReturnInst(const Instruction &inst);
+
+    // Used to create branches for the live variables at the end of a BB
+    void processBranchInst(const Instruction &inst);
+
+    void processCallInst(const Instruction& inst);
+
+    // A constant operand is a source if the block waits for another operand too
+    void processOperator(const Value* operand, Block* connecBlock,
+        int connecPort, const BasicBlock* BB, bool source = false);
+
+    /* Operators that wait for all their operands, with some of them not constant, so their
+        constants can be sources */
+    bool canUseSources(const Instruction &inst);
+
+    // Add merges to represent live variables at th beginning of a BB
+    void processLiveIn(const BasicBlock* BB);
+
+    /* We have to create the constants that can appear in some phi, but they will
+        appear as Values in the BB of the phi, not in the BB that they should be placed.
+        Therefore, we keep a reference when we compute the live variable analysis,
+        and then when we process the BB, we create all the constants. We have to create them
+        at the moment the BB is processed, otherwise we will lose reference of the control block
+        that should connect with that constant and trigger it */
+    void processPhiConstants(const BasicBlock* BB);
+
+    // Create control modules to trigger constants
+    void processBBEntryControl(const BasicBlock* BB);
+    void processBBExitControl(const BasicBlock* BB);
+
+    void connectOrphanCst(ConstantInterf* connecBlock);
+
+    void connectBlocks(Block* block, Block* connecBlock,
+        int connecPort, const Value* value = nullptr);
+
+    void connectMerge(Merge* merge, Block* block,
+        const BasicBlock* predBB, const Value* value = nullptr);
+    void connectMerges();
+    void connectControlMerges();
+
+    // Sources are not connected to the control of the BB
+    ConstantInterf* createConstant(const Value* operand, const BasicBlock* BB,
+        bool source = false);
+
+};
+
+
+#endif // FUNCTIONGRAPHBUILDER_H
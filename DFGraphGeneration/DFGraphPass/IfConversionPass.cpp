@@ -0,0 +1,176 @@
+#include "IfConversionPass.h"
+
+char IfConversionPass::ID = 0;
+
+static cl::opt <double> costThreshold("if-conversion-threshold",
+    cl::desc("Expected cost of the operators executed for nothing, in adders, up to which "
+        "an if-then-else region is converted into selects"),
+    cl::init(4));
+
+static cl::opt <unsigned int> maxInstructions("if-conversion-max-insts",
+    cl::desc("Instructions that each side of a converted region can have"),
+    cl::init(8));
+
+IfConversionPass::IfConversionPass() : FunctionPass(ID) {}
+
+IfConversionPass::~IfConversionPass() {}
+
+
+bool IfConversionPass::runOnFunction(Function &F) {
+    PassProfiler::Scope scope("IfConversionPass", F.getName());
+    numDiamonds = 0;
+    numTriangles = 0;
+    numSelects = 0;
+    /* A BB is tried again after converting its region, as the join merged into it can
+        start another one. The regions outside are found in the next walk */
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (Function::iterator it = F.begin(); it != F.end(); ) {
+            if (convertRegion(&*it)) changed = true;
+            else ++it;
+        }
+    }
+    PassProfiler& profiler = PassProfiler::get();
+    profiler.addCount("if-conversion diamonds", numDiamonds);
+    profiler.addCount("if-conversion triangles", numTriangles);
+    profiler.addCount("selects from phis", numSelects);
+    return numDiamonds + numTriangles > 0;
+}
+
+
+unsigned int IfConversionPass::getCost(const Instruction& inst) {
+    switch (inst.getOpcode())
+    {
+        case Instruction::Mul:
+        case Instruction::FCmp:
+            return 2;
+        case Instruction::FAdd:
+        case Instruction::FSub:
+        case Instruction::FMul:
+            return 4;
+        case Instruction::UDiv:
+        case Instruction::SDiv:
+        case Instruction::URem:
+        case Instruction::SRem:
+        case Instruction::FDiv:
+        case Instruction::FRem:
+            return 8;
+        default:
+            return 1;
+    }
+}
+
+
+bool IfConversionPass::canSpeculate(const BasicBlock* side, unsigned int& cost) {
+    cost = 0;
+    if (side->size() > maxInstructions + 1) return false;
+    const BranchInst* branch = dyn_cast<BranchInst>(side->getTerminator());
+    if (branch == nullptr or branch->isConditional()) return false;
+    for (const Instruction& inst : *side) {
+        if (&inst == branch) break;
+        if (isa<PHINode>(inst) or inst.mayReadOrWriteMemory() or inst.mayHaveSideEffects() or
+            !isSafeToSpeculativelyExecute(&inst))
+        {
+            return false;
+        }
+        cost += getCost(inst);
+    }
+    return true;
+}
+
+
+bool IfConversionPass::convertRegion(BasicBlock* head) {
+    BranchInst* branch = dyn_cast<BranchInst>(head->getTerminator());
+    if (branch == nullptr or branch->isUnconditional()) return false;
+    BasicBlock* succs[2] = {branch->getSuccessor(0), branch->getSuccessor(1)};
+    if (succs[0] == succs[1]) return false;
+    /* A successor can be a side if the branch is its only way in. Its single successor is
+        the join, that is either the one of the other side or the other successor */
+    BasicBlock* nexts[2] = {nullptr, nullptr};
+    for (unsigned int i = 0; i < 2; ++i) {
+        if (succs[i] == head or succs[i]->getSinglePredecessor() != head) continue;
+        nexts[i] = succs[i]->getSingleSuccessor();
+    }
+    // Side of the true and false successors, nullptr when it is the join
+    BasicBlock* sides[2] = {nullptr, nullptr};
+    BasicBlock* join;
+    if (nexts[0] != nullptr and nexts[0] == nexts[1]) {
+        sides[0] = succs[0];
+        sides[1] = succs[1];
+        join = nexts[0];
+    }
+    else if (nexts[0] != nullptr and nexts[0] == succs[1]) {
+        sides[0] = succs[0];
+        join = succs[1];
+    }
+    else if (nexts[1] != nullptr and nexts[1] == succs[0]) {
+        sides[1] = succs[1];
+        join = succs[0];
+    }
+    else return false;
+    if (join == head or join == sides[0] or join == sides[1]) return false;
+    bool diamond = sides[0] != nullptr and sides[1] != nullptr;
+
+    double probabilities[2] = {0.5, 0.5};
+    uint64_t trueWeight, falseWeight;
+    if (branch->extractProfMetadata(trueWeight, falseWeight) and
+        trueWeight + falseWeight > 0)
+    {
+        probabilities[0] = (double)trueWeight / (trueWeight + falseWeight);
+        probabilities[1] = 1 - probabilities[0];
+    }
+    double cost = 0;
+    for (unsigned int i = 0; i < 2; ++i) {
+        if (sides[i] == nullptr) continue;
+        unsigned int sideCost;
+        if (!canSpeculate(sides[i], sideCost)) return false;
+        cost += (1 - probabilities[i]) * sideCost;
+    }
+    if (cost > costThreshold) return false;
+
+    for (unsigned int i = 0; i < 2; ++i) {
+        if (sides[i] == nullptr) continue;
+        for (Instruction& inst : make_early_inc_range(*sides[i])) {
+            if (inst.isTerminator()) break;
+            inst.moveBefore(branch);
+        }
+    }
+    // Each phi of the join takes the value of the side the condition selects
+    Value* condition = branch->getCondition();
+    for (PHINode& phi : join->phis()) {
+        Value* values[2];
+        for (unsigned int i = 0; i < 2; ++i) {
+            values[i] = phi.getIncomingValueForBlock(sides[i] != nullptr ? sides[i] : head);
+        }
+        Value* selected = values[0];
+        if (values[0] != values[1]) {
+            selected = SelectInst::Create(condition, values[0], values[1],
+                phi.getName() + ".sel", branch);
+            ++numSelects;
+        }
+        for (unsigned int i = 0; i < 2; ++i) {
+            if (sides[i] != nullptr) phi.removeIncomingValue(sides[i], false);
+        }
+        if (diamond) phi.addIncoming(selected, head);
+        else phi.setIncomingValueForBlock(head, selected);
+    }
+    BranchInst::Create(join, head);
+    branch->eraseFromParent();
+    for (unsigned int i = 0; i < 2; ++i) {
+        if (sides[i] == nullptr) continue;
+        sides[i]->dropAllReferences();
+        sides[i]->eraseFromParent();
+    }
+    if (diamond) ++numDiamonds;
+    else ++numTriangles;
+    // Fewer BB are fewer control blocks in the graph
+    if (join->getSinglePredecessor() == head) MergeBlockIntoPredecessor(join);
+    return true;
+}
+
+
+static RegisterPass<IfConversionPass> registerIfConversionPass("ifConversionPass",
+    "Convert small if-then-else regions into selects for DFGraphPass",
+    false /* Only looks at CFG */,
+    false /* Analysis Pass */);
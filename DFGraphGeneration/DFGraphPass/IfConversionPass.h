@@ -0,0 +1,61 @@
+#ifndef IFCONVERSIONPASS_H
+#define IFCONVERSIONPASS_H
+
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/Pass.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Support/CommandLine.h"
+#include "../../LiveVarsAnalysis/LiveVarsPass/PassProfiler.h"
+
+using namespace std;
+using namespace llvm;
+
+
+/* Turns the small if-then-else regions of a function into code without branches, so
+    DFGraphPass builds them as a datapath that ends in Select blocks instead of a Branch
+    for each live value and a Merge for each one at the join. The regions are diamonds,
+    a BB with a conditional branch whose two successors go to the same BB, and triangles,
+    where one of the successors is the join itself. Each side has to be a single BB without
+    memory accesses, calls or instructions that cannot be executed speculatively.
+
+    Both sides are executed every time, and the Select waits for both of them, so the
+    operators of the side that is not taken are the price. Each side costs the sum of its
+    operators, by their latency relative to an adder, times the probability of not taking
+    it, from the branch weights of the IR when there are and 1/2 when not. The region is
+    converted if the sum of both is at most -if-conversion-threshold. The regions nested
+    inside a side are converted first, and then the side can be converted too.
+
+    It changes the IR, so it runs before DFGraphPass, e.g.
+    opt -gepPass -ifConversionPass -dfGraphPass */
+class IfConversionPass : public FunctionPass {
+
+public:
+
+    static char ID;
+
+    IfConversionPass();
+    ~IfConversionPass();
+
+    bool runOnFunction(Function &F) override;
+
+    // Latency of the operator of an instruction relative to an adder
+    static unsigned int getCost(const Instruction& inst);
+
+private:
+
+    unsigned int numDiamonds;
+    unsigned int numTriangles;
+    unsigned int numSelects;
+
+    // The cost of the side when all its instructions can be executed speculatively
+    bool canSpeculate(const BasicBlock* side, unsigned int& cost);
+    // Converts the region that starts with the branch of the BB, if it is worth it
+    bool convertRegion(BasicBlock* head);
+
+};
+
+
+#endif // IFCONVERSIONPASS_H
@@ -0,0 +1,187 @@
+#include "MemoryDependences.h"
+#include "llvm/Analysis/MemoryLocation.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/SCCIterator.h"
+
+
+MemoryDependences::MemoryDependences(const Function& F, AAResults& AA, MemorySSA& MSSA,
+    bool useQueue) : numOrdered(0), numUnordered(0)
+{
+    if (useQueue) findQueued(F, AA);
+    for (const BasicBlock& BB : F.getBasicBlockList()) orderBB(BB, AA, MSSA);
+}
+
+MemoryDependences::~MemoryDependences() {}
+
+
+const vector <const Instruction*>& MemoryDependences::getPredecessors(
+    const Instruction* inst) const
+{
+    DenseMap <const Instruction*, vector <const Instruction*> >::const_iterator it =
+        predecessors.find(inst);
+    if (it == predecessors.end()) return noPredecessors;
+    return it->second;
+}
+
+bool MemoryDependences::isQueued(const Instruction* inst) const {
+    return queued.count(inst) > 0;
+}
+
+unsigned int MemoryDependences::getNumOrdered() const {
+    return numOrdered;
+}
+
+unsigned int MemoryDependences::getNumUnordered() const {
+    return numUnordered;
+}
+
+unsigned int MemoryDependences::getNumQueued() const {
+    return queued.size();
+}
+
+
+const Value* MemoryDependences::getLoweredBase(const Value* address) {
+    const IntToPtrInst* intToPtr = dyn_cast<IntToPtrInst>(address);
+    if (intToPtr == nullptr) return nullptr;
+    // The offsets of the lowered GEP are added one by one to the pointer
+    const Value* value = intToPtr->getOperand(0);
+    const unsigned int maxAdditions = 16;
+    for (unsigned int i = 0; i < maxAdditions; ++i) {
+        if (const PtrToIntInst* ptrToInt = dyn_cast<PtrToIntInst>(value)) {
+            return ptrToInt->getPointerOperand();
+        }
+        const llvm::BinaryOperator* add = dyn_cast<llvm::BinaryOperator>(value);
+        if (add == nullptr or add->getOpcode() != Instruction::Add) return nullptr;
+        if (isa<PtrToIntInst>(add->getOperand(1))) value = add->getOperand(1);
+        else value = add->getOperand(0);
+    }
+    return nullptr;
+}
+
+AliasResult MemoryDependences::alias(AAResults& AA, const MemoryLocation& location,
+    const Value* base, const MemoryLocation& otherLocation, const Value* otherBase)
+{
+    AliasResult result = AA.alias(location, otherLocation);
+    if (result == AliasResult::NoAlias) return result;
+    if (base != nullptr and otherBase != nullptr and base != otherBase and
+        AA.alias(MemoryLocation::getBeforeOrAfter(base),
+        MemoryLocation::getBeforeOrAfter(otherBase)) == AliasResult::NoAlias)
+    {
+        return AliasResult::NoAlias;
+    }
+    return result;
+}
+
+
+void MemoryDependences::findQueued(const Function& F, AAResults& AA) {
+    // In a BB of a cycle an access can conflict with the ones of the next iteration
+    SmallPtrSet <const BasicBlock*, 16> cyclic;
+    for (scc_iterator <const Function*> it = scc_begin(&F); !it.isAtEnd(); ++it) {
+        if (!it.hasCycle()) continue;
+        for (const BasicBlock* BB : *it) cyclic.insert(BB);
+    }
+    vector <const Instruction*> accesses;
+    vector <MemoryLocation> locations;
+    vector <const Value*> bases;
+    for (const BasicBlock& BB : F.getBasicBlockList()) {
+        for (const Instruction& inst : BB) {
+            if (const LoadInst* load = dyn_cast<LoadInst>(&inst)) {
+                locations.push_back(MemoryLocation::get(load));
+            }
+            else if (const StoreInst* store = dyn_cast<StoreInst>(&inst)) {
+                locations.push_back(MemoryLocation::get(store));
+            }
+            else continue;
+            accesses.push_back(&inst);
+            bases.push_back(getLoweredBase(locations.back().Ptr));
+        }
+    }
+    // Conflicts of each access, and the ones the queue starts from
+    vector <vector <unsigned int> > conflicts(accesses.size());
+    vector <unsigned int> pending;
+    vector <bool> found(accesses.size(), false);
+    for (unsigned int i = 0; i < accesses.size(); ++i) {
+        const BasicBlock* BB = accesses[i]->getParent();
+        for (unsigned int j = 0; j < i; ++j) {
+            if (!isa<StoreInst>(accesses[i]) and !isa<StoreInst>(accesses[j])) continue;
+            if (alias(AA, locations[i], bases[i], locations[j], bases[j]) ==
+                AliasResult::NoAlias)
+            {
+                continue;
+            }
+            conflicts[i].push_back(j);
+            conflicts[j].push_back(i);
+            if (accesses[j]->getParent() != BB or cyclic.count(BB)) {
+                if (!found[i]) pending.push_back(i);
+                if (!found[j]) pending.push_back(j);
+                found[i] = found[j] = true;
+            }
+        }
+    }
+    // The order of the queue is not known by the channels, so their conflicts go too
+    for (unsigned int i = 0; i < pending.size(); ++i) {
+        queued.insert(accesses[pending[i]]);
+        for (unsigned int conflict : conflicts[pending[i]]) {
+            if (found[conflict]) continue;
+            found[conflict] = true;
+            pending.push_back(conflict);
+        }
+    }
+}
+
+
+void MemoryDependences::orderBB(const BasicBlock& BB, AAResults& AA, MemorySSA& MSSA) {
+    const MemorySSA::AccessList* accessList = MSSA.getBlockAccesses(&BB);
+    if (accessList == nullptr) return;
+    MemorySSAWalker* walker = MSSA.getWalker();
+    // Loads and stores already seen, and the ones ordered before each of them
+    vector <const Instruction*> accesses;
+    vector <MemoryLocation> locations;
+    vector <const Value*> bases;
+    vector <BitVector> ordered;
+    for (const MemoryAccess& access : *accessList) {
+        if (isa<MemoryPhi>(access)) continue;
+        const Instruction* inst = cast<MemoryUseOrDef>(access).getMemoryInst();
+        if (!isa<LoadInst>(inst) and !isa<StoreInst>(inst)) {
+            // Calls are triggered by the control of the BB, not by the memory accesses
+            ++numUnordered;
+            continue;
+        }
+        if (queued.count(inst)) continue;
+        bool write = isa<StoreInst>(inst);
+        MemoryLocation location = (write ? MemoryLocation::get(cast<StoreInst>(inst)) :
+            MemoryLocation::get(cast<LoadInst>(inst)));
+        MemoryAccess* clobber = walker->getClobberingMemoryAccess(MSSA.getMemoryAccess(inst));
+        if (!MSSA.isLiveOnEntryDef(clobber) and
+            (isa<MemoryPhi>(clobber) or clobber->getBlock() != &BB))
+        {
+            ++numUnordered;
+        }
+        const Value* base = getLoweredBase(location.Ptr);
+        BitVector before(accesses.size());
+        vector <const Instruction*>& preds = predecessors[inst];
+        for (unsigned int i = accesses.size(); i-- > 0; ) {
+            bool otherWrite = isa<StoreInst>(accesses[i]);
+            if (!write and !otherWrite) continue;
+            AliasResult result = alias(AA, location, base, locations[i], bases[i]);
+            if (result == AliasResult::NoAlias) continue;
+            if (!before.test(i)) {
+                preds.push_back(accesses[i]);
+                before.set(i);
+                before |= ordered[i];
+                ++numOrdered;
+            }
+            // Nothing before a store to the same location can be seen or overwritten
+            if (otherWrite and result == AliasResult::MustAlias and
+                locations[i].Size == location.Size)
+            {
+                break;
+            }
+        }
+        if (preds.empty()) predecessors.erase(inst);
+        accesses.push_back(inst);
+        locations.push_back(location);
+        bases.push_back(base);
+        ordered.push_back(before);
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef MEMORYDEPENDENCES_H
+#define MEMORYDEPENDENCES_H
+
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Analysis/MemorySSA.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include <vector>
+
+using namespace std;
+using namespace llvm;
+
+
+/* Loads and stores of a BB that have to be ordered, because they may access the same
+    address and at least one of them writes. The accesses of each BB are taken in the
+    order of MemorySSA, and each one is compared with alias analysis with the ones before
+    it, up to a store that writes the same location. Only the closest ones are kept: an
+    access that is already ordered through another one is not a predecessor.
+    GetElemPtrPass leaves the addresses as integer additions to the pointer they come from,
+    that alias analysis cannot follow, so the pointers are found and compared too.
+
+    Everything is computed in the constructor, as the analyses of a function are only
+    valid until the ones of another function are requested, and after that it is only
+    read, so the builders of the graphs can use it from different threads.
+
+    The conflicts that cannot be ordered this way, with accesses of other BB or between
+    iterations of a loop (when the BB is in a cycle of the CFG), are left to a load-store
+    queue: the accesses with one of them, and the ones that conflict with those, are
+    queued, and they are not ordered with channels. Without the queue, and for the
+    conflicts with calls, they are only counted */
+class MemoryDependences {
+
+public:
+
+    MemoryDependences(const Function& F, AAResults& AA, MemorySSA& MSSA,
+        bool useQueue = false);
+    ~MemoryDependences();
+
+    // Accesses of the same BB that have to finish before the one given, from the closest
+    const vector <const Instruction*>& getPredecessors(const Instruction* inst) const;
+
+    // Accesses that go through the load-store queue of the function
+    bool isQueued(const Instruction* inst) const;
+
+    unsigned int getNumOrdered() const;
+    unsigned int getNumUnordered() const;
+    unsigned int getNumQueued() const;
+
+private:
+
+    DenseMap <const Instruction*, vector <const Instruction*> > predecessors;
+    vector <const Instruction*> noPredecessors;
+    unsigned int numOrdered;
+    unsigned int numUnordered;
+    SmallPtrSet <const Instruction*, 16> queued;
+
+    void findQueued(const Function& F, AAResults& AA);
+    void orderBB(const BasicBlock& BB, AAResults& AA, MemorySSA& MSSA);
+
+    // Pointer an address computed as inttoptr(ptrtoint(base) + offset) comes from
+    static const Value* getLoweredBase(const Value* address);
+    // NoAlias also when the lowered addresses come from pointers that do not alias
+    static AliasResult alias(AAResults& AA, const MemoryLocation& location,
+        const Value* base, const MemoryLocation& otherLocation, const Value* otherBase);
+
+};
+
+
+#endif // MEMORYDEPENDENCES_H
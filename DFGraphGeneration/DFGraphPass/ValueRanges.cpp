@@ -0,0 +1,38 @@
+#include "ValueRanges.h"
+#include "llvm/IR/ConstantRange.h"
+
+
+ValueRanges::ValueRanges(const Function& F, LazyValueInfo& LVI, ScalarEvolution& SE) {
+    for (const BasicBlock& BB : F.getBasicBlockList()) {
+        for (const Instruction& inst : BB) {
+            IntegerType* type = dyn_cast<IntegerType>(inst.getType());
+            // Phis become merges, that take the widths of what enters them
+            if (type == nullptr or type->getBitWidth() == 1 or isa<PHINode>(inst)) continue;
+            Instruction* context = const_cast<Instruction*>(&inst);
+            ConstantRange range = LVI.getConstantRange(context, context, false);
+            // Both ranges hold every value, so the value is also in their intersection
+            const SCEV* expression = SE.getSCEV(context);
+            range = range.intersectWith(SE.getUnsignedRange(expression));
+            range = range.intersectWith(SE.getSignedRange(expression));
+            unsigned int width = getNeededBits(range.getUnsignedMax(),
+                range.isAllNonNegative());
+            if (width > 0 and width < type->getBitWidth()) widths[&inst] = width;
+        }
+    }
+}
+
+ValueRanges::~ValueRanges() {}
+
+
+unsigned int ValueRanges::getWidth(const Value* value) const {
+    return widths.lookup(value);
+}
+
+unsigned int ValueRanges::getNumNarrowed() const {
+    return widths.size();
+}
+
+unsigned int ValueRanges::getNeededBits(const APInt& maxValue, bool nonNegative) {
+    if (!nonNegative) return 0;
+    return maxValue.getActiveBits() + 1;
+}
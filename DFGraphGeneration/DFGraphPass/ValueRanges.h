@@ -0,0 +1,44 @@
+#ifndef VALUERANGES_H
+#define VALUERANGES_H
+
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Analysis/LazyValueInfo.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/ADT/DenseMap.h"
+
+using namespace std;
+using namespace llvm;
+
+
+/* Widths that the integer values of a function need, from the ranges LazyValueInfo finds
+    for them (like the bits an and keeps, or the bounds a comparison sets in a BB) and
+    the ones of ScalarEvolution, that also bounds the counters of the loops with the
+    number of iterations, where LazyValueInfo gives up at the cycle of the phi.
+    Only the values that are never negative are narrowed, to the bits of their highest
+    value and a 0 on top, so they can be extended again with zeros or with their sign.
+
+    As MemoryDependences, everything is computed in the constructor and then only read,
+    so the builders of the graphs can use it from different threads */
+class ValueRanges {
+
+public:
+
+    ValueRanges(const Function& F, LazyValueInfo& LVI, ScalarEvolution& SE);
+    ~ValueRanges();
+
+    // Width of the value, 0 if it is not narrower than its type
+    unsigned int getWidth(const Value* value) const;
+    unsigned int getNumNarrowed() const;
+
+    // Bits of a value that is never negative and its 0 on top, 0 if it can be negative
+    static unsigned int getNeededBits(const APInt& maxValue, bool nonNegative);
+
+private:
+
+    DenseMap <const Value*, unsigned int> widths;
+
+};
+
+
+#endif // VALUERANGES_H
@@ -0,0 +1,290 @@
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include "DotReader.h"
+#include "BinaryGraph.h"
+#include "BufferPlacement.h"
+#include "TimingAnalysis.h"
+#include "ThroughputAnalysis.h"
+#include "OperatorLibrary.h"
+#include "WidthMinimization.h"
+#include "GraphCleanup.h"
+#include <set>
+#include <unordered_set>
+#include <cstdlib>
+
+using namespace std;
+using namespace DFGraphComp;
+
+
+/* Reads a graph saved in a DOT file by DFGraphPass (or written by hand following
+    Dataflow.md) and writes it again, in DOT or in the binary format, depending on
+    the extension of the output file. With -clock-period the buffers are placed as
+    DFGraphPass does, cutting the paths longer than the period given. With -timing the
+    cycle period and the critical path of each function are printed, and with
+    -timing-channels also the arrival time and slack of every channel. With -throughput
+    the critical cycle of each strongly connected component is printed. With
+    -operator-library the latency, II and delay of the operators are taken from the table
+    given (see OperatorLibrary.h) before anything else is done. With -minimize-widths the
+    widths of the operators and constants are propagated through the blocks that carry
+    their values, before the operators are characterized (the ranges of the IR that
+    DFGraphPass also uses are not in the file). With -cleanup the blocks whose values are not
+    used and the forks of a single output are removed first, and the outputs left free
+    are connected to sinks.
+
+    Usage: dfgraph-tool input.dot [-cleanup] [-minimize-widths] [-operator-library table]
+        [-clock-period N] [-timing] [-timing-channels] [-throughput]
+        [-o output.dot|output.dfg] */
+
+
+static void printUsage() {
+    cerr << "Usage: dfgraph-tool input.dot [-cleanup] [-minimize-widths] "
+        "[-operator-library table] "
+        "[-clock-period N] [-timing] [-timing-channels] [-throughput] "
+        "[-o output.dot|output.dfg]" << endl;
+}
+
+static bool endsWith(const string& text, const string& suffix) {
+    return text.size() >= suffix.size() and
+        text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/* The blocks added after reading the file, from the number of blocks each graph had, get
+    the first numbers of their kind not used in the file */
+static void nameNewBlocks(DotReader& reader, const vector <unsigned int>& numReadBlocks) {
+    set <string> names;
+    for (unsigned int i = 0; i < reader.getNumGraphs(); ++i) {
+        const vector <Block*>& blocks = reader.getGraph(i).getCreatedBlocks();
+        for (unsigned int j = 0; j < numReadBlocks[i]; ++j) {
+            names.insert(blocks[j]->getBlockName());
+        }
+    }
+    map <string, unsigned int> counters;
+    for (unsigned int i = 0; i < reader.getNumGraphs(); ++i) {
+        const vector <Block*>& blocks = reader.getGraph(i).getCreatedBlocks();
+        for (unsigned int j = numReadBlocks[i]; j < blocks.size(); ++j) {
+            unsigned int& counter = counters[blocks[j]->getNamePrefix()];
+            do {
+                blocks[j]->setInstanceNumber(++counter);
+            } while (names.count(blocks[j]->getBlockName()));
+            names.insert(blocks[j]->getBlockName());
+        }
+    }
+}
+
+// Groups of graphs linked by their calls, that the buffers and the analyses see as a whole
+static vector <vector <FunctionGraph*> > getLinkedGraphs(DotReader& reader) {
+    vector <FunctionGraph*> graphs;
+    for (unsigned int i = 0; i < reader.getNumGraphs(); ++i) {
+        graphs.push_back(&reader.getGraph(i));
+    }
+    vector <vector <unsigned int> > groups = ChannelGraph::findLinkedGraphs(graphs);
+    vector <vector <FunctionGraph*> > linkedGraphs(groups.size());
+    for (unsigned int i = 0; i < groups.size(); ++i) {
+        for (unsigned int j = 0; j < groups[i].size(); ++j) {
+            linkedGraphs[i].push_back(graphs[groups[i][j]]);
+        }
+    }
+    return linkedGraphs;
+}
+
+static void cleanGraphs(DotReader& reader) {
+    unsigned int numRemoved = 0;
+    unsigned int numCollapsed = 0;
+    unsigned int numSinks = 0;
+    unordered_set <Block*> readBlocks;
+    for (unsigned int i = 0; i < reader.getNumGraphs(); ++i) {
+        const vector <Block*>& blocks = reader.getGraph(i).getCreatedBlocks();
+        readBlocks.insert(blocks.begin(), blocks.end());
+    }
+    // A block fed from another graph goes with its producer, so the linked graphs go together
+    vector <vector <FunctionGraph*> > linkedGraphs = getLinkedGraphs(reader);
+    for (unsigned int i = 0; i < linkedGraphs.size(); ++i) {
+        GraphCleanup cleanup(linkedGraphs[i]);
+        cleanup.cleanGraph();
+        numRemoved += cleanup.getNumBlocksRemoved();
+        numCollapsed += cleanup.getNumForksCollapsed();
+        numSinks += cleanup.getNumSinks();
+    }
+    // The sinks are the last blocks created in the graph they were placed in
+    vector <unsigned int> numReadBlocks;
+    for (unsigned int i = 0; i < reader.getNumGraphs(); ++i) {
+        const vector <Block*>& blocks = reader.getGraph(i).getCreatedBlocks();
+        unsigned int numRead = 0;
+        while (numRead < blocks.size() and readBlocks.count(blocks[numRead])) ++numRead;
+        numReadBlocks.push_back(numRead);
+    }
+    nameNewBlocks(reader, numReadBlocks);
+    cout << "Blocks removed: " << numRemoved << ", forks collapsed: " << numCollapsed <<
+        ", sinks inserted: " << numSinks << endl;
+}
+
+static void minimizeWidths(DotReader& reader) {
+    unsigned int numPorts = 0;
+    unsigned int numBits = 0;
+    for (unsigned int i = 0; i < reader.getNumGraphs(); ++i) {
+        WidthMinimization minimization(reader.getGraph(i));
+        minimization.minimizeWidths();
+        numPorts += minimization.getNumPortsNarrowed();
+        numBits += minimization.getNumBitsRemoved();
+    }
+    cout << "Ports narrowed: " << numPorts << " (" << numBits << " bits)" << endl;
+}
+
+static bool characterizeOperators(DotReader& reader, const string& libraryName) {
+    OperatorLibrary library;
+    if (!library.readFile(libraryName)) {
+        cerr << libraryName << ": " << library.getError() << endl;
+        return false;
+    }
+    unsigned int numFound = 0;
+    for (unsigned int i = 0; i < reader.getNumGraphs(); ++i) {
+        numFound += library.characterize(reader.getGraph(i));
+    }
+    cout << "Operators characterized: " << numFound << endl;
+    return true;
+}
+
+static void placeBuffers(DotReader& reader, double clockPeriod) {
+    unsigned int numOpaque = 0;
+    unsigned int numTiming = 0;
+    unsigned int numTransparent = 0;
+    vector <unsigned int> numReadBlocks;
+    for (unsigned int i = 0; i < reader.getNumGraphs(); ++i) {
+        numReadBlocks.push_back(reader.getGraph(i).getCreatedBlocks().size());
+    }
+    vector <vector <FunctionGraph*> > linkedGraphs = getLinkedGraphs(reader);
+    for (unsigned int i = 0; i < linkedGraphs.size(); ++i) {
+        BufferPlacement placement(linkedGraphs[i], clockPeriod);
+        placement.placeBuffers();
+        numOpaque += placement.getNumOpaqueBuffers();
+        numTiming += placement.getNumTimingBuffers();
+        numTransparent += placement.getNumTransparentBuffers();
+        if (placement.getNumTimingViolations() > 0) {
+            cerr << "Warning: " << placement.getNumTimingViolations() << " blocks of " <<
+                linkedGraphs[i][0]->getFunctionName();
+            if (linkedGraphs[i].size() > 1) cerr << " and the functions linked to it";
+            cerr << " are slower than the clock period" << endl;
+        }
+    }
+    nameNewBlocks(reader, numReadBlocks);
+    cout << "Buffers placed: " << numOpaque << " opaque (" << numTiming << 
+        " for the clock period), " << numTransparent << " transparent" << endl;
+}
+
+static void printTiming(DotReader& reader, double clockPeriod, bool printChannels) {
+    vector <vector <FunctionGraph*> > linkedGraphs = getLinkedGraphs(reader);
+    for (unsigned int i = 0; i < linkedGraphs.size(); ++i) {
+        TimingAnalysis timing(linkedGraphs[i]);
+        timing.analyze(clockPeriod);
+        timing.printReport(cout, printChannels);
+    }
+}
+
+static void printThroughput(DotReader& reader) {
+    vector <vector <FunctionGraph*> > linkedGraphs = getLinkedGraphs(reader);
+    for (unsigned int i = 0; i < linkedGraphs.size(); ++i) {
+        ThroughputAnalysis throughput(linkedGraphs[i]);
+        throughput.analyze();
+        throughput.printReport(cout);
+    }
+}
+
+static void writeDot(DotReader& reader, ofstream& file) {
+    DotBuffer buffer;
+    buffer << "digraph \"" << reader.getGraphName() << "\" {\n";
+    buffer << "\tlabel=\"" << reader.getGraphName() << "\";\n";
+    for (unsigned int i = 0; i < reader.getNumGraphs(); ++i) {
+        buffer << '\n';
+        reader.getGraph(i).printNodes(buffer);
+    }
+    for (unsigned int i = 0; i < reader.getNumGraphs(); ++i) {
+        buffer << '\n';
+        reader.getGraph(i).printEdges(buffer);
+    }
+    buffer << "\n}\n";
+    buffer.writeTo(file);
+}
+
+static void writeBinary(DotReader& reader, ofstream& file) {
+    BinaryGraphWriter writer;
+    for (unsigned int i = 0; i < reader.getNumGraphs(); ++i) {
+        writer.addFunction(reader.getGraph(i));
+    }
+    writer.write(file);
+}
+
+int main(int argc, char* argv[]) {
+    string inputName;
+    string outputName;
+    string libraryName;
+    double clockPeriod = 0;
+    bool timing = false;
+    bool timingChannels = false;
+    bool throughput = false;
+    bool widths = false;
+    bool cleanup = false;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "-o" and i + 1 < argc) outputName = argv[++i];
+        else if (arg == "-operator-library" and i + 1 < argc) libraryName = argv[++i];
+        else if (arg == "-clock-period" and i + 1 < argc) {
+            clockPeriod = atof(argv[++i]);
+            if (clockPeriod <= 0) {
+                printUsage();
+                return 1;
+            }
+        }
+        else if (arg == "-cleanup") cleanup = true;
+        else if (arg == "-minimize-widths") widths = true;
+        else if (arg == "-timing") timing = true;
+        else if (arg == "-timing-channels") timingChannels = true;
+        else if (arg == "-throughput") throughput = true;
+        else if (inputName.empty() and arg[0] != '-') inputName = arg;
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (inputName.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    DotReader reader;
+    if (!reader.readFile(inputName)) {
+        cerr << inputName << ": " << reader.getError() << endl;
+        return 1;
+    }
+    unsigned int numBlocks = 0;
+    for (unsigned int i = 0; i < reader.getNumGraphs(); ++i) {
+        FunctionGraph& graph = reader.getGraph(i);
+        for (unsigned int j = 0; j < graph.getNumBBs(); ++j) {
+            numBlocks += graph.getBB(j).getBlocks().size();
+            numBlocks += graph.getBB(j).getControlBlocks().size();
+        }
+        vector <Block*> outerBlocks;
+        graph.getOuterBlocks(outerBlocks);
+        numBlocks += outerBlocks.size();
+    }
+    cout << inputName << ": " << reader.getNumGraphs() << " functions, " << numBlocks <<
+        " blocks, " << reader.getNumChannels() << " channels" << endl;
+    if (cleanup) cleanGraphs(reader);
+    if (widths) minimizeWidths(reader);
+    if (!libraryName.empty() and !characterizeOperators(reader, libraryName)) return 1;
+    if (clockPeriod > 0) placeBuffers(reader, clockPeriod);
+    if (timing or timingChannels) printTiming(reader, clockPeriod, timingChannels);
+    if (throughput) printThroughput(reader);
+
+    if (outputName.empty()) return 0;
+    bool binary = endsWith(outputName, ".dfg");
+    ofstream file(outputName, binary ? ios::out | ios::binary : ios::out);
+    if (!file.is_open()) {
+        cerr << "Cannot open " << outputName << endl;
+        return 1;
+    }
+    if (binary) writeBinary(reader, file);
+    else writeDot(reader, file);
+    return 0;
+}
@@ -9,6 +9,7 @@
 #include "llvm/PassRegistry.h"
 #include "llvm/IR/GetElementPtrTypeIterator.h"
 #include "llvm/IR/IRBuilder.h"
+#include "../../LiveVarsAnalysis/LiveVarsPass/PassProfiler.h"
 
 using namespace llvm;
 
@@ -19,6 +20,8 @@ struct GetElemPtrPass : public FunctionPass {
     GetElemPtrPass() : FunctionPass(ID) {}
 
     bool runOnFunction(Function &F) override {
+        PassProfiler::Scope scope("GetElemPtrPass", F.getName());
+        unsigned int numLowered = 0;
         DataLayout DL(F.getParent());
         for (Function::iterator it = F.begin(); it != F.end(); ++it) {
             BasicBlock::iterator it2 = it->begin();
@@ -89,10 +92,12 @@ struct GetElemPtrPass : public FunctionPass {
                     ++it2;
                     inst->replaceAllUsesWith(resultPtr);
                     inst->eraseFromParent();
+                    numLowered++;
                 }
                 else ++it2;
             }
         }
+        PassProfiler::get().addCount("GEPs lowered", numLowered);
         return true;
     }
 };
@@ -1,176 +1,351 @@
-
 #include "LiveVarsPass.h"
 
+#define DEBUG_TYPE "liveVarsPass"
 
-char LiveVarsPass::ID = 0;
+STATISTIC(NumBBIterations, "Number of BB transfer functions evaluated by the liveness solver");
 
-// Public Functions
+static cl::opt <unsigned int> numThreads("live-vars-threads",
+    cl::desc("Threads used to analyse the functions (0 to use all the cores)"),
+    cl::init(0));
 
-LiveVarsPass::LiveVarsPass() : FunctionPass(ID) {}
+static cl::opt <bool> dumpLiveVars("live-vars-dump",
+    cl::desc("Write the live variables of each function to <file>_<function>_LiveVariables.txt"),
+    cl::init(false));
 
 
-LiveVarsPass::~LiveVarsPass() {}
+/*
+ * =================================
+ *  Class FunctionLiveVars
+ * =================================
+*/
 
 
-string LiveVarsPass::getInputFileName() {
-    return inputFileName;
+FunctionLiveVars::FunctionLiveVars(const Function& F) {
+    this->F = &F;
+    numIterations = 0;
 }
 
 
-StringRef LiveVarsPass::getFuncName() {
-    return funcName;
-}
+FunctionLiveVars::~FunctionLiveVars() {}
 
 
-bool LiveVarsPass::runOnFunction(Function &F) {
-    if (inputFileName.empty()) {
-        inputFileName = F.getParent()->getModuleIdentifier();
-        inputFileName = inputFileName.substr(0, inputFileName.size()-3);
+void FunctionLiveVars::analyze() {
+    PassProfiler::HeapPeak heapPeak(F->getName());
+    {
+        PassProfiler::Scope scope("Liveness uses and defs", F->getName());
+        numberValues();
+        unsigned int BBNum;
+        for (Function::const_iterator bb_it = F->begin(); bb_it != F->end(); ++bb_it) {
+            BBNum = BBNumbers[&(*bb_it)];
+            computeUsesDefs(*bb_it, uses[BBNum], defs[BBNum]);
+            if (&(*(bb_it->begin())) != bb_it->getFirstNonPHI()) {
+                processPhiUses(*bb_it);
+            }
+        }
+        heapPeak.sample();
     }
-    else { // Reset maps for other functions in the LLVM files
-        liveInVars.clear(); 
-        liveOutVars.clear();
-        phiConstants.clear();
+    {
+        PassProfiler::Scope scope("Liveness fixpoint", F->getName());
+        solveLiveness();
     }
-    setCurrentFunc(F);
-    map <StringRef, set<const Value*> > uses;
-    map <StringRef, set<const Value*> > defs;
-    StringRef BBName;
-    for (Function::const_iterator bb_it = F.begin(); bb_it != F.end(); ++bb_it) {
-        BBName = bb_it->getName();
-        uses.insert(make_pair(BBName, set<const Value*>()));
-        defs.insert(make_pair(BBName, set<const Value*>()));
-        computeUsesDefs(*bb_it, uses[BBName], defs[BBName]);
-        if (&(*(bb_it->begin())) != bb_it->getFirstNonPHI()) {
-            processPhiUses(*bb_it);
+    PassProfiler::get().addCount("liveness BB iterations", numIterations);
+    // All the sets are still alive, it is the most the analysis uses
+    heapPeak.sample();
+    // Only the live sets are needed afterwards
+    uses.clear();
+    defs.clear();
+}
+
+
+const Function& FunctionLiveVars::getFunction() {
+    return *F;
+}
+
+
+unsigned int FunctionLiveVars::getNumValues() {
+    return values.size();
+}
+
+
+unsigned int FunctionLiveVars::getValueNumber(const Value* value) {
+    DenseMap <const Value*, unsigned int>::const_iterator it = valueNumbers.find(value);
+    assert(it != valueNumbers.end() && "Value not numbered in the function");
+    return it->second;
+}
+
+
+const Value* FunctionLiveVars::getValue(unsigned int valueNumber) {
+    assert(valueNumber < values.size() && "Wrong value number");
+    return values[valueNumber];
+}
+
+
+const BitVector& FunctionLiveVars::getLiveInBits(const BasicBlock* BB) {
+    return livesIn[getBBNumber(BB)];
+}
+
+
+const BitVector& FunctionLiveVars::getLiveOutBits(const BasicBlock* BB) {
+    return livesOut[getBBNumber(BB)];
+}
+
+
+const vector <pair <const PHINode*, unsigned int> >& FunctionLiveVars::getPhiConstants(
+    const BasicBlock* BB)
+{
+    return phiConstants[getBBNumber(BB)];
+}
+
+
+unsigned int FunctionLiveVars::getNumIterations() {
+    return numIterations;
+}
+
+
+void FunctionLiveVars::printLiveVars(const string& fileName) {
+    ofstream file;
+    file.open(fileName);
+    unsigned int BBNum;
+    for (Function::const_iterator bb_it = F->begin(); bb_it != F->end(); ++bb_it) {
+        BBNum = BBNumbers[&(*bb_it)];
+        file << "Block " << bb_it->getName().str() << '\n';
+        file << "Live In\n";
+        for (unsigned int valueNum : livesIn[BBNum].set_bits()) {
+            file << values[valueNum]->getName().str() << '\n';
         }
-    }
-    bool changes;
-    Function::BasicBlockListType &blocks = F.getBasicBlockList();
-    do {
-        changes = false;
-        for (Function::BasicBlockListType::const_reverse_iterator bb_it = blocks.rbegin(); 
-                bb_it != blocks.rend(); ++bb_it) {
-            BBName = bb_it->getName();
-            bool change = iterateBasicBlock(*bb_it, uses[BBName], defs[BBName],  
-                liveInVars, liveOutVars);
-            changes = changes | change; 
+        file << "Live Out\n";
+        for (unsigned int valueNum : livesOut[BBNum].set_bits()) {
+            file << values[valueNum]->getName().str() << '\n';
         }
-    } 
-    while (changes);
-    printLiveVarsAnalysis(F);
-    return false;
+    }
+    // Statistics are not printed by release builds of LLVM
+    file << "Solver iterations " << numIterations << '\n';
+    file.close();
 }
 
 
-// Private Functions
+void FunctionLiveVars::numberValues() {
+    // Only arguments and instructions producing a value can be live
+    for (Function::const_arg_iterator arg_it = F->arg_begin(); arg_it != F->arg_end();
+        ++arg_it)
+    {
+        valueNumbers[&(*arg_it)] = values.size();
+        values.push_back(&(*arg_it));
+    }
+    for (Function::const_iterator bb_it = F->begin(); bb_it != F->end(); ++bb_it) {
+        unsigned int BBNum = BBNumbers.size();
+        BBNumbers[&(*bb_it)] = BBNum;
+        for (BasicBlock::const_iterator inst_it = bb_it->begin(); inst_it != bb_it->end();
+            ++inst_it)
+        {
+            if (!inst_it->getType()->isVoidTy()) {
+                valueNumbers[&(*inst_it)] = values.size();
+                values.push_back(&(*inst_it));
+            }
+        }
+    }
+    unsigned int numBBs = BBNumbers.size();
+    uses.assign(numBBs, BitVector(values.size()));
+    defs.assign(numBBs, BitVector(values.size()));
+    livesIn.assign(numBBs, BitVector(values.size()));
+    livesOut.assign(numBBs, BitVector(values.size()));
+    phiConstants.assign(numBBs, vector <pair <const PHINode*, unsigned int> >());
+}
+
 
-void LiveVarsPass::computeUsesDefs(const BasicBlock& BB, set<const Value*>& uses, 
-        set<const Value*>& defs) 
+void FunctionLiveVars::computeUsesDefs(const BasicBlock& BB, BitVector& uses,
+    BitVector& defs)
 {
-    for (BasicBlock::const_iterator inst_it = BB.begin(); inst_it != BB.end(); ++inst_it) {    
+    unsigned int valueNum;
+    for (BasicBlock::const_iterator inst_it = BB.begin(); inst_it != BB.end(); ++inst_it) {
         if (!isa<PHINode>(*inst_it)) { // phis uses processed separately
-            for (User::const_op_iterator op_it = inst_it->op_begin(); op_it != inst_it->op_end(); 
-                ++op_it) 
+            for (User::const_op_iterator op_it = inst_it->op_begin(); op_it != inst_it->op_end();
+                ++op_it)
             {
-                if ((isa<Instruction>(op_it->get()) || isa<Argument>(op_it->get())) 
-                    and defs.find(op_it->get()) == defs.end()) 
-                {
-                    uses.insert(op_it->get());  
+                if (isa<Instruction>(op_it->get()) || isa<Argument>(op_it->get())) {
+                    valueNum = getValueNumber(op_it->get());
+                    if (!defs.test(valueNum)) {
+                        uses.set(valueNum);
+                    }
                 }
             }
-        }  
-        if (!inst_it->getType()->isVoidTy() and uses.find(&(*inst_it)) == uses.end()) {
-            defs.insert(&(*inst_it));
         }
-    }    
+        if (!inst_it->getType()->isVoidTy()) {
+            valueNum = getValueNumber(&(*inst_it));
+            if (!uses.test(valueNum)) {
+                defs.set(valueNum);
+            }
+        }
+    }
 }
 
 
-void LiveVarsPass::processPhiUses(const BasicBlock& BB) {
-    StringRef predBBName;
+void FunctionLiveVars::processPhiUses(const BasicBlock& BB) {
+    const BasicBlock* predBB;
     for (BasicBlock::const_iterator it = BB.begin(); &(*it) != BB.getFirstNonPHI(); ++it) {
         const PHINode* phi = cast<PHINode> (it);
         const Value* value;
         for (unsigned int i = 0; i < phi->getNumIncomingValues(); ++i) {
             value = phi->getIncomingValue(i);
-            predBBName = phi->getIncomingBlock(i)->getName();
+            predBB = phi->getIncomingBlock(i);
             if (isa<Instruction>(value) || isa<Argument>(value)) {
-                liveOutVars[predBBName].insert(value);
+                livesOut[BBNumbers[predBB]].set(getValueNumber(value));
             }
             else if (isa<Constant>(value)) {
                 /* constants stored separately to place them when processing the corresponding BB,
                     as they will appear in the phi instruction itself in the LLVM IR */
-                phiConstants[predBBName].insert(make_pair(phi, i));
+                phiConstants[BBNumbers[predBB]].push_back(make_pair(phi, i));
             }
         }
     }
 }
 
 
-bool LiveVarsPass::iterateBasicBlock(const BasicBlock &BB, const set<const Value*> &uses, 
-    const set<const Value*> &defs, map<StringRef, set<const Value*> > &livesIn, 
-    map<StringRef, set<const Value*> > &livesOut) 
-{
-    StringRef BBName = BB.getName();
-    set<const Value*> newLivesIn, aux;
-    set_difference(livesOut[BBName].begin(), livesOut[BBName].end(),
-        defs.begin(), defs.end(), 
-        inserter(aux, aux.begin()));
-    set_union(aux.begin(), aux.end(),
-        uses.begin(), uses.end(), 
-        inserter(newLivesIn, newLivesIn.begin()));
-    bool changes = false;
-    for (set<const Value*>::const_iterator it = newLivesIn.begin(); 
-        it != newLivesIn.end(); it++) 
+void FunctionLiveVars::solveLiveness() {
+    vector <const BasicBlock*> BBs(BBNumbers.size());
+    for (Function::const_iterator bb_it = F->begin(); bb_it != F->end(); ++bb_it) {
+        BBs[BBNumbers[&(*bb_it)]] = &(*bb_it);
+    }
+    /* Liveness flows backwards, so the reverse post-order is walked from the end:
+        a BB is processed after its successors (back edges aside) */
+    deque <unsigned int> worklist;
+    BitVector inWorklist(BBs.size());
+    ReversePostOrderTraversal <const Function*> RPOT(F);
+    vector <const BasicBlock*> RPO(RPOT.begin(), RPOT.end());
+    for (vector <const BasicBlock*>::const_reverse_iterator it = RPO.rbegin();
+        it != RPO.rend(); ++it)
     {
-        changes = changes | livesIn[BBName].insert(*it).second;
+        worklist.push_back(BBNumbers[*it]);
+        inWorklist.set(BBNumbers[*it]);
+    }
+    // Unreachable BBs are not in the traversal but can still use values
+    for (unsigned int i = 0; i < BBs.size(); ++i) {
+        if (!inWorklist.test(i)) {
+            worklist.push_back(i);
+            inWorklist.set(i);
+        }
     }
-    StringRef predBBName;
+    unsigned int BBNum;
+    numIterations = 0;
+    while (!worklist.empty()) {
+        BBNum = worklist.front();
+        worklist.pop_front();
+        inWorklist.reset(BBNum);
+        ++numIterations;
+        if (iterateBasicBlock(*BBs[BBNum])) {
+            // Only the predecessors see a different live out
+            for (const_pred_iterator it = pred_begin(BBs[BBNum]); it != pred_end(BBs[BBNum]);
+                ++it)
+            {
+                unsigned int predNum = BBNumbers[*it];
+                if (!inWorklist.test(predNum)) {
+                    worklist.push_back(predNum);
+                    inWorklist.set(predNum);
+                }
+            }
+        }
+    }
+    NumBBIterations += numIterations;
+}
+
+
+bool FunctionLiveVars::iterateBasicBlock(const BasicBlock &BB) {
+    unsigned int BBNum = BBNumbers[&BB];
+    // live in = uses | (live out & ~defs), computed a whole word at a time
+    BitVector newLivesIn(livesOut[BBNum]);
+    newLivesIn.reset(defs[BBNum]);
+    newLivesIn |= uses[BBNum];
+    /* The sets only grow, so the predecessors already have the live in
+        values unless they changed in this iteration */
+    if (newLivesIn == livesIn[BBNum]) {
+        return false;
+    }
+    livesIn[BBNum] = newLivesIn;
     for (const_pred_iterator it = pred_begin(&BB); it != pred_end(&BB); ++it) {
-        predBBName = (*it)->getName();
-        livesOut[predBBName].insert(newLivesIn.begin(), newLivesIn.end());
+        livesOut[BBNumbers[*it]] |= newLivesIn;
     }
-    return changes;
+    return true;
 }
 
 
-void LiveVarsPass::printLiveVarsAnalysis(Function& F) {
-    ofstream file;
-    file.open(inputFileName + "_" + F.getName().str() + "_LiveVariables.txt");
-    StringRef BBName;
-    for (Function::const_iterator bb_it = F.begin(); bb_it != F.end(); ++bb_it) {
-        BBName = bb_it->getName();
-        file << "Block " << BBName.str() << '\n';
-        file << "Live In\n";
-        for (set<const Value*>::const_iterator var_it = liveInVars[BBName].begin(); 
-            var_it != liveInVars[BBName].end(); ++var_it) 
-        {
-            file << (*var_it)->getName().str() << '\n';
-        }
-        file << "Live Out\n";
-        for (set<const Value*>::const_iterator var_it = liveOutVars[BBName].begin(); 
-            var_it != liveOutVars[BBName].end(); ++var_it) 
-        {
-            file << (*var_it)->getName().str() << '\n';
-        }
+unsigned int FunctionLiveVars::getBBNumber(const BasicBlock* BB) {
+    DenseMap <const BasicBlock*, unsigned int>::const_iterator it = BBNumbers.find(BB);
+    assert(it != BBNumbers.end() && "BB not in the function");
+    return it->second;
+}
+
+
+/*
+ * =================================
+ *  Class LiveVarsPass
+ * =================================
+*/
+
+
+char LiveVarsPass::ID = 0;
+
+
+LiveVarsPass::LiveVarsPass() : ModulePass(ID) {}
+
+
+LiveVarsPass::~LiveVarsPass() {}
+
+
+string LiveVarsPass::getInputFileName() {
+    return inputFileName;
+}
+
+
+FunctionLiveVars& LiveVarsPass::getLiveVars(const Function& F) {
+    DenseMap <const Function*, unsigned int>::const_iterator it = functionNumbers.find(&F);
+    assert(it != functionNumbers.end() && "Function not analysed");
+    return functions[it->second];
+}
+
+
+void LiveVarsPass::getAnalysisUsage(AnalysisUsage &AU) const {
+    AU.setPreservesAll();
+}
+
+
+bool LiveVarsPass::runOnModule(Module &M) {
+    PassProfiler::Scope scope("LiveVarsPass");
+    inputFileName = M.getModuleIdentifier();
+    inputFileName = inputFileName.substr(0, inputFileName.size()-3);
+    releaseMemory();
+    // All the results are created first, so they do not move while the threads run
+    for (Module::const_iterator it = M.begin(); it != M.end(); ++it) {
+        if (it->isDeclaration()) continue;
+        functionNumbers[&(*it)] = functions.size();
+        functions.push_back(FunctionLiveVars(*it));
     }
-    file.close();
+    ThreadPool pool(hardware_concurrency(PassProfiler::getNumThreads(numThreads)));
+    for (unsigned int i = 0; i < functions.size(); ++i) {
+        FunctionLiveVars* liveVars = &functions[i];
+        pool.async([liveVars] { liveVars->analyze(); });
+    }
+    pool.wait();
+    if (dumpLiveVars) printLiveVarsAnalysis();
+    return false;
+}
+
+
+void LiveVarsPass::releaseMemory() {
+    functions.clear();
+    functionNumbers.clear();
 }
 
 
-void LiveVarsPass::setCurrentFunc(Function& F) {
-    funcName = F.getName();
-    for (Function::const_iterator bb_it = F.begin(); bb_it != F.end(); ++bb_it) {
-        liveInVars.insert(make_pair(bb_it->getName(), set <const Value*>()));
-        liveOutVars.insert(make_pair(bb_it->getName(), set <const Value*>()));
-        phiConstants.insert(make_pair(bb_it->getName(), 
-            set <pair <const PHINode*, unsigned int> >()));
+void LiveVarsPass::printLiveVarsAnalysis() {
+    for (unsigned int i = 0; i < functions.size(); ++i) {
+        FunctionLiveVars& liveVars = functions[i];
+        liveVars.printLiveVars(inputFileName + "_" +
+            liveVars.getFunction().getName().str() + "_LiveVariables.txt");
     }
 }
 
 
-static RegisterPass<LiveVarsPass> registerLiveVarsPass("liveVarsPass", 
+static RegisterPass<LiveVarsPass> registerLiveVarsPass("liveVarsPass",
     "Live Variable Analysis Pass",
     false /* Only looks at CFG */,
-    false /* Analysis Pass */);
+    true /* Analysis Pass */);
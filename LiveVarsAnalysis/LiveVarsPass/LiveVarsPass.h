@@ -6,53 +6,117 @@
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/CFG.h"
 #include "llvm/Pass.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
+#include "PassProfiler.h"
 #include <map>
 #include <unordered_map>
 #include <set>
 #include <vector>
+#include <deque>
 #include <algorithm>
 #include <fstream>
 
 using namespace std;
 using namespace llvm;
 
-    
-class LiveVarsPass : public FunctionPass {
+
+/* Live variables of a single function. The arguments and the instructions producing a
+    value are numbered densely, and the live sets of each BB are bit vectors indexed by
+    that number. The analysis only reads the IR, so different functions can be analysed
+    at the same time */
+class FunctionLiveVars {
 
 public:
 
-    map <StringRef, set <const Value*> > liveInVars;
-    map <StringRef, set <const Value*> > liveOutVars;
-    map <StringRef, set <pair <const PHINode*, unsigned int > > > phiConstants;
+    FunctionLiveVars(const Function& F);
+    ~FunctionLiveVars();
 
-    static char ID;
+    void analyze();
 
-    LiveVarsPass();
-    ~LiveVarsPass();
+    const Function& getFunction();
 
-    string getInputFileName();
-    StringRef getFuncName();
-    
-    bool runOnFunction(Function &F) override;
+    // Dense numbering of the arguments and instructions of the function
+    unsigned int getNumValues();
+    unsigned int getValueNumber(const Value* value);
+    const Value* getValue(unsigned int valueNumber);
+
+    // Bit vectors indexed by value number
+    const BitVector& getLiveInBits(const BasicBlock* BB);
+    const BitVector& getLiveOutBits(const BasicBlock* BB);
+
+    /* Constants that the phis of the successors take from BB, as each phi and the index
+        of the operand, in the order they appear in the IR */
+    const vector <pair <const PHINode*, unsigned int> >& getPhiConstants(const BasicBlock* BB);
+
+    // Transfer functions evaluated until the fixpoint
+    unsigned int getNumIterations();
+
+    void printLiveVars(const string& fileName);
 
 private:
 
-    string inputFileName;
-    StringRef funcName; // Current function running the analysis pass
+    const Function* F;
+
+    vector <const Value*> values;
+    DenseMap <const Value*, unsigned int> valueNumbers;
+    DenseMap <const BasicBlock*, unsigned int> BBNumbers;
+
+    // Indexed by BB number. Uses and defs are only kept while solving
+    vector <BitVector> uses;
+    vector <BitVector> defs;
+    vector <BitVector> livesIn;
+    vector <BitVector> livesOut;
+    vector <vector <pair <const PHINode*, unsigned int> > > phiConstants;
+    unsigned int numIterations;
+
+    void numberValues();
 
-    void computeUsesDefs(const BasicBlock &BB, set<const Value*> &uses, 
-        set<const Value*> &defs);
+    void computeUsesDefs(const BasicBlock &BB, BitVector &uses, BitVector &defs);
 
     void processPhiUses(const BasicBlock& BB);
 
-    bool iterateBasicBlock(const BasicBlock &BB, const set<const Value*> &uses, 
-        const set<const Value*> &defs, map<StringRef, set<const Value*> > &livesIn, 
-        map<StringRef, set<const Value*> > &livesOut);
+    void solveLiveness();
+
+    bool iterateBasicBlock(const BasicBlock &BB);
+
+    unsigned int getBBNumber(const BasicBlock* BB);
+
+};
 
-    void printLiveVarsAnalysis(Function& F);
 
-    void setCurrentFunc(Function& F);
+/* Computes the live variables of every function of the module at once, in parallel,
+    and keeps them until the passes using them finish */
+class LiveVarsPass : public ModulePass {
+
+public:
+
+    static char ID;
+
+    LiveVarsPass();
+    ~LiveVarsPass();
+
+    string getInputFileName();
+
+    FunctionLiveVars& getLiveVars(const Function& F);
+
+    void getAnalysisUsage(AnalysisUsage &AU) const override;
+    bool runOnModule(Module &M) override;
+    void releaseMemory() override;
+
+private:
+
+    string inputFileName;
+    // One per function with body, in the order of the module
+    vector <FunctionLiveVars> functions;
+    DenseMap <const Function*, unsigned int> functionNumbers;
+
+    void printLiveVarsAnalysis();
 
 };
 
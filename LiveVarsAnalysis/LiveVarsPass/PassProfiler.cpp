@@ -0,0 +1,304 @@
+#include "PassProfiler.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/JSON.h"
+#include <algorithm>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+static cl::opt <bool> printProfile("dfgraph-profile",
+    cl::desc("Print the time of each phase of the graph generation and its counters"),
+    cl::init(false));
+
+static cl::opt <string> traceFile("dfgraph-trace",
+    cl::desc("Write a Chrome trace of the graph generation, one track per function"),
+    cl::value_desc("filename"));
+
+static cl::opt <bool> profileHeap("dfgraph-profile-heap",
+    cl::desc("Also measure the peak heap of each function, processing them one at a time"),
+    cl::init(false));
+
+// Times in the trace start when the library is loaded, before any Scope can begin
+static const chrono::steady_clock::time_point origin = chrono::steady_clock::now();
+
+
+/*
+ * =================================
+ *  Class PassProfiler::Scope
+ * =================================
+*/
+
+
+PassProfiler::Scope::Scope(const char* phase, StringRef track, StringRef detail) {
+    if (!isEnabled()) {
+        this->phase = nullptr;
+        return;
+    }
+    this->phase = phase;
+    this->track = track.str();
+    this->detail = detail.str();
+    start = chrono::steady_clock::now();
+}
+
+
+PassProfiler::Scope::~Scope() {
+    if (phase == nullptr) return;
+    get().addEvent(phase, track, detail, start, chrono::steady_clock::now());
+}
+
+
+/*
+ * =================================
+ *  Class PassProfiler::HeapPeak
+ * =================================
+*/
+
+
+PassProfiler::HeapPeak::HeapPeak(StringRef track) {
+    enabled = isHeapEnabled();
+    if (!enabled) return;
+    this->track = track.str();
+    start = getHeapSize();
+    peak = start;
+}
+
+
+PassProfiler::HeapPeak::~HeapPeak() {
+    if (!enabled) return;
+    sample();
+    get().recordHeapUse(track, peak - start);
+}
+
+
+void PassProfiler::HeapPeak::sample() {
+    if (!enabled) return;
+    peak = max(peak, getHeapSize());
+}
+
+
+/*
+ * =================================
+ *  Class PassProfiler
+ * =================================
+*/
+
+
+PassProfiler::PassProfiler() {}
+
+
+PassProfiler& PassProfiler::get() {
+    static PassProfiler profiler;
+    return profiler;
+}
+
+
+bool PassProfiler::isEnabled() {
+    return printProfile or !traceFile.empty();
+}
+
+
+bool PassProfiler::isHeapEnabled() {
+    return profileHeap and isEnabled();
+}
+
+
+unsigned int PassProfiler::getNumThreads(unsigned int numThreads) {
+    return isHeapEnabled() ? 1 : numThreads;
+}
+
+
+void PassProfiler::addCount(StringRef counter, uint64_t value) {
+    if (!isEnabled()) return;
+    lock_guard <mutex> guard(lock);
+    counters[counter.str()] += value;
+}
+
+
+void PassProfiler::recordHeapUse(StringRef track, size_t bytes) {
+    if (!isHeapEnabled()) return;
+    lock_guard <mutex> guard(lock);
+    size_t& heapUse = heapUses[track.str()];
+    heapUse = max(heapUse, bytes);
+}
+
+
+size_t PassProfiler::getHeapSize() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    return mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+}
+
+
+void PassProfiler::addEvent(const char* phase, const string& track, const string& detail,
+    chrono::steady_clock::time_point start, chrono::steady_clock::time_point end)
+{
+    Event event;
+    event.phase = phase;
+    event.track = track;
+    event.detail = detail;
+    event.start = chrono::duration <double, micro>(start - origin).count();
+    event.duration = chrono::duration <double, micro>(end - start).count();
+    lock_guard <mutex> guard(lock);
+    events.push_back(event);
+}
+
+
+void PassProfiler::report(const string& moduleName, const vector <string>& functionNames) {
+    if (!isEnabled()) return;
+    lock_guard <mutex> guard(lock);
+    // Events come from several threads
+    std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+        return a.start < b.start;
+    });
+    // The module first, then the functions, and last any other track in order of name
+    vector <string> tracks(1, "");
+    tracks.insert(tracks.end(), functionNames.begin(), functionNames.end());
+    map <string, bool> knownTracks;
+    for (unsigned int i = 0; i < tracks.size(); ++i) knownTracks[tracks[i]] = true;
+    map <string, bool> otherTracks;
+    for (unsigned int i = 0; i < events.size(); ++i) {
+        if (!knownTracks.count(events[i].track)) otherTracks[events[i].track] = true;
+    }
+    // Like the copies of the functions, that are only known by their heap
+    for (map <string, size_t>::const_iterator it = heapUses.begin(); it != heapUses.end();
+        ++it)
+    {
+        if (!knownTracks.count(it->first)) otherTracks[it->first] = true;
+    }
+    for (map <string, bool>::const_iterator it = otherTracks.begin(); it != otherTracks.end();
+        ++it)
+    {
+        tracks.push_back(it->first);
+    }
+    if (printProfile) printSummary(errs(), tracks);
+    if (!traceFile.empty() and !writeTrace(traceFile, moduleName, tracks)) {
+        errs() << "Cannot write the trace " << traceFile << '\n';
+    }
+    events.clear();
+    counters.clear();
+    heapUses.clear();
+}
+
+
+void PassProfiler::printSummary(raw_ostream& out, const vector <string>& tracks) {
+    struct PhaseTime
+    {
+        unsigned int calls;
+        double total;
+        double max;
+    };
+    // Phases in the order they first ran
+    vector <const char*> phases;
+    map <string, PhaseTime> times;
+    for (unsigned int i = 0; i < events.size(); ++i) {
+        const Event& event = events[i];
+        map <string, PhaseTime>::iterator it = times.find(event.phase);
+        if (it == times.end()) {
+            phases.push_back(event.phase);
+            it = times.insert(make_pair(string(event.phase), PhaseTime{0, 0, 0})).first;
+        }
+        it->second.calls += 1;
+        it->second.total += event.duration;
+        it->second.max = max(it->second.max, event.duration);
+    }
+    out << "===" << string(70, '-') << "===\n";
+    out << "                      DFGraph generation profile\n";
+    out << "===" << string(70, '-') << "===\n";
+    out << format("  %-36s %8s %12s %12s\n", (const char*)"Phase", (const char*)"Calls",
+        (const char*)"Total ms", (const char*)"Max ms");
+    for (unsigned int i = 0; i < phases.size(); ++i) {
+        const PhaseTime& time = times[phases[i]];
+        out << format("  %-36s %8u %12.3f %12.3f\n", phases[i], time.calls,
+            time.total / 1000, time.max / 1000);
+    }
+    if (!counters.empty()) {
+        out << '\n' << format("  %-36s %8s\n", (const char*)"Counter",
+            (const char*)"Value");
+        for (map <string, uint64_t>::const_iterator it = counters.begin();
+            it != counters.end(); ++it)
+        {
+            out << format("  %-36s %8llu\n", it->first.c_str(), (unsigned long long)it->second);
+        }
+    }
+    if (!heapUses.empty()) {
+        out << '\n' << format("  %-36s %14s\n", (const char*)"Function",
+            (const char*)"Peak heap KiB");
+        for (unsigned int i = 0; i < tracks.size(); ++i) {
+            map <string, size_t>::const_iterator it = heapUses.find(tracks[i]);
+            if (it == heapUses.end()) continue;
+            out << format("  %-36s %14.1f\n", it->first.c_str(), it->second / 1024.0);
+        }
+    }
+    out << '\n';
+}
+
+
+bool PassProfiler::writeTrace(const string& fileName, const string& moduleName,
+    const vector <string>& tracks)
+{
+    error_code error;
+    raw_fd_ostream file(fileName, error);
+    if (error) return false;
+    map <string, unsigned int> trackIds;
+    for (unsigned int i = 0; i < tracks.size(); ++i) trackIds[tracks[i]] = i;
+    json::OStream json(file);
+    json.object([&] {
+        json.attributeArray("traceEvents", [&] {
+            for (unsigned int i = 0; i < events.size(); ++i) {
+                const Event& event = events[i];
+                json.object([&] {
+                    json.attribute("name", event.phase);
+                    json.attribute("ph", "X");
+                    json.attribute("pid", 1);
+                    json.attribute("tid", (int64_t)trackIds[event.track]);
+                    json.attribute("ts", event.start);
+                    json.attribute("dur", event.duration);
+                    if (!event.detail.empty()) {
+                        json.attributeObject("args", [&] {
+                            json.attribute("detail", event.detail);
+                        });
+                    }
+                });
+            }
+            // Names of the tracks, and their order as in the module
+            for (unsigned int i = 0; i < tracks.size(); ++i) {
+                string name = (i == 0 ? "Module " + moduleName : tracks[i]);
+                json.object([&] {
+                    json.attribute("name", "thread_name");
+                    json.attribute("ph", "M");
+                    json.attribute("pid", 1);
+                    json.attribute("tid", (int64_t)i);
+                    json.attributeObject("args", [&] { json.attribute("name", name); });
+                });
+                json.object([&] {
+                    json.attribute("name", "thread_sort_index");
+                    json.attribute("ph", "M");
+                    json.attribute("pid", 1);
+                    json.attribute("tid", (int64_t)i);
+                    json.attributeObject("args", [&] {
+                        json.attribute("sort_index", (int64_t)i);
+                    });
+                });
+            }
+        });
+        json.attributeObject("counters", [&] {
+            for (map <string, uint64_t>::const_iterator it = counters.begin();
+                it != counters.end(); ++it)
+            {
+                json.attribute(it->first, (int64_t)it->second);
+            }
+        });
+        json.attributeObject("peakHeapBytes", [&] {
+            for (map <string, size_t>::const_iterator it = heapUses.begin();
+                it != heapUses.end(); ++it)
+            {
+                json.attribute(it->first, (int64_t)it->second);
+            }
+        });
+    });
+    file << '\n';
+    return true;
+}
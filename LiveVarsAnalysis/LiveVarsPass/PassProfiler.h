@@ -0,0 +1,117 @@
+#ifndef PASSPROFILER_H
+#define PASSPROFILER_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace llvm;
+
+
+/* Instrumentation of the passes that generate the graph. The passes mark their phases
+    with a Scope and add to named counters, and at the end of DFGraphPass a summary table
+    is printed (-dfgraph-profile) and/or a Chrome trace is written (-dfgraph-trace=file),
+    with one track per function. It lives in this library as every pass of the pipeline
+    loads it, so all of them share the same profiler.
+    When neither option is given a Scope only checks a flag.
+    With -dfgraph-profile-heap the peak heap of each function is measured too. As the heap
+    is only known for the whole process, the passes then process one function at a time */
+class PassProfiler {
+
+public:
+
+    // Times a phase of the function of the track, the empty track is the whole module
+    class Scope {
+
+    public:
+
+        Scope(const char* phase, StringRef track = StringRef(), StringRef detail = StringRef());
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator = (const Scope&) = delete;
+
+    private:
+
+        const char* phase;
+        string track;
+        string detail;
+        chrono::steady_clock::time_point start;
+
+    };
+
+    /* Highest heap used while a function is processed, over the moments it is sampled.
+        It is recorded for the track when it goes out of scope */
+    class HeapPeak {
+
+    public:
+
+        HeapPeak(StringRef track);
+        ~HeapPeak();
+
+        HeapPeak(const HeapPeak&) = delete;
+        HeapPeak& operator = (const HeapPeak&) = delete;
+
+        void sample();
+
+    private:
+
+        string track;
+        bool enabled;
+        size_t start;
+        size_t peak;
+
+    };
+
+    static PassProfiler& get();
+    static bool isEnabled();
+    static bool isHeapEnabled();
+    // Threads the passes can use, only one while the heap is measured
+    static unsigned int getNumThreads(unsigned int numThreads);
+
+    void addCount(StringRef counter, uint64_t value = 1);
+
+    // Heap used by a function, keeping the maximum given
+    void recordHeapUse(StringRef track, size_t bytes);
+    // Bytes allocated by the process at the moment, 0 if it cannot be known
+    static size_t getHeapSize();
+
+    /* Prints and/or writes what was recorded, and starts again. The tracks follow the
+        order of the functions given */
+    void report(const string& moduleName, const vector <string>& functionNames);
+
+private:
+
+    struct Event
+    {
+        const char* phase;
+        string track;
+        string detail;
+        // Microseconds since the library was loaded
+        double start;
+        double duration;
+    };
+
+    mutex lock;
+    vector <Event> events;
+    map <string, uint64_t> counters;
+    map <string, size_t> heapUses;
+
+    PassProfiler();
+
+    void addEvent(const char* phase, const string& track, const string& detail,
+        chrono::steady_clock::time_point start, chrono::steady_clock::time_point end);
+
+    void printSummary(raw_ostream& out, const vector <string>& tracks);
+    bool writeTrace(const string& fileName, const string& moduleName,
+        const vector <string>& tracks);
+
+};
+
+
+#endif // PASSPROFILER_H